@@ -18,6 +18,8 @@
 
 #include "EEG.h"
 #include "Sound_and_Spectrum.h"
+#include "NUM2.h"
+#include "MelderThread.h"
 
 #include "oo_DESTROY.h"
 #include "EEG_def.h"
@@ -94,7 +96,39 @@ long EEG_getChannelNumber (EEG me, const char32 *channelName) {
 	return 0;
 }
 
-autoEEG EEG_readFromBdfFile (MelderFile file) {
+/*
+	A BDF or EDF file consists of a header and a sequence of data records.
+	Every data record contains numberOfSamplesPerDataRecord consecutive samples of channel 1,
+	then as many samples of channel 2, and so on, with 3 (BDF) or 2 (EDF) bytes per sample.
+	The records are read a block of a few megabytes at a time, and only the requested records
+	and channels are read and decoded.
+*/
+static void EEG_decodeBdfSamples (const unsigned char *p, bool is24bit, long numberOfSamples, double factor, double *to) {
+	if (is24bit) {
+		for (long i = 0; i < numberOfSamples; i ++, p += 3) {
+			int32_t externalValue = (int32_t) ((uint32_t) p [2] << 24 | (uint32_t) p [1] << 16 | (uint32_t) p [0] << 8) >> 8;   // extend the 24-bit sign to 32 bits
+			to [i] = externalValue * factor;
+		}
+	} else {
+		for (long i = 0; i < numberOfSamples; i ++, p += 2) {
+			int16 externalValue = (int16) (uint16) ((uint16) p [1] << 8 | (uint16) p [0]);
+			to [i] = externalValue * factor;
+		}
+	}
+}
+
+/*
+	An EEG object knows its kinds of channels only from their number (see EEG_getNumberOfCapElectrodes
+	and EEG_getNumberOfExtraSensors), so the kind of the channel at a position depends on how many channels there are.
+*/
+static const char32 *EEG_getKindOfChannel (long numberOfChannels, long channel) {
+	const long numberOfCapElectrodes = (numberOfChannels - 1) & ~ 15L;
+	const long numberOfExtraSensors = numberOfChannels == 1 ? 0 : numberOfChannels & 1 ? 1 : 8;
+	return channel <= numberOfCapElectrodes ? U"cap electrode" :
+		channel > numberOfChannels - numberOfExtraSensors ? U"extra sensor" : U"external electrode";
+}
+
+autoEEG EEG_readFromBdfFile_part (MelderFile file, double fromTime, double toTime, const char32 *channelRanges) {
 	try {
 		autofile f = Melder_fopen (file, "rb");
 		char buffer [81];
@@ -189,54 +223,128 @@ autoEEG EEG_readFromBdfFile (MelderFile file) {
 			fread (buffer, 1, 32, f); buffer [32] = '\0';   // reserved
 		}
 		double duration = numberOfDataRecords * durationOfDataRecord;
-		autoEEG him = EEG_create (0, duration);
+		bool readingPart = toTime > fromTime && (fromTime > 0.0 || toTime < duration);
+		if (! readingPart) {
+			fromTime = 0.0;
+			toTime = duration;
+		}
+		if (fromTime < 0.0) fromTime = 0.0;
+		if (toTime > duration) toTime = duration;
+		if (fromTime >= toTime)
+			Melder_throw (U"The time range doesn't overlap with the recording (0 to ", duration, U" seconds).");
+		const long totalNumberOfSamples = numberOfSamplesPerDataRecord * numberOfDataRecords;
+		const double dx = 1.0 / samplingFrequency, x1 = 0.5 / samplingFrequency;
+		const double rfirstSample = 1.0 + ceil ((fromTime - x1) / dx), rlastSample = 1.0 + floor ((toTime - x1) / dx);
+		const long firstSample = rfirstSample < 1.0 ? 1 : (long) rfirstSample;
+		const long lastSample = rlastSample > (double) totalNumberOfSamples ? totalNumberOfSamples : (long) rlastSample;
+		if (firstSample > lastSample)
+			Melder_throw (U"The time range from ", fromTime, U" to ", toTime, U" seconds contains no samples.");
+		/*
+			The status channel (the last channel) is always read, because the TextGrid is made from it.
+		*/
+		long numberOfSelectedChannels = numberOfChannels;
+		autoNUMvector <long> selectedChannels;
+		if (channelRanges && channelRanges [0] != U'\0') {
+			long numberOfRequestedChannels;
+			autoNUMvector <long> requestedChannels (NUMstring_getElementsOfRanges (channelRanges, numberOfChannels,
+				& numberOfRequestedChannels, nullptr, U"channel", true), 1);
+			selectedChannels.reset (1, numberOfRequestedChannels + 1);
+			numberOfSelectedChannels = 0;
+			for (long i = 1; i <= numberOfRequestedChannels; i ++)
+				if (requestedChannels [i] != numberOfChannels)
+					selectedChannels [++ numberOfSelectedChannels] = requestedChannels [i];
+			selectedChannels [++ numberOfSelectedChannels] = numberOfChannels;
+			/*
+				Every channel has to stay the kind of channel that it is in the file,
+				otherwise filtering, re-referencing and naming would treat it wrongly.
+			*/
+			for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++) {
+				const char32 *kindInFile = EEG_getKindOfChannel (numberOfChannels, selectedChannels [ichan]);
+				const char32 *kindInPart = EEG_getKindOfChannel (numberOfSelectedChannels, ichan);
+				if (! str32equ (kindInPart, kindInFile))
+					Melder_throw (U"Channel ", selectedChannels [ichan], U" cannot be read as one of ", numberOfSelectedChannels,
+						U" channels, because it would change from ", kindInFile, U" to ", kindInPart, U".\n"
+						U"Choose the cap electrodes in groups of 16, and all or none of the external electrodes and extra sensors.");
+			}
+		} else {
+			selectedChannels.reset (1, numberOfChannels);
+			for (long channel = 1; channel <= numberOfChannels; channel ++)
+				selectedChannels [channel] = channel;
+		}
+		autoEEG him = EEG_create (fromTime, toTime);
 		his numberOfChannels = numberOfChannels;
-		autoSound me = Sound_createSimple (numberOfChannels, duration, samplingFrequency);
-		Melder_assert (my nx == numberOfSamplesPerDataRecord * numberOfDataRecords);
-		autoNUMvector <unsigned char> dataBuffer (0L, 3 * numberOfSamplesPerDataRecord - 1);
-		for (long record = 1; record <= numberOfDataRecords; record ++) {
-			for (long channel = 1; channel <= numberOfChannels; channel ++) {
-				double factor = channel == numberOfChannels ? 1.0 : physicalMinimum [channel] / digitalMinimum [channel];
-				if (channel < numberOfChannels - EEG_getNumberOfExtraSensors (him.get())) factor /= 1000000.0;
-				if (is24bit) {
-					fread (& dataBuffer [0], 3, numberOfSamplesPerDataRecord, f);
-					unsigned char *p = & dataBuffer [0];
-					for (long i = 1; i <= numberOfSamplesPerDataRecord; i ++) {
-						long sample = i + (record - 1) * numberOfSamplesPerDataRecord;
-						Melder_assert (sample <= my nx);
-						uint8_t lowByte = *p ++, midByte = *p ++, highByte = *p ++;
-						uint32_t externalValue = ((uint32_t) highByte << 16) | ((uint32_t) midByte << 8) | (uint32_t) lowByte;
-						if ((highByte & 128) != 0)   // is the 24-bit sign bit on?
-							externalValue |= 0xFF000000;   // extend negative sign to 32 bits
-						my z [channel] [sample] = (int32_t) externalValue * factor;
-					}
-				} else {
-					fread (& dataBuffer [0], 2, numberOfSamplesPerDataRecord, f);
-					unsigned char *p = & dataBuffer [0];
-					for (long i = 1; i <= numberOfSamplesPerDataRecord; i ++) {
-						long sample = i + (record - 1) * numberOfSamplesPerDataRecord;
-						Melder_assert (sample <= my nx);
-						uint8 lowByte = *p ++, highByte = *p ++;
-						uint16 externalValue = (uint16) ((uint16) highByte << 8) | (uint16) lowByte;
-						my z [channel] [sample] = (int16) externalValue * factor;
+		autoSound me = Sound_create (numberOfSelectedChannels, fromTime, toTime,
+			lastSample - firstSample + 1, dx, x1 + (firstSample - 1) * dx);
+		autoNUMvector <double> factor (1, numberOfSelectedChannels);
+		for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++) {
+			const long channel = selectedChannels [ichan];
+			factor [ichan] = channel == numberOfChannels ? 1.0 : physicalMinimum [channel] / digitalMinimum [channel];
+			if (channel < numberOfChannels - EEG_getNumberOfExtraSensors (him.get())) factor [ichan] /= 1000000.0;
+		}
+		/*
+			Runs of consecutive selected channels are contiguous in a record;
+			if all channels are selected, a block of consecutive records is read with a single fread.
+		*/
+		const long numberOfBytesPerSample = is24bit ? 3 : 2;
+		const long numberOfBytesPerChannel = numberOfBytesPerSample * numberOfSamplesPerDataRecord;
+		const long numberOfBytesPerDataRecord = numberOfBytesPerChannel * numberOfChannels;
+		const long firstDataRecord = (firstSample - 1) / numberOfSamplesPerDataRecord + 1;
+		const long lastDataRecord = (lastSample - 1) / numberOfSamplesPerDataRecord + 1;
+		long numberOfDataRecordsPerBlock = 4000000 / numberOfBytesPerDataRecord;
+		if (numberOfDataRecordsPerBlock < 1) numberOfDataRecordsPerBlock = 1;
+		autoNUMvector <unsigned char> dataBuffer ((long) 0, numberOfDataRecordsPerBlock * numberOfBytesPerDataRecord - 1);
+		for (long firstRecordOfBlock = firstDataRecord; firstRecordOfBlock <= lastDataRecord; firstRecordOfBlock += numberOfDataRecordsPerBlock) {
+			long lastRecordOfBlock = firstRecordOfBlock + numberOfDataRecordsPerBlock - 1;
+			if (lastRecordOfBlock > lastDataRecord) lastRecordOfBlock = lastDataRecord;
+			const long numberOfRecordsInBlock = lastRecordOfBlock - firstRecordOfBlock + 1;
+			const off_t blockPosition = numberOfBytesInHeaderRecord + (off_t) (firstRecordOfBlock - 1) * numberOfBytesPerDataRecord;
+			if (numberOfSelectedChannels == numberOfChannels) {
+				fseeko (f, blockPosition, SEEK_SET);
+				size_t numberOfBytesRead = fread (& dataBuffer [0], 1, numberOfRecordsInBlock * numberOfBytesPerDataRecord, f);
+				memset (& dataBuffer [numberOfBytesRead], 0, numberOfRecordsInBlock * numberOfBytesPerDataRecord - numberOfBytesRead);   // a truncated file ends in silence
+			} else {
+				for (long irecord = 0; irecord < numberOfRecordsInBlock; irecord ++) {
+					for (long ichan = 1; ichan <= numberOfSelectedChannels; ) {
+						long jchan = ichan;
+						while (jchan < numberOfSelectedChannels && selectedChannels [jchan + 1] == selectedChannels [jchan] + 1)
+							jchan ++;
+						const long offsetInRecord = (selectedChannels [ichan] - 1) * numberOfBytesPerChannel;
+						const long numberOfBytesInRun = (jchan - ichan + 1) * numberOfBytesPerChannel;
+						unsigned char *run = & dataBuffer [irecord * numberOfBytesPerDataRecord + offsetInRecord];
+						fseeko (f, blockPosition + (off_t) irecord * numberOfBytesPerDataRecord + offsetInRecord, SEEK_SET);
+						size_t numberOfBytesRead = fread (run, 1, numberOfBytesInRun, f);
+						memset (run + numberOfBytesRead, 0, numberOfBytesInRun - numberOfBytesRead);
+						ichan = jchan + 1;
 					}
 				}
 			}
+			for (long record = firstRecordOfBlock; record <= lastRecordOfBlock; record ++) {
+				const long firstSampleOfRecord = (record - 1) * numberOfSamplesPerDataRecord + 1;
+				const long fromSample = std::max (firstSample, firstSampleOfRecord);
+				const long toSample = std::min (lastSample, firstSampleOfRecord + numberOfSamplesPerDataRecord - 1);
+				const unsigned char *recordBytes = & dataBuffer [(record - firstRecordOfBlock) * numberOfBytesPerDataRecord];
+				for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++) {
+					EEG_decodeBdfSamples (recordBytes + (selectedChannels [ichan] - 1) * numberOfBytesPerChannel +
+						(fromSample - firstSampleOfRecord) * numberOfBytesPerSample, is24bit,
+						toSample - fromSample + 1, factor [ichan], & my z [ichan] [fromSample - firstSample + 1]);
+				}
+			}
 		}
+		const long statusChannel = numberOfSelectedChannels;
 		int numberOfStatusBits = 8;
 		for (long i = 1; i <= my nx; i ++) {
-			unsigned long value = (long) my z [numberOfChannels] [i];
+			unsigned long value = (long) my z [statusChannel] [i];
 			if (value & 0x0000FF00) {
 				numberOfStatusBits = 16;
 			}
 		}
 		autoTextGrid thee;
 		if (hasLetters) {
-			thee = TextGrid_create (0, duration, U"Mark Trigger", U"Mark Trigger");
+			thee = TextGrid_create (fromTime, toTime, U"Mark Trigger", U"Mark Trigger");
 			autoMelderString letters;
 			double time = NUMundefined;
 			for (long i = 1; i <= my nx; i ++) {
-				unsigned long value = (long) my z [numberOfChannels] [i];
+				unsigned long value = (long) my z [statusChannel] [i];
 				for (int byte = 1; byte <= numberOfStatusBits / 8; byte ++) {
 					unsigned long mask = byte == 1 ? 0x000000ff : 0x0000ff00;
 					char32 kar = byte == 1 ? (value & mask) : (value & mask) >> 8;
@@ -256,7 +364,10 @@ autoEEG EEG_readFromBdfFile (MelderFile file) {
 							MelderString_empty (& letters);
 						} else {
 							if (! NUMdefined (time)) {
-								Melder_throw (U"Undefined time for label at sample ", i, U".");
+								if (! readingPart)
+									Melder_throw (U"Undefined time for label at sample ", i, U".");
+								MelderString_empty (& letters);   // the tail of a label that started before the part
+								continue;
 							}
 							try {
 								if (Melder_nequ (letters. string, U"Trigger-", 8)) {
@@ -282,19 +393,28 @@ autoEEG EEG_readFromBdfFile (MelderFile file) {
 				TextGrid_insertPoint (thee.get(), 1, time, U"");
 				time = NUMundefined;   // defensive
 			}
+			if (readingPart) {
+				for (int itier = 1; itier <= 2; itier ++) {
+					TextTier tier = (TextTier) thy tiers->at [itier];
+					for (long ipoint = tier -> points.size; ipoint > 0; ipoint --) {
+						double pointTime = tier -> points.at [ipoint] -> number;
+						if (pointTime < fromTime || pointTime > toTime)
+							tier -> points. removeItem (ipoint);
+					}
+				}
+			}
 		} else {
-			thee = TextGrid_create (0, duration,
+			thee = TextGrid_create (fromTime, toTime,
 				numberOfStatusBits == 8 ? U"S1 S2 S3 S4 S5 S6 S7 S8" : U"S1 S2 S3 S4 S5 S6 S7 S8 S9 S10 S11 S12 S13 S14 S15 S16", U"");
 			for (int bit = 1; bit <= numberOfStatusBits; bit ++) {
 				unsigned long bitValue = 1 << (bit - 1);
 				IntervalTier tier = (IntervalTier) thy tiers->at [bit];
 				for (long i = 1; i <= my nx; i ++) {
-					unsigned long previousValue = i == 1 ? 0 : (long) my z [numberOfChannels] [i - 1];
-					unsigned long thisValue = (long) my z [numberOfChannels] [i];
+					unsigned long previousValue = i == 1 ? 0 : (long) my z [statusChannel] [i - 1];
+					unsigned long thisValue = (long) my z [statusChannel] [i];
 					if ((thisValue & bitValue) != (previousValue & bitValue)) {
-						double time = i == 1 ? 0.0 : my x1 + (i - 1.5) * my dx;
-						if (time != 0.0)
-							TextGrid_insertBoundary (thee.get(), bit, time);
+						if (i > 1)
+							TextGrid_insertBoundary (thee.get(), bit, my x1 + (i - 1.5) * my dx);
 						if ((thisValue & bitValue) != 0)
 							TextGrid_setIntervalText (thee.get(), bit, tier -> intervals.size, U"1");
 					}
@@ -404,12 +524,24 @@ autoEEG EEG_readFromBdfFile (MelderFile file) {
 			EEG_setChannelName (him.get(), 63, U"PO4");
 			EEG_setChannelName (him.get(), 64, U"O2");
 		}
+		if (numberOfSelectedChannels < numberOfChannels) {
+			autostring32vector selectedChannelNames (1, numberOfSelectedChannels);
+			for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++)
+				selectedChannelNames [ichan] = Melder_dup (his channelNames [selectedChannels [ichan]]);
+			autostring32vector allChannelNames (his channelNames, 1, numberOfChannels);   // to be freed
+			his channelNames = selectedChannelNames.transfer();
+			his numberOfChannels = numberOfSelectedChannels;
+		}
 		return him;
 	} catch (MelderError) {
 		Melder_throw (U"BDF file not read.");
 	}
 }
 
+autoEEG EEG_readFromBdfFile (MelderFile file) {
+	return EEG_readFromBdfFile_part (file, 0.0, 0.0, U"");
+}
+
 static void detrend (double *a, long numberOfSamples) {
 	double firstValue = a [1], lastValue = a [numberOfSamples];
 	a [1] = a [numberOfSamples] = 0.0;
@@ -418,32 +550,165 @@ static void detrend (double *a, long numberOfSamples) {
 	}
 }
 
-void EEG_detrend (EEG me) {
-	for (long ichan = 1; ichan <= my numberOfChannels - EEG_getNumberOfExtraSensors (me); ichan ++) {
-		detrend (my sound -> z [ichan], my sound -> nx);
+/*
+	Detrending, filtering and re-referencing treat every electrode channel separately,
+	so the channels are divided over threads. Each thread has its own Fourier table and buffer,
+	because a table holds scratch space; everything is allocated here, before the threads start.
+*/
+#define EEG_CHANNELS_DETREND  1
+#define EEG_CHANNELS_FILTER  2
+#define EEG_CHANNELS_SUBTRACT  3
+
+Thing_define (EEG_ChannelArgs, Thing) {
+	int task;
+	double **z;
+	long numberOfSamples, firstChannel, lastChannel;
+	const double *reference;   // [1..numberOfSamples], SUBTRACT
+	long numberOfFrequencies;   // FILTER
+	const double *gain1, *gain2, *gain3;   // [1..numberOfFrequencies]; gain3 may be null
+	double dt, df;
+	autoNUMfft_Table fourierTable;
+	double *data;   // [1..fourierTable.n]
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (EEG_ChannelArgs, Thing, 0);
+
+void structEEG_ChannelArgs :: v_destroy () noexcept {
+	NUMvector_free <double> (data, 1);
+	EEG_ChannelArgs_Parent :: v_destroy ();
+}
+
+static MelderThread_RETURN_TYPE EEG_processChannels (EEG_ChannelArgs me) {
+	const long nx = my numberOfSamples;
+	for (long ichan = my firstChannel; ichan <= my lastChannel; ichan ++) {
+		double *a = my z [ichan];
+		if (my task == EEG_CHANNELS_DETREND) {
+			detrend (a, nx);
+		} else if (my task == EEG_CHANNELS_SUBTRACT) {
+			for (long isamp = 1; isamp <= nx; isamp ++)
+				a [isamp] -= my reference [isamp];
+		} else {
+			/*
+				The same operations, in the same order, as Sound_to_Spectrum, Spectrum_passHannBand,
+				Spectrum_stopHannBand and Spectrum_to_Sound, but in the layout of NUMfft, without any copies.
+			*/
+			const long nfft = my fourierTable.n, numberOfFrequencies = my numberOfFrequencies;
+			double *data = my data;
+			for (long isamp = 1; isamp <= nx; isamp ++)
+				data [isamp] = a [isamp];
+			for (long isamp = nx + 1; isamp <= nfft; isamp ++)
+				data [isamp] = 0.0;
+			NUMfft_forward (& my fourierTable, data);
+			for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq ++) {
+				const long ire = ifreq == 1 ? 1 : ifreq == numberOfFrequencies ? nfft : ifreq + ifreq - 2;
+				double re = data [ire] * my dt;
+				re *= my gain1 [ifreq];
+				re *= my gain2 [ifreq];
+				if (my gain3) re *= my gain3 [ifreq];
+				data [ire] = re * my df;
+				if (ifreq != 1 && ifreq != numberOfFrequencies) {
+					double im = data [ire + 1] * my dt;
+					im *= my gain1 [ifreq];
+					im *= my gain2 [ifreq];
+					if (my gain3) im *= my gain3 [ifreq];
+					data [ire + 1] = im * my df;
+				}
+			}
+			NUMfft_backward (& my fourierTable, data);
+			for (long isamp = 1; isamp <= nx; isamp ++)
+				a [isamp] = data [isamp];
+		}
 	}
+	MelderThread_RETURN;
+}
+
+static int EEG_createChannelArgs (EEG me, int task, long numberOfChannels, double numberOfOperationsPerChannel,
+	autoEEG_ChannelArgs *args, long maximumNumberOfThreads = 16)
+{
+	int numberOfThreads = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > maximumNumberOfThreads) numberOfThreads = maximumNumberOfThreads;
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	double maximumNumberOfThreadsForLoad = numberOfChannels * numberOfOperationsPerChannel / 1e5;
+	if (numberOfThreads > maximumNumberOfThreadsForLoad) numberOfThreads = (int) maximumNumberOfThreadsForLoad;
+	if (numberOfThreads > numberOfChannels) numberOfThreads = numberOfChannels;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	long firstChannel = 1;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		autoEEG_ChannelArgs arg = Thing_new (EEG_ChannelArgs);
+		arg -> task = task;
+		arg -> z = my sound -> z;
+		arg -> numberOfSamples = my sound -> nx;
+		arg -> firstChannel = firstChannel;
+		arg -> lastChannel = ithread == numberOfThreads ? numberOfChannels : numberOfChannels * ithread / numberOfThreads;
+		firstChannel = arg -> lastChannel + 1;
+		args [ithread - 1] = arg.move();
+	}
+	return numberOfThreads;
+}
+
+void EEG_detrend (EEG me) {
+	const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
+	if (numberOfElectrodeChannels < 1) return;
+	autoEEG_ChannelArgs args [16];
+	int numberOfThreads = EEG_createChannelArgs (me, EEG_CHANNELS_DETREND, numberOfElectrodeChannels, 2.0 * my sound -> nx, args);
+	MelderThread_run (EEG_processChannels, args, numberOfThreads);
 }
 
-void EEG_filter (EEG me, double lowFrequency, double lowWidth, double highFrequency, double highWidth, bool doNotch50Hz) {
-	try {
 /*
-	long nsampFFT = 1;
-	while (nsampFFT < my sound -> nx)
-		nsampFFT *= 2;
-	autoNUMfft_Table fftTable;
-	NUMfft_Table_init (& fftTable, nsampFFT);
+	The gain of a Spectrum_passHannBand or Spectrum_stopHannBand for each frequency bin,
+	computed by applying the band to a flat spectrum.
 */
-		for (long ichan = 1; ichan <= my numberOfChannels - EEG_getNumberOfExtraSensors (me); ichan ++) {
-			autoSound channel = Sound_extractChannel (my sound.get(), ichan);
-			autoSpectrum spec = Sound_to_Spectrum (channel.get(), true);
-			Spectrum_passHannBand (spec.get(), lowFrequency, 0.0, lowWidth);
-			Spectrum_passHannBand (spec.get(), 0.0, highFrequency, highWidth);
-			if (doNotch50Hz) {
-				Spectrum_stopHannBand (spec.get(), 48.0, 52.0, 1.0);
-			}
-			autoSound him = Spectrum_to_Sound (spec.get());
-			NUMvector_copyElements (his z [1], my sound -> z [ichan], 1, my sound -> nx);
+static autoSpectrum EEG_getBandGains (long numberOfFrequencies, double df, double fmax,
+	double bandMinimum, double bandMaximum, double smoothing, bool stop)
+{
+	autoSpectrum gains = Spectrum_create (fmax, numberOfFrequencies);
+	gains -> dx = df;
+	for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq ++)
+		gains -> z [1] [ifreq] = 1.0;
+	if (stop)
+		Spectrum_stopHannBand (gains.get(), bandMinimum, bandMaximum, smoothing);
+	else
+		Spectrum_passHannBand (gains.get(), bandMinimum, bandMaximum, smoothing);
+	return gains;
+}
+
+void EEG_filter (EEG me, double lowFrequency, double lowWidth, double highFrequency, double highWidth, bool doNotch50Hz) {
+	try {
+		const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
+		if (numberOfElectrodeChannels < 1) return;
+		const double dt = my sound -> dx;
+		long nfft = 2;
+		while (nfft < my sound -> nx)
+			nfft *= 2;
+		const long numberOfFrequencies = nfft / 2 + 1;
+		const double df = 1.0 / (dt * nfft);
+		autoSpectrum gain1 = EEG_getBandGains (numberOfFrequencies, df, 0.5 / dt, lowFrequency, 0.0, lowWidth, false);
+		autoSpectrum gain2 = EEG_getBandGains (numberOfFrequencies, df, 0.5 / dt, 0.0, highFrequency, highWidth, false);
+		autoSpectrum gain3;
+		if (doNotch50Hz)
+			gain3 = EEG_getBandGains (numberOfFrequencies, df, 0.5 / dt, 48.0, 52.0, 1.0, true);
+		/*
+			Every thread needs about four times nfft numbers; keep this under a gigabyte.
+		*/
+		long maximumNumberOfThreads = (long) (1e9 / (32.0 * nfft));
+		autoEEG_ChannelArgs args [16];
+		int numberOfThreads = EEG_createChannelArgs (me, EEG_CHANNELS_FILTER, numberOfElectrodeChannels,
+			10.0 * nfft * log2 ((double) nfft), args, maximumNumberOfThreads);
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			EEG_ChannelArgs arg = args [ithread - 1].get();
+			arg -> numberOfFrequencies = numberOfFrequencies;
+			arg -> gain1 = gain1 -> z [1];
+			arg -> gain2 = gain2 -> z [1];
+			arg -> gain3 = gain3 ? gain3 -> z [1] : nullptr;
+			arg -> dt = dt;
+			arg -> df = df;
+			NUMfft_Table_init (& arg -> fourierTable, nfft);
+			arg -> data = NUMvector <double> (1, nfft);
 		}
+		MelderThread_run (EEG_processChannels, args, numberOfThreads);
 	} catch (MelderError) {
 		Melder_throw (me, U": not filtered.");
 	}
@@ -472,6 +737,15 @@ void EEG_setExternalElectrodeNames (EEG me,
 	EEG_setChannelName (me, firstExternalElectrode + 7, nameExg8);
 }
 
+static void EEG_subtractFromChannels (EEG me, long numberOfChannels, const double *reference) {
+	if (numberOfChannels < 1) return;
+	autoEEG_ChannelArgs args [16];
+	int numberOfThreads = EEG_createChannelArgs (me, EEG_CHANNELS_SUBTRACT, numberOfChannels, my sound -> nx, args);
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++)
+		args [ithread - 1] -> reference = reference;
+	MelderThread_run (EEG_processChannels, args, numberOfThreads);
+}
+
 void EEG_subtractReference (EEG me, const char32 *channelNumber1_text, const char32 *channelNumber2_text) {
 	long channelNumber1 = EEG_getChannelNumber (me, channelNumber1_text);
 	if (channelNumber1 == 0)
@@ -480,13 +754,12 @@ void EEG_subtractReference (EEG me, const char32 *channelNumber1_text, const cha
 	if (channelNumber2 == 0 && channelNumber2_text [0] != '\0')
 		Melder_throw (me, U": no channel named \"", channelNumber2_text, U"\".");
 	const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
+	autoNUMvector <double> reference (1, my sound -> nx);
+	double *ref1 = my sound -> z [channelNumber1], *ref2 = channelNumber2 == 0 ? nullptr : my sound -> z [channelNumber2];
 	for (long isamp = 1; isamp <= my sound -> nx; isamp ++) {
-		double referenceValue = channelNumber2 == 0 ? my sound -> z [channelNumber1] [isamp] :
-			0.5 * (my sound -> z [channelNumber1] [isamp] + my sound -> z [channelNumber2] [isamp]);
-		for (long ichan = 1; ichan <= numberOfElectrodeChannels; ichan ++) {
-			my sound -> z [ichan] [isamp] -= referenceValue;
-		}
+		reference [isamp] = ref2 ? 0.5 * (ref1 [isamp] + ref2 [isamp]) : ref1 [isamp];
 	}
+	EEG_subtractFromChannels (me, numberOfElectrodeChannels, reference.peek());
 }
 
 void EEG_subtractMeanChannel (EEG me, long fromChannel, long toChannel) {
@@ -497,16 +770,20 @@ void EEG_subtractMeanChannel (EEG me, long fromChannel, long toChannel) {
 	if (fromChannel > toChannel)
 		Melder_throw (U"Channel range cannot run from ", fromChannel, U" to ", toChannel, U". Please reverse.");
 	const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
-	for (long isamp = 1; isamp <= my sound -> nx; isamp ++) {
-		double referenceValue = 0.0;
-		for (long ichan = fromChannel; ichan <= toChannel; ichan ++) {
-			referenceValue += my sound -> z [ichan] [isamp];
-		}
-		referenceValue /= (toChannel - fromChannel + 1);
-		for (long ichan = 1; ichan <= numberOfElectrodeChannels; ichan ++) {
-			my sound -> z [ichan] [isamp] -= referenceValue;
+	/*
+		Sum channel by channel, which adds up the values of each sample in the same order as sample by sample.
+	*/
+	autoNUMvector <double> reference (1, my sound -> nx);
+	for (long ichan = fromChannel; ichan <= toChannel; ichan ++) {
+		const double *channel = my sound -> z [ichan];
+		for (long isamp = 1; isamp <= my sound -> nx; isamp ++) {
+			reference [isamp] += channel [isamp];
 		}
 	}
+	for (long isamp = 1; isamp <= my sound -> nx; isamp ++) {
+		reference [isamp] /= (toChannel - fromChannel + 1);
+	}
+	EEG_subtractFromChannels (me, numberOfElectrodeChannels, reference.peek());
 }
 
 void EEG_setChannelToZero (EEG me, long channelNumber) {
@@ -27,6 +27,15 @@
 autoEEG EEG_create (double tmin, double tmax);
 
 autoEEG EEG_readFromBdfFile (MelderFile file);
+autoEEG EEG_readFromBdfFile_part (MelderFile file, double fromTime, double toTime, const char32 *channelRanges);
+/*
+	Reads only the data records that overlap the time range, and decodes only the channels
+	in the ranges (e.g. "1:16 33:40"); the status channel is always included, as the last channel.
+	Every channel has to remain the same kind of channel (cap electrode, external electrode or extra sensor)
+	among the channels read as in the whole file, because an EEG object tells these kinds apart by their number only.
+	The times of the part are preserved. If toTime <= fromTime, the whole time domain is read;
+	if channelRanges is empty, all channels are read.
+*/
 
 autoEEG EEGs_concatenate (OrderedOf<structEEG>* me);
 
@@ -164,6 +164,21 @@ DO
 	}
 END2 }
 
+FORM (EEG_readFromBdfFile_part, U"Read EEG from BDF/EDF file (part)", nullptr) {
+	LABEL (U"", U"BDF or EDF file:")
+	TEXTFIELD (U"File", U"")
+	SENTENCE (U"Channels", U"1:32")
+	REAL (U"left Time range (s)", U"0.0")
+	REAL (U"right Time range (s)", U"60.0")
+	OK2
+DO
+	structMelderFile file = { 0 };
+	Melder_relativePathToFile (GET_STRING (U"File"), & file);
+	autoEEG me = EEG_readFromBdfFile_part (& file,
+		GET_REAL (U"left Time range"), GET_REAL (U"right Time range"), GET_STRING (U"Channels"));
+	praat_new (me.move(), MelderFile_name (& file));
+END2 }
+
 FORM (EEG_removeTriggers, U"Remove triggers", nullptr) {
 	OPTIONMENU_ENUM (U"Remove every trigger that...", kMelder_string, DEFAULT)
 	SENTENCE (U"...the text", U"hi")
@@ -807,6 +822,8 @@ void praat_EEG_init () {
 
 	Data_recognizeFileType (bdfFileRecognizer);
 
+	praat_addMenuCommand (U"Objects", U"Open", U"Read EEG from BDF/EDF file (part)...", nullptr, 0, DO_EEG_readFromBdfFile_part);
+
 	praat_addAction1 (classEEG, 0, U"EEG help", nullptr, 0, DO_EEG_help);
 	praat_addAction1 (classEEG, 1, U"View & Edit", nullptr, praat_ATTRACTIVE | praat_NO_API, DO_EEG_viewAndEdit);
 	praat_addAction1 (classEEG, 0, U"Query -", nullptr, 0, nullptr);
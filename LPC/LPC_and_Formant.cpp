@@ -25,6 +25,8 @@
 #include "LPC_and_Formant.h"
 #include "LPC_and_Polynomial.h"
 #include "NUM2.h"
+#include "NUMmachar.h"
+#include "MelderThread.h"
 
 void Formant_Frame_init (Formant_Frame me, long nFormants) {
 	my nFormants = nFormants;
@@ -40,14 +42,8 @@ void Formant_Frame_scale (Formant_Frame me, double scale) {
 	}
 }
 
-void Roots_into_Formant_Frame (Roots me, Formant_Frame thee, double samplingFrequency, double margin) {
-	long n = my max - my min + 1;
-	autoNUMvector<double> fc (1, n);
-	autoNUMvector<double> bc (1, n);
-
-	// Determine the formants and bandwidths
-
-	thy nFormants = 0;
+static long Roots_getFormants (Roots me, double samplingFrequency, double margin, double *fc, double *bc) {
+	long numberOfFormants = 0;
 	double fLow = margin, fHigh = samplingFrequency / 2 - margin;
 	for (long i = my min; i <= my max; i++) {
 		if (my v[i].im < 0) {
@@ -57,11 +53,22 @@ void Roots_into_Formant_Frame (Roots me, Formant_Frame thee, double samplingFreq
 		if (f >= fLow && f <= fHigh) {
 			/*b = - log (my v[i].re * my v[i].re + my v[i].im * my v[i].im) * samplingFrequency / 2 / NUMpi;*/
 			double b = - log (dcomplex_abs (my v[i])) * samplingFrequency / NUMpi;
-			thy nFormants++;
-			fc[thy nFormants] = f;
-			bc[thy nFormants] = b;
+			numberOfFormants++;
+			fc[numberOfFormants] = f;
+			bc[numberOfFormants] = b;
 		}
 	}
+	return numberOfFormants;
+}
+
+void Roots_into_Formant_Frame (Roots me, Formant_Frame thee, double samplingFrequency, double margin) {
+	long n = my max - my min + 1;
+	autoNUMvector<double> fc (1, n);
+	autoNUMvector<double> bc (1, n);
+
+	// Determine the formants and bandwidths
+
+	thy nFormants = Roots_getFormants (me, samplingFrequency, margin, fc.peek(), bc.peek());
 
 	Formant_Frame_init (thee, thy nFormants);
 
@@ -83,11 +90,267 @@ void LPC_Frame_into_Formant_Frame (LPC_Frame me, Formant_Frame thee, double samp
 	Roots_into_Formant_Frame (r.get(), thee, 1 / samplingPeriod, margin);
 }
 
+/*
+	Aberth-Ehrlich iteration for all the roots z[1..n] of c[1] + c[2] x + ... + c[n+1] x^n at the same time,
+	starting from the values in z. Every root is repelled by the others, so that
+	two approximations cannot converge to the same root.
+	Returns false if the iteration does not converge within maxit steps.
+*/
+static bool NUMpolynomial_aberth (const double *c, long n, dcomplex *z, long maxit) {
+	for (long iter = 1; iter <= maxit; iter++) {
+		double maximumCorrection = 0.0;
+		for (long i = 1; i <= n; i++) {
+			double x = z[i].re, y = z[i].im;
+			double pr = c[n + 1], pi = 0.0, dpr = 0.0, dpi = 0.0;
+			for (long k = n; k > 0; k--) {
+				double tr = dpr;
+				dpr = dpr * x - dpi * y + pr;
+				dpi = tr * y + dpi * x + pi;
+				tr = pr;
+				pr = pr * x - pi * y + c[k];
+				pi = tr * y + pi * x;
+			}
+			if (pr == 0.0 && pi == 0.0) {
+				continue;   // an exact root
+			}
+			double dp2 = dpr * dpr + dpi * dpi;
+			if (dp2 == 0.0) {
+				return false;
+			}
+			double ratioRe = (pr * dpr + pi * dpi) / dp2, ratioIm = (pi * dpr - pr * dpi) / dp2;   // p / p'
+			double sumRe = 0.0, sumIm = 0.0;   // sum of 1 / (z[i] - z[j])
+			for (long j = 1; j <= n; j++) {
+				if (j == i) {
+					continue;
+				}
+				double dx = x - z[j].re, dy = y - z[j].im, d2 = dx * dx + dy * dy;
+				if (d2 == 0.0) {
+					return false;
+				}
+				sumRe += dx / d2;
+				sumIm -= dy / d2;
+			}
+			double qRe = 1.0 - (ratioRe * sumRe - ratioIm * sumIm), qIm = - (ratioRe * sumIm + ratioIm * sumRe);
+			double q2 = qRe * qRe + qIm * qIm;
+			if (q2 == 0.0) {
+				return false;
+			}
+			double wRe = (ratioRe * qRe + ratioIm * qIm) / q2, wIm = (ratioIm * qRe - ratioRe * qIm) / q2;
+			z[i].re -= wRe;
+			z[i].im -= wIm;
+			double correction = sqrt (wRe * wRe + wIm * wIm) / (sqrt (x * x + y * y) + 1e-3);
+			if (! (correction <= 1e300)) {
+				return false;   // NaN or overflow
+			}
+			if (correction > maximumCorrection) {
+				maximumCorrection = correction;
+			}
+		}
+		if (maximumCorrection < 1e-11) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	The Aberth iteration also stops with small corrections near a multiple root, and for x^n
+	its approximations shrink towards zero at the angles of the starting circle.
+	Accept the roots z[1..n] only if they are simple, i.e. no two of them are closer than 1e-6,
+	and if |p (z)| is small compared with the sum of the absolute values of the terms of p (z).
+*/
+static bool NUMpolynomial_rootsAreSimple (const double *c, long n, const dcomplex *z) {
+	for (long i = 1; i <= n; i++) {
+		double x = z[i].re, y = z[i].im, absz = sqrt (x * x + y * y);
+		double pr = c[n + 1], pi = 0.0, scale = fabs (c[n + 1]);
+		for (long k = n; k > 0; k--) {
+			double tr = pr;
+			pr = pr * x - pi * y + c[k];
+			pi = tr * y + pi * x;
+			scale = scale * absz + fabs (c[k]);
+		}
+		if (! (sqrt (pr * pr + pi * pi) <= 1e-6 * scale)) {
+			return false;
+		}
+		for (long j = i + 1; j <= n; j++) {
+			double dx = x - z[j].re, dy = y - z[j].im;
+			if (dx * dx + dy * dy < 1e-12) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*
+	Make the roots found by the Aberth iteration look like the eigenvalues of the companion matrix:
+	real roots get an imaginary part of exactly zero, and complex roots come in exact conjugate pairs,
+	the one with the positive imaginary part first. Fails if a complex root has no partner,
+	or if the roots don't add up to the sum given by the polynomial.
+*/
+static bool NUMpolynomial_pairRoots (const double *c, long n, dcomplex *z, dcomplex *work) {
+	long nwork = 0;
+	double sumRe = 0.0, sumAbs = 0.0;
+	for (long i = 1; i <= n; i++) {
+		double absz = dcomplex_abs (z[i]);
+		sumRe += z[i].re;
+		sumAbs += absz;
+		if (fabs (z[i].im) <= 1e-9 * absz) {
+			z[i].im = 0.0;
+		}
+	}
+	if (fabs (sumRe + c[n] / c[n + 1]) > 1e-8 * (sumAbs + 1.0)) {
+		return false;
+	}
+	for (long i = 1; i <= n; i++) {
+		if (z[i].im <= 0.0) {
+			continue;
+		}
+		long partner = 0;
+		double minimumDistance = 1e308;
+		for (long j = 1; j <= n; j++) {
+			if (z[j].im < 0.0) {
+				double dx = z[j].re - z[i].re, dy = z[j].im + z[i].im, distance = dx * dx + dy * dy;
+				if (distance < minimumDistance) {
+					minimumDistance = distance;
+					partner = j;
+				}
+			}
+		}
+		if (partner == 0 || sqrt (minimumDistance) > 1e-7 * (dcomplex_abs (z[i]) + 1e-3)) {
+			return false;
+		}
+		double re = 0.5 * (z[i].re + z[partner].re), im = 0.5 * (z[i].im - z[partner].im);
+		work[++ nwork] = dcomplex_create (re, im);
+		work[++ nwork] = dcomplex_create (re, - im);
+		z[partner].im = 0.0;
+		z[partner].re = NUMundefined;   // taken
+	}
+	for (long i = 1; i <= n; i++) {
+		if (z[i].im == 0.0 && NUMdefined (z[i].re)) {
+			work[++ nwork] = z[i];
+		}
+	}
+	if (nwork != n) {
+		return false;
+	}
+	for (long i = 1; i <= n; i++) {
+		z[i] = work[i];
+	}
+	return true;
+}
+
+/*
+	The frames are divided into blocks of LPC_to_Formant_BLOCK_SIZE frames, and the threads get whole blocks.
+	Within a block, the Aberth iteration for a frame starts from the roots of the previous frame;
+	the first frame of a block starts from a circle. Hence the result does not depend on the number of threads.
+	The roots are then polished, fixed into the unit circle and converted to formants
+	exactly as in LPC_Frame_into_Formant_Frame.
+	Frames for which the iteration fails are marked, and redone afterwards in the main thread
+	by LPC_Frame_into_Formant_Frame, i.e. with the eigenvalues of the companion matrix
+	(NUMlapack_dhseqr keeps its state in static variables, so it cannot be called from several threads at a time).
+*/
+#define LPC_to_Formant_BLOCK_SIZE  32
+
+Thing_define (LPC_to_Formant_Args, Thing) {
+	LPC lpc;
+	long firstFrame, lastFrame;
+	double samplingFrequency, margin;
+	long *numberOfFormants;   // [1..lpc -> nx]; -1 if the frame has to be redone
+	double **frequencies, **bandwidths;   // [1..lpc -> nx] [1..lpc -> maxnCoefficients]
+	autoPolynomial polynomial;
+	autoRoots roots;
+	dcomplex *z, *previousRoots, *work;   // [1..lpc -> maxnCoefficients]
+	bool isMainThread;
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (LPC_to_Formant_Args, Thing, 0);
+
+void structLPC_to_Formant_Args :: v_destroy () noexcept {
+	NUMvector_free <dcomplex> (z, 1);
+	NUMvector_free <dcomplex> (previousRoots, 1);
+	NUMvector_free <dcomplex> (work, 1);
+	LPC_to_Formant_Args_Parent :: v_destroy ();
+}
+
+static MelderThread_RETURN_TYPE LPC_to_Formant_frames (LPC_to_Formant_Args me) {
+	LPC lpc = my lpc;
+	Polynomial p = my polynomial.get();
+	Roots r = my roots.get();
+	long previousDegree = 0;
+	for (long iframe = my firstFrame; iframe <= my lastFrame; iframe++) {
+		LPC_Frame frame = & lpc -> d_frames[iframe];
+		long degree = frame -> nCoefficients;
+		if ((iframe - 1) % LPC_to_Formant_BLOCK_SIZE == 0) {
+			previousDegree = 0;
+		}
+		if (degree == 0) {
+			my numberOfFormants[iframe] = 0;
+			previousDegree = 0;
+			continue;
+		}
+		p -> numberOfCoefficients = degree + 1;
+		for (long i = 1; i <= degree; i++) {
+			p -> coefficients[i] = frame -> a[degree - i + 1];
+		}
+		p -> coefficients[degree + 1] = 1.0;
+		if (p -> coefficients[1] == 0.0) {   // a root at zero, e.g. all coefficients zero for a silent frame
+			my numberOfFormants[iframe] = -1;
+			previousDegree = 0;
+			continue;
+		}
+
+		bool converged = false;
+		if (degree == previousDegree) {
+			for (long i = 1; i <= degree; i++) {
+				my z[i] = my previousRoots[i];
+			}
+			converged = NUMpolynomial_aberth (p -> coefficients, degree, my z, 20) &&
+				NUMpolynomial_rootsAreSimple (p -> coefficients, degree, my z) &&
+				NUMpolynomial_pairRoots (p -> coefficients, degree, my z, my work);
+		}
+		if (! converged) {
+			double radius = fabs (p -> coefficients[1]) > 0.0 ? pow (fabs (p -> coefficients[1]), 1.0 / degree) : 0.5;
+			for (long i = 1; i <= degree; i++) {
+				double phi = 2.0 * NUMpi * (i - 1) / degree + 0.4;
+				my z[i] = dcomplex_create (radius * cos (phi), radius * sin (phi));
+			}
+			converged = NUMpolynomial_aberth (p -> coefficients, degree, my z, 100) &&
+				NUMpolynomial_rootsAreSimple (p -> coefficients, degree, my z) &&
+				NUMpolynomial_pairRoots (p -> coefficients, degree, my z, my work);
+		}
+		if (! converged) {
+			my numberOfFormants[iframe] = -1;
+			previousDegree = 0;
+			continue;
+		}
+		r -> max = degree;
+		for (long i = 1; i <= degree; i++) {
+			r -> v[i] = my z[i];
+		}
+		Roots_and_Polynomial_polish (r, p);
+		for (long i = 1; i <= degree; i++) {
+			my previousRoots[i] = r -> v[i];
+		}
+		previousDegree = degree;
+		Roots_fixIntoUnitCircle (r);
+		my numberOfFormants[iframe] = Roots_getFormants (r, my samplingFrequency, my margin, my frequencies[iframe], my bandwidths[iframe]);
+
+		if (my isMainThread && (iframe - my firstFrame) % 100 == 99) {
+			Melder_progress ((double) (iframe - my firstFrame) / (my lastFrame - my firstFrame + 1),
+				U"LPC to Formant: frame ", iframe - my firstFrame + 1, U" out of ", my lastFrame - my firstFrame + 1, U".");
+		}
+	}
+	MelderThread_RETURN;
+}
+
 autoFormant LPC_to_Formant (LPC me, double margin) {
 	try {
 		double samplingFrequency = 1.0 / my samplingPeriod;
 		long nmax = my maxnCoefficients, err = 0;
-		long interval = nmax > 20 ? 1 : 10;
 
 		if (nmax > 99) {
 			Melder_throw (U"We cannot find the roots of a polynomial of order > 99.");
@@ -97,25 +360,71 @@ autoFormant LPC_to_Formant (LPC me, double margin) {
 		}
 
 		autoFormant thee = Formant_create (my xmin, my xmax, my nx, my dx, my x1, (nmax + 1) / 2);
+		if (nmax < 1) {
+			for (long i = 1; i <= my nx; i++) {
+				thy d_frames[i].intensity = my d_frames[i].gain;
+			}
+			return thee;
+		}
 
 		autoMelderProgress progress (U"LPC to Formant");
 
+		if (! NUMfpp) {
+			NUMmachar ();   // before the threads use it
+		}
+		autoNUMvector<long> numberOfFormants (1, my nx);
+		autoNUMmatrix<double> frequencies (1, my nx, 1, nmax);
+		autoNUMmatrix<double> bandwidths (1, my nx, 1, nmax);
+		long numberOfBlocks = (my nx - 1) / LPC_to_Formant_BLOCK_SIZE + 1;
+		int numberOfThreads = MelderThread_getNumberOfProcessors ();
+		if (numberOfThreads > 16) numberOfThreads = 16;
+		if (numberOfThreads > numberOfBlocks) numberOfThreads = numberOfBlocks;
+		if (numberOfThreads < 1) numberOfThreads = 1;
+		autoLPC_to_Formant_Args args [16];
+		long firstBlock = 1;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread++) {
+			autoLPC_to_Formant_Args arg = Thing_new (LPC_to_Formant_Args);
+			long lastBlock = ithread == numberOfThreads ? numberOfBlocks : numberOfBlocks * ithread / numberOfThreads;
+			arg -> lpc = me;
+			arg -> firstFrame = (firstBlock - 1) * LPC_to_Formant_BLOCK_SIZE + 1;
+			arg -> lastFrame = lastBlock * LPC_to_Formant_BLOCK_SIZE < my nx ? lastBlock * LPC_to_Formant_BLOCK_SIZE : my nx;
+			arg -> samplingFrequency = samplingFrequency;
+			arg -> margin = margin;
+			arg -> numberOfFormants = numberOfFormants.peek();
+			arg -> frequencies = frequencies.peek();
+			arg -> bandwidths = bandwidths.peek();
+			arg -> polynomial = Polynomial_create (-1, 1, nmax);
+			arg -> roots = Roots_create (nmax);
+			arg -> z = NUMvector<dcomplex> (1, nmax);
+			arg -> previousRoots = NUMvector<dcomplex> (1, nmax);
+			arg -> work = NUMvector<dcomplex> (1, nmax);
+			arg -> isMainThread = ithread == numberOfThreads;
+			firstBlock = lastBlock + 1;
+			args[ithread - 1] = arg.move();
+		}
+		MelderThread_run (LPC_to_Formant_frames, args, numberOfThreads);
+
 		for (long i = 1; i <= my nx; i++) {
 			Formant_Frame formant = & thy d_frames[i];
 			LPC_Frame lpc = & my d_frames[i];
 
-			// Initialisation of Formant_Frame is taken care of in Roots_into_Formant_Frame!
-
-			try {
-				LPC_Frame_into_Formant_Frame (lpc, formant, my samplingPeriod, margin);
-			} catch (MelderError) {
-				Melder_clearError();
-				err++;
+			if (numberOfFormants[i] < 0) {
+				try {
+					LPC_Frame_into_Formant_Frame (lpc, formant, my samplingPeriod, margin);
+				} catch (MelderError) {
+					Melder_clearError();
+					err++;
+				}
+				continue;
 			}
-
-			if ( (interval == 1 || (i % interval) == 1)) {
-				Melder_progress ( (double) i / my nx, U"LPC to Formant: frame ", i,
-				                   U" out of ", my nx, U".");
+			formant -> intensity = lpc -> gain;
+			if (lpc -> nCoefficients == 0) {
+				continue;
+			}
+			Formant_Frame_init (formant, numberOfFormants[i]);
+			for (long j = 1; j <= formant -> nFormants; j++) {
+				formant -> formant[j].frequency = frequencies[i][j];
+				formant -> formant[j].bandwidth = bandwidths[i][j];
 			}
 		}
 
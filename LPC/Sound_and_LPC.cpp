@@ -30,6 +30,7 @@
 #include "Vector.h"
 #include "Spectrum.h"
 #include "NUM2.h"
+#include "MelderThread.h"
 
 #define LPC_METHOD_AUTO 1
 #define LPC_METHOD_COVAR 2
@@ -71,20 +72,60 @@ void LPC_Frame_and_Sound_filterInverse (LPC_Frame me, Sound thee, int channel) {
 	}
 }
 
-static int Sound_into_LPC_Frame_auto (Sound me, LPC_Frame thee) {
+/*
+	r[lag] = sum (j = max (jmin, lag + 1) .. n, x[j - lag] * x[j]), for lag = lag1..lag2.
+	Four lags are accumulated in a single pass over j, so that x[j] is loaded once for four independent sums.
+	Every sum is still taken in increasing order of j, so the values are exactly those of the one-lag-at-a-time loops.
+*/
+static void lagProducts (const double x[], long n, long jmin, long lag1, long lag2, double r[]) {
+	long lag = lag1;
+	for (; lag + 3 <= lag2; lag += 4) {
+		double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+		long jcommon = jmin > lag + 4 ? jmin : lag + 4;   // from here on all four lags have terms
+		for (long k = 0; k < 4; k++) {
+			long jfirst = jmin > lag + k + 1 ? jmin : lag + k + 1;
+			for (long j = jfirst; j < jcommon && j <= n; j++) {
+				sum[k] += x[j - lag - k] * x[j];
+			}
+		}
+		double sum0 = sum[0], sum1 = sum[1], sum2 = sum[2], sum3 = sum[3];
+		const double *x0 = x - lag, *x1 = x - lag - 1, *x2 = x - lag - 2, *x3 = x - lag - 3;
+		for (long j = jcommon; j <= n; j++) {
+			double xj = x[j];
+			sum0 += x0[j] * xj;
+			sum1 += x1[j] * xj;
+			sum2 += x2[j] * xj;
+			sum3 += x3[j] * xj;
+		}
+		r[lag] = sum0;
+		r[lag + 1] = sum1;
+		r[lag + 2] = sum2;
+		r[lag + 3] = sum3;
+	}
+	for (; lag <= lag2; lag++) {
+		double sum = 0.0;
+		for (long j = jmin > lag + 1 ? jmin : lag + 1; j <= n; j++) {
+			sum += x[j - lag] * x[j];
+		}
+		r[lag] = sum;
+	}
+}
+
+/*
+	The frame kernels work on the windowed samples x[1..n] and take their vectors from work,
+	which the caller has zeroed and which has at least LPC_FRAME_WORK_SIZE (m) elements.
+*/
+#define LPC_FRAME_WORK_SIZE(m)  ((m) * ((m) + 1) / 2 + 5 * (m) + 3)
+
+static int Sound_into_LPC_Frame_auto (const double x[], long n, LPC_Frame thee, double work[]) {
 	long i = 1; // For error condition at end
 	long m = thy nCoefficients;
 
-	autoNUMvector<double> r (1, m + 1);
-	autoNUMvector<double> a (1, m + 1);
-	autoNUMvector<double> rc (1, m);
+	double *r = & work[0];   // r[1..m+1]
+	double *a = & work[m + 1];   // a[1..m+1]
+	double *rc = & work[m + 1 + m + 1];   // rc[1..m]
 
-	double  *x = my z[1];
-	for (i = 1; i <= m + 1; i++) {
-		for (long j = 1; j <= my nx - i + 1; j++) {
-			r[i] += x[j] * x[j + i - 1];
-		}
-	}
+	lagProducts (x, n, 1, 0, m, r + 1);   // r[i] is the autocorrelation at lag i - 1
 	if (r[1] == 0.0) {
 		i = 1; /* ! */ goto end;
 	}
@@ -128,22 +169,22 @@ end:
 	a = & work[m*(m+1)/2+m+1];
 	beta = & work [m+1)/2+m+m+1+1];
 	cc = & work[m+1)/2+m+m+1+m+1]
-	for (i=1; i<=m(m+1)/2+m+m+1+m+m+1;i++) work[i] = 0;
+	followed by phi[0..m], the products sum (j = m+1..n, x[j-i] x[j]) that cc[1] needs in step i
 */
-static int Sound_into_LPC_Frame_covar (Sound me, LPC_Frame thee) {
-	long i = 1, n = my nx, m = thy nCoefficients;
-	double *x = my z[1];
-
-	autoNUMvector<double> b (1, m * (m + 1) / 2);
-	autoNUMvector<double> grc (1, m);
-	autoNUMvector<double> a (1, m + 1);
-	autoNUMvector<double> beta (1, m);
-	autoNUMvector<double> cc (1, m + 1);
-
-	thy gain = 0.0;
+static int Sound_into_LPC_Frame_covar (const double x[], long n, LPC_Frame thee, double work[]) {
+	long i = 1, m = thy nCoefficients;
+
+	double *b = & work[0];   // b[1..m(m+1)/2]
+	double *grc = & work[m * (m + 1) / 2];   // grc[1..m]
+	double *a = & work[m * (m + 1) / 2 + m];   // a[1..m+1]
+	double *beta = & work[m * (m + 1) / 2 + m + m + 1];   // beta[1..m]
+	double *cc = & work[m * (m + 1) / 2 + m + m + 1 + m];   // cc[1..m+1]
+	double *phi = & work[m * (m + 1) / 2 + m + m + 1 + m + m + 1 + 1];   // phi[0..m]
+
+	lagProducts (x, n, m + 1, 0, m, phi);
+	thy gain = phi[0];
+	cc[1] = phi[1];
 	for (i = m + 1; i <= n; i++) {
-		thy gain += x[i] * x[i];
-		cc[1] += x[i] * x[i - 1];
 		cc[2] += x[i - 1] * x[i - 1];
 	}
 
@@ -162,10 +203,7 @@ static int Sound_into_LPC_Frame_covar (Sound me, LPC_Frame thee) {
 		for (long j = 1; j <= i; j++) {
 			cc[i - j + 2] = cc[i - j + 1] + x[m - i + 1] * x[m - i + j] - x[n - i + 1] * x[n - i + j];
 		}
-		cc[1] = 0.0;
-		for (long j = m + 1; j <= n; j++) {
-			cc[1] += x[j - i] * x[j]; /* 30 */
-		}
+		cc[1] = phi[i]; /* 30 */
 		b[i * (i + 1) / 2] = 1.0;
 		for (long j = 1; j <= i - 1; j++) { /* 70 */
 			double gam = 0.0;
@@ -223,27 +261,35 @@ end:
 	return 0; // Melder_warning ("Less coefficienst than asked for.");
 }
 
-static int Sound_into_LPC_Frame_burg (Sound me, LPC_Frame thee) {
-	int status = NUMburg (my z[1], my nx, thy a, thy nCoefficients, &thy gain);
-	thy gain *= my nx;
+/*
+	work[1..LPC_BURG_WORK_SIZE (n, m)], which NUMburg_nothrow uses for its vectors b1, b2 and aa.
+*/
+#define LPC_BURG_WORK_SIZE(n,m)  ((n) + (n) + (m))
+
+static int Sound_into_LPC_Frame_burg (double x[], long n, LPC_Frame thee, double work[]) {
+	int status = NUMburg_nothrow (x, n, thy a, thy nCoefficients, &thy gain, work);
+	thy gain *= n;
 	for (long i = 1; i <= thy nCoefficients; i++) {
 		thy a[i] = -thy a[i];
 	}
 	return status;
 }
 
-static int Sound_into_LPC_Frame_marple (Sound me, LPC_Frame thee, double tol1, double tol2) {
-	long m = 1, n = my nx, mmax = thy nCoefficients;
+/*
+	work[1..4*(mmax+1)]: c[1..mmax+1], d[1..mmax+1], r[1..mmax+1], and rx[0..mmax],
+	where rx[k] = sum (j = k+1..n, x[j-k] x[j]) are the lag products that the recursion needs.
+*/
+static int Sound_into_LPC_Frame_marple (const double x[], long n, LPC_Frame thee, double tol1, double tol2, double work[]) {
+	long m = 1, mmax = thy nCoefficients;
 	int status = 1;
-	double *a = thy a, *x = my z[1];
-
-	autoNUMvector<double> c (1, mmax + 1);
-	autoNUMvector<double> d (1, mmax + 1);
-	autoNUMvector<double> r (1, mmax + 1);
-	double e0 = 0.0;
-	for (long k = 1; k <= n; k++) {
-		e0 += x[k] * x[k];
-	}
+	double *a = thy a;
+
+	double *c = & work[0];   // c[1..mmax+1]
+	double *d = & work[mmax + 1];   // d[1..mmax+1]
+	double *r = & work[mmax + 1 + mmax + 1];   // r[1..mmax+1]
+	double *rx = & work[mmax + 1 + mmax + 1 + mmax + 1 + 1];   // rx[0..mmax]
+	lagProducts (x, n, 1, 0, mmax, rx);
+	double e0 = rx[0];
 	e0 *= 2.0;
 	if (e0 == 0.0) {
 		m = 0; thy gain *= 0.5; /* because e0 is twice the energy */
@@ -259,10 +305,7 @@ static int Sound_into_LPC_Frame_marple (Sound me, LPC_Frame thee, double tol1, d
 	q1 = 1.0 / thy gain;
 	c[1] = q1 * x[1];
 	d[1] = q1 * x[n];
-	double s1 = 0.0;
-	for (long k = 1; k <= n - 1; k++) {
-		s1 += x[k + 1] * x[k];
-	}
+	double s1 = rx[1];
 	r[1] = 2.0 * s1;
 	a[1] = - q1 * r[1];
 	thy gain *= (1.0 - a[1] * a[1]);
@@ -334,10 +377,7 @@ static int Sound_into_LPC_Frame_marple (Sound me, LPC_Frame thee, double tol1, d
 			r[k + 1] = r[k] - x[n + 1 - k] * c1 - x[k] * c2;
 			delta += r[k + 1] * a[k];
 		}
-		s1 = 0.0;
-		for (long k = 1; k <= n - m; k++) {
-			s1 += x[k + m] * x[k];
-		}
+		s1 = rx[m];
 		r[1] = 2.0 * s1;
 		delta += r[1];
 		q2 = - delta / thy gain;
@@ -368,10 +408,81 @@ end:
 	return status == 1 || status == 4 || status == 5;
 }
 
+/*
+	The frames are divided over the threads. Every thread has its own frame buffer and work space,
+	and the frames are independent, so the result does not depend on the number of threads.
+*/
+Thing_define (Sound_into_LPC_Args, Thing) {
+	Sound sound;   // the pre-emphasized copy
+	LPC lpc;
+	long firstFrame, lastFrame;
+	double windowDuration, *window;   // window[1..nsamp_window]
+	long nsamp_window;
+	int method;
+	double tol1, tol2;
+	double *x, *work;   // x[1..nsamp_window], work[1..LPC_FRAME_WORK_SIZE (lpc -> maxnCoefficients)] or, for Burg, work[1..LPC_BURG_WORK_SIZE (nsamp_window, lpc -> maxnCoefficients)]
+	bool isMainThread;
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (Sound_into_LPC_Args, Thing, 0);
+
+void structSound_into_LPC_Args :: v_destroy () noexcept {
+	NUMvector_free <double> (x, 1);
+	NUMvector_free <double> (work, 1);
+	Sound_into_LPC_Args_Parent :: v_destroy ();
+}
+
+static MelderThread_RETURN_TYPE Sound_into_LPC_frames (Sound_into_LPC_Args me) {
+	Sound sound = my sound;
+	LPC thee = my lpc;
+	double *x = my x, *window = my window, *z = sound -> z[1];
+	long n = my nsamp_window, workSize = LPC_FRAME_WORK_SIZE (thy maxnCoefficients);
+	for (long i = my firstFrame; i <= my lastFrame; i++) {
+		LPC_Frame lpcframe = (LPC_Frame) & thy d_frames[i];
+		double t = Sampled_indexToX (thee, i);
+		/*
+			As Sound_into_Sound, Vector_subtractMean and Sounds_multiply on a frame Sound, but in one buffer.
+		*/
+		long offset = Sampled_xToNearestIndex (sound, t - my windowDuration / 2) - 1;
+		double sum = 0.0;
+		for (long j = 1; j <= n; j++) {
+			long k = offset + j;
+			x[j] = k < 1 || k > sound -> nx ? 0 : z[k];
+			sum += x[j];
+		}
+		double mean = sum / n;
+		for (long j = 1; j <= n; j++) {
+			x[j] = (x[j] - mean) * window[j];
+		}
+		if (my method != LPC_METHOD_BURG) {
+			for (long j = 1; j <= workSize; j++) {
+				my work[j] = 0.0;
+			}
+		}
+		if (my method == LPC_METHOD_AUTO) {
+			(void) Sound_into_LPC_Frame_auto (x, n, lpcframe, my work);
+		} else if (my method == LPC_METHOD_COVAR) {
+			(void) Sound_into_LPC_Frame_covar (x, n, lpcframe, my work);
+		} else if (my method == LPC_METHOD_BURG) {
+			(void) Sound_into_LPC_Frame_burg (x, n, lpcframe, my work);
+		} else if (my method == LPC_METHOD_MARPLE) {
+			(void) Sound_into_LPC_Frame_marple (x, n, lpcframe, my tol1, my tol2, my work);
+		}
+		if (my isMainThread && (i - my firstFrame) % 10 == 0) {
+			Melder_progress ((double) (i - my firstFrame) / (my lastFrame - my firstFrame + 1),
+				U"LPC analysis of frame ", i - my firstFrame + 1, U" out of ", my lastFrame - my firstFrame + 1, U".");
+		}
+	}
+	MelderThread_RETURN;
+}
+
 static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidth, double dt, double preEmphasisFrequency, int method, double tol1, double tol2) {
 	double t1, samplingFrequency = 1.0 / my dx;
 	double windowDuration = 2 * analysisWidth; /* gaussian window */
-	long nFrames, frameErrorCount = 0;
+	long nFrames;
 
 	if (floor (windowDuration / my dx) < predictionOrder + 1) {
 		Melder_throw (U"Analysis window duration too short.\n For a prediction order of ", predictionOrder,
@@ -383,7 +494,6 @@ static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidt
 	}
 	Sampled_shortTermAnalysis (me, windowDuration, dt, & nFrames, & t1);
 	autoSound sound = Data_copy (me);
-	autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 	autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 	autoLPC thee = LPC_create (my xmin, my xmax, nFrames, dt, t1, predictionOrder, my dx);
 
@@ -394,33 +504,37 @@ static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidt
 	}
 
 	for (long i = 1; i <= nFrames; i++) {
-		LPC_Frame lpcframe = (LPC_Frame) & thy d_frames[i];
-		double t = Sampled_indexToX (thee.get(), i);
-		LPC_Frame_init (lpcframe, predictionOrder);
-		Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-		Vector_subtractMean (sframe.get());
-		Sounds_multiply (sframe.get(), window.get());
-		if (method == LPC_METHOD_AUTO) {
-			if (! Sound_into_LPC_Frame_auto (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_COVAR) {
-			if (! Sound_into_LPC_Frame_covar (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_BURG) {
-			if (! Sound_into_LPC_Frame_burg (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_MARPLE) {
-			if (! Sound_into_LPC_Frame_marple (sframe.get(), lpcframe, tol1, tol2)) {
-				frameErrorCount++;
-			}
-		}
-		if ((i % 10) == 1) {
-			Melder_progress ( (double) i / nFrames, U"LPC analysis of frame ", i, U" out of ", nFrames, U".");
-		}
-	}
+		LPC_Frame_init (& thy d_frames[i], predictionOrder);
+	}
+
+	long nsamp_window = window -> nx;
+	double numberOfOperations = (double) nFrames * nsamp_window * (predictionOrder + 1);
+	int numberOfThreads = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	if (numberOfThreads > numberOfOperations / 1e5) numberOfThreads = (int) (numberOfOperations / 1e5);
+	if (numberOfThreads > nFrames) numberOfThreads = (int) nFrames;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	autoSound_into_LPC_Args args [16];
+	long firstFrame = 1;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread++) {
+		autoSound_into_LPC_Args arg = Thing_new (Sound_into_LPC_Args);
+		arg -> sound = sound.get();
+		arg -> lpc = thee.get();
+		arg -> firstFrame = firstFrame;
+		arg -> lastFrame = ithread == numberOfThreads ? nFrames : nFrames * ithread / numberOfThreads;
+		arg -> windowDuration = windowDuration;
+		arg -> window = window -> z[1];
+		arg -> nsamp_window = nsamp_window;
+		arg -> method = method;
+		arg -> tol1 = tol1;
+		arg -> tol2 = tol2;
+		arg -> x = NUMvector <double> (1, nsamp_window);
+		arg -> work = NUMvector <double> (1, method == LPC_METHOD_BURG ? LPC_BURG_WORK_SIZE (nsamp_window, predictionOrder) : LPC_FRAME_WORK_SIZE (predictionOrder));
+		arg -> isMainThread = ithread == numberOfThreads;
+		firstFrame = arg -> lastFrame + 1;
+		args[ithread - 1] = arg.move();
+	}
+	MelderThread_run (Sound_into_LPC_frames, args, numberOfThreads);
 	return thee;
 }
 
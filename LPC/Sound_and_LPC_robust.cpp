@@ -33,10 +33,12 @@
 #include "SVD.h"
 #include "Vector.h"
 #include "NUM2.h"
+#include "NUMclapack.h"
+#include "MelderThread.h"
 
 struct huber_struct {
 	autoSound e;
-	double k, tol, tol_svd;
+	double k, tol;
 	long iter, itermax;
 	int wantlocation, wantscale;
 	double location, scale;
@@ -45,10 +47,13 @@ struct huber_struct {
 	double *a;
 	double **covar, *c;
 	autoSVD svd;
+	double *t;   // [1..p]
+	double *svdwork;   // [0..lsvdwork]
+	long lsvdwork;
 };
 
 static void huber_struct_init (struct huber_struct *hs, double windowDuration, long p, double samplingFrequency, double location, int wantlocation) {
-	hs -> w = hs -> work = hs -> a = hs -> c = nullptr;
+	hs -> w = hs -> work = hs -> a = hs -> c = hs -> t = hs -> svdwork = nullptr;
 	hs -> covar = nullptr;
 	hs -> svd = autoSVD();
 	hs -> e = Sound_createSimple (1, windowDuration, samplingFrequency);
@@ -61,6 +66,20 @@ static void huber_struct_init (struct huber_struct *hs, double windowDuration, l
 	hs -> covar = NUMmatrix<double> (1, p, 1, p);
 	hs -> c = NUMvector<double> (1, p);
 	hs -> svd = SVD_create (p, p);
+	hs -> t = NUMvector<double> (1, p);
+	/*
+		Ask NUMlapack_dgesvd how much work space a p by p problem needs (see SVD_compute).
+	*/
+	char jobu = 'S', jobvt = 'O';
+	long lda = p, lwork = -1, info;
+	double wt[2];
+	SVD svd = hs -> svd.get();
+	(void) NUMlapack_dgesvd (& jobu, & jobvt, & p, & p, & svd -> u[1][1], & lda, & svd -> d[1], & svd -> v[1][1], & lda, nullptr, & lda, wt, & lwork, & info);
+	if (info != 0) {
+		Melder_throw (U"SVD work space not determined.");
+	}
+	hs -> lsvdwork = (long) wt[0];
+	hs -> svdwork = NUMvector<double> (0, hs -> lsvdwork);
 	hs -> wantlocation = wantlocation;
 	if (! wantlocation) {
 		hs -> location = location;
@@ -76,6 +95,8 @@ static void huber_struct_destroy (struct huber_struct *hs) {
 	NUMvector_free<double> (hs -> a, 1);
 	NUMmatrix_free<double> (hs -> covar, 1, 1);
 	NUMvector_free<double> (hs -> c, 1);
+	NUMvector_free<double> (hs -> t, 1);
+	NUMvector_free<double> (hs -> svdwork, 0);
 }
 
 static void huber_struct_getWeights (struct huber_struct *hs, double *e) {
@@ -88,46 +109,109 @@ static void huber_struct_getWeights (struct huber_struct *hs, double *e) {
 	}
 }
 
+/*
+	covar[i][j] = sum (k = p+1..n, s[k-j] s[k-i] w[k]) and c[i] = - sum (k = p+1..n, s[k-i] s[k] w[k]).
+	The elements of a row are accumulated four at a time in a single pass over k,
+	so that s[k-i] and w[k] are loaded once for four independent sums that the processor can compute side by side.
+	Each sum is still taken in the order of k, with the products in the same order as before,
+	because a frame with a nearly silent half has an ill-conditioned covariance matrix
+	and would otherwise change visibly by rounding alone.
+*/
 static void huber_struct_getWeightedCovars (struct huber_struct *hs, double *s) {
 	long p = hs -> p, n = hs -> n;
 	double *w = hs -> w, **covar = hs -> covar, *c = hs -> c;
 
 	for (long i = 1; i <= p; i++) {
-		for (long j = i; j <= p; j++) {
-			double tmp = 0;
+		const double *si = s - i;
+		long j = i;
+		for (; j + 3 <= p; j += 4) {
+			const double *s0 = s - j, *s1 = s - j - 1, *s2 = s - j - 2, *s3 = s - j - 3;
+			double tmp0 = 0.0, tmp1 = 0.0, tmp2 = 0.0, tmp3 = 0.0;
 			for (long k = p + 1; k <= n; k++) {
-				tmp += s[k - j] * s[k - i] * w[k];
+				double sik = si[k], wk = w[k];
+				tmp0 += s0[k] * sik * wk;
+				tmp1 += s1[k] * sik * wk;
+				tmp2 += s2[k] * sik * wk;
+				tmp3 += s3[k] * sik * wk;
+			}
+			covar[i][j] = covar[j][i] = tmp0;
+			covar[i][j + 1] = covar[j + 1][i] = tmp1;
+			covar[i][j + 2] = covar[j + 2][i] = tmp2;
+			covar[i][j + 3] = covar[j + 3][i] = tmp3;
+		}
+		for (; j <= p; j++) {
+			double tmp = 0.0;
+			for (long k = p + 1; k <= n; k++) {
+				tmp += s[k - j] * si[k] * w[k];
 			}
 			covar[i][j] = covar[j][i] = tmp;
 		}
 
-		double tmp = 0;
+		double tmp = 0.0;
 		for (long k = p + 1; k <= n; k++) {
-			tmp += s[k - i] * s[k] * w[k];
+			tmp += si[k] * s[k] * w[k];
 		}
 		c[i] = -tmp;
 	}
 }
 
-static void huber_struct_solvelpc (struct huber_struct *hs) {
+MelderThread_MUTEX (huber_mutex);
+static bool huber_mutex_inited;
+
+/*
+	Solve covar a = c for the first p rows and columns, as SVD_compute and SVD_solve would do,
+	but in the work space of the huber_struct, so that several threads can each solve their own frames.
+	Returns false if the SVD could not be computed.
+*/
+static bool huber_struct_solvelpc (struct huber_struct *hs) {
 	SVD me = hs -> svd.get();
-	double **covar = hs -> covar;
+	double **covar = hs -> covar, *c = hs -> c, *a = hs -> a, *t = hs -> t;
+	long p = hs -> p, lda = my numberOfColumns, lwork = hs -> lsvdwork, info;
+	char jobu = 'S', jobvt = 'O';
 
-	for (long i = 1; i <= my numberOfRows; i++) {
-		for (long j = 1; j <= my numberOfColumns; j++) {
+	for (long i = 1; i <= p; i++) {
+		for (long j = 1; j <= p; j++) {
 			my u[i][j] = covar[i][j];
 		}
 	}
+	{// scope
+		MelderThread_LOCK (huber_mutex);   // NUMlapack_dgesvd keeps its state in static variables
+		(void) NUMlapack_dgesvd (& jobu, & jobvt, & p, & p, & my u[1][1], & lda, & my d[1], & my v[1][1], & lda, nullptr, & lda, hs -> svdwork, & lwork, & info);
+		MelderThread_UNLOCK (huber_mutex);
+	}
+	if (info != 0) {
+		return false;
+	}
 
-	SVD_setTolerance (me, hs -> tol_svd);
-	SVD_compute (me);
-
-	//long nzeros = SVD_zeroSmallSingularValues (me, 0);
-
-	SVD_solve (me, hs -> c, hs -> a);
+	/*
+		x = V D^-1 U' c; the row vectors of v are still those of V' here.
+	*/
+	for (long j = 1; j <= p; j++) {
+		double tmp = 0.0;
+		if (my d[j] > 0.0) {
+			for (long i = 1; i <= p; i++) {
+				tmp += my u[i][j] * c[i];
+			}
+			tmp /= my d[j];
+		}
+		t[j] = tmp;
+	}
+	for (long j = 1; j <= p; j++) {
+		double tmp = 0.0;
+		for (long i = 1; i <= p; i++) {
+			tmp += my v[i][j] * t[i];
+		}
+		a[j] = tmp;
+	}
+	return true;
 }
 
-void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs) {
+/*
+	Returns false if the frame could not be optimised: either the scale of the residual is zero,
+	in which case him keeps the coefficients of the last iteration,
+	or the SVD failed, in which case him gets the starting coefficients of me.
+*/
+static bool LPC_Frames_and_Sound_huber_nothrow (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs) {
 	long p = my nCoefficients > his nCoefficients ? his nCoefficients : my nCoefficients;
 	long n = hs -> e -> nx > thy nx ? thy nx : hs -> e -> nx;
 	double *e = hs -> e -> z[1], *s = thy z[1];
@@ -138,28 +222,34 @@ void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct
 
 	double s0;
 	do {
-		Sound hse = hs -> e.get();
-		for (long i = 1; i <= thy nx; i++) {
-			hse -> z[1][i] = thy z[1][i];
+		/*
+			The inverse filtered signal, as LPC_Frame_and_Sound_filterInverse would compute it from a copy of s.
+		*/
+		for (long i = 1; i <= n; i++) {
+			double ei = s[i];
+			long m = i - 1 < his nCoefficients ? i - 1 : his nCoefficients;
+			for (long j = 1; j <= m; j++) {
+				ei += his a[j] * s[i - j];
+			}
+			e[i] = ei;
 		}
-		LPC_Frame_and_Sound_filterInverse (him, hse, 1);
 
 		s0 = hs -> scale;
 
-		NUMstatistics_huber (e, n, & (hs -> location), hs -> wantlocation, & (hs -> scale), hs -> wantscale, hs -> k, hs -> tol, hs -> work);
+		if (! NUMstatistics_huber_nothrow (e, n, & (hs -> location), hs -> wantlocation, & (hs -> scale), hs -> wantscale, hs -> k, hs -> tol, hs -> work)) {
+			return false;
+		}
 
 		huber_struct_getWeights (hs, e);
 		huber_struct_getWeightedCovars (hs, s);
 
 		// Solve C a = [-] c */
-		try {
-			huber_struct_solvelpc (hs);
-		} catch (MelderError) {
+		if (! huber_struct_solvelpc (hs)) {
 			// Copy the starting lpc coeffs */
 			for (long i = 1; i <= p; i++) {
 				his a[i] = my a[i];
 			}
-			throw MelderError();
+			return false;
 		}
 		for (long i = 1; i <= p; i++) {
 			his a[i] = hs -> a[i];
@@ -167,6 +257,17 @@ void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct
 
 		(hs -> iter) ++;
 	} while ( (hs -> iter < hs -> itermax) && (fabs (s0 - hs -> scale) > hs -> tol * s0));
+	return true;
+}
+
+void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs) {
+	if (! huber_mutex_inited) {
+		MelderThread_MUTEX_INIT (huber_mutex);
+		huber_mutex_inited = true;
+	}
+	if (! LPC_Frames_and_Sound_huber_nothrow (me, thee, him, hs)) {
+		Melder_throw (U"LPC frame could not be optimised.");
+	}
 }
 
 #if 0
@@ -181,12 +282,61 @@ void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct
 	double **covar, *c;
 	autoSVD svd;
 #endif
-	
+
+/*
+	Every thread has its own huber_struct and its own frame buffer, all allocated in the main thread.
+	The frames are independent, so the result does not depend on the number of threads.
+*/
+Thing_define (LPC_and_Sound_into_LPC_robust_Args, Thing) {
+	LPC lpc, result;
+	Sound sound, window;
+	autoSound sframe;
+	double windowDuration;
+	long firstFrame, lastFrame;
+	struct huber_struct hs;
+	long numberOfIterations, frameErrorCount;
+	bool isMainThread;
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (LPC_and_Sound_into_LPC_robust_Args, Thing, 0);
+
+void structLPC_and_Sound_into_LPC_robust_Args :: v_destroy () noexcept {
+	huber_struct_destroy (& hs);
+	LPC_and_Sound_into_LPC_robust_Args_Parent :: v_destroy ();
+}
+
+static MelderThread_RETURN_TYPE LPC_and_Sound_into_LPC_robust_frames (LPC_and_Sound_into_LPC_robust_Args me) {
+	Sound sframe = my sframe.get();
+	for (long i = my firstFrame; i <= my lastFrame; i++) {
+		LPC_Frame lpc = (LPC_Frame) & my lpc -> d_frames[i];
+		LPC_Frame lpcto = (LPC_Frame) & my result -> d_frames[i];
+		double t = Sampled_indexToX (my lpc, i);
+
+		Sound_into_Sound (my sound, sframe, t - my windowDuration / 2);
+		Vector_subtractMean (sframe);
+		Sounds_multiply (sframe, my window);
+
+		if (! LPC_Frames_and_Sound_huber_nothrow (lpc, sframe, lpcto, & my hs)) {
+			my frameErrorCount++;
+		}
+
+		my numberOfIterations += my hs.iter;
+
+		if (my isMainThread && (i - my firstFrame) % 10 == 0) {
+			Melder_progress ((double) (i - my firstFrame) / (my lastFrame - my firstFrame + 1),
+				U"LPC analysis of frame ", i - my firstFrame + 1, U" out of ", my lastFrame - my firstFrame + 1, U".");
+		}
+	}
+	MelderThread_RETURN;
+}
+
 autoLPC LPC_and_Sound_to_LPC_robust (LPC thee, Sound me, double analysisWidth, double preEmphasisFrequency, double k,
 	int itermax, double tol, int wantlocation) {
-	struct huber_struct struct_huber { autoSound(), 0.0, 0.0, 0.0, 0, 0, 0, 0, 0.0, 0.0, 0, 0, nullptr, nullptr, nullptr, nullptr, nullptr, autoSVD() };
 	try {
-		double t1, samplingFrequency = 1.0 / my dx, tol_svd = 0.000001;
+		double t1, samplingFrequency = 1.0 / my dx;
 		double location = 0, windowDuration = 2 * analysisWidth; /* Gaussian window */
 		long nFrames, frameErrorCount = 0, iter = 0;
 		long p = thy maxnCoefficients;
@@ -206,50 +356,55 @@ autoLPC LPC_and_Sound_to_LPC_robust (LPC thee, Sound me, double analysisWidth, d
 		}
 
 		autoSound sound = Data_copy (me);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoLPC him = Data_copy (thee);
-		huber_struct_init (&struct_huber, windowDuration, p, samplingFrequency, location, wantlocation);
-
-		struct_huber.k = k;
-		struct_huber.tol = tol;
-		struct_huber.tol_svd = tol_svd;
-		struct_huber.itermax = itermax;
 
 		autoMelderProgress progess (U"LPC analysis");
 
 		Sound_preEmphasis (sound.get(), preEmphasisFrequency);
 
-		for (long i = 1; i <= nFrames; i++) {
-			LPC_Frame lpc = (LPC_Frame) & thy d_frames[i];
-			LPC_Frame lpcto = (LPC_Frame) & his d_frames[i];
-			double t = Sampled_indexToX (thee, i);
-
-			Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-			Vector_subtractMean (sframe.get());
-			Sounds_multiply (sframe.get(), window.get());
-
-			try {
-				LPC_Frames_and_Sound_huber (lpc, sframe.get(), lpcto, & struct_huber);
-			} catch (MelderError) {
-				frameErrorCount++;
-			}
-
-			iter += struct_huber.iter;
-
-			if ( (i % 10) == 1) {
-				Melder_progress ( (double) i / nFrames, U"LPC analysis of frame ", i, U" out of ", nFrames, U".");
-			}
+		if (! huber_mutex_inited) {
+			MelderThread_MUTEX_INIT (huber_mutex);
+			huber_mutex_inited = true;
+		}
+		double numberOfOperationsPerFrame = (double) window -> nx * (p + 1) * (p + 2) / 2 * (itermax > 0 ? itermax : 1);
+		int numberOfThreads = MelderThread_getNumberOfProcessors ();
+		if (numberOfThreads > 16) numberOfThreads = 16;
+		if (numberOfThreads > nFrames * numberOfOperationsPerFrame / 1e5) numberOfThreads = (int) (nFrames * numberOfOperationsPerFrame / 1e5);
+		if (numberOfThreads > nFrames) numberOfThreads = (int) nFrames;
+		if (numberOfThreads < 1) numberOfThreads = 1;
+		autoLPC_and_Sound_into_LPC_robust_Args args [16];
+		long firstFrame = 1;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread++) {
+			autoLPC_and_Sound_into_LPC_robust_Args arg = Thing_new (LPC_and_Sound_into_LPC_robust_Args);
+			arg -> lpc = thee;
+			arg -> result = him.get();
+			arg -> sound = sound.get();
+			arg -> window = window.get();
+			arg -> sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
+			arg -> windowDuration = windowDuration;
+			arg -> firstFrame = firstFrame;
+			arg -> lastFrame = ithread == numberOfThreads ? nFrames : nFrames * ithread / numberOfThreads;
+			huber_struct_init (& arg -> hs, windowDuration, p, samplingFrequency, location, wantlocation);
+			arg -> hs.k = k;
+			arg -> hs.tol = tol;
+			arg -> hs.itermax = itermax;
+			arg -> isMainThread = ithread == numberOfThreads;
+			firstFrame = arg -> lastFrame + 1;
+			args[ithread - 1] = arg.move();
 		}
+		MelderThread_run (LPC_and_Sound_into_LPC_robust_frames, args, numberOfThreads);
 
+		for (int ithread = 1; ithread <= numberOfThreads; ithread++) {
+			frameErrorCount += args[ithread - 1] -> frameErrorCount;
+			iter += args[ithread - 1] -> numberOfIterations;
+		}
 		if (frameErrorCount) Melder_warning (U"Results of ", frameErrorCount,
 			U" frame(s) out of ", nFrames, U" could not be optimised.");
 		MelderInfo_writeLine (U"Number of iterations: ", iter,
 			U"\n   Average per frame: ", ((double) iter) / nFrames);
-		huber_struct_destroy (&struct_huber);
 		return him;
 	} catch (MelderError) {
-		huber_struct_destroy (&struct_huber);
 		Melder_throw (me, U": no robust LPC created.");
 	}
 }
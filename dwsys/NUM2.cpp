@@ -2079,21 +2079,25 @@ double NUMformantfilter_amplitude (double fc, double bw, double f) {
 	return 1.0 / (dq * dq + 1.0);
 }
 
+int NUMburg (double x[], long n, double a[], int m, double *xms) {
+	autoNUMvector<double> work (1, n + n + m);
+	return NUMburg_nothrow (x, n, a, m, xms, work.peek());
+}
+
 /* Childers (1978), Modern Spectrum analysis, IEEE Press, 252-255) */
-/* work[1..n+n+n];
+/* work[1..n+n+m];
 b1 = & work[1];
 b2 = & work[n+1];
 aa = & work[n+n+1];
-for (i=1; i<=n+n+n; i++) work[i]=0;
 */
-int NUMburg (double x[], long n, double a[], int m, double *xms) {
+int NUMburg_nothrow (double x[], long n, double a[], int m, double *xms, double work[]) {
 	for (long j = 1; j <= m; j++) {
 		a[j] = 0.0;
 	}
 
-	autoNUMvector<double> b1 (1, n);
-	autoNUMvector<double> b2 (1, n);
-	autoNUMvector<double> aa (1, m);
+	double *b1 = & work[0];   // b1[1..n]
+	double *b2 = & work[n];   // b2[1..n]
+	double *aa = & work[n + n];   // aa[1..m]
 
 	// (3)
 
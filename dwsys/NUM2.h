@@ -310,6 +310,13 @@ void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
 	If work == NULL, the routine allocates (and destroys) its own memory.
 */
 
+bool NUMstatistics_huber_nothrow (double *x, long n, double *location, int wantlocation,
+	double *scale, int wantscale, double k, double tol, double *work);
+/*
+	As NUMstatistics_huber, but returns false instead of throwing if n < 1 or if the scale is zero.
+	It does not allocate, so work may not be NULL; it can be called from several threads at a time.
+*/
+
 void NUMmonotoneRegression (const double x[], long n, double xs[]);
 /*
 	Find numbers xs[1..n] that have a monotone relationship with
@@ -1008,6 +1015,12 @@ int NUMburg (double x[], long n, double a[], int m, double *xms);
 	Spectrum Analysis, IEEE Press, 1978, 252-255.
 */
 
+int NUMburg_nothrow (double x[], long n, double a[], int m, double *xms, double work[]);
+/*
+	As NUMburg, but with the caller's work[1..n+n+m] instead of allocated memory,
+	so that it can be called from several threads at a time.
+*/
+
 void NUMdmatrix_to_dBs (double **m, long rb, long re, long cb, long ce,
 	double ref, double factor, double floor);
 /*
@@ -1159,6 +1172,15 @@ struct structNUMfft_Table
   long n;
   double *trigcache;
   long *splitcache;
+  /*
+	For lengths with large prime factors the transform is computed as a Bluestein chirp-z
+	transform, i.e. as a convolution of power-of-two length bluesteinSize.
+	All these pointers are null for the other lengths.
+	The work buffer is scratch space for every transform, so a table with bluesteinSize > 0
+	is not reentrant: threads that transform concurrently must each have their own table.
+  */
+  long bluesteinSize;
+  double *chirp, *chirpSpectrum, *twiddle, *work;
 };
 
 typedef struct structNUMfft_Table_f *NUMfft_Table_f;
@@ -1168,6 +1190,11 @@ void NUMfft_Table_init_f (NUMfft_Table_f table, long n);
 void NUMfft_Table_init (NUMfft_Table table, long n);
 /*
 	n : data size
+	Any n is allowed: if the mixed-radix transform for n would be slow because n has
+	large prime factors, the double version switches to a Bluestein transform,
+	which guarantees O(n log n) with the same output ordering.
+	A table may not be shared between threads that call NUMfft_forward or NUMfft_backward
+	at the same time (see bluesteinSize above).
 */
 
 struct autoNUMfft_Table : public structNUMfft_Table {
@@ -1175,10 +1202,16 @@ struct autoNUMfft_Table : public structNUMfft_Table {
                 n = 0;
                 trigcache = 0;
                 splitcache = 0;
+                bluesteinSize = 0;
+                chirp = chirpSpectrum = twiddle = work = 0;
         }
         ~autoNUMfft_Table () {
                 NUMvector_free (trigcache, 0);
                 NUMvector_free (splitcache, 0);
+                NUMvector_free (chirp, 0);
+                NUMvector_free (chirpSpectrum, 0);
+                NUMvector_free (twiddle, 0);
+                NUMvector_free (work, 0);
         }
 };
 
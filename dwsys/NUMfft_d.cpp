@@ -60,10 +60,99 @@ void NUMreverseRealFastFourierTransform (double *data, long n) {
 	NUMfft_backward (& table, data);
 }
 
+/*
+	In-place radix-2 transforms of the m complex numbers z [0..2m-1] (real and imaginary parts interleaved).
+	twiddle [2k], twiddle [2k+1] contain cos and sin of 2 pi k / m, for k = 0 .. m/2-1.
+	The forward transform (minus sign in the exponent) leaves its result in bit-reversed order,
+	and the backward transform expects its input in that order, so that a convolution
+	never has to reorder its data.
+	Both transforms recurse on the two halves of a block, so that large transforms
+	do their smaller stages within the cache.
+*/
+static void complexFourierTransform_forwardToBitReversed (double *z, long length, const double *twiddle, long step) {
+	if (length < 2) {
+		return;
+	}
+	long half = length >> 1;
+	double *u = z, *v = z + 2 * half;
+	for (long k = 0; k < half; k ++, u += 2, v += 2) {
+		double wr = twiddle [2 * k * step], wi = - twiddle [2 * k * step + 1];
+		double dr = u [0] - v [0], di = u [1] - v [1];
+		u [0] += v [0]; u [1] += v [1];
+		v [0] = dr * wr - di * wi; v [1] = dr * wi + di * wr;
+	}
+	complexFourierTransform_forwardToBitReversed (z, half, twiddle, 2 * step);
+	complexFourierTransform_forwardToBitReversed (z + 2 * half, half, twiddle, 2 * step);
+}
+
+static void complexFourierTransform_backwardFromBitReversed (double *z, long length, const double *twiddle, long step) {
+	if (length < 2) {
+		return;
+	}
+	long half = length >> 1;
+	complexFourierTransform_backwardFromBitReversed (z, half, twiddle, 2 * step);
+	complexFourierTransform_backwardFromBitReversed (z + 2 * half, half, twiddle, 2 * step);
+	double *u = z, *v = z + 2 * half;
+	for (long k = 0; k < half; k ++, u += 2, v += 2) {
+		double wr = twiddle [2 * k * step], wi = twiddle [2 * k * step + 1];
+		double vr = v [0] * wr - v [1] * wi, vi = v [0] * wi + v [1] * wr;
+		v [0] = u [0] - vr; v [1] = u [1] - vi;
+		u [0] += vr; u [1] += vi;
+	}
+}
+
+/*
+	Discrete Fourier transform with a minus sign in the exponent of the n complex numbers in my work,
+	as the Bluestein convolution
+		X [k] = w [k] sum_j (x [j] w [j]) conj (w [k - j]),  w [j] = exp (- i pi j^2 / n).
+	On entry my work [0 .. 2n-1] contains the input, on exit the result.
+*/
+static void NUMfft_Table_bluestein (NUMfft_Table me) {
+	long n = my n, m = my bluesteinSize;
+	double *z = my work, *w = my chirp, *b = my chirpSpectrum;
+	for (long j = 0; j < n; j ++) {
+		double re = z [2 * j] * w [2 * j] - z [2 * j + 1] * w [2 * j + 1];
+		double im = z [2 * j] * w [2 * j + 1] + z [2 * j + 1] * w [2 * j];
+		z [2 * j] = re; z [2 * j + 1] = im;
+	}
+	for (long j = 2 * n; j < 2 * m; j ++) {
+		z [j] = 0.0;
+	}
+	complexFourierTransform_forwardToBitReversed (z, m, my twiddle, 1);
+	for (long k = 0; k < m; k ++) {
+		double re = z [2 * k] * b [2 * k] - z [2 * k + 1] * b [2 * k + 1];
+		double im = z [2 * k] * b [2 * k + 1] + z [2 * k + 1] * b [2 * k];
+		z [2 * k] = re; z [2 * k + 1] = im;
+	}
+	complexFourierTransform_backwardFromBitReversed (z, m, my twiddle, 1);
+	for (long k = 0; k < n; k ++) {
+		double re = z [2 * k] * w [2 * k] - z [2 * k + 1] * w [2 * k + 1];
+		double im = z [2 * k] * w [2 * k + 1] + z [2 * k + 1] * w [2 * k];
+		z [2 * k] = re / m; z [2 * k + 1] = im / m;
+	}
+}
+
 void NUMfft_forward (NUMfft_Table me, double *data) {
 	if (my n == 1) {
 		return;
 	}
+	if (my bluesteinSize > 0) {
+		long n = my n;
+		for (long j = 0; j < n; j ++) {
+			my work [2 * j] = data [j + 1];
+			my work [2 * j + 1] = 0.0;
+		}
+		NUMfft_Table_bluestein (me);
+		data [1] = my work [0];
+		for (long k = 1; 2 * k < n; k ++) {
+			data [2 * k] = my work [2 * k];
+			data [2 * k + 1] = my work [2 * k + 1];
+		}
+		if (n % 2 == 0) {
+			data [n] = my work [n];
+		}
+		return;
+	}
 	drftf1 (my n, &data[1], my trigcache, my trigcache + my n, my splitcache);
 }
 
@@ -71,11 +160,95 @@ void NUMfft_backward (NUMfft_Table me, double *data) {
 	if (my n == 1) {
 		return;
 	}
+	if (my bluesteinSize > 0) {
+		/*
+			Build the complex conjugate of the full Hermitian spectrum,
+			transform it forward and take the real part.
+		*/
+		long n = my n;
+		my work [0] = data [1];
+		my work [1] = 0.0;
+		for (long k = 1; 2 * k < n; k ++) {
+			my work [2 * k] = my work [2 * (n - k)] = data [2 * k];
+			my work [2 * k + 1] = - data [2 * k + 1];
+			my work [2 * (n - k) + 1] = data [2 * k + 1];
+		}
+		if (n % 2 == 0) {
+			my work [n] = data [n];
+			my work [n + 1] = 0.0;
+		}
+		NUMfft_Table_bluestein (me);
+		for (long j = 0; j < n; j ++) {
+			data [j + 1] = my work [2 * j];
+		}
+		return;
+	}
 	drftb1 (my n, &data[1], my trigcache, my trigcache + my n, my splitcache);
 }
 
+/*
+	The mixed-radix transform handles the factors 2, 3, 4 and 5 efficiently, but any other prime factor p
+	costs of the order of n p operations. A Bluestein transform costs of the order of
+	three complex transforms of a power of two m that is at least 2n - 1.
+	The weights of the two costs were measured; the Bluestein transform only wins for prime factors
+	larger than about 800, but then it wins by far (a large prime n would take O (n^2)).
+*/
+static long NUMfft_getBluesteinSize (long n) {
+	long m = 1, log2m = 0;
+	while (m < 2 * n - 1) {
+		m *= 2;
+		log2m ++;
+	}
+	double mixedRadixCost = 0.0;
+	long remainder = n;
+	for (long p = 2; p * p <= remainder; p ++) {
+		while (remainder % p == 0) {
+			mixedRadixCost += p <= 5 ? log2 ((double) p) : 0.5 * p;
+			remainder /= p;
+		}
+	}
+	if (remainder > 1) {
+		mixedRadixCost += remainder <= 5 ? log2 ((double) remainder) : 0.5 * remainder;
+	}
+	double bluesteinCost = 12.0 * log2m * m / n;
+	return mixedRadixCost > bluesteinCost ? m : 0;
+}
+
 void NUMfft_Table_init (NUMfft_Table me, long n) {
 	my n = n;
+	my bluesteinSize = n > 1 ? NUMfft_getBluesteinSize (n) : 0;
+	if (my bluesteinSize > 0) {
+		long m = my bluesteinSize;
+		my chirp = NUMvector <double> (0, 2 * n - 1);
+		my chirpSpectrum = NUMvector <double> (0, 2 * m - 1);
+		my twiddle = NUMvector <double> (0, m - 1);
+		my work = NUMvector <double> (0, 2 * m - 1);
+		for (long k = 0; k < m / 2; k ++) {
+			double arg = 2.0 * NUMpi * k / m;
+			my twiddle [2 * k] = cos (arg);
+			my twiddle [2 * k + 1] = sin (arg);
+		}
+		for (long j = 0; j < n; j ++) {
+			double arg = NUMpi * (double) ((long long) j * j % (2 * n)) / n;   // keep the argument small for precision
+			my chirp [2 * j] = cos (arg);
+			my chirp [2 * j + 1] = - sin (arg);
+		}
+		/*
+			The convolution kernel conj (w [j]) for j = - (n - 1) .. n - 1, wrapped around modulo m.
+		*/
+		double *b = my chirpSpectrum;
+		for (long j = 0; j < 2 * m; j ++) {
+			b [j] = 0.0;
+		}
+		b [0] = my chirp [0];
+		b [1] = - my chirp [1];
+		for (long j = 1; j < n; j ++) {
+			b [2 * j] = b [2 * (m - j)] = my chirp [2 * j];
+			b [2 * j + 1] = b [2 * (m - j) + 1] = - my chirp [2 * j + 1];
+		}
+		complexFourierTransform_forwardToBitReversed (b, m, my twiddle, 1);   // bit-reversed, like the data it multiplies
+		return;
+	}
 	my trigcache = NUMvector <double> (0, 3 * n - 1);
 	my splitcache = NUMvector <long> (0, 31);
 	NUMrffti (n, my trigcache, my splitcache);
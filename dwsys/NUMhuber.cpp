@@ -61,17 +61,15 @@ static double NUMgauss (double x) {
 	return NUM1_sqrt2pi * exp (- 0.5 * x * x);
 }
 
-void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
-                          double *scale, int wantscale, double k, double tol, double *work) {
+bool NUMstatistics_huber_nothrow (double *x, long n, double *location, int wantlocation,
+                                  double *scale, int wantscale, double k, double tol, double *work) {
 	double *tmp = work;
 	double theta = 2.0 * NUMgaussP (k) - 1.0;
 	double beta = theta + k * k * (1.0 - theta) - 2.0 * k * NUMgauss (k);
 	long n1 = n;
 
-	autoNUMvector<double> atmp;
-	if (work == 0)  {
-		atmp.reset (1, n);
-		tmp = atmp.peek();
+	if (n < 1) {
+		return false;
 	}
 	double mad;
 	NUMmad (x, n, location, wantlocation, & mad, tmp);
@@ -79,7 +77,7 @@ void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
 		*scale = mad;
 	}
 	if (*scale == 0) {
-		Melder_throw (U"Scale is zero.");
+		return false;
 	}
 
 	double mu0, mu1 = *location;
@@ -128,4 +126,20 @@ void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
 	if (wantscale) {
 		*scale = s1;
 	}
+	return true;
+}
+
+void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
+                          double *scale, int wantscale, double k, double tol, double *work) {
+	if (n < 1) {
+		Melder_throw (U"The dimension must be at least 1");
+	}
+	autoNUMvector<double> atmp;
+	if (! work) {
+		atmp.reset (1, n);
+		work = atmp.peek();
+	}
+	if (! NUMstatistics_huber_nothrow (x, n, location, wantlocation, scale, wantscale, k, tol, work)) {
+		Melder_throw (U"Scale is zero.");
+	}
 }
@@ -25,6 +25,7 @@
 #include "NUMmachar.h"
 #include "NUM2.h"
 #include "Strings_extensions.h"
+#include "MelderThread.h"
 
 #include "oo_DESTROY.h"
 #include "GaussianMixture_def.h"
@@ -70,52 +71,262 @@ static void NUMdvector_scaleAsProbabilities (double *v, long n) {
 		}
 }
 
+/*
+	The log density of component `me` at x, with the inverse Cholesky factor (or the inverse standard deviations)
+	as computed by SSCP_expandLowerCholesky; diff [1..dimension] is workspace.
+	Same as ln2pid - 0.5 * (lnd + NUMmahalanobisDistance_chi (...)), but with the differences from the centroid computed only once.
+*/
+static inline double Covariance_getLogDensity (Covariance me, const double *x, double *diff, double ln2pid) {
+	const long dimension = my numberOfColumns;
+	const double *centroid = my centroid;
+	for (long j = 1; j <= dimension; j ++) {
+		diff [j] = x [j] - centroid [j];
+	}
+	double chisq = 0.0;
+	if (my numberOfRows == 1) {   // diagonal
+		const double *linv = my lowerCholesky [1];
+		for (long j = 1; j <= dimension; j ++) {
+			double t = linv [j] * diff [j];
+			chisq += t * t;
+		}
+	} else {
+		for (long i = dimension; i > 0; i --) {
+			const double *linv = my lowerCholesky [i];
+			double t = 0.0;
+			for (long j = 1; j <= i; j ++) {
+				t += linv [j] * diff [j];
+			}
+			chisq += t * t;
+		}
+	}
+	return ln2pid - 0.5 * (my lnd + chisq);
+}
+
+/*
+	The E-step and the sums of the M-step go through the data row by row.
+	The rows are divided over threads; every thread writes only its own rows of p
+	and accumulates its sums separately, to be added by the caller.
+	The lower Cholesky factors of the covariances are computed beforehand, once per update of the covariance,
+	and are only read by the threads.
+*/
+#define GaussianMixture_EM_DENSITIES  1
+#define GaussianMixture_EM_MARGINALS  2
+#define GaussianMixture_EM_GAMMAS  3
+#define GaussianMixture_EM_CENTROID  4
+#define GaussianMixture_EM_COVARIANCE  5
+
+Thing_define (GaussianMixture_EM_Args, Thing) {
+	int task;
+	GaussianMixture gm;
+	double **data, **p;   // p has numberOfRows + 1 rows and numberOfComponents + 1 columns
+	long numberOfRows, firstRow, lastRow;
+	long firstComponent, lastComponent;   // DENSITIES
+	long component;   // CENTROID, COVARIANCE
+	double *diff, *lnN;   // [1..dimension], [1..numberOfComponents]
+	double *sums;   // [1..numberOfComponents] for MARGINALS and GAMMAS; [1..dimension] for CENTROID
+	double **sumsOfProducts;   // [1..1 or dimension] [1..dimension] for COVARIANCE
+	double lnp;   // GAMMAS
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (GaussianMixture_EM_Args, Thing, 0);
+
+void structGaussianMixture_EM_Args :: v_destroy () noexcept {
+	NUMvector_free <double> (diff, 1);
+	NUMvector_free <double> (lnN, 1);
+	NUMvector_free <double> (sums, 1);
+	NUMmatrix_free <double> (sumsOfProducts, 1, 1);
+	GaussianMixture_EM_Args_Parent :: v_destroy ();
+}
+
+static MelderThread_RETURN_TYPE GaussianMixture_EM_rows (GaussianMixture_EM_Args me) {
+	GaussianMixture gm = my gm;
+	const long numberOfComponents = gm -> numberOfComponents, dimension = gm -> dimension;
+	double **data = my data, **p = my p, *mixingProbabilities = gm -> mixingProbabilities;
+	const double ln2pid = - 0.5 * dimension * log (NUM2pi);
+	if (my task == GaussianMixture_EM_DENSITIES) {
+		for (long i = my firstRow; i <= my lastRow; i ++) {
+			for (long ic = my firstComponent; ic <= my lastComponent; ic ++) {
+				double prob = exp (Covariance_getLogDensity (gm -> covariances->at [ic], data [i], my diff, ln2pid));
+				p [i] [ic] = prob < 1e-300 ? 1e-300 : prob;   // prevent p from being zero
+			}
+		}
+	} else if (my task == GaussianMixture_EM_MARGINALS) {
+		for (long ic = 1; ic <= numberOfComponents; ic ++) {
+			my sums [ic] = 0.0;
+		}
+		for (long i = my firstRow; i <= my lastRow; i ++) {
+			double rowsum = 0.0;
+			for (long ic = 1; ic <= numberOfComponents; ic ++) {
+				rowsum += mixingProbabilities [ic] * p [i] [ic];
+			}
+			p [i] [numberOfComponents + 1] = rowsum;
+			for (long ic = 1; ic <= numberOfComponents; ic ++) {
+				my sums [ic] += mixingProbabilities [ic] * p [i] [ic] / rowsum;
+			}
+		}
+	} else if (my task == GaussianMixture_EM_GAMMAS) {
+		double **gamma = p;
+		for (long ic = 1; ic <= numberOfComponents; ic ++) {
+			my sums [ic] = 0.0;
+		}
+		my lnp = 0.0;
+		for (long i = my firstRow; i <= my lastRow; i ++) {
+			double rowsum = 0.0;
+			for (long ic = 1; ic <= numberOfComponents; ic ++) {
+				my lnN [ic] = Covariance_getLogDensity (gm -> covariances->at [ic], data [i], my diff, ln2pid);
+				gamma [i] [ic] = mixingProbabilities [ic] * exp (my lnN [ic]); // eq. Bishop 9.16
+				rowsum += gamma [i] [ic];
+			}
+
+			// If the gamma[i]'s are too small, their sum will be zero and the scaling will overflow
+
+			if (rowsum == 0.0) {
+				continue;    // This is ok because gamma[i]'s will all be zero
+			}
+
+			// scale gamma and get log(likehood) (Bishop eq. 9.40)
+
+			for (long ic = 1; ic <= numberOfComponents; ic ++) {
+				gamma [i] [ic] /= rowsum; // eq. Bishop 9.16
+				my sums [ic] += gamma [i] [ic]; // eq. Bishop 9.18
+				my lnp += gamma [i] [ic] * (log (mixingProbabilities [ic])  + my lnN [ic]); // eq. Bishop 9.40
+			}
+		}
+	} else if (my task == GaussianMixture_EM_CENTROID) {
+		const long component = my component;
+		const double mixprob = mixingProbabilities [component];
+		for (long j = 1; j <= dimension; j ++) {
+			my sums [j] = 0.0;
+		}
+		for (long i = my firstRow; i <= my lastRow; i ++) {
+			double gamma = mixprob * p [i] [component] / p [i] [numberOfComponents + 1];
+			const double *x = data [i];
+			for (long j = 1; j <= dimension; j ++) {
+				my sums [j] += gamma * x [j]; // eq. Bishop 9.17
+			}
+		}
+	} else if (my task == GaussianMixture_EM_COVARIANCE) {
+		const long component = my component;
+		const double mixprob = mixingProbabilities [component];
+		Covariance cov = gm -> covariances->at [component];
+		const double *centroid = cov -> centroid;
+		double **sop = my sumsOfProducts, *diff = my diff;
+		for (long j = 1; j <= cov -> numberOfRows; j ++) {
+			for (long k = 1; k <= dimension; k ++) {
+				sop [j] [k] = 0.0;
+			}
+		}
+		for (long i = my firstRow; i <= my lastRow; i ++) {
+			double gamma = mixprob * p [i] [component] / p [i] [numberOfComponents + 1];
+			const double *x = data [i];
+			for (long j = 1; j <= dimension; j ++) {
+				diff [j] = centroid [j] - x [j];
+			}
+			if (cov -> numberOfRows == 1) {   // 1xn covariance
+				double *sop1 = sop [1];
+				for (long j = 1; j <= dimension; j ++) {
+					sop1 [j] += gamma * diff [j] * diff [j];
+				}
+			} else {   // upper triangle of nxn covariance
+				for (long j = 1; j <= dimension; j ++) {
+					double gxj = gamma * diff [j], *sopj = sop [j];
+					for (long k = j; k <= dimension; k ++) {
+						sopj [k] += gxj * diff [k];
+					}
+				}
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
+/*
+	Divide the rows over at most 16 threads, but not into portions of less than about 1e5 multiplications each.
+*/
+static int GaussianMixture_EM_createArgs (GaussianMixture me, double **data, long numberOfRows, double **p, double numberOfOperationsPerRow,
+	autoGaussianMixture_EM_Args *args)
+{
+	int numberOfThreads = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	double maximumNumberOfThreads = numberOfRows * numberOfOperationsPerRow / 1e5;
+	if (numberOfThreads > maximumNumberOfThreads) numberOfThreads = (int) maximumNumberOfThreads;
+	if (numberOfThreads > numberOfRows) numberOfThreads = numberOfRows;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	long firstRow = 1;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		autoGaussianMixture_EM_Args arg = Thing_new (GaussianMixture_EM_Args);
+		arg -> gm = me;
+		arg -> data = data;
+		arg -> p = p;
+		arg -> numberOfRows = numberOfRows;
+		arg -> firstRow = firstRow;
+		arg -> lastRow = ithread == numberOfThreads ? numberOfRows : numberOfRows * ithread / numberOfThreads;
+		arg -> firstComponent = 1;
+		arg -> lastComponent = my numberOfComponents;
+		arg -> diff = NUMvector <double> (1, my dimension);
+		arg -> lnN = NUMvector <double> (1, my numberOfComponents);
+		arg -> sums = NUMvector <double> (1, std::max (my numberOfComponents, my dimension));
+		arg -> sumsOfProducts = NUMmatrix <double> (1, my dimension, 1, my dimension);
+		firstRow = arg -> lastRow + 1;
+		args [ithread - 1] = arg.move();
+	}
+	return numberOfThreads;
+}
+
+static void GaussianMixture_EM_run (autoGaussianMixture_EM_Args *args, int numberOfThreads, int task) {
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		args [ithread - 1] -> task = task;
+	}
+	MelderThread_run (GaussianMixture_EM_rows, args, numberOfThreads);
+}
+
 static void GaussianMixture_updateCovariance (GaussianMixture me, long component, double **data, long numberOfRows, double **p) {
 	if (component < 1 || component > my numberOfComponents) {
 		return;
 	}
 	Covariance thee = my covariances->at [component];
 
-	double mixprob = my mixingProbabilities [component];
 	double gsum = p [numberOfRows + 1] [component];
+	autoGaussianMixture_EM_Args args [16];
+	int numberOfThreads = GaussianMixture_EM_createArgs (me, data, numberOfRows, p,
+		thy numberOfRows == 1 ? 2.0 * my dimension : 0.5 * my dimension * my dimension, args);
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		args [ithread - 1] -> component = component;
+	}
+
 	// update the means
 
+	GaussianMixture_EM_run (args, numberOfThreads, GaussianMixture_EM_CENTROID);
 	for (long j = 1; j <= thy numberOfColumns; j ++) {
-		thy centroid [j] = 0;
-		for (long i = 1; i <= numberOfRows; i ++) {
-			double gamma = mixprob * p [i] [component] / p [i] [my numberOfComponents + 1];
-			thy centroid [j] += gamma * data [i] [j] ; // eq. Bishop 9.17
+		double sum = 0.0;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			sum += args [ithread - 1] -> sums [j];
 		}
-		thy centroid [j] /= gsum;
+		thy centroid [j] = sum / gsum;
 	}
 
-	// update covariance with the new mean
+	// update covariance with the new mean; we cannot divide by nk - 1, this could cause instability
 
+	GaussianMixture_EM_run (args, numberOfThreads, GaussianMixture_EM_COVARIANCE);
 	if (thy numberOfRows == 1) { // 1xn covariance
 		for (long j = 1; j <= thy numberOfColumns; j ++) {
-			thy data[1][j] = 0;
-		}
-		for (long i = 1; i <= numberOfRows; i ++) {
-			double gamma = mixprob * p [i] [component] / p [i] [my numberOfComponents + 1];
-			double gdn = gamma / gsum;
-			for (long j = 1; j <= thy numberOfColumns; j ++) {
-				double xj = thy centroid [j] - data [i] [j];
-				thy data [1] [j] += gdn * xj * xj;
+			double sum = 0.0;
+			for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+				sum += args [ithread - 1] -> sumsOfProducts [1] [j];
 			}
+			thy data [1] [j] = sum / gsum;
 		}
 	} else { // nxn covariance
-		for (long j = 1; j <= thy numberOfRows; j ++)
+		for (long j = 1; j <= thy numberOfRows; j ++) {
 			for (long k = j; k <= thy numberOfColumns; k ++) {
-				thy data [k] [j] = thy data [j] [k] = 0;
-			}
-		for (long i = 1; i <= numberOfRows; i ++) {
-			double gamma = mixprob * p [i] [component] / p [i] [my numberOfComponents + 1];
-			double gdn = gamma / gsum; // we cannot divide by nk - 1, this could cause instability
-			for (long j = 1; j <= thy numberOfColumns; j ++) {
-				double xj = thy centroid [j] - data [i] [j];
-				for (long k = j; k <= thy numberOfColumns; k ++) {
-					thy data [j] [k] = thy data [k] [j] += gdn * xj * (thy centroid [k] - data [i] [k]);
+				double sum = 0.0;
+				for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+					sum += args [ithread - 1] -> sumsOfProducts [j] [k];
 				}
+				thy data [k] [j] = thy data [j] [k] = sum / gsum;
 			}
 		}
 	}
@@ -757,38 +968,22 @@ void GaussianMixture_and_TableOfReal_getGammas (GaussianMixture me, TableOfReal
 			Covariance cov = my covariances->at [im];
 			SSCP_expandLowerCholesky (cov);
 		}
+		autoGaussianMixture_EM_Args args [16];
+		int numberOfThreads = GaussianMixture_EM_createArgs (me, thy data, thy numberOfRows, gamma,
+			my numberOfComponents * (0.5 * my dimension * my dimension + 50.0), args);
+		GaussianMixture_EM_run (args, numberOfThreads, GaussianMixture_EM_GAMMAS);
 
 		double *nk = gamma[thy numberOfRows + 1];
 		for (long im = 1; im <= my numberOfComponents; im ++) {
 			nk[im] = 0.0;
 		}
-
 		double lnp = 0.0;
-		double ln2pid = - 0.5 * my dimension * log (NUM2pi);
-		autoNUMvector<double> lnN (1, my numberOfComponents);
-		for (long i = 1; i <=  thy numberOfRows; i ++) {
-			double rowsum = 0.0;
-			for (long im = 1; im <= my numberOfComponents; im ++) {
-				Covariance cov = my covariances->at [im];
-				double dsq = NUMmahalanobisDistance_chi (cov -> lowerCholesky, thy data [i], cov -> centroid, cov -> numberOfRows, my dimension);
-				lnN [im] = ln2pid - 0.5 * (cov -> lnd + dsq);
-				gamma [i] [im] = my mixingProbabilities[im] * exp (lnN [im]); // eq. Bishop 9.16
-				rowsum += gamma [i] [im];
-			}
-
-			// If the gamma[i]'s are too small, their sum will be zero and the scaling will overflow
-
-			if (rowsum == 0.0) {
-				continue;    // This is ok because gamma[i]'s will all be zero
-			}
-
-			// scale gamma and get log(likehood) (Bishop eq. 9.40)
-
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			GaussianMixture_EM_Args arg = args [ithread - 1].get();
 			for (long im = 1; im <= my numberOfComponents; im ++) {
-				gamma [i] [im] /= rowsum; // eq. Bishop 9.16
-				nk [im] += gamma [i] [im]; // eq. Bishop 9.18
-				lnp += gamma [i] [im] * (log (my mixingProbabilities [im])  + lnN [im]); // eq. Bishop 9.40
+				nk[im] += arg -> sums [im];
 			}
+			lnp += arg -> lnp;
 		}
 		if (p_lnp) {
 			*p_lnp = lnp;
@@ -863,8 +1058,6 @@ void GaussianMixture_splitComponent (GaussianMixture me, long component) {
 
 int GaussianMixture_and_TableOfReal_getProbabilities (GaussianMixture me, TableOfReal thee, long component, double **p) {
 	try {
-		double ln2pid = my dimension * log (NUM2pi);
-
 		// Update only one component or all?
 
 		long icb = 1, ice = my numberOfComponents;
@@ -875,14 +1068,15 @@ int GaussianMixture_and_TableOfReal_getProbabilities (GaussianMixture me, TableO
 		for (long ic = icb; ic <= ice; ic ++) {
 			Covariance him = my covariances->at [ic];
 			SSCP_expandLowerCholesky (him);
-
-			for (long i = 1; i <= thy numberOfRows; i++) {
-				double dsq = NUMmahalanobisDistance_chi (his lowerCholesky, thy data [i], his centroid, his numberOfRows, my dimension);
-				double prob = exp (- 0.5 * (ln2pid + his lnd + dsq));
-				prob = prob < 1e-300 ? 1e-300 : prob; // prevent p from being zero
-				p[i][ic] = prob;
-			}
 		}
+		autoGaussianMixture_EM_Args args [16];
+		int numberOfThreads = GaussianMixture_EM_createArgs (me, thy data, thy numberOfRows, p,
+			(ice - icb + 1) * (0.5 * my dimension * my dimension + 50.0), args);
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			args [ithread - 1] -> firstComponent = icb;
+			args [ithread - 1] -> lastComponent = ice;
+		}
+		GaussianMixture_EM_run (args, numberOfThreads, GaussianMixture_EM_DENSITIES);
 
 		GaussianMixture_updateProbabilityMarginals (me, p, thy numberOfRows);
 		return 1;
@@ -985,20 +1179,15 @@ long GaussianMixture_getNumberOfParametersInComponent (GaussianMixture me) {
 }
 
 void GaussianMixture_updateProbabilityMarginals (GaussianMixture me, double **p, long numberOfRows) {
-	long nocp1 = my numberOfComponents + 1, norp1 = numberOfRows + 1;
-
+	autoGaussianMixture_EM_Args args [16];
+	int numberOfThreads = GaussianMixture_EM_createArgs (me, nullptr, numberOfRows, p, 3.0 * my numberOfComponents, args);
+	GaussianMixture_EM_run (args, numberOfThreads, GaussianMixture_EM_MARGINALS);
 	for (long ic = 1; ic <= my numberOfComponents; ic ++) {
-		p [norp1] [ic] = 0.0;
-	}
-	for (long i = 1; i <= numberOfRows; i ++) {
-		double rowsum = 0.0;
-		for (long ic = 1; ic <= my numberOfComponents; ic ++) {
-			rowsum += my mixingProbabilities [ic] * p [i] [ic];
-		}
-		p [i] [nocp1] = rowsum;
-		for (long ic = 1; ic <= my numberOfComponents; ic ++) {
-			p [norp1] [ic] += my mixingProbabilities[ic] * p [i] [ic] / p [i] [nocp1];
+		double sum = 0.0;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			sum += args [ithread - 1] -> sums [ic];
 		}
+		p [numberOfRows + 1] [ic] = sum;
 	}
 }
 
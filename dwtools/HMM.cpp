@@ -24,6 +24,7 @@
 #include "Index.h"
 #include "NUM2.h"
 #include "Strings_extensions.h"
+#include "MelderThread.h"
 
 #include "oo_DESTROY.h"
 #include "HMM_def.h"
@@ -75,7 +76,6 @@ autoHMMBaumWelch HMMBaumWelch_create (long nstates, long nsymbols, long capacity
 void HMMBaumWelch_getGamma (HMMBaumWelch me);
 autoHMMBaumWelch HMM_forward (HMM me, long *obs, long nt);
 void HMMBaumWelch_reInit (HMMBaumWelch me);
-void HMM_and_HMMBaumWelch_getXi (HMM me, HMMBaumWelch thee, long *obs);
 void HMM_and_HMMBaumWelch_reestimate (HMM me, HMMBaumWelch thee);
 void HMM_and_HMMBaumWelch_addEstimate (HMM me, HMMBaumWelch thee, long *obs);
 void HMM_and_HMMBaumWelch_forward (HMM me, HMMBaumWelch thee, long *obs);
@@ -227,10 +227,7 @@ void HMMState_setLabel (HMMState me, char32 *label) {
 /**************** HMMBaumWelch ******************************/
 
 void structHMMBaumWelch :: v_destroy () noexcept {
-	for (long it = 1; it <= capacity; it ++) {
-		NUMmatrix_free (xi[it], 1, 1);
-	}
-	NUMvector_free (xi, 1);
+	NUMvector_free (weightedBeta, 1);
 	NUMvector_free (scale, 1);
 	NUMmatrix_free (beta, 1, 1);
 	NUMmatrix_free (alpha, 1, 1);
@@ -247,18 +244,15 @@ autoHMMBaumWelch HMMBaumWelch_create (long nstates, long nsymbols, long capacity
 		my numberOfTimes = my capacity = capacity;
 		my numberOfStates = nstates;
 		my numberOfSymbols = nsymbols;
-		my alpha = NUMmatrix<double> (1, nstates, 1, capacity);
-		my beta = NUMmatrix<double> (1, nstates, 1, capacity);
+		my alpha = NUMmatrix<double> (1, capacity, 1, nstates);
+		my beta = NUMmatrix<double> (1, capacity, 1, nstates);
 		my scale = NUMvector<double> (1, capacity);
-		my xi = NUMvector<double **> (1, capacity);
+		my weightedBeta = NUMvector<double> (1, nstates);
 		my aij_num = NUMmatrix<double> (0, nstates, 1, nstates + 1);
 		my aij_denom = NUMmatrix<double> (0, nstates, 1, nstates + 1);
 		my bik_num = NUMmatrix<double> (1, nstates, 1, nsymbols);
 		my bik_denom = NUMmatrix<double> (1, nstates, 1, nsymbols);
-		my gamma = NUMmatrix<double> (1, nstates, 1, capacity);
-		for (long it = 1; it <= capacity; it++) {
-			my xi[it] = NUMmatrix<double> (1, nstates, 1, nstates);
-		}
+		my gamma = NUMmatrix<double> (1, capacity, 1, nstates);
 		return me;
 	} catch (MelderError) {
 		Melder_throw (U"HMMBaumWelch not created.");
@@ -267,14 +261,14 @@ autoHMMBaumWelch HMMBaumWelch_create (long nstates, long nsymbols, long capacity
 
 void HMMBaumWelch_getGamma (HMMBaumWelch me) {
 	for (long it = 1; it <= my numberOfTimes; it ++) {
+		double *alpha_t = my alpha [it], *beta_t = my beta [it], *gamma_t = my gamma [it];
 		double sum = 0.0;
 		for (long is = 1; is <= my numberOfStates; is ++) {
-			my gamma [is] [it] = my alpha [is] [it] * my beta [is] [it];
-			sum += my gamma [is] [it];
+			gamma_t [is] = alpha_t [is] * beta_t [is];
+			sum += gamma_t [is];
 		}
-
 		for (long is = 1; is <= my numberOfStates; is ++) {
-			my gamma [is] [it] /= sum;
+			gamma_t [is] /= sum;
 		}
 	}
 }
@@ -855,7 +849,7 @@ void HMMBaumWelch_reInit (HMMBaumWelch me) {
 	/*
 		The _num and _denum matrices are asigned as += in the iteration loop and therefore need to be zeroed
 		at the start of each new iteration.
-		The elements of alpha, beta, scale, gamma & xi are always calculated directly and need not be
+		The elements of alpha, beta, scale & gamma are always calculated directly and need not be
 		initialised.
 	*/
 	for (long is = 0; is <= my numberOfStates; is++) {
@@ -872,52 +866,155 @@ void HMMBaumWelch_reInit (HMMBaumWelch me) {
 	}
 }
 
+static void HMMBaumWelch_addAccumulators (HMMBaumWelch me, HMMBaumWelch thee) {
+	my totalNumberOfSequences += thy totalNumberOfSequences;
+	my lnProb += thy lnProb;
+	for (long is = 0; is <= my numberOfStates; is ++) {
+		for (long js = 1; js <= my numberOfStates + 1; js ++) {
+			my aij_num [is] [js] += thy aij_num [is] [js];
+			my aij_denom [is] [js] += thy aij_denom [is] [js];
+		}
+	}
+	for (long is = 1; is <= my numberOfStates; is ++) {
+		for (long k = 1; k <= my numberOfSymbols; k ++) {
+			my bik_num [is] [k] += thy bik_num [is] [k];
+			my bik_denom [is] [k] += thy bik_denom [is] [k];
+		}
+	}
+}
+
+Thing_define (HMM_learn_Args, Thing) { public:
+	HMM hmm;
+	autoHMMBaumWelch bw;
+	long *observations, *segmentStart, *segmentLength;
+	long firstSegment, lastSegment;
+};
+
+Thing_implement (HMM_learn_Args, Thing, 0);
+
+static autoHMM_learn_Args HMM_learn_Args_create (HMM hmm, long capacity, double minProb,
+	long *observations, long *segmentStart, long *segmentLength, long firstSegment, long lastSegment)
+{
+	autoHMM_learn_Args me = Thing_new (HMM_learn_Args);
+	my hmm = hmm;
+	my bw = HMMBaumWelch_create (hmm -> numberOfStates, hmm -> numberOfObservationSymbols, capacity);
+	my bw -> minProb = minProb;
+	my observations = observations;
+	my segmentStart = segmentStart;
+	my segmentLength = segmentLength;
+	my firstSegment = firstSegment;
+	my lastSegment = lastSegment;
+	return me;
+}
+
+/*
+	The expectation step for a range of observation sequences.
+	Each thread has its own HMMBaumWelch, so nothing is shared except the (read-only) HMM.
+*/
+static MelderThread_RETURN_TYPE HMM_learn_expectation (HMM_learn_Args me) {
+	HMMBaumWelch bw = my bw.get();
+	for (long iseg = my firstSegment; iseg <= my lastSegment; iseg ++) {
+		long *obs = my observations + my segmentStart [iseg] - 1;
+		bw -> numberOfTimes = my segmentLength [iseg];
+		(bw -> totalNumberOfSequences) ++;
+		HMM_and_HMMBaumWelch_forward (my hmm, bw, obs); // get new alphas
+		HMM_and_HMMBaumWelch_backward (my hmm, bw, obs); // get new betas
+		HMMBaumWelch_getGamma (bw);
+		HMM_and_HMMBaumWelch_addEstimate (my hmm, bw, obs);
+	}
+	MelderThread_RETURN;
+}
+
 void HMM_and_HMMObservationSequenceBag_learn (HMM me, HMMObservationSequenceBag thee, double delta_lnp, double minProb, int info) {
 	try {
-		// act as if all observation sequences are in memory
-		long capacity = HMMObservationSequenceBag_getLongestSequence (thee);
-		autoHMMBaumWelch bw = HMMBaumWelch_create (my numberOfStates, my numberOfObservationSymbols, capacity);
-		bw -> minProb = minProb;
+		/*
+			Translate all observation sequences to symbol numbers once.
+			Interpretation of unknowns: end of sequence.
+		*/
+		long totalNumberOfObservations = 0;
+		for (long ios = 1; ios <= thy size; ios ++) {
+			totalNumberOfObservations += thy at [ios] -> rows.size;
+		}
+		autoNUMvector<long> observations (1, totalNumberOfObservations);
+		autoNUMvector<long> segmentStart (1, totalNumberOfObservations), segmentLength (1, totalNumberOfObservations);
+		long numberOfSegments = 0, capacity = 0, offset = 0;
+		for (long ios = 1; ios <= thy size; ios ++) {
+			HMMObservationSequence hmm_os = thy at [ios];
+			autoStringsIndex si = HMM_and_HMMObservationSequence_to_StringsIndex (me, hmm_os);
+			long *obs = si -> classIndex, nobs = si -> numberOfElements; // convenience
+			for (long i = 1; i <= nobs; i ++) {
+				observations [offset + i] = obs [i];
+			}
+			long istart = 1, iend = nobs;
+			while (istart <= nobs) {
+				while (istart <= nobs && obs[istart] == 0) {
+					istart++;
+				};
+				if (istart > nobs) {
+					break;
+				}
+				iend = istart + 1;
+				while (iend <= nobs && obs[iend] != 0) {
+					iend++;
+				}
+				iend --;
+				numberOfSegments ++;
+				segmentStart [numberOfSegments] = offset + istart;
+				segmentLength [numberOfSegments] = iend - istart + 1;
+				if (segmentLength [numberOfSegments] > capacity) {
+					capacity = segmentLength [numberOfSegments];
+				}
+				istart = iend + 1;
+			}
+			offset += nobs;
+		}
+		if (numberOfSegments == 0) {
+			Melder_throw (U"There are no known observations.");
+		}
+		/*
+			Divide the sequences over the threads, in portions of about equal numbers of observations.
+		*/
+		int numberOfThreads = MelderThread_getNumberOfProcessors ();
+		if (numberOfThreads > 16) numberOfThreads = 16;
+		if (numberOfThreads > numberOfSegments) numberOfThreads = numberOfSegments;
+		if ((double) offset * my numberOfStates * my numberOfStates < 1e5) numberOfThreads = 1;   // not worth the overhead
+		if (numberOfThreads < 1) numberOfThreads = 1;
+		autoHMM_learn_Args args [16];
+		long firstSegment = 1, numberOfObservationsDone = 0;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			long lastSegment = firstSegment;
+			double wantedNumberOfObservations = (double) offset * ithread / numberOfThreads;
+			numberOfObservationsDone += segmentLength [firstSegment];
+			while (lastSegment < numberOfSegments - (numberOfThreads - ithread) &&
+				(ithread == numberOfThreads || numberOfObservationsDone + segmentLength [lastSegment + 1] <= wantedNumberOfObservations))
+			{
+				numberOfObservationsDone += segmentLength [++ lastSegment];
+			}
+			long threadCapacity = 0;
+			for (long iseg = firstSegment; iseg <= lastSegment; iseg ++) {
+				if (segmentLength [iseg] > threadCapacity) threadCapacity = segmentLength [iseg];
+			}
+			args [ithread - 1] = HMM_learn_Args_create (me, threadCapacity, minProb,
+				observations.peek(), segmentStart.peek(), segmentLength.peek(), firstSegment, lastSegment);
+			firstSegment = lastSegment + 1;
+		}
+		HMMBaumWelch bw = args [0] -> bw.get();
 		if (info) {
 			MelderInfo_open (); 
 		}
 		long iter = 0; double lnp;
 		do {
 			lnp = bw -> lnProb;
-			HMMBaumWelch_reInit (bw.get());
-			for (long ios = 1; ios <= thy size; ios ++) {
-				HMMObservationSequence hmm_os = thy at [ios];
-				autoStringsIndex si = HMM_and_HMMObservationSequence_to_StringsIndex (me, hmm_os); // TODO outside the loop or more efficiently
-				long *obs = si -> classIndex, nobs = si -> numberOfElements; // convenience
-
-				// Interpretation of unknowns: end of sequence
-
-				long istart = 1, iend = nobs;
-				while (istart <= nobs) {
-					while (istart <= nobs && obs[istart] == 0) {
-						istart++;
-					};
-					if (istart > nobs) {
-						break;
-					}
-					iend = istart + 1;
-					while (iend <= nobs && obs[iend] != 0) {
-						iend++;
-					}
-					iend --;
-					bw -> numberOfTimes = iend - istart + 1;
-					(bw -> totalNumberOfSequences) ++;
-					HMM_and_HMMBaumWelch_forward (me, bw.get(), obs + istart - 1); // get new alphas
-					HMM_and_HMMBaumWelch_backward (me, bw.get(), obs + istart - 1); // get new betas
-					HMMBaumWelch_getGamma (bw.get());
-					HMM_and_HMMBaumWelch_getXi (me, bw.get(), obs + istart - 1);
-					HMM_and_HMMBaumWelch_addEstimate (me, bw.get(), obs + istart - 1);
-					istart = iend + 1;
-				}
+			for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+				HMMBaumWelch_reInit (args [ithread - 1] -> bw.get());
+			}
+			MelderThread_run (HMM_learn_expectation, args, numberOfThreads);
+			for (int ithread = 2; ithread <= numberOfThreads; ithread ++) {
+				HMMBaumWelch_addAccumulators (bw, args [ithread - 1] -> bw.get());
 			}
 			// we have processed all observation sequences, now it is time to estimate new probabilities.
 			iter++;
-			HMM_and_HMMBaumWelch_reestimate (me, bw.get());
+			HMM_and_HMMBaumWelch_reestimate (me, bw);
 			if (info) { 
 				MelderInfo_writeLine (U"Iteration: ", iter, U" ln(prob): ", bw -> lnProb); 
 			}
@@ -1136,48 +1233,51 @@ void HMM_drawForwardAndBackwardProbabilitiesIllustration (Graphics g, bool garni
 	}
 }
 
-void HMM_and_HMMBaumWelch_getXi (HMM me, HMMBaumWelch thee, long *obs) {
-
-	for (long it = 1; it <= thy numberOfTimes - 1; it++) {
-		double sum = 0.0;
-		for (long is = 1; is <= thy numberOfStates; is++) {
-			for (long js = 1; js <= thy numberOfStates; js++) {
-				thy xi[it][is][js] = thy alpha[is][it] * thy beta[js][it + 1] *
-					my transitionProbs[is][js] * my emissionProbs[js][ obs[it + 1] ];
-				sum += thy xi[it][is][js];
-			}
-		}
-		for (long is = 1; is <= my numberOfStates; is++) {
-			for (long js = 1; js <= my numberOfStates; js++) {
-				thy xi[it][is][js] /= sum;
-			}
-		}
-	}
-}
-
+/*
+	Accumulates the expected numbers of transitions and emissions of one observation sequence.
+	The transition probabilities xi [t] [i] [j] are not stored, but added into aij_num as they are computed:
+		xi [t] [i] [j] = alpha [t] [i] * a [i] [j] * b [j] [o (t+1)] * beta [t+1] [j] / sum (t),
+	where, by the backward recursion, sum (t) = sum over i of alpha [t] [i] * beta [t] [i] * scale [t].
+	Transitions with zero probability contribute zero, so they are never reestimated.
+*/
 void HMM_and_HMMBaumWelch_addEstimate (HMM me, HMMBaumWelch thee, long *obs) {
 	for (long is = 1; is <= my numberOfStates; is ++) {
 		// only for valid start states with p > 0
 		if (my transitionProbs [0] [is] > 0.0) {
-			thy aij_num [0] [is] += thy gamma [is] [1];
+			thy aij_num [0] [is] += thy gamma [1] [is];
 			thy aij_denom [0] [is] += 1.0;
 		}
 	}
 
+	double *weightedBeta = thy weightedBeta;
+	for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
+		double *alpha_t = thy alpha [it], *beta_t = thy beta [it], *beta_tp1 = thy beta [it + 1];
+		long symbol = obs [it + 1];
+		double sum = 0.0;
+		for (long is = 1; is <= my numberOfStates; is ++) {
+			weightedBeta [is] = my emissionProbs [is] [symbol] * beta_tp1 [is];
+			sum += alpha_t [is] * beta_t [is];
+		}
+		sum *= thy scale [it];
+		for (long is = 1; is <= my numberOfStates; is ++) {
+			double factor = alpha_t [is] / sum;
+			if (factor == 0.0) continue;
+			double *a_is = my transitionProbs [is], *num_is = thy aij_num [is];
+			for (long js = 1; js <= my numberOfStates; js ++) {
+				num_is [js] += factor * a_is [js] * weightedBeta [js];
+			}
+		}
+	}
+
 	for (long is = 1; is <= my numberOfStates; is ++) {
 		double gammasum = 0.0;
 		for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
-			gammasum += thy gamma [is] [it];
+			gammasum += thy gamma [it] [is];
 		}
 
 		for (long js = 1; js <= my numberOfStates; js ++) {
-			double xisum = 0.0;
-			for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
-				xisum += thy xi [it] [is] [js];
-			}
 			// zero probs signal invalid connections, don't reestimate
 			if (my transitionProbs [is] [js] > 0.0) {
-				thy aij_num [is] [js] += xisum;
 				thy aij_denom [is] [js] += gammasum;
 			}
 		}
@@ -1187,24 +1287,20 @@ void HMM_and_HMMBaumWelch_addEstimate (HMM me, HMMBaumWelch thee, long *obs) {
 			A not hidden model is emulated with fixed emissionProbs.
 		*/
 		if (! my notHidden) {
-			gammasum += thy gamma [is] [thy numberOfTimes];   // now sum all, add last term
+			gammasum += thy gamma [thy numberOfTimes] [is];   // now sum all, add last term
+			for (long it = 1; it <= thy numberOfTimes; it ++) {
+				thy bik_num [is] [obs [it]] += thy gamma [it] [is];
+			}
 			for (long k = 1; k <= my numberOfObservationSymbols; k ++) {
-				double gammasum_k = 0.0;
-				for (long it = 1; it <= thy numberOfTimes; it ++) {
-					if (obs [it] == k) {
-						gammasum_k += thy gamma [is] [it];
-					}
-				}
 				// only reestimate probs > 0 !
 				if (my emissionProbs [is] [k] > 0.0) {
-					thy bik_num [is] [k] += gammasum_k;
 					thy bik_denom [is] [k] += gammasum;
 				}
 			}
 		}
 		// For a left-to-right model the final state determines the transition prob to go to the END state
 		if (my leftToRight) {
-			thy aij_num [is] [my numberOfStates + 1] += thy gamma [is] [thy numberOfTimes];
+			thy aij_num [is] [my numberOfStates + 1] += thy gamma [thy numberOfTimes] [is];
 			thy aij_denom [is] [my numberOfStates + 1] += 1.0;
 		}
 	}
@@ -1251,31 +1347,44 @@ void HMM_and_HMMBaumWelch_reestimate (HMM me, HMMBaumWelch thee) {
 	}
 }
 
+/*
+	The scaled forward and backward recursions (Rabiner 1989).
+	The loops are ordered such that the innermost loop runs along a row of the transition matrix
+	and along the contiguous state vector of alpha or beta.
+*/
 void HMM_and_HMMBaumWelch_forward (HMM me, HMMBaumWelch thee, long *obs) {
 	// initialise at t = 1 & scale
+	double *alpha_1 = thy alpha [1];
 	thy scale [1] = 0.0;
 	for (long js = 1; js <= my numberOfStates; js ++) {
-		thy alpha [js] [1] = my transitionProbs [0] [js] * my emissionProbs [js] [obs [1]];
-		thy scale [1] += thy alpha [js] [1];
+		alpha_1 [js] = my transitionProbs [0] [js] * my emissionProbs [js] [obs [1]];
+		thy scale [1] += alpha_1 [js];
 	}
 	for (long js = 1; js <= my numberOfStates; js ++) {
-		thy alpha [js] [1] /= thy scale [1];
+		alpha_1 [js] /= thy scale [1];
 	}
 	// recursion
 	for (long it = 2; it <= thy numberOfTimes; it ++) {
-		thy scale [it] = 0.0;
+		double *alpha_t = thy alpha [it], *alpha_tm1 = thy alpha [it - 1];
 		for (long js = 1; js <= my numberOfStates; js ++) {
-			double sum = 0.0;
-			for (long is = 1; is <= my numberOfStates; is ++) {
-				sum += thy alpha [is] [it - 1] * my transitionProbs [is] [js];
+			alpha_t [js] = 0.0;
+		}
+		for (long is = 1; is <= my numberOfStates; is ++) {
+			double alpha_is = alpha_tm1 [is];
+			if (alpha_is == 0.0) continue;
+			double *a_is = my transitionProbs [is];
+			for (long js = 1; js <= my numberOfStates; js ++) {
+				alpha_t [js] += alpha_is * a_is [js];
 			}
-
-			thy alpha [js] [it] = sum * my emissionProbs [js] [obs [it]];
-			thy scale [it] += thy alpha [js] [it];
 		}
-
+		long symbol = obs [it];
+		thy scale [it] = 0.0;
 		for (long js = 1; js <= my numberOfStates; js ++) {
-			thy alpha [js] [it] /= thy scale [it];
+			alpha_t [js] *= my emissionProbs [js] [symbol];
+			thy scale [it] += alpha_t [js];
+		}
+		for (long js = 1; js <= my numberOfStates; js ++) {
+			alpha_t [js] /= thy scale [it];
 		}
 	}
 
@@ -1285,16 +1394,24 @@ void HMM_and_HMMBaumWelch_forward (HMM me, HMMBaumWelch thee, long *obs) {
 }
 
 void HMM_and_HMMBaumWelch_backward (HMM me, HMMBaumWelch thee, long *obs) {
+	double *beta_T = thy beta [thy numberOfTimes];
 	for (long is = 1; is <= my numberOfStates; is ++) {
-		thy beta [is] [thy numberOfTimes] = 1.0 / thy scale [thy numberOfTimes];
+		beta_T [is] = 1.0 / thy scale [thy numberOfTimes];
 	}
+	double *weightedBeta = thy weightedBeta;
 	for (long it = thy numberOfTimes - 1; it >= 1; it --) {
+		double *beta_t = thy beta [it], *beta_tp1 = thy beta [it + 1];
+		long symbol = obs [it + 1];
+		for (long js = 1; js <= my numberOfStates; js ++) {
+			weightedBeta [js] = beta_tp1 [js] * my emissionProbs [js] [symbol];
+		}
 		for (long is = 1; is <= my numberOfStates; is ++) {
+			double *a_is = my transitionProbs [is];
 			double sum = 0.0;
 			for (long js = 1; js <= my numberOfStates; js ++) {
-				sum += thy beta [js] [it + 1] * my transitionProbs [is] [js] * my emissionProbs [js] [obs [it + 1]];
+				sum += a_is [js] * weightedBeta [js];
 			}
-			thy beta [is] [it] = sum / thy scale [it];
+			beta_t [is] = sum / thy scale [it];
 		}
 	}
 }
@@ -1302,36 +1419,56 @@ void HMM_and_HMMBaumWelch_backward (HMM me, HMMBaumWelch thee, long *obs) {
 /*************************** HMM decoding ***********************************/
 
 // precondition: valid symbols, i.e. 1 <= o[i] <= my numberOfSymbols for i=1..nt
+/*
+	The recursion works with ln(p), so that long observation sequences do not underflow.
+	The transposed logarithmic transition matrix lets the innermost loop run over contiguous memory.
+*/
 void HMM_and_HMMViterbi_decode (HMM me, HMMViterbi thee, long *obs) {
-	long ntimes = thy numberOfTimes;
+	long ntimes = thy numberOfTimes, nstates = my numberOfStates;
+	autoNUMmatrix<double> lnTransitionsTo (1, nstates, 1, nstates);   // [to] [from]
+	autoNUMvector<double> lnScore_tm1 (1, nstates);
+	for (long is = 1; is <= nstates; is++) {
+		for (long isp = 1; isp <= nstates; isp++) {
+			lnTransitionsTo[is][isp] = my transitionProbs[isp][is] > 0.0 ? log (my transitionProbs[isp][is]) : -INFINITY;
+		}
+	}
 	// initialisation
-	for (long is = 1; is <= my numberOfStates; is++) {
-		thy viterbi[is][1] = my transitionProbs[0][is] * my emissionProbs[is][ obs[1] ];
+	for (long is = 1; is <= nstates; is++) {
+		double p = my transitionProbs[0][is] * my emissionProbs[is][ obs[1] ];
+		thy viterbi[is][1] = p > 0.0 ? log (p) : -INFINITY;
 		thy bp[is][1] = 0;
 	}
 	// recursion
 	for (long it = 2; it <= ntimes; it++) {
-		for (long is = 1; is <= my numberOfStates; is++) {
+		for (long isp = 1; isp <= nstates; isp++) {
+			lnScore_tm1[isp] = thy viterbi[isp][it - 1];
+		}
+		for (long is = 1; is <= nstates; is++) {
 			// all transitions isp -> is from previous time to current
-			double max_score = -1; // any negative number is ok
-			for (long isp = 1; isp <= my numberOfStates; isp++) {
-				double score = thy viterbi[isp][it - 1] * my transitionProbs[isp][is]; // * my emissionProbs[is][ obs[it] ]
+			double *lnTransitions_is = lnTransitionsTo[is];
+			double max_score = -INFINITY;
+			long best_isp = 1;
+			for (long isp = 1; isp <= nstates; isp++) {
+				double score = lnScore_tm1[isp] + lnTransitions_is[isp]; // * my emissionProbs[is][ obs[it] ]
 				if (score > max_score) {
 					max_score = score;
-					thy bp[is][it] = isp;
+					best_isp = isp;
 				}
 			}
-			thy viterbi[is][it] = max_score * my emissionProbs[is][ obs[it] ];
+			double emissionProb = my emissionProbs[is][ obs[it] ];
+			thy bp[is][it] = best_isp;
+			thy viterbi[is][it] = emissionProb > 0.0 ? max_score + log (emissionProb) : -INFINITY;
 		}
 	}
 	// path starts at state with best end probability
 	thy path[ntimes] = 1;
-	thy prob = thy viterbi[1][ntimes];
-	for (long is = 2; is <= my numberOfStates; is++) {
-		if (thy viterbi[is][ntimes] > thy prob) {
-			thy prob = thy viterbi[ thy path[ntimes] = is ][ntimes];
+	double lnProb = thy viterbi[1][ntimes];
+	for (long is = 2; is <= nstates; is++) {
+		if (thy viterbi[is][ntimes] > lnProb) {
+			lnProb = thy viterbi[ thy path[ntimes] = is ][ntimes];
 		}
 	}
+	thy prob = exp (lnProb);
 	// trace back and get path
 	for (long it = ntimes; it > 1; it--) {
 		thy path[it - 1] = thy bp[ thy path[it] ][it];
@@ -50,11 +50,11 @@ Thing_define (HMMBaumWelch, Daata) {
 	long numberOfSymbols;
 	double lnProb;
 	double minProb;
-	double **alpha;
+	double **alpha;   // [time] [state], so that the recursions run over contiguous states
 	double **beta;
 	double *scale;
 	double **gamma;
-	double ***xi;
+	double *weightedBeta;   // work space [state]
 	double **aij_num, **aij_denom;
 	double **bik_num, **bik_denom;
 
@@ -36,6 +36,7 @@
 #include "MDS.h"
 #include "SSCP.h"
 #include "PCA.h"
+#include "MelderThread.h"
 
 #define TINY 1e-30
 
@@ -1194,34 +1195,46 @@ autoScalarProduct Distance_to_ScalarProduct (Distance me, bool normalize) {
 /**********  Configuration & ..... ***********************************/
 
 
+/*
+	The Minkowski distance between the points i and j of a Configuration,
+	divided by the largest coordinate difference first to prevent overflow when the metric is a large number:
+	d = (x^n)^(1/n) may overflow if x>1 & n >>1 even if d would not overflow!
+	metric changed 24/11/97
+	my w[k] * pow (|i-j|) instead of pow (my w[k] * |i-j|)
+*/
+static double Configuration_getDistance (Configuration me, long i, long j) {
+	double *xi = my data[i], *xj = my data[j];
+	if (my metric == 2) {
+		double d = 0.0;
+		for (long k = 1; k <= my numberOfColumns; k++) {
+			double dtmp = xi[k] - xj[k];
+			d += my w[k] * dtmp * dtmp;
+		}
+		return sqrt (d);
+	}
+	double dmax = 0.0, d = 0.0;
+	for (long k = 1; k <= my numberOfColumns; k++) {
+		double dtmp  = fabs (xi[k] - xj[k]);
+		if (dtmp > dmax) {
+			dmax = dtmp;
+		}
+	}
+	if (dmax > 0.0) {
+		for (long k = 1; k <= my numberOfColumns; k++) {
+			double arg = fabs (xi[k] - xj[k]) / dmax;
+			d += my w[k] * pow (arg, my metric);
+		}
+	}
+	return dmax * pow (d, 1.0 / my metric);
+}
+
 autoDistance Configuration_to_Distance (Configuration me) {
 	try {
 		autoDistance thee = Distance_create (my numberOfRows);
 		TableOfReal_copyLabels (me, thee.get(), 1, -1);
 		for (long i = 1; i <= thy numberOfRows - 1; i++) {
 			for (long j = i + 1; j <= thy numberOfColumns; j++) {
-				double dmax = 0.0, d = 0.0;
-
-				/*
-					first divide distance by maximum to prevent overflow when metric is a large number.
-					d = (x^n)^(1/n) may overflow if x>1 & n >>1 even if d would not overflow!
-					metric changed 24/11/97
-					my w[k] * pow (|i-j|) instead of pow (my w[k] * |i-j|)
-				*/
-
-				for (long k = 1; k <= my numberOfColumns; k++) {
-					double dtmp  = fabs (my data[i][k] - my data[j][k]);
-					if (dtmp > dmax) {
-						dmax = dtmp;
-					}
-				}
-				if (dmax > 0.0) {
-					for (long k = 1; k <= my numberOfColumns; k++) {
-						double arg = fabs (my data[i][k] - my data[j][k]) / dmax;
-						d += my w[k] * pow (arg, my metric);
-					}
-				}
-				thy data[i][j] = thy data[j][i] = dmax * pow (d, 1.0 / my metric);
+				thy data[i][j] = thy data[j][i] = Configuration_getDistance (me, i, j);
 			}
 		}
 		return thee;
@@ -1587,41 +1600,135 @@ autoDistanceList DissimilarityList_to_DistanceList (DissimilarityList me, int me
 
 /*****************  Kruskal *****************************************/
 
-static void smacof_guttmanTransform (Configuration cx, Configuration cz, Distance disp, Weight weight, double **vplus) {
-	long nPoints = cx -> numberOfRows, nDimensions = cx -> numberOfColumns;
-	double **z = cz -> data;
-
-	autoNUMmatrix<double> b (1, nPoints, 1, nPoints);
-	autoDistance distZ = Configuration_to_Distance (cz);
-
-	// compute B(Z) (eq. 8.25)
-
-	for (long i = 1; i <= nPoints; i++) {
-		double sum = 0.0;
-		for (long j = 1; j <= nPoints; j++) {
-			double dzij = distZ -> data[i][j];
-			if (i == j || dzij == 0.0) {
-				continue;
+/*
+	Work on the rows [firstRow, lastRow] of one of the passes of a smacof iteration.
+	Every pass writes only its own rows, so that the rows can be divided over threads.
+*/
+Thing_define (Smacof_Args, Thing) {
+	int pass;   // 1: B(Z)Z; 2: (V+)(B(Z)Z); 3: distances and raw stress components of X
+	long firstRow, lastRow;
+	long nPoints, nDimensions;
+	double **w, **fit, **distZ, **z, **bz, **vplus;
+	Configuration cx;
+	double **distX;
+	double etafit, etaconf, rho;
+};
+
+Thing_implement (Smacof_Args, Thing, 0);
+
+static MelderThread_RETURN_TYPE smacof_rows (Smacof_Args me) {
+	long nPoints = my nPoints, nDimensions = my nDimensions;
+	if (my pass == 1) {
+		/*
+			B(Z) (eq. 8.25) has b[i][j] = - w[i][j] * fit[i][j] / dz[i][j] off the diagonal and zero row sums,
+			so that row i of B(Z)Z is the sum of b[i][j] * (z[j] - z[i]); B(Z) itself is never stored.
+		*/
+		double **z = my z;
+		for (long i = my firstRow; i <= my lastRow; i++) {
+			double *bzi = my bz[i], *zi = z[i], *wi = my w[i], *fiti = my fit[i], *dzi = my distZ[i];
+			for (long k = 1; k <= nDimensions; k++) {
+				bzi[k] = 0.0;
+			}
+			for (long j = 1; j <= nPoints; j++) {
+				if (j == i || dzi[j] == 0.0) {
+					continue;
+				}
+				double bij = - wi[j] * fiti[j] / dzi[j];
+				double *zj = z[j];
+				for (long k = 1; k <= nDimensions; k++) {
+					bzi[k] += bij * (zj[k] - zi[k]);
+				}
+			}
+		}
+	} else if (my pass == 2) {
+		double **x = my cx -> data;
+		for (long i = my firstRow; i <= my lastRow; i++) {
+			double *xi = x[i], *vplusi = my vplus[i];
+			for (long k = 1; k <= nDimensions; k++) {
+				xi[k] = 0.0;
+			}
+			for (long l = 1; l <= nPoints; l++) {
+				double vplusil = vplusi[l], *bzl = my bz[l];
+				for (long k = 1; k <= nDimensions; k++) {
+					xi[k] += vplusil * bzl[k];
+				}
+			}
+		}
+	} else {
+		/*
+			Whole rows, so that the threads need not share rows; the stress components count every pair once.
+		*/
+		double etafit = 0.0, etaconf = 0.0, rho = 0.0;
+		for (long i = my firstRow; i <= my lastRow; i++) {
+			double *di = my distX[i], *wi = my w[i], *fiti = my fit[i];
+			for (long j = 1; j <= nPoints; j++) {
+				if (j == i) {
+					continue;
+				}
+				double dij = di[j] = Configuration_getDistance (my cx, i, j);
+				if (j > i) {
+					etafit += wi[j] * fiti[j] * fiti[j];
+					etaconf += wi[j] * dij * dij;
+					rho += wi[j] * fiti[j] * dij;
+				}
 			}
-			b[i][j] = - weight -> data[i][j] * disp -> data[i][j] / dzij;
-			sum += b[i][j];
 		}
-		b[i][i] = - sum;
+		my etafit = etafit;
+		my etaconf = etaconf;
+		my rho = rho;
 	}
+	MelderThread_RETURN;
+}
 
-	// Guttman transform: Xu = (V+)B(Z)Z (eq. 8.29)
-
-	for (long i = 1; i <= nPoints; i++) {
-		for (long j = 1; j <= nDimensions; j++) {
-			double xij = 0.0;
-			for (long k = 1;  k <= nPoints; k++) {
-				for (long l = 1; l <= nPoints; l++) {
-					xij += vplus[i][k] * b[k][l] * z[l][j];
-				}
+/*
+	Make cx the Guttman transform Xu = (V+)B(Z)Z (eq. 8.29) of the configuration Z in the args, as two products of order nPoints^2 * nDimensions,
+	and put the distances of cx in distX; returns the normalized stress of cx with respect to fit.
+	If vplus is null, all weights are equal to weight, V+ is the centring matrix divided by nPoints * weight,
+	and the second product becomes a scaling.
+*/
+static double smacof_guttmanTransform (Configuration cx, Distance distZ, Distance fit, double **vplus, double weight,
+	double **bz, Distance distX, autoSmacof_Args *args, int numberOfThreads)
+{
+	long nPoints = cx -> numberOfRows, nDimensions = cx -> numberOfColumns;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		Smacof_Args arg = args [ithread - 1].get();
+		arg -> fit = fit -> data;
+		arg -> distZ = distZ -> data;
+		arg -> distX = distX -> data;
+		arg -> pass = 1;
+	}
+	MelderThread_run (smacof_rows, args, numberOfThreads);
+	if (vplus) {
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			args [ithread - 1] -> pass = 2;
+		}
+		MelderThread_run (smacof_rows, args, numberOfThreads);
+	} else {
+		double scale = 1.0 / (nPoints * weight);
+		for (long k = 1; k <= nDimensions; k++) {
+			double mean = 0.0;
+			for (long i = 1; i <= nPoints; i++) {
+				mean += bz[i][k];
+			}
+			mean /= nPoints;
+			for (long i = 1; i <= nPoints; i++) {
+				cx -> data[i][k] = (bz[i][k] - mean) * scale;
 			}
-			cx -> data[i][j] = xij;
 		}
 	}
+	double etafit = 0.0, etaconf = 0.0, rho = 0.0;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		args [ithread - 1] -> pass = 3;
+	}
+	MelderThread_run (smacof_rows, args, numberOfThreads);
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		Smacof_Args arg = args [ithread - 1].get();
+		etafit += arg -> etafit;
+		etaconf += arg -> etaconf;
+		rho += arg -> rho;
+	}
+	double denum = etafit * etaconf;   // as in Distance_Weight_stress (MDS_NORMALIZED_STRESS)
+	return denum > 0.0 ? 1.0 - rho * rho / denum : NUMundefined;
 }
 
 double Distance_Weight_stress (Distance fit, Distance conf, Weight weight, int type) {
@@ -1795,85 +1902,184 @@ double Distance_Weight_congruenceCoefficient (Distance x, Distance y, Weight w)
 	return xy / (sqrt (x2) * sqrt (y2));
 }
 
-autoConfiguration Dissimilarity_Configuration_Weight_Transformator_smacof (Dissimilarity me, Configuration conf, Weight weight, Transformator t, double tolerance, long numberOfIterations, bool showProgress, double *stress) {
-	try {
-		long nPoints = conf -> numberOfRows;
-		long nDimensions = conf -> numberOfColumns;
-		double tol = 1e-6, stressp = 1e308, stres;
-		bool no_weight = ! weight;
-
-		if (my numberOfRows != nPoints || (!no_weight && weight -> numberOfRows != nPoints) || t -> numberOfPoints != nPoints) {
-			Melder_throw (U"Dimensions not in concordance.");
-		}
-		autoWeight aw;
-		if (no_weight) {
-			aw = Weight_create (nPoints);
-			weight = aw.get();
-		}
-		autoNUMmatrix<double> v (1, nPoints, 1, nPoints);
-		autoNUMmatrix<double> vplus (1, nPoints, 1, nPoints);
-		autoConfiguration z = Data_copy (conf);
-		autoMDSVec vec = Dissimilarity_to_MDSVec (me);
+MelderThread_MUTEX (smacof_mutex);
+static bool smacof_mutex_inited;
 
-		double **w = weight -> data;
-
-		if (showProgress) {
-			Melder_progress (0.0, U"MDS analysis");
+/*
+	V+, the Moore-Penrose inverse of V (eq. 8.19), into vplus,
+	except if all weights are equal: then vplus stays empty and *p_weight is the common weight (see smacof_guttmanTransform).
+*/
+static void smacof_getVplus (Weight weight, autoNUMmatrix<double>& vplus, double *p_weight) {
+	long nPoints = weight -> numberOfRows;
+	double **w = weight -> data, w12 = nPoints > 1 ? w[1][2] : 1.0;
+	bool equalWeights = w12 > 0.0;
+	for (long i = 1; i <= nPoints && equalWeights; i++) {
+		for (long j = 1; j <= nPoints; j++) {
+			if (j != i && w[i][j] != w12) {
+				equalWeights = false;
+				break;
+			}
 		}
+	}
+	*p_weight = w12;
+	if (equalWeights) {
+		return;
+	}
+	autoNUMmatrix<double> v (1, nPoints, 1, nPoints);
+	vplus.reset (1, nPoints, 1, nPoints);
 
-		// Get V (eq. 8.19).
+	// Get V (eq. 8.19).
 
-		for (long i = 1; i <= nPoints; i++) {
-			double wsum = 0;
-			for (long j = 1; j <= nPoints; j++) {
-				if (i == j) {
-					continue;
-				}
-				v[i][j] = - w[i][j];
-				wsum += w[i][j];
+	for (long i = 1; i <= nPoints; i++) {
+		double wsum = 0;
+		for (long j = 1; j <= nPoints; j++) {
+			if (i == j) {
+				continue;
 			}
-			v[i][i] = wsum;
+			v[i][j] = - w[i][j];
+			wsum += w[i][j];
 		}
+		v[i][i] = wsum;
+	}
 
-		// V is row and column centered and therefore: rank(V) <= nPoints-1.
-		// V^-1 does not exist -> get Moore-Penrose inverse.
-
-		NUMpseudoInverse (v.peek(), nPoints, nPoints, vplus.peek(), tol);
-		for (long iter = 1; iter <= numberOfIterations; iter++) {
-			autoDistance dist = Configuration_to_Distance (conf);
+	// V is row and column centered and therefore: rank(V) <= nPoints-1.
+	// V^-1 does not exist -> get Moore-Penrose inverse.
 
-			// transform & normalization
+	NUMpseudoInverse (v.peek(), nPoints, nPoints, vplus.peek(), 1e-6);
+}
 
-			autoDistance fit = Transformator_transform (t, vec.get(), dist.get(), weight);
+/*
+	One smacof run that starts from conf and leaves its final configuration in result; returns the stress.
+	conf is used as a workspace.
+	Objects are created only under the mutex, and so is the transformation,
+	which may keep results in the Transformator; several runs can therefore go on in parallel.
+	With numberOfThreads > 1, the passes of every iteration are divided over that many threads instead.
+*/
+static double smacof_run (Dissimilarity me, Configuration conf, Configuration result, Weight weight, double **vplus, double equalWeight,
+	Transformator t, double tolerance, long numberOfIterations, bool showProgress, int numberOfThreads, volatile int *cancelled)
+{
+	long nPoints = conf -> numberOfRows;
+	long nDimensions = conf -> numberOfColumns;
+	double stressp = 1e308, stres = NUMundefined;
+
+	autoMDSVec vec;
+	autoNUMmatrix<double> bz;
+	autoDistance dist1, dist2;
+	autoSmacof_Args args [16];
+	{// scope
+		MelderThread_LOCK (smacof_mutex);
+		try {
+			vec = Dissimilarity_to_MDSVec (me);
+			bz.reset (1, nPoints, 1, nDimensions);
+			dist1 = Configuration_to_Distance (conf);
+			dist2 = Distance_create (nPoints);
+			long firstRow = 1;
+			for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+				autoSmacof_Args arg = Thing_new (Smacof_Args);
+				arg -> firstRow = firstRow;
+				arg -> lastRow = ithread == numberOfThreads ? nPoints : nPoints * ithread / numberOfThreads;
+				arg -> nPoints = nPoints;
+				arg -> nDimensions = nDimensions;
+				arg -> w = weight -> data;
+				arg -> z = result -> data;
+				arg -> bz = bz.peek();
+				arg -> vplus = vplus;
+				arg -> cx = conf;
+				args [ithread - 1] = arg.move();
+				firstRow = args [ithread - 1] -> lastRow + 1;
+			}
+		} catch (MelderError) {
+			MelderThread_UNLOCK (smacof_mutex);
+			throw;
+		}
+		MelderThread_UNLOCK (smacof_mutex);
+	}
+	NUMmatrix_copyElements (conf -> data, result -> data, 1, nPoints, 1, nDimensions);
+	Distance distZ = dist1.get(), distX = dist2.get();   // distZ holds the distances of Z = result
+
+	if (showProgress) {
+		Melder_progress (0.0, U"MDS analysis");
+	}
+	for (long iter = 1; iter <= numberOfIterations; iter++) {
+		if (*cancelled) {
+			break;
+		}
+
+		// transform & normalization
+
+		autoDistance fit;
+		{// scope
+			MelderThread_LOCK (smacof_mutex);
+			try {
+				fit = Transformator_transform (t, vec.get(), distZ, weight);
+			} catch (MelderError) {
+				MelderThread_UNLOCK (smacof_mutex);
+				throw;
+			}
+			MelderThread_UNLOCK (smacof_mutex);
+		}
 
-			// Make conf the Guttman transform of z
+		// Make conf the Guttman transform of z, and compute its stress
 
-			smacof_guttmanTransform (conf, z.get(), fit.get(), weight, vplus.peek());
+		stres = smacof_guttmanTransform (conf, distZ, fit.get(), vplus, equalWeight, bz.peek(), distX, args, numberOfThreads);
 
-			// Compute stress
+		// Check stop criterium
 
-			autoDistance cdist = Configuration_to_Distance (conf);
+		if (fabs (stres - stressp) / stressp < tolerance) {
+			break;
+		}
 
-			stres = Distance_Weight_stress (fit.get(), cdist.get(), weight, MDS_NORMALIZED_STRESS);
+		// Make Z = X
 
-			// Check stop criterium
+		NUMmatrix_copyElements (conf -> data, result -> data, 1, nPoints, 1, nDimensions);
+		std::swap (distZ, distX);
 
-			if (fabs (stres - stressp) / stressp < tolerance) {
-				break;
-			}
+		stressp = stres;
+		if (showProgress) {
+			Melder_progress ((double) iter / (numberOfIterations + 1), U"kruskal: stress ", stres);
+		}
+	}
+	if (showProgress) {
+		Melder_progress (1.0);
+	}
+	return stres;
+}
 
-			// Make Z = X
+/*
+	The number of threads over which the passes of a smacof iteration are divided.
+*/
+static int smacof_getNumberOfThreads (long nPoints, long nDimensions) {
+	if ((double) nPoints * nPoints * nDimensions < 1e6) {
+		return 1;   // not worth the overhead
+	}
+	int numberOfThreads = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	if (numberOfThreads > nPoints) numberOfThreads = nPoints;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	return numberOfThreads;
+}
 
-			NUMmatrix_copyElements (conf -> data, z -> data, 1, nPoints, 1, nDimensions);
+autoConfiguration Dissimilarity_Configuration_Weight_Transformator_smacof (Dissimilarity me, Configuration conf, Weight weight, Transformator t, double tolerance, long numberOfIterations, bool showProgress, double *stress) {
+	try {
+		long nPoints = conf -> numberOfRows;
+		bool no_weight = ! weight;
 
-			stressp = stres;
-			if (showProgress) {
-				Melder_progress ((double) iter / (numberOfIterations + 1), U"kruskal: stress ", stres);
-			}
+		if (my numberOfRows != nPoints || (!no_weight && weight -> numberOfRows != nPoints) || t -> numberOfPoints != nPoints) {
+			Melder_throw (U"Dimensions not in concordance.");
 		}
-		if (showProgress) {
-			Melder_progress (1.0);
+		autoWeight aw;
+		if (no_weight) {
+			aw = Weight_create (nPoints);
+			weight = aw.get();
 		}
+		if (! smacof_mutex_inited) { MelderThread_MUTEX_INIT (smacof_mutex); smacof_mutex_inited = true; }
+		autoNUMmatrix<double> vplus;
+		double equalWeight;
+		smacof_getVplus (weight, vplus, & equalWeight);
+		autoConfiguration z = Data_copy (conf);
+		volatile int cancelled = 0;
+		double stres = smacof_run (me, conf, z.get(), weight, vplus.peek(), equalWeight, t, tolerance, numberOfIterations, showProgress,
+			smacof_getNumberOfThreads (nPoints, conf -> numberOfColumns), & cancelled);
 		if (stress) {
 			*stress = stres;
 		}
@@ -1886,36 +2092,153 @@ autoConfiguration Dissimilarity_Configuration_Weight_Transformator_smacof (Dissi
 	}
 }
 
+/*
+	A number of smacof runs: the repetitions ithread, ithread + numberOfThreads, ... of the thread with number ithread.
+*/
+Thing_define (MultiSmacof_Args, Thing) {
+	Dissimilarity dissimilarity;
+	Weight weight;
+	double **vplus, equalWeight;
+	Transformator transformator;
+	double tolerance;
+	long numberOfIterations;
+	ConfigurationList starts, results;
+	double *stress;   // [1..numberOfRepetitions]
+	long firstRepetition, numberOfRepetitions;
+	int numberOfThreads;
+	bool showProgress, isMainThread, failed;
+	volatile int *cancelled;
+};
+
+Thing_implement (MultiSmacof_Args, Thing, 0);
+
+static MelderThread_RETURN_TYPE multiSmacof_repetitions (MultiSmacof_Args me) {
+	for (long irep = my firstRepetition; irep <= my numberOfRepetitions; irep += my numberOfThreads) {
+		if (*my cancelled) {
+			break;
+		}
+		try {
+			my stress [irep] = smacof_run (my dissimilarity, my starts -> at [irep], my results -> at [irep], my weight, my vplus, my equalWeight,
+				my transformator, my tolerance, my numberOfIterations, false, 1, my cancelled);
+			if (my isMainThread && my showProgress) {
+				Melder_progress ((double) irep / (my numberOfRepetitions + 1), irep, U" from ", my numberOfRepetitions);
+			}
+		} catch (MelderError) {
+			*my cancelled = 1;
+			if (my isMainThread) {
+				throw;
+			}
+			my failed = true;
+			break;
+		}
+	}
+	MelderThread_RETURN;
+}
+
 autoConfiguration Dissimilarity_Configuration_Weight_Transformator_multiSmacof (Dissimilarity me, Configuration conf,  Weight w, Transformator t, double tolerance, long numberOfIterations, long numberOfRepetitions, bool showProgress) {
 	int showMulti = showProgress && numberOfRepetitions > 1;
 	try {
 		bool showSingle = ( showProgress && numberOfRepetitions == 1 );
-		double stress, stressmax = 1e308;
+		double stress;
+
+		if (numberOfRepetitions < 2) {
+			autoConfiguration cstart = Data_copy (conf);
+			return Dissimilarity_Configuration_Weight_Transformator_smacof (me, cstart.get(), w, t, tolerance, numberOfIterations, showSingle, &stress);
+		}
+		long nPoints = conf -> numberOfRows;
+		if (my numberOfRows != nPoints || (w && w -> numberOfRows != nPoints) || t -> numberOfPoints != nPoints) {
+			Melder_throw (U"Dimensions not in concordance.");
+		}
+		autoWeight aw;
+		if (! w) {
+			aw = Weight_create (nPoints);
+			w = aw.get();
+		}
+		if (! smacof_mutex_inited) { MelderThread_MUTEX_INIT (smacof_mutex); smacof_mutex_inited = true; }
+		autoNUMmatrix<double> vplus;
+		double equalWeight;
+		smacof_getVplus (w, vplus, & equalWeight);
 
+		/*
+			The starting configurations are the same as when the runs follow each other:
+			the given configuration, then a new random one after every run.
+		*/
+		autoConfigurationList starts = ConfigurationList_create (), results = ConfigurationList_create ();
 		autoConfiguration cstart = Data_copy (conf);
-		autoConfiguration  cbest = Data_copy (conf);
+		for (long i = 1; i <= numberOfRepetitions; i++) {
+			starts -> addItem_move (Data_copy (cstart.get()));
+			results -> addItem_move (Data_copy (cstart.get()));
+			Configuration_randomize (cstart.get());
+			TableOfReal_centreColumns (cstart.get());
+		}
+		autoNUMvector<double> stresses (1, numberOfRepetitions);
 
 		if (showMulti) {
 			Melder_progress (0.0, U"MDS many times");
 		}
 
-		for (long i = 1; i <= numberOfRepetitions; i++) {
-			autoConfiguration cresult = Dissimilarity_Configuration_Weight_Transformator_smacof (me, cstart.get(), w, t, tolerance, numberOfIterations, showSingle, &stress);
-			if (stress < stressmax) {
-				stressmax = stress;
-				cbest = cresult.move();
+		/*
+			Large problems divide every iteration over the threads; small ones run their repetitions in parallel.
+		*/
+		int numberOfThreadsPerRun = smacof_getNumberOfThreads (nPoints, conf -> numberOfColumns);
+		int numberOfThreads = numberOfThreadsPerRun > 1 ? 1 : MelderThread_getNumberOfProcessors ();
+		if (numberOfThreads > 16) numberOfThreads = 16;
+		if (numberOfThreads > numberOfRepetitions) numberOfThreads = numberOfRepetitions;
+		/*
+			An ISplineTransformator keeps its spline coefficients as the warm start of the next regression,
+			so its repetitions have to follow each other, as they always did.
+		*/
+		if (Thing_isa (t, classISplineTransformator)) numberOfThreads = 1;
+		if (numberOfThreads < 1) numberOfThreads = 1;
+		volatile int cancelled = 0;
+		if (numberOfThreads == 1) {
+			for (long i = 1; i <= numberOfRepetitions; i++) {
+				stresses [i] = smacof_run (me, starts -> at [i], results -> at [i], w, vplus.peek(), equalWeight, t, tolerance, numberOfIterations,
+					false, numberOfThreadsPerRun, & cancelled);
+				if (showMulti) {
+					Melder_progress ( (double) i / (numberOfRepetitions + 1), i, U" from ", numberOfRepetitions);
+				}
 			}
-			Configuration_randomize (cstart.get());
-			TableOfReal_centreColumns (cstart.get());
+		} else {
+			autoMultiSmacof_Args args [16];
+			for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+				autoMultiSmacof_Args arg = Thing_new (MultiSmacof_Args);
+				arg -> dissimilarity = me;
+				arg -> weight = w;
+				arg -> vplus = vplus.peek();
+				arg -> equalWeight = equalWeight;
+				arg -> transformator = t;
+				arg -> tolerance = tolerance;
+				arg -> numberOfIterations = numberOfIterations;
+				arg -> starts = starts.get();
+				arg -> results = results.get();
+				arg -> stress = stresses.peek();
+				arg -> firstRepetition = ithread;
+				arg -> numberOfRepetitions = numberOfRepetitions;
+				arg -> numberOfThreads = numberOfThreads;
+				arg -> showProgress = showMulti;
+				arg -> isMainThread = ithread == numberOfThreads;
+				arg -> cancelled = & cancelled;
+				args [ithread - 1] = arg.move();
+			}
+			MelderThread_run (multiSmacof_repetitions, args, numberOfThreads);
+			for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+				if (args [ithread - 1] -> failed) {
+					Melder_throw (U"Not all repetitions could be performed.");
+				}
+			}
+		}
 
-			if (showMulti) {
-				Melder_progress ( (double) i / (numberOfRepetitions + 1), i, U" from ", numberOfRepetitions);
+		long ibest = 1;
+		for (long i = 2; i <= numberOfRepetitions; i++) {
+			if (stresses [i] < stresses [ibest]) {
+				ibest = i;
 			}
 		}
 		if (showMulti) {
 			Melder_progress (1.0);
 		}
-		return cbest;
+		return results -> subtractItem_move (ibest);
 	} catch (MelderError) {
 		if (showMulti) {
 			Melder_progress (1.0);
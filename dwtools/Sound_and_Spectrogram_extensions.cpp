@@ -31,6 +31,7 @@
 #include "Sound_to_Pitch.h"
 #include "Vector.h"
 #include "NUM2.h"
+#include "MelderThread.h"
 
 #define MIN(m,n) ((m) < (n) ? (m) : (n))
 // prototypes
@@ -87,30 +88,240 @@ static autoSpectrum Sound_to_Spectrum_power (Sound me) {
 	}
 }
 
-static void Sound_into_BarkSpectrogram_frame (Sound me, BarkSpectrogram thee, long frame) {
-	autoSpectrum him = Sound_to_Spectrum_power (me);
-	long numberOfFrequencies = his nx;
-	autoNUMvector<double> z (1, numberOfFrequencies);
+/*
+	A filter bank as a sparse band-by-bin matrix: filter i only has nonzero weights for the
+	frequency bins ifrom [i] .. ito [i] of the power spectrum; these weights are stored
+	consecutively in weights [offset [i] + ifrom [i] .. offset [i] + ito [i]].
+	The weights are computed once per analysis and shared by all frames.
+*/
+Thing_define (BandFilterWeights, Thing) { public:
+	long numberOfFilters, numberOfFourierSamples;
+	double df;   // the width of a frequency bin
+	autoNUMvector <long> ifrom, ito, offset;
+	autoNUMvector <double> weights;
+};
+
+Thing_implement (BandFilterWeights, Thing, 0);
+
+static autoBandFilterWeights BandFilterWeights_create (long numberOfFilters, long windowLength, double samplingPeriod) {
+	autoBandFilterWeights me = Thing_new (BandFilterWeights);
+	my numberOfFilters = numberOfFilters;
+	my numberOfFourierSamples = 2;
+	while (my numberOfFourierSamples < windowLength) my numberOfFourierSamples *= 2;
+	my df = 1.0 / (samplingPeriod * my numberOfFourierSamples);
+	my ifrom.reset (1, numberOfFilters);
+	my ito.reset (1, numberOfFilters);
+	my offset.reset (1, numberOfFilters);
+	return me;
+}
 
-	for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq++) {
-		double fhz = his x1 + (ifreq - 1) * his dx;
-		z[ifreq] = thy v_hertzToFrequency (fhz);
+static void BandFilterWeights_allocateWeights (BandFilterWeights me) {
+	long numberOfWeights = 0;
+	for (long ifilter = 1; ifilter <= my numberOfFilters; ifilter ++) {
+		my offset [ifilter] = numberOfWeights - my ifrom [ifilter] + 1;
+		if (my ito [ifilter] >= my ifrom [ifilter]) {
+			numberOfWeights += my ito [ifilter] - my ifrom [ifilter] + 1;
+		}
 	}
+	my weights.reset (1, numberOfWeights > 0 ? numberOfWeights : 1);
+}
 
-	for (long i = 1; i <= thy ny; i++) {
-		double p = 0;
-		double z0 = thy y1 + (i - 1) * thy dy;
-		double *pow = his z[1]; // TODO ??
-		for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq++) {
+/*
+	The Sekey & Hanson filter never becomes exactly zero, but its weight drops below
+	the cut-off beyond about 8 Bark below and 21 Bark above the centre frequency,
+	where its contribution to the band power is negligible.
+*/
+#define BARKFILTER_WEIGHT_CUTOFF  1e-20
+
+static autoBandFilterWeights BarkSpectrogram_getFilterWeights (BarkSpectrogram me, long windowLength, double samplingPeriod) {
+	autoBandFilterWeights thee = BandFilterWeights_create (my ny, windowLength, samplingPeriod);
+	long numberOfFrequencies = thy numberOfFourierSamples / 2 + 1;
+	double df = thy df;
+	autoNUMvector <double> z (1, numberOfFrequencies);
+	for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq ++) {
+		double fhz = (ifreq - 1) * df;
+		z [ifreq] = my v_hertzToFrequency (fhz);
+	}
+	for (long ifilter = 1; ifilter <= my ny; ifilter ++) {
+		double z0 = my y1 + (ifilter - 1) * my dy;
+		long ifrom = 1, ito = numberOfFrequencies;
+		while (ifrom <= ito && NUMsekeyhansonfilter_amplitude (z0, z [ifrom]) < BARKFILTER_WEIGHT_CUTOFF) {
+			ifrom ++;
+		}
+		while (ito >= ifrom && NUMsekeyhansonfilter_amplitude (z0, z [ito]) < BARKFILTER_WEIGHT_CUTOFF) {
+			ito --;
+		}
+		thy ifrom [ifilter] = ifrom;
+		thy ito [ifilter] = ito;
+	}
+	BandFilterWeights_allocateWeights (thee.get());
+	for (long ifilter = 1; ifilter <= my ny; ifilter ++) {
+		double z0 = my y1 + (ifilter - 1) * my dy;
+		double *w = thy weights.peek() + thy offset [ifilter];
+		for (long ifreq = thy ifrom [ifilter]; ifreq <= thy ito [ifilter]; ifreq ++) {
 			// Sekey & Hanson filter is defined in the power domain.
 			// We therefore multiply the power with a (and not a^2).
 			// integral (F(z),z=0..25) = 1.58/9
 
-			double a = NUMsekeyhansonfilter_amplitude (z0, z[ifreq]);
-			p += a * pow[ifreq] ;
+			w [ifreq] = NUMsekeyhansonfilter_amplitude (z0, z [ifreq]);
 		}
-		thy z[i][frame] = p;
 	}
+	return thee;
+}
+
+static autoBandFilterWeights MelSpectrogram_getFilterWeights (MelSpectrogram me, long windowLength, double samplingPeriod) {
+	autoBandFilterWeights thee = BandFilterWeights_create (my ny, windowLength, samplingPeriod);
+	long numberOfFrequencies = thy numberOfFourierSamples / 2 + 1;
+	double df = thy df;
+	for (long ifilter = 1; ifilter <= my ny; ifilter ++) {
+		double fc_mel = my y1 + (ifilter - 1) * my dy;
+		double fl_hz = my v_frequencyToHertz (fc_mel - my dy);
+		double fh_hz =  my v_frequencyToHertz (fc_mel + my dy);
+		double rifrom = 1.0 + ceil (fl_hz / df), rito = 1.0 + floor (fh_hz / df);
+		thy ifrom [ifilter] = rifrom < 1.0 ? 1 : (long) rifrom;
+		thy ito [ifilter] = rito > (double) numberOfFrequencies ? numberOfFrequencies : (long) rito;
+	}
+	BandFilterWeights_allocateWeights (thee.get());
+	for (long ifilter = 1; ifilter <= my ny; ifilter ++) {
+		double fc_mel = my y1 + (ifilter - 1) * my dy;
+		double fc_hz = my v_frequencyToHertz (fc_mel);
+		double fl_hz = my v_frequencyToHertz (fc_mel - my dy);
+		double fh_hz =  my v_frequencyToHertz (fc_mel + my dy);
+		double *w = thy weights.peek() + thy offset [ifilter];
+		for (long ifreq = thy ifrom [ifilter]; ifreq <= thy ito [ifilter]; ifreq ++) {
+			// Bin with a triangular filter the power (= amplitude-squared)
+
+			double f = (ifreq - 1) * df;
+			w [ifreq] = NUMtriangularfilter_amplitude (fl_hz, fc_hz, fh_hz, f);
+		}
+	}
+	return thee;
+}
+
+Thing_define (Sound_into_BandFilterSpectrogram_Args, Thing) { public:
+	Sound sound;
+	BandFilterSpectrogram spectrogram;
+	BandFilterWeights filterWeights;
+	double *window, windowDuration;
+	long windowLength;
+	long firstFrame, lastFrame;
+	bool isMainThread;
+	volatile int *cancelled;
+};
+
+Thing_implement (Sound_into_BandFilterSpectrogram_Args, Thing, 0);
+
+static autoSound_into_BandFilterSpectrogram_Args Sound_into_BandFilterSpectrogram_Args_create (Sound sound,
+	BandFilterSpectrogram spectrogram, BandFilterWeights filterWeights, double *window, long windowLength,
+	double windowDuration, long firstFrame, long lastFrame,
+	bool isMainThread, volatile int *cancelled)
+{
+	autoSound_into_BandFilterSpectrogram_Args me = Thing_new (Sound_into_BandFilterSpectrogram_Args);
+	my sound = sound;
+	my spectrogram = spectrogram;
+	my filterWeights = filterWeights;
+	my window = window;
+	my windowLength = windowLength;
+	my windowDuration = windowDuration;
+	my firstFrame = firstFrame;
+	my lastFrame = lastFrame;
+	my isMainThread = isMainThread;
+	my cancelled = cancelled;
+	return me;
+}
+
+MelderThread_MUTEX (mutex);
+static bool mutex_inited;
+
+/*
+	Every thread owns one Fourier table and one frame buffer, which are reused for all its frames.
+	The power spectrum of a frame is computed in the same way as by Sound_to_Spectrum_power ().
+*/
+static MelderThread_RETURN_TYPE Sound_into_BandFilterSpectrogram (Sound_into_BandFilterSpectrogram_Args me) {
+	Sound sound = my sound;
+	BandFilterSpectrogram thee = my spectrogram;
+	BandFilterWeights filterWeights = my filterWeights;
+	long nfft = filterWeights -> numberOfFourierSamples, numberOfFrequencies = nfft / 2 + 1;
+	autoNUMfft_Table fftTable;
+	autoNUMvector <double> data, power;
+	{// scope
+		MelderThread_LOCK (mutex);
+		NUMfft_Table_init (& fftTable, nfft);
+		data.reset (1, nfft);
+		power.reset (1, numberOfFrequencies);
+		MelderThread_UNLOCK (mutex);
+	}
+	double scale = 2.0 * filterWeights -> df / my windowDuration;
+	// factor '2' because we combine positive and negative frequencies
+	// df : width of frequency bin
+	// my windowDuration : duration of the analysis frame
+	double scaling = sound -> dx;
+	double *s = sound -> z [1];
+	for (long iframe = my firstFrame; iframe <= my lastFrame; iframe ++) {
+		if (my isMainThread) {
+			try {
+				Melder_progress ((double) (iframe - my firstFrame) / (my lastFrame - my firstFrame + 1),
+					U"Frame ", iframe, U" out of ", thy nx, U".");
+			} catch (MelderError) {
+				*my cancelled = 1;
+				throw;
+			}
+		} else if (*my cancelled) {
+			MelderThread_RETURN;
+		}
+		double t = Sampled_indexToX (thee, iframe);
+		long index = Sampled_xToNearestIndex (sound, t - my windowDuration / 2.0);
+		for (long i = 1; i <= my windowLength; i ++) {
+			long j = index - 1 + i;
+			data [i] = ( j < 1 || j > sound -> nx ? 0.0 : s [j] ) * my window [i];
+		}
+		for (long i = my windowLength + 1; i <= nfft; i ++) {
+			data [i] = 0.0;
+		}
+		NUMfft_forward (& fftTable, data.peek());
+		double re = data [1] * scaling;
+		power [1] = scale * (re * re) * 0.5;   // 0 Hz and Nyquist bins don't count for two
+		for (long i = 2; i < numberOfFrequencies; i ++) {
+			double rei = data [i + i - 2] * scaling, imi = data [i + i - 1] * scaling;
+			power [i] = scale * (rei * rei + imi * imi);
+		}
+		re = data [nfft] * scaling;
+		power [numberOfFrequencies] = scale * (re * re) * 0.5;
+
+		for (long ifilter = 1; ifilter <= thy ny; ifilter ++) {
+			double p = 0.0, *w = filterWeights -> weights.peek() + filterWeights -> offset [ifilter];
+			for (long ifreq = filterWeights -> ifrom [ifilter]; ifreq <= filterWeights -> ito [ifilter]; ifreq ++) {
+				p += w [ifreq] * power [ifreq];
+			}
+			thy z [ifilter] [iframe] = p;
+		}
+	}
+	MelderThread_RETURN;
+}
+
+static void Sound_into_BandFilterSpectrogram_frames (Sound me, BandFilterSpectrogram thee, BandFilterWeights filterWeights, Sound window) {
+	long numberOfFrames = thy nx;
+	long numberOfFramesPerThread = 20;
+	int numberOfThreads = (numberOfFrames - 1) / numberOfFramesPerThread + 1;
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	numberOfFramesPerThread = (numberOfFrames - 1) / numberOfThreads + 1;
+
+	if (! mutex_inited) { MelderThread_MUTEX_INIT (mutex); mutex_inited = true; }
+	autoSound_into_BandFilterSpectrogram_Args args [16];
+	long firstFrame = 1, lastFrame = numberOfFramesPerThread;
+	volatile int cancelled = 0;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		if (ithread == numberOfThreads) lastFrame = numberOfFrames;
+		args [ithread - 1] = Sound_into_BandFilterSpectrogram_Args_create (me, thee, filterWeights,
+			window -> z [1], window -> nx, window -> xmax - window -> xmin, firstFrame, lastFrame,
+			ithread == numberOfThreads, & cancelled);
+		firstFrame = lastFrame + 1;
+		lastFrame += numberOfFramesPerThread;
+	}
+	MelderThread_run (Sound_into_BandFilterSpectrogram, args, numberOfThreads);
 }
 
 autoBarkSpectrogram Sound_to_BarkSpectrogram (Sound me, double analysisWidth, double dt, double f1_bark, double fmax_bark, double df_bark) {
@@ -140,24 +351,13 @@ autoBarkSpectrogram Sound_to_BarkSpectrogram (Sound me, double analysisWidth, do
 
 		long numberOfFrames; double t1;
 		Sampled_shortTermAnalysis (me, windowDuration, dt, & numberOfFrames, & t1);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoBarkSpectrogram thee = BarkSpectrogram_create (my xmin, my xmax, numberOfFrames, dt, t1, fmin_bark, fmax_bark, numberOfFilters, df_bark, f1_bark);
+		autoBandFilterWeights filterWeights = BarkSpectrogram_getFilterWeights (thee.get(), window -> nx, my dx);
 
 		autoMelderProgress progess (U"BarkSpectrogram analysis");
 
-		for (long iframe = 1; iframe <= numberOfFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-
-			Sound_into_Sound (me, sframe.get(), t - windowDuration / 2.0);
-			Sounds_multiply (sframe.get(), window.get());
-			Sound_into_BarkSpectrogram_frame (sframe.get(), thee.get(), iframe);
-
-			if (iframe % 10 == 1) {
-				Melder_progress ( (double) iframe / numberOfFrames,  U"BarkSpectrogram analysis: frame ",
-					iframe, U" from ", numberOfFrames, U".");
-			}
-		}
+		Sound_into_BandFilterSpectrogram_frames (me, thee.get(), filterWeights.get(), window.get());
 		
 		_Spectrogram_windowCorrection ((Spectrogram) thee.get(), window -> nx);
 
@@ -167,28 +367,6 @@ autoBarkSpectrogram Sound_to_BarkSpectrogram (Sound me, double analysisWidth, do
 	}
 }
 
-static void Sound_into_MelSpectrogram_frame (Sound me, MelSpectrogram thee, long frame) {
-	autoSpectrum him = Sound_to_Spectrum_power (me);
-
-	for (long ifilter = 1; ifilter <= thy ny; ifilter ++) {
-		double power = 0;
-		double fc_mel = thy y1 + (ifilter - 1) * thy dy;
-		double fc_hz = thy v_frequencyToHertz (fc_mel);
-		double fl_hz = thy v_frequencyToHertz (fc_mel - thy dy);
-		double fh_hz =  thy v_frequencyToHertz (fc_mel + thy dy);
-		long ifrom, ito;
-		Sampled_getWindowSamples (him.get(), fl_hz, fh_hz, &ifrom, &ito);
-		for (long i = ifrom; i <= ito; i++) {
-			// Bin with a triangular filter the power (= amplitude-squared)
-
-			double f = his x1 + (i - 1) * his dx;
-			double a = NUMtriangularfilter_amplitude (fl_hz, fc_hz, fh_hz, f);
-			power += a * his z[1][i];
-		}
-		thy z[ifilter][frame] = power;
-	}
-}
-
 autoMelSpectrogram Sound_to_MelSpectrogram (Sound me, double analysisWidth, double dt, double f1_mel, double fmax_mel, double df_mel) {
 	try {
 		double t1, samplingFrequency = 1.0 / my dx, nyquist = 0.5 * samplingFrequency;
@@ -218,22 +396,13 @@ autoMelSpectrogram Sound_to_MelSpectrogram (Sound me, double analysisWidth, doub
 		fmax_mel = f1_mel + numberOfFilters * df_mel;
 
 		Sampled_shortTermAnalysis (me, windowDuration, dt, &numberOfFrames, &t1);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoMelSpectrogram thee = MelSpectrogram_create (my xmin, my xmax, numberOfFrames, dt, t1, fmin_mel, fmax_mel, numberOfFilters, df_mel, f1_mel);
+		autoBandFilterWeights filterWeights = MelSpectrogram_getFilterWeights (thee.get(), window -> nx, my dx);
 
 		autoMelderProgress progress (U"MelSpectrograms analysis");
 
-		for (long iframe = 1; iframe <= numberOfFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			Sound_into_Sound (me, sframe.get(), t - windowDuration / 2.0);
-			Sounds_multiply (sframe.get(), window.get());
-			Sound_into_MelSpectrogram_frame (sframe.get(), thee.get(), iframe);
-			
-			if (iframe % 10 == 1) {
-				Melder_progress ((double) iframe / numberOfFrames, U"Frame ", iframe, U" out of ", numberOfFrames, U".");
-			}
-		}
+		Sound_into_BandFilterSpectrogram_frames (me, thee.get(), filterWeights.get(), window.get());
 		
 		_Spectrogram_windowCorrection ((Spectrogram) thee.get(), window -> nx);
 
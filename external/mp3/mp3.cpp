@@ -29,14 +29,12 @@
  * the file *twice*, since we can't know the exact number of frames.
  *
  * What's worse, there is no guaranteed standard way of checking whether an MP3
- * file is CBR or VBR.  We therefore use the following compromise, which is
- * guaranteed to work on all files:
- *
- * - If there is a Xing header, read it to get the number of frames.
- * - Otherwise *estimate* the number of frames.
- * - Keep a reasonably (?) sized table of "key" offsets.
- * - Scan all the headers and keep required offsets in the table.
- * - After the scan, we also know the precise number of frames and samples.
+ * file is CBR or VBR.  We therefore scan all the headers and keep the offset
+ * of every frame in a table (a Xing header, if present, tells us in advance
+ * how large the table will be).  After the scan, we also know the precise
+ * number of frames and samples, and a seek can start decoding at the exact
+ * frame.  The table can be saved by the caller and given back later with
+ * mp3f_restore (), so that the scan is needed only once per file.
  *
  * TODO: Find exactly what the encoder delay is.
  *       (see http://mp3decoders.mp3-tech.org/decoders_lame.html)
@@ -47,6 +45,7 @@
 
 /*#define MP3_DEBUG*/
 
+#include <stdlib.h>
 #include <string.h>
 #include "mp3.h"
 #include "melder.h"
@@ -57,7 +56,6 @@ extern "C" {
 }
 
 #define MP3F_BUFFER_SIZE (8 * 1024)
-#define MP3F_MAX_LOCATIONS 1024
 
 /*
  * MP3 encoders and decoders add a number of silent samples at the beginning.
@@ -92,9 +90,9 @@ struct _MP3_FILE
 	unsigned samples_per_frame;
 	MP3F_OFFSET samples;
 
-	MP3F_OFFSET locations[MP3F_MAX_LOCATIONS]; 
+	MP3F_OFFSET *locations;   /* the offset of every frame */
 	unsigned num_locations;
-	unsigned frames_per_location;
+	unsigned max_locations;
 
 	unsigned delay;
 
@@ -156,9 +154,25 @@ MP3_FILE mp3f_new ()
 
 void mp3f_delete (MP3_FILE mp3f)
 {
+	if (mp3f)
+		free (mp3f -> locations);
 	Melder_free (mp3f);
 }
 
+static int mp3f_reserve_locations (MP3_FILE mp3f, unsigned n)
+{
+	MP3F_OFFSET *locations;
+	if (n <= mp3f -> max_locations)
+		return 1;
+	/* Called from libMAD callbacks, so no exceptions */
+	locations = (MP3F_OFFSET *) realloc (mp3f -> locations, n * sizeof (MP3F_OFFSET));
+	if (! locations)
+		return 0;
+	mp3f -> locations = locations;
+	mp3f -> max_locations = n;
+	return 1;
+}
+
 void mp3f_set_file (MP3_FILE mp3f, FILE *f)
 {
 	mp3f -> f = f;
@@ -241,7 +255,7 @@ int mp3f_analyze (MP3_FILE mp3f)
 	struct mad_decoder *decoder = & mp3f -> decoder;
 	int status;
 #ifdef MP3_DEBUG
-	unsigned estimate, last;
+	unsigned estimate;
 #endif /* MP3_DEBUG */
 
 	if (! mp3f || ! mp3f -> f)
@@ -271,40 +285,12 @@ int mp3f_analyze (MP3_FILE mp3f)
 	if (status != 0)
 		goto end;
 
-	/*
-	 * If we don't have a Xing header we need to estimate the frame count.
-	 * This doesn't have to be accurate since we're going to count them
-	 * later when we scan for header offsets.
-	 */
-	if (! mp3f -> xing) {
-		MP3F_OFFSET file_size, frame_size;
-
-		/* Take size of first frame */
-		frame_size = mp3f -> locations [1] - mp3f -> locations[0];
-
-		/* For file size, seek to end */
-		fseek (mp3f -> f, mp3f -> id3TagSize_bytes, SEEK_END); // David Weenink
-		file_size = ftell (mp3f -> f);
-
-		/* This estimate will be pretty accurate for CBR */
-		mp3f -> frames = file_size / frame_size;
-
-		MP3_DPRINTF (("File size: %lu bytes\n", (unsigned long)file_size));
-		MP3_DPRINTF (("First frame size: %lu bytes\n", (unsigned long)frame_size));
-		MP3_DPRINTF (("Estimated frames: %lu\n", (unsigned long)mp3f -> frames));
+	/* With a Xing header we know how many offsets there will be */
+	if (mp3f -> xing && ! mp3f_reserve_locations (mp3f, mp3f -> frames)) {
+		status = -1;
+		goto end;
 	}
 
-	/* Calculate how many frames can fit in a "location" */
-	if (mp3f -> frames <= MP3F_MAX_LOCATIONS)
-		mp3f -> frames_per_location = 1;
-	else
-		mp3f -> frames_per_location = (mp3f -> frames + MP3F_MAX_LOCATIONS - 1) / MP3F_MAX_LOCATIONS;
-
-	MP3_DPRINTF (("MP3: Each location is %u frame(s) (%.3fs), each %u samples\n",
-				mp3f -> frames_per_location,
-				mp3f -> frames_per_location * mp3f -> samples_per_frame / (float)mp3f -> frequency,
-				mp3f -> samples_per_frame));
-
 	/* Read all frames to get offsets*/
 #ifdef MP3_DEBUG
 	estimate = mp3f -> frames;
@@ -329,13 +315,6 @@ int mp3f_analyze (MP3_FILE mp3f)
 		       	mp3f -> frames,
 		       	estimate,
 			MP3_PERCENT (mp3f -> frames, estimate)));
-#ifdef MP3_DEBUG
-	last = mp3f -> frames - (mp3f -> frames_per_location * (mp3f -> num_locations - 1));
-	MP3_DPRINTF (("MP3F: Last location frames = %u (%+.2f%%) = %.3fs\n",
-				last,
-				MP3_PERCENT (mp3f -> frames_per_location, last),
-				last * mp3f -> samples_per_frame / (float)mp3f -> frequency));
-#endif /* MP3_DEBUG */
 
 if(status!=-1)   // ppgb 2015-01-17
 	mp3f_seek (mp3f, 0);
@@ -346,6 +325,39 @@ end:
 	return (status == 0);
 }
 
+int mp3f_restore (MP3_FILE mp3f, unsigned channels, unsigned frequency,
+		unsigned samples_per_frame, unsigned frames, const MP3F_OFFSET *frame_offsets)
+{
+	if (! mp3f || ! mp3f -> f || frames == 0 || samples_per_frame == 0)
+		return 0;
+	if (! mp3f_reserve_locations (mp3f, frames))
+		return 0;
+	memcpy (mp3f -> locations, frame_offsets, frames * sizeof (MP3F_OFFSET));
+	mp3f -> num_locations = frames;
+	mp3f -> xing = 0;
+	mp3f -> channels = channels;
+	mp3f -> frequency = frequency;
+	mp3f -> samples_per_frame = samples_per_frame;
+	mp3f -> frames = frames;
+	mp3f -> samples = (MP3F_OFFSET) frames * samples_per_frame;
+	return mp3f_seek (mp3f, 0);
+}
+
+unsigned mp3f_samples_per_frame (MP3_FILE mp3f)
+{
+	return mp3f -> samples_per_frame;
+}
+
+unsigned mp3f_frames (MP3_FILE mp3f)
+{
+	return mp3f -> num_locations;
+}
+
+const MP3F_OFFSET *mp3f_frame_offsets (MP3_FILE mp3f)
+{
+	return mp3f -> locations;
+}
+
 unsigned mp3f_channels (MP3_FILE mp3f)
 {
 	return mp3f -> channels;
@@ -375,7 +387,7 @@ int mp3f_seek (MP3_FILE mp3f, MP3F_OFFSET sample)
 	if (! mp3f || ! mp3f -> f)
 		return 0;
 
-	if (! mp3f -> frames_per_location)
+	if (! mp3f -> num_locations)
 		if (! mp3f_analyze (mp3f))
 			return 0;
 
@@ -388,12 +400,11 @@ int mp3f_seek (MP3_FILE mp3f, MP3F_OFFSET sample)
 		-- frame; 
 	if ( frame ) /* ...and the first frame it decodes is useless */
 		-- frame; 
-Melder_assert (mp3f -> frames_per_location > 0);
 Melder_assert (mp3f -> num_locations > 0);
-	location = frame / mp3f -> frames_per_location;
+	location = frame;
 	if (location >= mp3f -> num_locations)
 		location = mp3f -> num_locations - 1;
-	frame = location * mp3f -> frames_per_location;
+	frame = location;
 	base = frame * mp3f -> samples_per_frame;
 
 Melder_assert (location >= 0);
@@ -552,8 +563,6 @@ static enum mad_flow mp3f_mad_first_header(void *context, struct mad_header cons
 	mp3f -> channels = MAD_NCHANNELS (header);
 	mp3f -> frequency = header -> samplerate;
 	mp3f -> samples_per_frame = 32 * MAD_NSBSAMPLES (header);
-	/* Just in case there is no Xing header: */
-	mp3f -> locations [mp3f -> num_locations ++] = header -> offset;
 
 	return MAD_FLOW_CONTINUE;
 }
@@ -568,12 +577,8 @@ static enum mad_flow mp3f_mad_first_filter (void *context,
 
 	mp3f -> xing = mp3f_check_xing (mp3f, stream);
 
-	/* Xing? No need to look further */
-	if (mp3f -> xing)
-		return MAD_FLOW_STOP;
-
-	/* Otherwise, read two frames for size estimate */
-	return (mp3f -> num_locations < 2) ? MAD_FLOW_IGNORE : MAD_FLOW_STOP;
+	/* The first frame is all we need */
+	return MAD_FLOW_STOP;
 }
 
 static enum mad_flow mp3f_mad_scan_header(void *context, struct mad_header const *header)
@@ -590,10 +595,11 @@ static enum mad_flow mp3f_mad_scan_header(void *context, struct mad_header const
 	if (mp3f -> samples_per_frame != 32 * MAD_NSBSAMPLES (header))
 		return MAD_FLOW_BREAK;
 
-	/* Check whether to log this offset in the table */
-	if ((mp3f -> frames % mp3f -> frames_per_location) == 0 &&
-			mp3f -> num_locations < MP3F_MAX_LOCATIONS)
-		mp3f -> locations [mp3f -> num_locations ++] = header -> offset;
+	/* Log this offset in the table */
+	if (mp3f -> num_locations == mp3f -> max_locations &&
+			! mp3f_reserve_locations (mp3f, 2 * mp3f -> max_locations + 1024))
+		return MAD_FLOW_BREAK;
+	mp3f -> locations [mp3f -> num_locations ++] = header -> offset;
 
 	/* Count this frame */
 	++ mp3f -> frames;
@@ -49,9 +49,14 @@ void mp3f_delete (MP3_FILE mp3f);
 void mp3f_set_file (MP3_FILE mp3f, FILE *f);
 
 int mp3f_analyze (MP3_FILE mp3f);
+int mp3f_restore (MP3_FILE mp3f, unsigned channels, unsigned frequency,
+		unsigned samples_per_frame, unsigned frames, const MP3F_OFFSET *frame_offsets);
 unsigned mp3f_channels (MP3_FILE mp3f);
 unsigned mp3f_frequency (MP3_FILE mp3f);
 MP3F_OFFSET mp3f_samples (MP3_FILE mp3f);
+unsigned mp3f_samples_per_frame (MP3_FILE mp3f);
+unsigned mp3f_frames (MP3_FILE mp3f);
+const MP3F_OFFSET *mp3f_frame_offsets (MP3_FILE mp3f);   /* [0..frames-1], after mp3f_analyze () */
 
 void mp3f_set_callback (MP3_FILE mp3f,
 		MP3F_CALLBACK callback, void *context);
@@ -150,7 +150,7 @@ static double Sound_getHannWindowedRms (Sound me, double tmid, double widthLeft,
 	return sqrt (sumOfSquares / windowSumOfSquares);
 }
 autoAmplitudeTier PointProcess_Sound_to_AmplitudeTier_period (PointProcess me, Sound thee, double tmin, double tmax,
-	double pmin, double pmax, double maximumPeriodFactor)
+	double pmin, double pmax, double maximumPeriodFactor, double *peakCache)
 {
 	try {
 		if (tmax <= tmin) tmin = my xmin, tmax = my xmax;
@@ -162,7 +162,13 @@ autoAmplitudeTier PointProcess_Sound_to_AmplitudeTier_period (PointProcess me, S
 			double p1 = my t [i] - my t [i - 1], p2 = my t [i + 1] - my t [i];
 			double intervalFactor = p1 > p2 ? p1 / p2 : p2 / p1;
 			if (pmin == pmax || (p1 >= pmin && p1 <= pmax && p2 >= pmin && p2 <= pmax && intervalFactor <= maximumPeriodFactor)) {
-				double peak = Sound_getHannWindowedRms (thee, my t [i], 0.2 * p1, 0.2 * p2);
+				double peak;
+				if (peakCache) {
+					if (peakCache [i] == -1.0) peakCache [i] = Sound_getHannWindowedRms (thee, my t [i], 0.2 * p1, 0.2 * p2);
+					peak = peakCache [i];
+				} else {
+					peak = Sound_getHannWindowedRms (thee, my t [i], 0.2 * p1, 0.2 * p2);
+				}
 				if (NUMdefined (peak) && peak > 0.0)
 					RealTier_addPoint (him.get(), my t [i], peak);
 			}
@@ -43,7 +43,13 @@ autoSound Sound_AmplitudeTier_multiply (Sound me, AmplitudeTier intensity);
 
 autoAmplitudeTier PointProcess_Sound_to_AmplitudeTier_point (PointProcess me, Sound thee);
 autoAmplitudeTier PointProcess_Sound_to_AmplitudeTier_period (PointProcess me, Sound thee,
-	double tmin, double tmax, double shortestPeriod, double longestPeriod, double maximumPeriodFactor);
+	double tmin, double tmax, double shortestPeriod, double longestPeriod, double maximumPeriodFactor,
+	double *peakCache = nullptr);
+/*
+	The amplitude at a point depends only on the point and its two neighbours, not on tmin and tmax.
+	A caller that converts many overlapping windows of the same PointProcess can therefore supply a peakCache [1..my nt],
+	filled with -1.0 beforehand, in which every amplitude is stored when it is measured for the first time.
+*/
 double AmplitudeTier_getShimmer_local (AmplitudeTier me, double shortestPeriod, double longestPeriod, double maximumAmplitudeFactor);
 double AmplitudeTier_getShimmer_local_dB (AmplitudeTier me, double shortestPeriod, double longestPeriod, double maximumAmplitudeFactor);
 double AmplitudeTier_getShimmer_apq3 (AmplitudeTier me, double shortestPeriod, double longestPeriod, double maximumAmplitudeFactor);
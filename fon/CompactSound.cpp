@@ -0,0 +1,140 @@
+/* CompactSound.cpp
+ *
+ * Copyright (C) 2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CompactSound.h"
+#include "LongSound.h"
+
+Thing_implement (CompactSound, Sampled, 0);
+
+void structCompactSound :: v_destroy () noexcept {
+	NUMmatrix_free <int16> (shorts, 1, 1);
+	NUMmatrix_free <float> (floats, 1, 1);
+	CompactSound_Parent :: v_destroy ();
+}
+
+void structCompactSound :: v_info () {
+	structDaata :: v_info ();
+	MelderInfo_writeLine (U"Number of channels: ", numberOfChannels, numberOfChannels == 1 ? U" (mono)" : numberOfChannels == 2 ? U" (stereo)" : U"");
+	MelderInfo_writeLine (U"Sample storage: ", storage == CompactSound_INT16 ? U"16-bit integer" : U"32-bit floating point");
+	MelderInfo_writeLine (U"Time domain:");
+	MelderInfo_writeLine (U"   Start time: ", xmin, U" seconds");
+	MelderInfo_writeLine (U"   End time: ", xmax, U" seconds");
+	MelderInfo_writeLine (U"   Total duration: ", xmax - xmin, U" seconds");
+	MelderInfo_writeLine (U"Time sampling:");
+	MelderInfo_writeLine (U"   Number of samples: ", nx);
+	MelderInfo_writeLine (U"   Sampling period: ", dx, U" seconds");
+	MelderInfo_writeLine (U"   Sampling frequency: ", Melder_single (1.0 / dx), U" Hz");
+	MelderInfo_writeLine (U"   First sample centred at: ", x1, U" seconds");
+	MelderInfo_writeLine (U"Memory use: ", Melder_bigInteger ((int64) numberOfChannels * nx * (storage == CompactSound_INT16 ? 2 : 4)), U" bytes");
+}
+
+void structCompactSound :: v_copy (Daata thee_Daata) {
+	CompactSound thee = static_cast <CompactSound> (thee_Daata);
+	CompactSound_Parent :: v_copy (thee);
+	thy numberOfChannels = numberOfChannels;
+	thy storage = storage;
+	thy shorts = NUMmatrix_copy <int16> (shorts, 1, numberOfChannels, 1, nx);
+	thy floats = NUMmatrix_copy <float> (floats, 1, numberOfChannels, 1, nx);
+}
+
+autoCompactSound CompactSound_create (long numberOfChannels, double xmin, double xmax, long nx, double dx, double x1, int storage) {
+	try {
+		autoCompactSound me = Thing_new (CompactSound);
+		Sampled_init (me.get(), xmin, xmax, nx, dx, x1);
+		my numberOfChannels = numberOfChannels;
+		my storage = storage;
+		if (storage == CompactSound_INT16)
+			my shorts = NUMmatrix <int16> (1, numberOfChannels, 1, nx);
+		else
+			my floats = NUMmatrix <float> (1, numberOfChannels, 1, nx);
+		return me;
+	} catch (MelderError) {
+		Melder_throw (U"CompactSound not created.");
+	}
+}
+
+static void CompactSound_setSamples (CompactSound me, long channel, long first, long n, const double *from) {
+	if (my storage == CompactSound_INT16) {
+		int16 *to = my shorts [channel] + first - 1;
+		for (long i = 1; i <= n; i ++) {
+			double value = round (from [i] * 32768.0);
+			to [i] = (int16) ( value < -32768.0 ? -32768.0 : value > 32767.0 ? 32767.0 : value );
+		}
+	} else {
+		float *to = my floats [channel] + first - 1;
+		for (long i = 1; i <= n; i ++)
+			to [i] = (float) from [i];
+	}
+}
+
+autoCompactSound Sound_to_CompactSound (Sound me, int storage) {
+	try {
+		autoCompactSound thee = CompactSound_create (my ny, my xmin, my xmax, my nx, my dx, my x1, storage);
+		for (long channel = 1; channel <= my ny; channel ++)
+			CompactSound_setSamples (thee.get(), channel, 1, my nx, my z [channel]);
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": not converted to CompactSound.");
+	}
+}
+
+autoSound CompactSound_to_Sound (CompactSound me) {
+	try {
+		autoSound thee = Sound_create (my numberOfChannels, my xmin, my xmax, my nx, my dx, my x1);
+		for (long channel = 1; channel <= my numberOfChannels; channel ++) {
+			double *to = thy z [channel];
+			if (my storage == CompactSound_INT16) {
+				CompactSound_Int16Accessor samples (me);
+				for (long i = 1; i <= my nx; i ++) to [i] = samples (channel, i);
+			} else {
+				CompactSound_Float32Accessor samples (me);
+				for (long i = 1; i <= my nx; i ++) to [i] = samples (channel, i);
+			}
+		}
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": not converted to Sound.");
+	}
+}
+
+autoCompactSound CompactSound_readFromSoundFile (MelderFile file) {
+	try {
+		autoLongSound source = LongSound_open (file);
+		int encoding = source -> encoding;
+		bool atMost16bits =
+			encoding == Melder_LINEAR_8_SIGNED || encoding == Melder_LINEAR_8_UNSIGNED ||
+			encoding == Melder_LINEAR_16_BIG_ENDIAN || encoding == Melder_LINEAR_16_LITTLE_ENDIAN ||
+			encoding == Melder_MULAW || encoding == Melder_ALAW || encoding == Melder_FLAC_COMPRESSION_16;
+		autoCompactSound me = CompactSound_create (source -> numberOfChannels, source -> xmin, source -> xmax,
+			source -> nx, source -> dx, source -> x1, atMost16bits ? CompactSound_INT16 : CompactSound_FLOAT32);
+		const long stretchLength = 65536;
+		autoNUMmatrix <double> stretch (1, my numberOfChannels, 1, stretchLength);
+		for (long first = 1; first <= my nx; first += stretchLength) {
+			long n = my nx - first + 1;
+			if (n > stretchLength) n = stretchLength;
+			LongSound_readAudioToFloat (source.get(), stretch.peek(), first, n);
+			for (long channel = 1; channel <= my numberOfChannels; channel ++)
+				CompactSound_setSamples (me.get(), channel, first, n, stretch [channel]);
+		}
+		return me;
+	} catch (MelderError) {
+		Melder_throw (U"CompactSound not read from sound file ", file, U".");
+	}
+}
+
+/* End of file CompactSound.cpp */
@@ -0,0 +1,87 @@
+#ifndef _CompactSound_h_
+#define _CompactSound_h_
+/* CompactSound.h
+ *
+ * Copyright (C) 2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Sound.h"
+
+#define CompactSound_INT16  1
+#define CompactSound_FLOAT32  2
+
+Thing_define (CompactSound, Sampled) {
+	long numberOfChannels;
+	int storage;   // CompactSound_INT16 or CompactSound_FLOAT32
+	int16 **shorts;   // [1..numberOfChannels] [1..nx] if storage == CompactSound_INT16; the amplitude is shorts [channel] [i] / 32768
+	float **floats;   // [1..numberOfChannels] [1..nx] if storage == CompactSound_FLOAT32
+
+	void v_destroy () noexcept
+		override;
+	void v_info ()
+		override;
+	void v_copy (Daata data_to)
+		override;
+	bool v_writable ()
+		override { return false; }
+	int v_domainQuantity ()
+		override { return MelderQuantity_TIME_SECONDS; }
+};
+
+/*
+	A CompactSound holds the samples of a sound in 2 (int16) or 4 (float32) bytes each, instead of the 8 bytes of a Sound.
+	The time attributes are those of a Sound (xmin, xmax, nx, dx, x1).
+	Int16 storage is exact for sound files with at most 16 bits per sample; amplitudes outside [-1, +1) are clipped.
+	Float32 storage keeps about 7 significant digits.
+*/
+
+autoCompactSound CompactSound_create (long numberOfChannels, double xmin, double xmax, long nx, double dx, double x1, int storage);
+
+autoCompactSound Sound_to_CompactSound (Sound me, int storage);
+autoSound CompactSound_to_Sound (CompactSound me);
+
+autoCompactSound CompactSound_readFromSoundFile (MelderFile file);
+/*
+	Read the file stretch by stretch, never holding more than a few seconds as 8-byte samples.
+	Files with at most 16 bits per sample are stored as int16, all others as float32.
+*/
+
+/*
+	Typed sample accessors.
+	An analysis kernel that is written as a template on its accessor
+	reads the samples of a Sound or a CompactSound where they are, without widening the whole signal:
+		samples (channel, i)
+	is sample i of the given channel as a double.
+	The constructors take the Sound or CompactSound, which the kernel may only know as a Sampled.
+*/
+struct Sound_SampleAccessor {
+	double **z;
+	Sound_SampleAccessor (Sampled sound) : z (static_cast <Sound> (sound) -> z) { }
+	double operator() (long channel, long i) const { return z [channel] [i]; }
+};
+struct CompactSound_Int16Accessor {
+	int16 **z;
+	CompactSound_Int16Accessor (Sampled sound) : z (static_cast <CompactSound> (sound) -> shorts) { }
+	double operator() (long channel, long i) const { return z [channel] [i] * (1.0 / 32768.0); }
+};
+struct CompactSound_Float32Accessor {
+	float **z;
+	CompactSound_Float32Accessor (Sampled sound) : z (static_cast <CompactSound> (sound) -> floats) { }
+	double operator() (long channel, long i) const { return z [channel] [i]; }
+};
+
+/* End of file CompactSound.h */
+#endif
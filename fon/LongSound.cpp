@@ -43,8 +43,11 @@
 
 #include "LongSound.h"
 #include "Preferences.h"
+#include "abcio.h"
 #include "flac_FLAC_stream_decoder.h"
 #include "mp3.h"
+#include <string>
+#include <vector>
 
 Thing_implement (LongSound, Sampled, 0);
 Thing_implement (SoundAndLongSoundList, Ordered, 0);
@@ -75,6 +78,8 @@ void structLongSound :: v_destroy () noexcept {
 	}
 	else if (f) fclose (f);
 	NUMvector_free <int16> (buffer, 0);
+	NUMvector_free <int64> (flacFrameFirstSamples, 1);
+	NUMvector_free <int64> (flacFrameOffsets, 1);
 	LongSound_Parent :: v_destroy ();
 }
 
@@ -142,6 +147,18 @@ static FLAC__StreamDecoderWriteStatus _LongSound_FLAC_write (const FLAC__StreamD
 	long numberOfSamples = header -> blocksize;
 	long bitsPerSample = header -> bits_per_sample;
 	(void) decoder;
+	if (my compressedSamplesToSkip > 0) {
+		/*
+		 * We sought to the start of the frame that contains the first sample we want.
+		 */
+		long numberOfSamplesToSkip = my compressedSamplesToSkip < numberOfSamples ? my compressedSamplesToSkip : numberOfSamples;
+		const FLAC__int32 *rest [FLAC__MAX_CHANNELS] = { nullptr };
+		for (unsigned channel = 0; channel < header -> channels; channel ++)
+			rest [channel] = buffer [channel] + numberOfSamplesToSkip;
+		my compressedSamplesToSkip -= numberOfSamplesToSkip;
+		numberOfSamples -= numberOfSamplesToSkip;
+		buffer = rest;
+	}
 	if (numberOfSamples > my compressedSamplesLeft)
 		numberOfSamples = my compressedSamplesLeft;
 	if (numberOfSamples == 0)
@@ -193,11 +210,334 @@ static void _LongSound_MP3_convert (const MP3F_SAMPLE *channels [MP3F_MAX_CHANNE
 	my compressedSamplesLeft -= numberOfSamples;
 }
 
+/*
+	Seek indexes.
+	Finding the frames of an MP3 or FLAC file requires reading the whole file.
+	We do that only once per sound file: the positions of the frames are saved in the preferences directory,
+	together with the size and modification time of the sound file, and are used as long as these stay the same.
+*/
+
+#define SEEK_INDEX_MAGIC  "Praat seek index"   // 16 bytes
+#define SEEK_INDEX_MP3  1
+#define SEEK_INDEX_FLAC  2
+
+static bool LongSound_getSeekIndexFile (LongSound me, MelderFile indexFile) {
+	extern structMelderDir praatDir;
+	if (MelderDir_isNull (& praatDir))
+		return false;
+	Melder_createDirectory (& praatDir, U"seekIndexes", 0777);
+	structMelderDir indexDir { { 0 } };
+	MelderDir_getSubdir (& praatDir, U"seekIndexes", & indexDir);
+	size_t hash = std::hash <std::u32string> () (my file. path);
+	MelderDir_getFile (& indexDir, Melder_cat (Melder_integer ((int64) (hash >> 1)), U".index"), indexFile);
+	return true;
+}
+
+static bool LongSound_readSeekIndex (LongSound me, int kind) {
+	try {
+		structMelderFile indexFile { 0 };
+		if (! LongSound_getSeekIndexFile (me, & indexFile) || ! MelderFile_exists (& indexFile))
+			return false;
+		autofile f = Melder_fopen (& indexFile, "rb");
+		char magic [16];
+		if (fread (magic, 1, 16, f) != 16 || ! strnequ (magic, SEEK_INDEX_MAGIC, 16) ||
+			(int) bingetu1 (f) != kind ||
+			bingetr8 (f) != MelderFile_length (& my file) ||
+			bingetr8 (f) != MelderFile_modificationTime (& my file))
+		{
+			return false;   // another version, or the sound file has changed
+		}
+		if (kind == SEEK_INDEX_MP3) {
+			unsigned numberOfChannels = bingetu4LE (f), sampleRate = bingetu4LE (f), samplesPerFrame = bingetu4LE (f);
+			unsigned numberOfFrames = bingetu4LE (f);
+			if (numberOfFrames == 0)
+				return false;
+			std::vector <MP3F_OFFSET> offsets (numberOfFrames);
+			MP3F_OFFSET offset = 0;
+			for (unsigned iframe = 0; iframe < numberOfFrames; iframe ++)
+				offsets [iframe] = offset += bingetu4LE (f);
+			f.close (& indexFile);
+			return mp3f_restore (my mp3f, numberOfChannels, sampleRate, samplesPerFrame, numberOfFrames, & offsets [0]);
+		} else {
+			long numberOfFrames = bingetu4LE (f);
+			if (numberOfFrames == 0) {
+				f.close (& indexFile);
+				return true;   // the frames could not be found before: seek with the decoder's own search
+			}
+			autoNUMvector <int64> firstSamples (1, numberOfFrames), offsets (1, numberOfFrames);
+			int64 sample = 0, offset = 0;
+			for (long iframe = 1; iframe <= numberOfFrames; iframe ++) {
+				firstSamples [iframe] = sample += bingetu4LE (f);
+				offsets [iframe] = offset += bingetu4LE (f);
+			}
+			f.close (& indexFile);
+			my numberOfFlacFrames = numberOfFrames;
+			my flacFrameFirstSamples = firstSamples.transfer();
+			my flacFrameOffsets = offsets.transfer();
+			return true;
+		}
+	} catch (MelderError) {
+		Melder_clearError ();
+		return false;
+	}
+}
+
+static void LongSound_writeSeekIndex (LongSound me, int kind) {
+	try {
+		structMelderFile indexFile { 0 };
+		if (! LongSound_getSeekIndexFile (me, & indexFile))
+			return;
+		autofile f = Melder_fopen (& indexFile, "wb");
+		fwrite (SEEK_INDEX_MAGIC, 1, 16, f);
+		binputu1 (kind, f);
+		binputr8 (MelderFile_length (& my file), f);
+		binputr8 (MelderFile_modificationTime (& my file), f);
+		if (kind == SEEK_INDEX_MP3) {
+			binputu4LE (mp3f_channels (my mp3f), f);
+			binputu4LE (mp3f_frequency (my mp3f), f);
+			binputu4LE (mp3f_samples_per_frame (my mp3f), f);
+			unsigned numberOfFrames = mp3f_frames (my mp3f);
+			const MP3F_OFFSET *offsets = mp3f_frame_offsets (my mp3f);
+			binputu4LE (numberOfFrames, f);
+			for (unsigned iframe = 0; iframe < numberOfFrames; iframe ++)
+				binputu4LE ((uint32) (offsets [iframe] - ( iframe == 0 ? 0 : offsets [iframe - 1] )), f);
+		} else {
+			binputu4LE ((uint32) my numberOfFlacFrames, f);
+			for (long iframe = 1; iframe <= my numberOfFlacFrames; iframe ++) {
+				binputu4LE ((uint32) (my flacFrameFirstSamples [iframe] - ( iframe == 1 ? 0 : my flacFrameFirstSamples [iframe - 1] )), f);
+				binputu4LE ((uint32) (my flacFrameOffsets [iframe] - ( iframe == 1 ? 0 : my flacFrameOffsets [iframe - 1] )), f);
+			}
+		}
+		f.close (& indexFile);
+	} catch (MelderError) {
+		Melder_clearError ();   // the index is only a cache
+	}
+}
+
+static void _LongSound_MP3_open (LongSound me) {
+	my mp3f = mp3f_new ();
+	mp3f_set_file (my mp3f, my f);
+	mp3f_set_callback (my mp3f, _LongSound_MP3_convert, me);
+	if (! LongSound_readSeekIndex (me, SEEK_INDEX_MP3)) {
+		if (! mp3f_analyze (my mp3f))
+			Melder_throw (U"Unable to analyze MP3 file.");
+		LongSound_writeSeekIndex (me, SEEK_INDEX_MP3);
+	}
+	my audioFileType = Melder_MP3;
+	my encoding = Melder_MPEG_COMPRESSION_16;
+	my numberOfChannels = mp3f_channels (my mp3f);
+	my sampleRate = mp3f_frequency (my mp3f);
+	my startOfData = 0;   // meaningless
+	my nx = mp3f_samples (my mp3f);
+	if ((MP3F_OFFSET) my nx != mp3f_samples (my mp3f))
+		Melder_throw (U"MP3 file too long.");
+}
+
+/*
+ * A FLAC frame header starts with the sync code 0xFFF8 (fixed block size) or 0xFFF9 (variable block size),
+ * contains the frame number or the first sample number in UTF-8 coding, and ends in a CRC-8.
+ * Its length is returned, or 0 if the bytes at `p` (at least 16 of them) are not a valid header.
+ */
+static long _LongSound_FLAC_parseFrameHeader (const unsigned char *p, int64 *number, long *blocksize) {
+	if (p [0] != 0xFF || (p [1] & 0xFE) != 0xF8 || (p [3] & 1) != 0)
+		return 0;
+	const int blocksizeCode = p [2] >> 4, sampleRateCode = p [2] & 15;
+	if (blocksizeCode == 0 || sampleRateCode == 15 || (p [3] >> 4) > 10 || ((p [3] >> 1) & 7) == 3 || ((p [3] >> 1) & 7) == 7)
+		return 0;
+	long length = 4;
+	/*
+	 * The UTF-8-coded number.
+	 */
+	int numberOfExtraBytes = 0;
+	uint32_t first = p [length ++];
+	if ((first & 0x80) == 0)
+		*number = first;
+	else {
+		while (first & (0x40 >> numberOfExtraBytes))
+			numberOfExtraBytes ++;
+		if (numberOfExtraBytes == 0 || numberOfExtraBytes > 6)
+			return 0;
+		*number = first & (0x3F >> numberOfExtraBytes);
+		for (int i = 1; i <= numberOfExtraBytes; i ++) {
+			if ((p [length] & 0xC0) != 0x80)
+				return 0;
+			*number = (*number << 6) | (p [length ++] & 0x3F);
+		}
+	}
+	if (blocksizeCode == 1)
+		*blocksize = 192;
+	else if (blocksizeCode <= 5)
+		*blocksize = 576L << (blocksizeCode - 2);
+	else if (blocksizeCode == 6)
+		*blocksize = p [length ++] + 1;
+	else if (blocksizeCode == 7) {
+		*blocksize = ((p [length] << 8) | p [length + 1]) + 1;
+		length += 2;
+	} else
+		*blocksize = 256L << (blocksizeCode - 8);
+	if (sampleRateCode == 12)
+		length += 1;
+	else if (sampleRateCode == 13 || sampleRateCode == 14)
+		length += 2;
+	unsigned int crc = 0;   // CRC-8 with polynomial x^8 + x^2 + x + 1
+	for (long i = 0; i < length; i ++) {
+		crc ^= p [i];
+		for (int bit = 0; bit < 8; bit ++)
+			crc = crc & 0x80 ? ((crc << 1) ^ 0x07) & 0xFF : crc << 1;
+	}
+	return crc == p [length] ? length + 1 : 0;
+}
+
+/*
+ * The number of channels that the channel assignment in the high nibble of byte 3 of a frame header stands for:
+ * 1 to 8 independent channels, or 2 for left/side, right/side and mid/side stereo.
+ */
+static int _LongSound_FLAC_numberOfChannels (const unsigned char *header) {
+	const int channelAssignment = header [3] >> 4;
+	return channelAssignment < 8 ? channelAssignment + 1 : 2;
+}
+
+/*
+ * Record the first sample and the file offset of each frame.
+ * The search for the next sync code uses the position of the previous frame, and a candidate counts only
+ * if its CRC is correct, its number is the expected one, its sample rate and sample size are those of the first frame,
+ * and its channel assignment is one for the number of channels of the file (the assignment itself can change
+ * from frame to frame in stereo files), so that a sync pattern inside the compressed data is practically never
+ * mistaken for a frame.
+ */
+static bool _LongSound_FLAC_scanFrames (LongSound me, int64 firstFrameOffset, std::vector <int64> *firstSamples, std::vector <int64> *offsets) {
+	try {
+		const long bufferSize = 1 << 20, margin = 16;
+		std::vector <unsigned char> buffer (bufferSize + margin);
+		int64 bufferOffset = firstFrameOffset;   // file offset of buffer [0]
+		if (fseeko (my f, firstFrameOffset, SEEK_SET))
+			return false;
+		long numberOfBytesInBuffer = fread (buffer.data (), 1, bufferSize + margin, my f);
+		bool endOfFile = numberOfBytesInBuffer < bufferSize + margin;
+		int64 sample = 0, number;
+		long position = 0, blocksize;
+		bool variableBlocksize = false;
+		unsigned char fixedFields [2] = { 0, 0 };
+		for (;;) {
+			/*
+			 * Here `position` is at the start of a known frame.
+			 */
+			unsigned char header [margin] = { 0 };
+			memcpy (header, & buffer [position], std::min ((long) margin, numberOfBytesInBuffer - position));
+			const long headerLength = _LongSound_FLAC_parseFrameHeader (header, & number, & blocksize);
+			if (headerLength == 0 || _LongSound_FLAC_numberOfChannels (header) != my numberOfChannels)
+				return false;
+			if (firstSamples -> empty ()) {
+				variableBlocksize = header [1] & 1;
+				fixedFields [0] = header [2] & 15;
+				fixedFields [1] = header [3] & 15;
+			}
+			if (number != (variableBlocksize ? sample : (int64) firstSamples -> size ()))
+				return false;
+			firstSamples -> push_back (sample);
+			offsets -> push_back (bufferOffset + position);
+			sample += blocksize;
+			/*
+			 * Look for the next frame.
+			 */
+			long candidate = position + headerLength;
+			for (;;) {
+				if (candidate + margin > numberOfBytesInBuffer) {
+					if (endOfFile && candidate >= numberOfBytesInBuffer)
+						return sample == my nx;   // the last frame ends at the end of the file
+					if (! endOfFile) {
+						/*
+						 * Shift the part from the current frame on to the start of the buffer, and refill.
+						 */
+						long keep = numberOfBytesInBuffer - position;
+						if (keep >= bufferSize)
+							return false;   // a frame of a megabyte cannot be a FLAC frame
+						memmove (buffer.data (), & buffer [position], keep);
+						bufferOffset += position;
+						candidate -= position;
+						position = 0;
+						long numberOfBytesRead = fread (& buffer [keep], 1, bufferSize + margin - keep, my f);
+						numberOfBytesInBuffer = keep + numberOfBytesRead;
+						endOfFile = numberOfBytesInBuffer < bufferSize + margin;
+						continue;
+					}
+				}
+				const unsigned char *found = (const unsigned char *) memchr (& buffer [candidate], 0xFF, numberOfBytesInBuffer - candidate);
+				if (! found) {
+					candidate = numberOfBytesInBuffer;
+					continue;
+				}
+				candidate = found - buffer.data ();
+				if (candidate + margin > numberOfBytesInBuffer && ! endOfFile)
+					continue;   // refill first
+				unsigned char next [margin] = { 0 };
+				memcpy (next, found, std::min ((long) margin, numberOfBytesInBuffer - candidate));
+				int64 nextNumber;
+				long nextBlocksize;
+				if (_LongSound_FLAC_parseFrameHeader (next, & nextNumber, & nextBlocksize) &&
+					(next [1] & 1) == variableBlocksize && (next [2] & 15) == fixedFields [0] && (next [3] & 15) == fixedFields [1] &&
+					_LongSound_FLAC_numberOfChannels (next) == my numberOfChannels &&
+					nextNumber == (variableBlocksize ? sample : (int64) firstSamples -> size ()))
+				{
+					position = candidate;
+					break;
+				}
+				candidate ++;
+			}
+		}
+	} catch (MelderError) {
+		Melder_clearError ();
+		return false;
+	}
+}
+
+static void _LongSound_FLAC_open (LongSound me) {
+	my flacDecoder = FLAC__stream_decoder_new ();
+	FLAC__stream_decoder_init_FILE (my flacDecoder, my f, _LongSound_FLAC_write, nullptr, _LongSound_FLAC_error, me);
+	if (! FLAC__stream_decoder_process_until_end_of_metadata (my flacDecoder))
+		Melder_throw (U"Cannot read the metadata of FLAC file ", & my file, U".");
+	if (LongSound_readSeekIndex (me, SEEK_INDEX_FLAC))
+		return;
+	/*
+	 * Find the frames by their headers, without decoding them.
+	 */
+	std::vector <int64> firstSamples, offsets;
+	FLAC__uint64 firstFrameOffset;
+	if (! FLAC__stream_decoder_get_decode_position (my flacDecoder, & firstFrameOffset))
+		return;   // no index; seek with the decoder's own search
+	if (! _LongSound_FLAC_scanFrames (me, (int64) firstFrameOffset, & firstSamples, & offsets)) {
+		/*
+		 * Seek with the decoder's own search, and remember that in an index without frames,
+		 * so that the file is not scanned again the next time it is opened.
+		 */
+		fseeko (my f, (int64) firstFrameOffset, SEEK_SET);
+		FLAC__stream_decoder_flush (my flacDecoder);
+		LongSound_writeSeekIndex (me, SEEK_INDEX_FLAC);
+		return;
+	}
+	fseeko (my f, (int64) firstFrameOffset, SEEK_SET);
+	FLAC__stream_decoder_flush (my flacDecoder);
+	my numberOfFlacFrames = firstSamples.size ();
+	my flacFrameFirstSamples = NUMvector <int64> (1, my numberOfFlacFrames);
+	my flacFrameOffsets = NUMvector <int64> (1, my numberOfFlacFrames);
+	for (long iframe = 1; iframe <= my numberOfFlacFrames; iframe ++) {
+		my flacFrameFirstSamples [iframe] = firstSamples [iframe - 1];
+		my flacFrameOffsets [iframe] = offsets [iframe - 1];
+	}
+	LongSound_writeSeekIndex (me, SEEK_INDEX_FLAC);
+}
+
 static void LongSound_init (LongSound me, MelderFile file) {
 	MelderFile_copy (file, & my file);
 	MelderFile_open (file);   // BUG: should be auto, but that requires an implemented .transfer()
 	my f = file -> filePointer;
-	my audioFileType = MelderFile_checkSoundFile (file, & my numberOfChannels, & my encoding, & my sampleRate, & my startOfData, & my nx);
+	char header [16];
+	bool isMp3 = fread (header, 1, 16, my f) == 16 && mp3_recognize (16, header);
+	rewind (my f);
+	if (isMp3)
+		_LongSound_MP3_open (me);   // analyse the file only once, or not at all if it has a seek index
+	else
+		my audioFileType = MelderFile_checkSoundFile (file, & my numberOfChannels, & my encoding, & my sampleRate, & my startOfData, & my nx);
 	if (my audioFileType == 0)
 		Melder_throw (U"File not recognized (LongSound only supports AIFF, AIFC, WAV, NeXT/Sun, NIST and FLAC).");
 	if (my encoding == Melder_SHORTEN || my encoding == Melder_POLYPHONE)
@@ -225,17 +565,9 @@ static void LongSound_init (LongSound me, MelderFile file) {
 	my imin = 1;
 	my imax = 0;
 	my flacDecoder = nullptr;
-	if (my audioFileType == Melder_FLAC) {
-		my flacDecoder = FLAC__stream_decoder_new ();
-		FLAC__stream_decoder_init_FILE (my flacDecoder, my f, _LongSound_FLAC_write, nullptr, _LongSound_FLAC_error, me);
-	}
-	my mp3f = nullptr;
+	if (my audioFileType == Melder_FLAC)
+		_LongSound_FLAC_open (me);
 	if (my audioFileType == Melder_MP3) {
-		my mp3f = mp3f_new ();
-		mp3f_set_file (my mp3f, my f);
-		mp3f_set_callback (my mp3f, _LongSound_MP3_convert, me);
-		if (! mp3f_analyze (my mp3f))
-			Melder_throw (U"Unable to analyze MP3 file.");
 		Melder_warning (U"Time measurements in MP3 files can be off by several tens of milliseconds. "
 			U"Please convert to WAV file if you need time precision or annotation.");
 	}
@@ -258,10 +590,32 @@ autoLongSound LongSound_open (MelderFile file) {
 	}
 }
 
+static void _LongSound_FLAC_seek (LongSound me, long firstSample) {
+	my compressedSamplesToSkip = 0;
+	if (my numberOfFlacFrames == 0) {
+		if (! FLAC__stream_decoder_seek_absolute (my flacDecoder, firstSample))
+			Melder_throw (U"Cannot seek in FLAC file ", & my file, U".");
+		return;
+	}
+	if (firstSample < 0 || firstSample >= my nx)
+		Melder_throw (U"Cannot seek in FLAC file ", & my file, U".");
+	/*
+	 * Find the last frame that starts at or before the first sample,
+	 * and start decoding there.
+	 */
+	long lo = 1, hi = my numberOfFlacFrames;
+	while (lo < hi) {
+		long mid = (lo + hi + 1) / 2;
+		if (my flacFrameFirstSamples [mid] <= firstSample) lo = mid; else hi = mid - 1;
+	}
+	if (! FLAC__stream_decoder_flush (my flacDecoder) || fseeko (my f, my flacFrameOffsets [lo], SEEK_SET))
+		Melder_throw (U"Cannot seek in FLAC file ", & my file, U".");
+	my compressedSamplesToSkip = firstSample - my flacFrameFirstSamples [lo];
+}
+
 static void _LongSound_FLAC_process (LongSound me, long firstSample, long numberOfSamples) {
 	my compressedSamplesLeft = numberOfSamples - 1;
-	if (! FLAC__stream_decoder_seek_absolute (my flacDecoder, firstSample))
-		Melder_throw (U"Cannot seek in FLAC file ", & my file, U".");
+	_LongSound_FLAC_seek (me, firstSample);
 	while (my compressedSamplesLeft > 0) {
 		if (FLAC__stream_decoder_get_state (my flacDecoder) == FLAC__STREAM_DECODER_END_OF_STREAM)
 			Melder_throw (U"FLAC file ", & my file, U" too short.");
@@ -39,8 +39,10 @@ Thing_define (LongSound, Sampled) {
 	long imin, imax, nmax;
 	struct FLAC__StreamDecoder *flacDecoder;
 	struct _MP3_FILE *mp3f;
+	long numberOfFlacFrames;
+	int64 *flacFrameFirstSamples, *flacFrameOffsets;   // [1..numberOfFlacFrames]: the seek index of a FLAC file
 	int compressedMode;
-	long compressedSamplesLeft;
+	long compressedSamplesLeft, compressedSamplesToSkip;
 	double *compressedFloats [2];
 	int16 *compressedShorts;
 
@@ -24,6 +24,8 @@
 #include "Ltas.h"
 #include "Sound_and_Spectrum.h"
 #include "Sound_to_PointProcess.h"
+#include "NUM2.h"
+#include "MelderThread.h"
 
 Thing_implement (Ltas, Vector, 2);
 
@@ -305,50 +307,206 @@ autoLtas Sound_to_Ltas (Sound me, double bandwidth) {
 	}
 }
 
+/*
+	The energy spectra of all the periods in a PointProcess, accumulated into bands.
+
+	Every period between two half intervals around a pulse gets a discrete Fourier transform of its own length,
+	exactly as Sound_to_Spectrum (Sound_extractPart (...), false) would do, but without creating the Sound and the Spectrum.
+	The periods are sorted by length, so that consecutive periods mostly have the same length
+	and a thread needs to set up an FFT table only once for every length that it encounters.
+	Each thread accumulates into its own bands; the bands of the threads are added at the end.
+*/
+Thing_define (PointProcess_Sound_into_Ltas_Args, Thing) { public:
+	Sound sound;
+	long *firstSample, *numberOfSamples;   // per period, sorted by numberOfSamples
+	long firstPeriod, lastPeriod;
+	bool harmonics;   // if true, band i gets harmonic i; otherwise band i gets all frequencies in ((i - 1) * bandWidth, i * bandWidth]
+	double bandWidth;
+	long numberOfBands;
+	double *energies, *numbers;   // [1..numberOfBands]
+	long totalNumberOfEnergies;
+	bool isMainThread;
+	volatile int *cancelled;
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (PointProcess_Sound_into_Ltas_Args, Thing, 0);
+
+void structPointProcess_Sound_into_Ltas_Args :: v_destroy () noexcept {
+	NUMvector_free <double> (energies, 1);
+	NUMvector_free <double> (numbers, 1);
+	PointProcess_Sound_into_Ltas_Args_Parent :: v_destroy ();
+}
+
+MelderThread_MUTEX (ltas_mutex);
+static bool ltas_mutex_inited;
+
+static MelderThread_RETURN_TYPE PointProcess_Sound_into_Ltas_periods (PointProcess_Sound_into_Ltas_Args me) {
+	Sound sound = my sound;
+	autoNUMvector <double> data;
+	{// scope
+		MelderThread_LOCK (ltas_mutex);
+		data.reset (1, my numberOfSamples [my lastPeriod]);   // the longest period of this thread
+		MelderThread_UNLOCK (ltas_mutex);
+	}
+	for (long iperiod = my firstPeriod; iperiod <= my lastPeriod; ) {
+		long numberOfSamples = my numberOfSamples [iperiod];
+		autoNUMfft_Table fftTable;
+		{// scope
+			MelderThread_LOCK (ltas_mutex);
+			NUMfft_Table_init (& fftTable, numberOfSamples);
+			MelderThread_UNLOCK (ltas_mutex);
+		}
+		long numberOfFrequencies = numberOfSamples / 2 + 1;
+		double scaling = sound -> dx, frequencyStep = 1.0 / (sound -> dx * numberOfSamples);
+		for (; iperiod <= my lastPeriod && my numberOfSamples [iperiod] == numberOfSamples; iperiod ++) {
+			if (my isMainThread) {
+				try {
+					Melder_progress ((double) (iperiod - my firstPeriod) / (my lastPeriod - my firstPeriod + 1),
+						U"Sound & PointProcess: To Ltas: period ", iperiod - my firstPeriod + 1, U" out of ", my lastPeriod - my firstPeriod + 1);
+				} catch (MelderError) {
+					*my cancelled = 1;
+					throw;
+				}
+			} else if (*my cancelled) {
+				MelderThread_RETURN;
+			}
+			long offset = my firstSample [iperiod] - 1;
+			for (long i = 1; i <= numberOfSamples; i ++) {
+				long isamp = offset + i;
+				data [i] = isamp < 1 || isamp > sound -> nx ? 0.0 :   // samples outside the sound are zero
+					sound -> ny == 1 ? sound -> z [1] [isamp] : 0.5 * (sound -> z [1] [isamp] + sound -> z [2] [isamp]);
+			}
+			NUMfft_forward (& fftTable, data.peek());
+			long lastFrequency = my harmonics && my numberOfBands < numberOfFrequencies ? my numberOfBands : numberOfFrequencies;
+			for (long ifreq = 1; ifreq <= lastFrequency; ifreq ++) {
+				double realPart, imaginaryPart;
+				if (ifreq == 1) {
+					realPart = data [1] * scaling;
+					imaginaryPart = 0.0;
+				} else if (ifreq < numberOfFrequencies) {
+					realPart = data [ifreq + ifreq - 2] * scaling;
+					imaginaryPart = data [ifreq + ifreq - 1] * scaling;
+				} else if ((numberOfSamples & 1) != 0) {
+					realPart = data [numberOfSamples - 1] * scaling;
+					imaginaryPart = data [numberOfSamples] * scaling;
+				} else {
+					realPart = data [numberOfSamples] * scaling;
+					imaginaryPart = 0.0;
+				}
+				double energy = (realPart * realPart + imaginaryPart * imaginaryPart) * 2.0 * frequencyStep;
+				if (my harmonics) {
+					my energies [ifreq] += energy;
+				} else {
+					double frequency = (ifreq - 1) * frequencyStep;
+					long iband = ceil (frequency / my bandWidth);
+					if (iband >= 1 && iband <= my numberOfBands) {
+						my energies [iband] += energy;
+						my numbers [iband] += 1;
+						my totalNumberOfEnergies += 1;
+					}
+				}
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
+/*
+	Adds the energies of all periods into energies [1..numberOfBands] (and their numbers into numbers [1..numberOfBands])
+	and returns the number of periods.
+*/
+static long PointProcess_Sound_into_Ltas (PointProcess pulses, Sound sound,
+	double shortestPeriod, double longestPeriod, double maximumPeriodFactor,
+	bool harmonics, double bandWidth, long numberOfBands, double *energies, double *numbers, long *totalNumberOfEnergies)
+{
+	/*
+		Collect the periods as Sound_extractPart would see them.
+	*/
+	autoNUMvector <long> firstSample (1, pulses -> nt), numberOfSamples (1, pulses -> nt);
+	long numberOfPeriods = 0;
+	for (long ipulse = 2; ipulse < pulses -> nt; ipulse ++) {
+		double leftInterval = pulses -> t [ipulse] - pulses -> t [ipulse - 1];
+		double rightInterval = pulses -> t [ipulse + 1] - pulses -> t [ipulse];
+		double intervalFactor = leftInterval > rightInterval ? leftInterval / rightInterval : rightInterval / leftInterval;
+		if (leftInterval >= shortestPeriod && leftInterval <= longestPeriod &&
+			rightInterval >= shortestPeriod && rightInterval <= longestPeriod &&
+			intervalFactor <= maximumPeriodFactor)
+		{
+			double t1 = pulses -> t [ipulse] - 0.5 * leftInterval, t2 = pulses -> t [ipulse] + 0.5 * rightInterval;
+			long ix1 = 1 + (long) ceil ((t1 - sound -> x1) / sound -> dx);
+			long ix2 = 1 + (long) floor ((t2 - sound -> x1) / sound -> dx);
+			if (ix2 < ix1)
+				Melder_throw (U"The period around ", pulses -> t [ipulse], U" seconds contains no samples.");
+			numberOfPeriods += 1;
+			firstSample [numberOfPeriods] = ix1;
+			numberOfSamples [numberOfPeriods] = ix2 - ix1 + 1;
+		}
+	}
+	*totalNumberOfEnergies = 0;
+	if (numberOfPeriods < 1) return 0;
+	NUMsort2 (numberOfPeriods, numberOfSamples.peek(), firstSample.peek());
+
+	long minimumNumberOfPeriodsPerThread = 50;
+	int numberOfThreads = numberOfPeriods / minimumNumberOfPeriodsPerThread;
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	long numberOfPeriodsPerThread = (numberOfPeriods - 1) / numberOfThreads + 1;
+
+	if (! ltas_mutex_inited) { MelderThread_MUTEX_INIT (ltas_mutex); ltas_mutex_inited = true; }
+	autoPointProcess_Sound_into_Ltas_Args args [16];
+	volatile int cancelled = 0;
+	long firstPeriod = 1, lastPeriod = numberOfPeriodsPerThread;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		if (ithread == numberOfThreads) lastPeriod = numberOfPeriods;
+		autoPointProcess_Sound_into_Ltas_Args arg = Thing_new (PointProcess_Sound_into_Ltas_Args);
+		arg -> sound = sound;
+		arg -> firstSample = firstSample.peek();
+		arg -> numberOfSamples = numberOfSamples.peek();
+		arg -> firstPeriod = firstPeriod;
+		arg -> lastPeriod = lastPeriod;
+		arg -> harmonics = harmonics;
+		arg -> bandWidth = bandWidth;
+		arg -> numberOfBands = numberOfBands;
+		arg -> energies = NUMvector <double> (1, numberOfBands);
+		arg -> numbers = NUMvector <double> (1, numberOfBands);
+		arg -> isMainThread = ithread == numberOfThreads;
+		arg -> cancelled = & cancelled;
+		args [ithread - 1] = arg.move();
+		firstPeriod = lastPeriod + 1;
+		lastPeriod += numberOfPeriodsPerThread;
+	}
+	MelderThread_run (PointProcess_Sound_into_Ltas_periods, args, numberOfThreads);
+
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		PointProcess_Sound_into_Ltas_Args arg = args [ithread - 1].get();
+		for (long iband = 1; iband <= numberOfBands; iband ++) {
+			energies [iband] += arg -> energies [iband];
+			if (numbers) numbers [iband] += arg -> numbers [iband];
+		}
+		*totalNumberOfEnergies += arg -> totalNumberOfEnergies;
+	}
+	return numberOfPeriods;
+}
+
 autoLtas PointProcess_Sound_to_Ltas (PointProcess pulses, Sound sound,
 	double maximumFrequency, double bandWidth,
 	double shortestPeriod, double longestPeriod, double maximumPeriodFactor)
 {
 	try {
-		long numberOfPeriods = pulses -> nt - 2, totalNumberOfEnergies = 0;
 		autoLtas ltas = Ltas_create (maximumFrequency / bandWidth, bandWidth);
 		ltas -> xmax = maximumFrequency;
 		autoLtas numbers = Data_copy (ltas.get());
-		if (numberOfPeriods < 1)
+		if (pulses -> nt < 3)
 			Melder_throw (U"Cannot compute an Ltas if there are no periods in the point process.");
 		autoMelderProgress progress (U"Ltas analysis...");
-		for (long ipulse = 2; ipulse < pulses -> nt; ipulse ++) {
-			double leftInterval = pulses -> t [ipulse] - pulses -> t [ipulse - 1];
-			double rightInterval = pulses -> t [ipulse + 1] - pulses -> t [ipulse];
-			double intervalFactor = leftInterval > rightInterval ? leftInterval / rightInterval : rightInterval / leftInterval;
-			Melder_progress ((double) ipulse / pulses -> nt, U"Sound & PointProcess: To Ltas: pulse ", ipulse, U" out of ", pulses -> nt);
-			if (leftInterval >= shortestPeriod && leftInterval <= longestPeriod &&
-				rightInterval >= shortestPeriod && rightInterval <= longestPeriod &&
-				intervalFactor <= maximumPeriodFactor)
-			{
-				/*
-				 * We have a period! Compute the spectrum.
-				 */
-				autoSound period = Sound_extractPart (sound,
-					pulses -> t [ipulse] - 0.5 * leftInterval, pulses -> t [ipulse] + 0.5 * rightInterval,
-					kSound_windowShape_RECTANGULAR, 1.0, false);
-				autoSpectrum spectrum = Sound_to_Spectrum (period.get(), false);
-				for (long ifreq = 1; ifreq <= spectrum -> nx; ifreq ++) {
-					double frequency = spectrum -> xmin + (ifreq - 1) * spectrum -> dx;
-					double realPart = spectrum -> z [1] [ifreq];
-					double imaginaryPart = spectrum -> z [2] [ifreq];
-					double energy = (realPart * realPart + imaginaryPart * imaginaryPart) * 2.0 * spectrum -> dx /* OLD: * sound -> nx */;
-					long iband = ceil (frequency / bandWidth);
-					if (iband >= 1 && iband <= ltas -> nx) {
-						ltas -> z [1] [iband] += energy;
-						numbers -> z [1] [iband] += 1;
-						totalNumberOfEnergies += 1;
-					}
-				}
-			} else {
-				numberOfPeriods -= 1;
-			}
-		}
+		long totalNumberOfEnergies;
+		long numberOfPeriods = PointProcess_Sound_into_Ltas (pulses, sound, shortestPeriod, longestPeriod, maximumPeriodFactor,
+			false, bandWidth, ltas -> nx, ltas -> z [1], numbers -> z [1], & totalNumberOfEnergies);
 		if (numberOfPeriods < 1)
 			Melder_throw (U"There are no periods in the point process.");
 		for (long iband = 1; iband <= ltas -> nx; iband ++) {
@@ -423,40 +581,14 @@ autoLtas PointProcess_Sound_to_Ltas_harmonics (PointProcess pulses, Sound sound,
 	double shortestPeriod, double longestPeriod, double maximumPeriodFactor)
 {
 	try {
-		long numberOfPeriods = pulses -> nt - 2;
 		autoLtas ltas = Ltas_create (maximumHarmonic, 1.0);
 		ltas -> xmax = maximumHarmonic;
-		if (numberOfPeriods < 1)
+		if (pulses -> nt < 3)
 			Melder_throw (U"There are no periods in the point process.");
 		autoMelderProgress progress (U"LTAS (harmonics) analysis...");
-		for (long ipulse = 2; ipulse < pulses -> nt; ipulse ++) {
-			double leftInterval = pulses -> t [ipulse] - pulses -> t [ipulse - 1];
-			double rightInterval = pulses -> t [ipulse + 1] - pulses -> t [ipulse];
-			double intervalFactor = leftInterval > rightInterval ? leftInterval / rightInterval : rightInterval / leftInterval;
-			Melder_progress ((double) ipulse / pulses -> nt, U"Sound & PointProcess: To Ltas: pulse ", ipulse, U" out of ", pulses -> nt);
-			if (leftInterval >= shortestPeriod && leftInterval <= longestPeriod &&
-				rightInterval >= shortestPeriod && rightInterval <= longestPeriod &&
-				intervalFactor <= maximumPeriodFactor)
-			{
-				/*
-				 * We have a period! Compute the spectrum.
-				 */
-				long localMaximumHarmonic;
-				autoSound period = Sound_extractPart (sound,
-					pulses -> t [ipulse] - 0.5 * leftInterval, pulses -> t [ipulse] + 0.5 * rightInterval,
-					kSound_windowShape_RECTANGULAR, 1.0, false);
-				autoSpectrum spectrum = Sound_to_Spectrum (period.get(), false);
-				localMaximumHarmonic = maximumHarmonic < spectrum -> nx ? maximumHarmonic : spectrum -> nx;
-				for (long iharm = 1; iharm <= localMaximumHarmonic; iharm ++) {
-					double realPart = spectrum -> z [1] [iharm];
-					double imaginaryPart = spectrum -> z [2] [iharm];
-					double energy = (realPart * realPart + imaginaryPart * imaginaryPart) * 2.0 * spectrum -> dx;
-					ltas -> z [1] [iharm] += energy;
-				}
-			} else {
-				numberOfPeriods -= 1;
-			}
-		}
+		long totalNumberOfEnergies;
+		long numberOfPeriods = PointProcess_Sound_into_Ltas (pulses, sound, shortestPeriod, longestPeriod, maximumPeriodFactor,
+			true, 1.0, ltas -> nx, ltas -> z [1], nullptr, & totalNumberOfEnergies);
 		if (numberOfPeriods < 1)
 			Melder_throw (U"There are no periods in the point process.");
 		for (long iharm = 1; iharm <= ltas -> nx; iharm ++) {
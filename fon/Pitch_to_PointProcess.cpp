@@ -35,6 +35,7 @@
 #include "Pitch_to_PointProcess.h"
 #include "PitchTier_to_PointProcess.h"
 #include "Pitch_to_PitchTier.h"
+#include "MelderThread.h"
 #include <ctype.h>
 
 autoPointProcess Pitch_to_PointProcess (Pitch pitch) {
@@ -135,15 +136,25 @@ static double Sound_findMaximumCorrelation (Sound me, double t1, double windowLe
 	Melder_assert (ileft2max >= ileft2min);   // if the loop is never executed, the result will be garbage
 	for (long ileft2 = ileft2min; ileft2 <= ileft2max; ileft2 ++) {
 		double norm1 = 0.0, norm2 = 0.0, product = 0.0, localPeak = 0.0;
+		/*
+			Clip the window so that both i1 and i2 = i1 + shift lie within 1..nx;
+			this leaves the inner loop without branches.
+			The sums are still accumulated in the order of the samples, so the result does not change.
+		*/
+		long shift = ileft2 - ileft1;
+		long i1min = ileft1, i1max = iright1;
+		if (i1min < 1) i1min = 1;
+		if (i1min < 1 - shift) i1min = 1 - shift;
+		if (i1max > my nx) i1max = my nx;
+		if (i1max > my nx - shift) i1max = my nx - shift;
 		for (long ichan = 1; ichan <= my ny; ichan ++) {
-			for (long i1 = ileft1, i2 = ileft2; i1 <= iright1; i1 ++, i2 ++) {
-				if (i1 < 1 || i1 > my nx || i2 < 1 || i2 > my nx) continue;
-				double amp1 = my z [ichan] [i1], amp2 = my z [ichan] [i2];
-				norm1 += amp1 * amp1;
-				norm2 += amp2 * amp2;
-				product += amp1 * amp2;
-				if (fabs (amp2) > localPeak)
-					localPeak = fabs (amp2);
+			const double *amp1 = my z [ichan], *amp2 = my z [ichan] + shift;
+			for (long i1 = i1min; i1 <= i1max; i1 ++) {
+				double a1 = amp1 [i1], a2 = amp2 [i1], absoluteA2 = fabs (a2);
+				norm1 += a1 * a1;
+				norm2 += a2 * a2;
+				product += a1 * a2;
+				localPeak = absoluteA2 > localPeak ? absoluteA2 : localPeak;
 			}
 		}
 		r1 = r2;   // >= 0
@@ -174,80 +185,229 @@ static double Sound_findMaximumCorrelation (Sound me, double t1, double windowLe
 	return maximumCorrelation;
 }
 
+/*
+	The pulses of a voiced interval are found by walking from its middle to the left and to the right.
+	These walks only read the sound and the pitch, so the voiced intervals are tracked in parallel.
+	What connects an interval to its predecessor is the last pulse added on the right of the predecessor,
+	which a pulse found on the left of the interval should not come too close to.
+	The threads therefore record their pulses as candidates, in the order in which they were found,
+	and the candidates are added to the PointProcess afterwards, in that same order, by a single thread.
+*/
+#define PulseCandidate_MIDDLE  0
+#define PulseCandidate_LEFT  1   // added only if more than minimumDistance after the last pulse added on the right: do not fill in a short originally unvoiced interval twice
+#define PulseCandidate_RIGHT  2
+struct PulseCandidate {
+	double time, minimumDistance;
+	int kind;
+};
+
+Thing_define (Sound_Pitch_to_PointProcess_cc_Args, Thing) { public:
+	Sound sound;
+	Pitch pitch;
+	double globalPeak;
+	double *tleft, *tright;   // the voiced intervals
+	long firstInterval, lastInterval;
+	PulseCandidate *candidates;   // [1..numberOfCandidates]
+	long numberOfCandidates, maximumNumberOfCandidates;
+	bool isMainThread;
+	volatile int *cancelled;
+
+	void v_destroy () noexcept
+		override;
+};
+
+Thing_implement (Sound_Pitch_to_PointProcess_cc_Args, Thing, 0);
+
+void structSound_Pitch_to_PointProcess_cc_Args :: v_destroy () noexcept {
+	NUMvector_free <PulseCandidate> (candidates, 1);
+	Sound_Pitch_to_PointProcess_cc_Args_Parent :: v_destroy ();
+}
+
+static autoSound_Pitch_to_PointProcess_cc_Args Sound_Pitch_to_PointProcess_cc_Args_create (Sound sound, Pitch pitch, double globalPeak,
+	double *tleft, double *tright, long firstInterval, long lastInterval, bool isMainThread, volatile int *cancelled)
+{
+	autoSound_Pitch_to_PointProcess_cc_Args me = Thing_new (Sound_Pitch_to_PointProcess_cc_Args);
+	my sound = sound;
+	my pitch = pitch;
+	my globalPeak = globalPeak;
+	my tleft = tleft;
+	my tright = tright;
+	my firstInterval = firstInterval;
+	my lastInterval = lastInterval;
+	my maximumNumberOfCandidates = 100;
+	my candidates = NUMvector <PulseCandidate> (1, my maximumNumberOfCandidates);
+	my isMainThread = isMainThread;
+	my cancelled = cancelled;
+	return me;
+}
+
+MelderThread_MUTEX (cc_mutex);
+static bool cc_mutex_inited;
+
+static void Sound_Pitch_to_PointProcess_cc_Args_addCandidate (Sound_Pitch_to_PointProcess_cc_Args me, double time, double minimumDistance, int kind) {
+	if (my numberOfCandidates >= my maximumNumberOfCandidates) {
+		MelderThread_LOCK (cc_mutex);
+		long newMaximum = 2 * my maximumNumberOfCandidates;
+		PulseCandidate *newCandidates = NUMvector <PulseCandidate> (1, newMaximum);
+		NUMvector_copyElements (my candidates, newCandidates, 1, my numberOfCandidates);
+		NUMvector_free <PulseCandidate> (my candidates, 1);
+		my candidates = newCandidates;
+		my maximumNumberOfCandidates = newMaximum;
+		MelderThread_UNLOCK (cc_mutex);
+	}
+	PulseCandidate *candidate = & my candidates [++ my numberOfCandidates];
+	candidate -> time = time;
+	candidate -> minimumDistance = minimumDistance;
+	candidate -> kind = kind;
+}
+
+static MelderThread_RETURN_TYPE Sound_Pitch_findPulses_cc (Sound_Pitch_to_PointProcess_cc_Args me) {
+	Sound sound = my sound;
+	Pitch pitch = my pitch;
+	double globalPeak = my globalPeak, peak;
+	for (long interval = my firstInterval; interval <= my lastInterval; interval ++) {
+		double tleft = my tleft [interval], tright = my tright [interval];
+
+		/*
+		 * Go to the middle of the voice stretch.
+		 */
+		double tmiddle = (tleft + tright) / 2;
+		if (my isMainThread) {
+			try {
+				Melder_progress ((double) (interval - my firstInterval) / (my lastInterval - my firstInterval + 1), U"Sound & Pitch to PointProcess");
+			} catch (MelderError) {
+				*my cancelled = 1;
+				throw;
+			}
+		} else if (*my cancelled) {
+			MelderThread_RETURN;
+		}
+		double f0middle = Pitch_getValueAtTime (pitch, tmiddle, kPitch_unit_HERTZ, Pitch_LINEAR);
+
+		/*
+		 * Our first point is near this middle.
+		 */
+		if (f0middle == NUMundefined) {
+			Melder_fatal (U"Sound_Pitch_to_PointProcess_cc:"
+				U" tleft ", tleft,
+				U", tright ", tright,
+				U", f0middle ", f0middle
+			);
+		}
+		double tmax = Sound_findExtremum (sound, tmiddle - 0.5 / f0middle, tmiddle + 0.5 / f0middle, true, true);
+		Melder_assert (NUMdefined (tmax));
+		Sound_Pitch_to_PointProcess_cc_Args_addCandidate (me, tmax, 0.0, PulseCandidate_MIDDLE);
+
+		double tsave = tmax;
+		for (;;) {
+			double f0 = Pitch_getValueAtTime (pitch, tmax, kPitch_unit_HERTZ, Pitch_LINEAR), correlation;
+			if (f0 == NUMundefined) break;
+			correlation = Sound_findMaximumCorrelation (sound, tmax, 1.0 / f0, tmax - 1.25 / f0, tmax - 0.8 / f0, & tmax, & peak);
+			if (correlation == -1) /*break*/ tmax -= 1.0 / f0;   // this one period will drop out
+			if (tmax < tleft) {
+				if (correlation > 0.7 && peak > 0.023333 * globalPeak) {
+					Sound_Pitch_to_PointProcess_cc_Args_addCandidate (me, tmax, 0.8 / f0, PulseCandidate_LEFT);
+				}
+				break;
+			}
+			if (correlation > 0.3 && (peak == 0.0 || peak > 0.01 * globalPeak)) {
+				Sound_Pitch_to_PointProcess_cc_Args_addCandidate (me, tmax, 0.8 / f0, PulseCandidate_LEFT);
+			}
+		}
+		tmax = tsave;
+		for (;;) {
+			double f0 = Pitch_getValueAtTime (pitch, tmax, kPitch_unit_HERTZ, Pitch_LINEAR), correlation;
+			if (f0 == NUMundefined) break;
+			correlation = Sound_findMaximumCorrelation (sound, tmax, 1.0 / f0, tmax + 0.8 / f0, tmax + 1.25 / f0, & tmax, & peak);
+			if (correlation == -1) /*break*/ tmax += 1.0 / f0;
+			if (tmax > tright) {
+				if (correlation > 0.7 && peak > 0.023333 * globalPeak) {
+					Sound_Pitch_to_PointProcess_cc_Args_addCandidate (me, tmax, 0.0, PulseCandidate_RIGHT);
+				}
+				break;
+			}
+			if (correlation > 0.3 && (peak == 0.0 || peak > 0.01 * globalPeak)) {
+				Sound_Pitch_to_PointProcess_cc_Args_addCandidate (me, tmax, 0.0, PulseCandidate_RIGHT);
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
 autoPointProcess Sound_Pitch_to_PointProcess_cc (Sound sound, Pitch pitch) {
 	try {
 		autoPointProcess point = PointProcess_create (sound -> xmin, sound -> xmax, 10);
-		double t = pitch -> xmin;
-		double addedRight = -1e308;
-		double globalPeak = Vector_getAbsoluteExtremum (sound, sound -> xmin, sound -> xmax, 0), peak;
-		
+		double globalPeak = Vector_getAbsoluteExtremum (sound, sound -> xmin, sound -> xmax, 0);
+
 		/*
-		 * Cycle over all voiced intervals.
+		 * Collect all voiced intervals; they consist of whole frames, so there are fewer of them than frames.
 		 */
-		autoMelderProgress progress (U"Sound & Pitch: To PointProcess...");
-		for (;;) {
-			double tleft, tright;
-			if (! Pitch_getVoicedIntervalAfter (pitch, t, & tleft, & tright)) break;
-			Melder_assert (tright > t);
-
-			/*
-			 * Go to the middle of the voice stretch.
-			 */
-			double tmiddle = (tleft + tright) / 2;
-			Melder_progress ((tmiddle - sound -> xmin) / (sound -> xmax - sound -> xmin), U"Sound & Pitch to PointProcess");
-			double f0middle = Pitch_getValueAtTime (pitch, tmiddle, kPitch_unit_HERTZ, Pitch_LINEAR);
+		autoNUMvector <double> tleft (1, pitch -> nx), tright (1, pitch -> nx);
+		long numberOfIntervals = 0;
+		double totalVoicedDuration = 0.0;
+		for (double t = pitch -> xmin;; ) {
+			double left, right;
+			if (! Pitch_getVoicedIntervalAfter (pitch, t, & left, & right)) break;
+			Melder_assert (right > t);
+			Melder_assert (numberOfIntervals < pitch -> nx);
+			numberOfIntervals += 1;
+			tleft [numberOfIntervals] = left;
+			tright [numberOfIntervals] = right;
+			totalVoicedDuration += right - left;
+			t = right;
+		}
+		if (numberOfIntervals == 0) return point;
 
-			/*
-			 * Our first point is near this middle.
-			 */
-			if (f0middle == NUMundefined) {
-				Melder_fatal (U"Sound_Pitch_to_PointProcess_cc:"
-					U" tleft ", tleft,
-					U", tright ", tright,
-					U", f0middle ", f0middle
-				);
-			}
-			double tmax = Sound_findExtremum (sound, tmiddle - 0.5 / f0middle, tmiddle + 0.5 / f0middle, true, true);
-			Melder_assert (NUMdefined (tmax));
-			PointProcess_addPoint (point.get(), tmax);
+		/*
+		 * Give every thread a run of consecutive intervals with about the same voiced duration.
+		 */
+		const double minimumVoicedDurationPerThread = 0.1;   // seconds
+		int numberOfThreads = (int) (totalVoicedDuration / minimumVoicedDurationPerThread);
+		const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+		if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+		if (numberOfThreads > 16) numberOfThreads = 16;
+		if (numberOfThreads > numberOfIntervals) numberOfThreads = numberOfIntervals;
+		if (numberOfThreads < 1) numberOfThreads = 1;
 
-			double tsave = tmax;
-			for (;;) {
-				double f0 = Pitch_getValueAtTime (pitch, tmax, kPitch_unit_HERTZ, Pitch_LINEAR), correlation;
-				if (f0 == NUMundefined) break;
-				correlation = Sound_findMaximumCorrelation (sound, tmax, 1.0 / f0, tmax - 1.25 / f0, tmax - 0.8 / f0, & tmax, & peak);
-				if (correlation == -1) /*break*/ tmax -= 1.0 / f0;   // this one period will drop out
-				if (tmax < tleft) {
-					if (correlation > 0.7 && peak > 0.023333 * globalPeak && tmax - addedRight > 0.8 / f0) {
-						PointProcess_addPoint (point.get(), tmax);
-					}
-					break;
-				}
-				if (correlation > 0.3 && (peak == 0.0 || peak > 0.01 * globalPeak)) {
-					if (tmax - addedRight > 0.8 / f0) {   // do not fill in a short originally unvoiced interval twice
-						PointProcess_addPoint (point.get(), tmax);
-					}
+		if (! cc_mutex_inited) { MelderThread_MUTEX_INIT (cc_mutex); cc_mutex_inited = true; }
+		autoSound_Pitch_to_PointProcess_cc_Args args [16];
+		autoMelderProgress progress (U"Sound & Pitch: To PointProcess...");
+		volatile int cancelled = 0;
+		long firstInterval = 1;
+		double voicedDurationSoFar = 0.0;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			long lastInterval = firstInterval;
+			voicedDurationSoFar += tright [lastInterval] - tleft [lastInterval];
+			if (ithread == numberOfThreads) {
+				lastInterval = numberOfIntervals;
+			} else {
+				double target = totalVoicedDuration * ithread / numberOfThreads;
+				long maximumLastInterval = numberOfIntervals - (numberOfThreads - ithread);   // leave one interval for each later thread
+				while (lastInterval < maximumLastInterval && voicedDurationSoFar < target) {
+					lastInterval += 1;
+					voicedDurationSoFar += tright [lastInterval] - tleft [lastInterval];
 				}
 			}
-			tmax = tsave;
-			for (;;) {
-				double f0 = Pitch_getValueAtTime (pitch, tmax, kPitch_unit_HERTZ, Pitch_LINEAR), correlation;
-				if (f0 == NUMundefined) break;
-				correlation = Sound_findMaximumCorrelation (sound, tmax, 1.0 / f0, tmax + 0.8 / f0, tmax + 1.25 / f0, & tmax, & peak);
-				if (correlation == -1) /*break*/ tmax += 1.0 / f0;
-				if (tmax > tright) {
-					if (correlation > 0.7 && peak > 0.023333 * globalPeak) {
-						PointProcess_addPoint (point.get(), tmax);
-						addedRight = tmax;
-					}
-					break;
-				}
-				if (correlation > 0.3 && (peak == 0.0 || peak > 0.01 * globalPeak)) {
-					PointProcess_addPoint (point.get(), tmax);
-					addedRight = tmax;
-				}
+			args [ithread - 1] = Sound_Pitch_to_PointProcess_cc_Args_create (sound, pitch, globalPeak,
+				tleft.peek(), tright.peek(), firstInterval, lastInterval, ithread == numberOfThreads, & cancelled);
+			firstInterval = lastInterval + 1;
+		}
+		MelderThread_run (Sound_Pitch_findPulses_cc, args, numberOfThreads);
+
+		/*
+		 * Add the candidates in the order of the serial algorithm.
+		 */
+		double addedRight = -1e308;
+		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			Sound_Pitch_to_PointProcess_cc_Args thread = args [ithread - 1].get();
+			for (long icand = 1; icand <= thread -> numberOfCandidates; icand ++) {
+				PulseCandidate *candidate = & thread -> candidates [icand];
+				if (candidate -> kind == PulseCandidate_LEFT && ! (candidate -> time - addedRight > candidate -> minimumDistance))
+					continue;
+				PointProcess_addPoint (point.get(), candidate -> time);
+				if (candidate -> kind == PulseCandidate_RIGHT)
+					addedRight = candidate -> time;
 			}
-			t = tright;
 		}
 		return point;
 	} catch (MelderError) {
@@ -25,6 +25,7 @@
 #include "Sound.h"
 #include "Sound_extensions.h"
 #include "NUM2.h"
+#include "MelderThread.h"
 
 #include "enums_getText.h"
 #include "Sound_enums.h"
@@ -509,6 +510,188 @@ autoSound Sounds_concatenate (OrderedOf<structSound>& list, double overlapTime)
 	}
 }
 
+/*
+	Linear convolution by uniformly partitioned overlap-add.
+	The shorter of the two signals (the "kernel") is cut into partitions of blockSize samples,
+	whose spectra (of size 2 * blockSize) are computed once. The longer signal (the "input") is
+	transformed block by block; the spectrum of every output block is the sum of the products
+	of the spectra of the last few input blocks with the kernel partitions.
+	Memory therefore grows with the length of the kernel, not with the length of the input,
+	and different channels and stretches of the output can be computed by different threads.
+*/
+
+static long NUMconvolution_getBlockSize (long inputLength, long kernelLength) {
+	long outputLength = inputLength + kernelLength - 1, bestBlockSize = 256;
+	double bestCost = 1e308;
+	for (long blockSize = 256; ; blockSize *= 2) {
+		long numberOfPartitions = (kernelLength - 1) / blockSize + 1;
+		/*
+			Cost per output sample: a forward and a backward real FFT of size 2 * blockSize,
+			and one complex multiply-add per frequency bin per partition.
+		*/
+		double cost = 10.0 * log2 (2.0 * blockSize) + 8.0 * numberOfPartitions;
+		if (cost < bestCost) {
+			bestCost = cost;
+			bestBlockSize = blockSize;
+		}
+		if (blockSize >= outputLength || numberOfPartitions == 1) break;
+	}
+	return bestBlockSize;
+}
+
+static void NUMconvolution_getBlock (double *data, long blockSize, long iblock, double *x, long nx, bool reversed) {
+	long first = iblock * blockSize;   // 0-based
+	for (long i = 0; i < blockSize; i ++) {
+		long s = first + i;
+		data [i + 1] = s < 0 || s >= nx ? 0.0 : reversed ? x [nx - s] : x [s + 1];
+	}
+	for (long i = blockSize + 1; i <= 2 * blockSize; i ++) {
+		data [i] = 0.0;
+	}
+}
+
+Thing_define (Sound_convolve_Args, Thing) { public:
+	Sound output, input, kernel;
+	bool inputReversed;
+	long blockSize, numberOfPartitions, numberOfBlocks;
+	double **kernelSpectra;   // [(channel - 1) * numberOfPartitions + partition] [1..2 * blockSize]
+	long firstTask, lastTask;   // tasks are (channel - 1) * numberOfBlocks + output block + 1
+};
+
+Thing_implement (Sound_convolve_Args, Thing, 0);
+
+static autoSound_convolve_Args Sound_convolve_Args_create (Sound output, Sound input, bool inputReversed, Sound kernel,
+	long blockSize, long numberOfPartitions, long numberOfBlocks, double **kernelSpectra, long firstTask, long lastTask)
+{
+	autoSound_convolve_Args me = Thing_new (Sound_convolve_Args);
+	my output = output;
+	my input = input;
+	my inputReversed = inputReversed;
+	my kernel = kernel;
+	my blockSize = blockSize;
+	my numberOfPartitions = numberOfPartitions;
+	my numberOfBlocks = numberOfBlocks;
+	my kernelSpectra = kernelSpectra;
+	my firstTask = firstTask;
+	my lastTask = lastTask;
+	return me;
+}
+
+MelderThread_MUTEX (convolve_mutex);
+static bool convolve_mutex_inited;
+
+static MelderThread_RETURN_TYPE Sound_convolve_blocks (Sound_convolve_Args me) {
+	long blockSize = my blockSize, nfft = 2 * blockSize, numberOfPartitions = my numberOfPartitions;
+	autoNUMfft_Table fftTable;
+	autoNUMmatrix <double> inputSpectra;   // a ring buffer of the last numberOfPartitions input spectra
+	autoNUMvector <double> sum, tail;
+	{// scope
+		MelderThread_LOCK (convolve_mutex);
+		NUMfft_Table_init (& fftTable, nfft);
+		inputSpectra.reset (0, numberOfPartitions - 1, 1, nfft);
+		sum.reset (1, nfft);
+		tail.reset (1, blockSize);
+		MelderThread_UNLOCK (convolve_mutex);
+	}
+	long outputLength = my output -> nx;
+	for (long task = my firstTask; task <= my lastTask; ) {
+		long channel = (task - 1) / my numberOfBlocks + 1;
+		long firstBlock = (task - 1) % my numberOfBlocks;   // 0-based output blocks
+		long lastBlock = my lastTask - (channel - 1) * my numberOfBlocks - 1;
+		if (lastBlock >= my numberOfBlocks) lastBlock = my numberOfBlocks - 1;
+		task += lastBlock - firstBlock + 1;
+		Sound input = my input;
+		double *x = input -> z [input -> ny == 1 ? 1 : channel];
+		double **kernelSpectra = my kernelSpectra + (my kernel -> ny == 1 ? 0 : (channel - 1) * numberOfPartitions);
+		double *y = my output -> z [channel];
+		/*
+			Output block j consists of the second half of the inverse transform for block j - 1
+			and the first half of that for block j; the latter needs the input spectra
+			of the blocks j - numberOfPartitions + 1 .. j.
+		*/
+		for (long iblock = firstBlock - numberOfPartitions; iblock <= lastBlock; iblock ++) {
+			double *spectrum = inputSpectra [(iblock + numberOfPartitions) % numberOfPartitions];
+			NUMconvolution_getBlock (spectrum, blockSize, iblock, x, input -> nx, my inputReversed);
+			NUMfft_forward (& fftTable, spectrum);
+			if (iblock < firstBlock - 1) continue;
+			for (long i = 1; i <= nfft; i ++) {
+				sum [i] = 0.0;
+			}
+			for (long ipart = 0; ipart < numberOfPartitions; ipart ++) {
+				double *xs = inputSpectra [(iblock - ipart + 2 * numberOfPartitions) % numberOfPartitions];
+				double *hs = kernelSpectra [ipart];
+				sum [1] += xs [1] * hs [1];
+				sum [nfft] += xs [nfft] * hs [nfft];
+				for (long i = 2; i < nfft; i += 2) {
+					sum [i] += xs [i] * hs [i] - xs [i + 1] * hs [i + 1];
+					sum [i + 1] += xs [i] * hs [i + 1] + xs [i + 1] * hs [i];
+				}
+			}
+			NUMfft_backward (& fftTable, sum.peek());
+			if (iblock >= firstBlock) {
+				long offset = iblock * blockSize;
+				for (long i = 1; i <= blockSize && offset + i <= outputLength; i ++) {
+					y [offset + i] = tail [i] + sum [i];
+				}
+			}
+			for (long i = 1; i <= blockSize; i ++) {
+				tail [i] = sum [blockSize + i];
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
+/*
+	For every channel, puts into him the linear convolution of the (possibly time-reversed) samples
+	of me and thee, without any scaling. Either sound may have one channel or as many as him.
+*/
+static void Sounds_into_Sound_convolve (Sound me, bool myReversed, Sound thee, bool thyReversed, Sound him) {
+	Sound input = me, kernel = thee;
+	bool inputReversed = myReversed, kernelReversed = thyReversed;
+	if (thy nx > my nx) {
+		input = thee, kernel = me;
+		inputReversed = thyReversed, kernelReversed = myReversed;
+	}
+	long blockSize = NUMconvolution_getBlockSize (input -> nx, kernel -> nx), nfft = 2 * blockSize;
+	long numberOfPartitions = (kernel -> nx - 1) / blockSize + 1;
+	long numberOfBlocks = (his nx - 1) / blockSize + 1;
+	autoNUMfft_Table fftTable;
+	NUMfft_Table_init (& fftTable, nfft);
+	autoNUMmatrix <double> kernelSpectra (0, kernel -> ny * numberOfPartitions - 1, 1, nfft);
+	for (long channel = 1; channel <= kernel -> ny; channel ++) {
+		for (long ipart = 0; ipart < numberOfPartitions; ipart ++) {
+			double *spectrum = kernelSpectra [(channel - 1) * numberOfPartitions + ipart];
+			NUMconvolution_getBlock (spectrum, blockSize, ipart, kernel -> z [channel], kernel -> nx, kernelReversed);
+			for (long i = 1; i <= blockSize; i ++) {
+				spectrum [i] /= nfft;   // compensate for the scaling of NUMfft_backward
+			}
+			NUMfft_forward (& fftTable, spectrum);
+		}
+	}
+
+	long numberOfTasks = his ny * numberOfBlocks;
+	long minimumNumberOfTasksPerThread = 4 * numberOfPartitions > 16 ? 4 * numberOfPartitions : 16;
+	int numberOfThreads = numberOfTasks / minimumNumberOfTasksPerThread;
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+	if (numberOfThreads > 16) numberOfThreads = 16;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	long numberOfTasksPerThread = (numberOfTasks - 1) / numberOfThreads + 1;
+
+	if (! convolve_mutex_inited) { MelderThread_MUTEX_INIT (convolve_mutex); convolve_mutex_inited = true; }
+	autoSound_convolve_Args args [16];
+	long firstTask = 1, lastTask = numberOfTasksPerThread;
+	for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		if (ithread == numberOfThreads) lastTask = numberOfTasks;
+		args [ithread - 1] = Sound_convolve_Args_create (him, input, inputReversed, kernel,
+			blockSize, numberOfPartitions, numberOfBlocks, kernelSpectra.peek(), firstTask, lastTask);
+		firstTask = lastTask + 1;
+		lastTask += numberOfTasksPerThread;
+	}
+	MelderThread_run (Sound_convolve_blocks, args, numberOfThreads);
+}
+
 autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain) {
 	try {
 		if (my ny > 1 && thy ny > 1 && my ny != thy ny)
@@ -516,34 +699,10 @@ autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling s
 		if (my dx != thy dx)
 			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
 		long n1 = my nx, n2 = thy nx;
-		long n3 = n1 + n2 - 1, nfft = 1;
-		while (nfft < n3) nfft *= 2;
-		autoNUMvector <double> data1 (1, nfft);
-		autoNUMvector <double> data2 (1, nfft);
+		long n3 = n1 + n2 - 1;
 		long numberOfChannels = my ny > thy ny ? my ny : thy ny;
 		autoSound him = Sound_create (numberOfChannels, my xmin + thy xmin, my xmax + thy xmax, n3, my dx, my x1 + thy x1);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [my ny == 1 ? 1 : channel];
-			for (long i = n1; i > 0; i --) data1 [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
-			a = thy z [thy ny == 1 ? 1 : channel];
-			for (long i = n2; i > 0; i --) data2 [i] = a [i];
-			for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
-			NUMrealft (data1.peek(), nfft, 1);
-			NUMrealft (data2.peek(), nfft, 1);
-			data2 [1] *= data1 [1];
-			data2 [2] *= data1 [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				double temp = data1 [i] * data2 [i] - data1 [i + 1] * data2 [i + 1];
-				data2 [i + 1] = data1 [i] * data2 [i + 1] + data1 [i + 1] * data2 [i];
-				data2 [i] = temp;
-			}
-			NUMrealft (data2.peek(), nfft, -1);
-			a = him -> z [channel];
-			for (long i = 1; i <= n3; i ++) {
-				a [i] = data2 [i];
-			}
-		}
+		Sounds_into_Sound_convolve (me, false, thee, false, him.get());
 		switch (signalOutsideTimeDomain) {
 			case kSounds_convolve_signalOutsideTimeDomain_ZERO: {
 				// do nothing
@@ -566,15 +725,15 @@ autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling s
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (him.get(), my dx / nfft);
+				Vector_multiplyByScalar (him.get(), my dx);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (him.get(), 1.0 / nfft);
+				// do nothing
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (thee);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (him.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (him.get(), 1.0 / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -596,37 +755,10 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
 		long numberOfChannels = my ny > thy ny ? my ny : thy ny;
 		long n1 = my nx, n2 = thy nx;
-		long n3 = n1 + n2 - 1, nfft = 1;
-		while (nfft < n3) nfft *= 2;
-		autoNUMvector <double> data1 (1, nfft);
-		autoNUMvector <double> data2 (1, nfft);
+		long n3 = n1 + n2 - 1;
 		double my_xlast = my x1 + (n1 - 1) * my dx;
 		autoSound him = Sound_create (numberOfChannels, thy xmin - my xmax, thy xmax - my xmin, n3, my dx, thy x1 - my_xlast);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [my ny == 1 ? 1 : channel];
-			for (long i = n1; i > 0; i --) data1 [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
-			a = thy z [thy ny == 1 ? 1 : channel];
-			for (long i = n2; i > 0; i --) data2 [i] = a [i];
-			for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
-			NUMrealft (data1.peek(), nfft, 1);
-			NUMrealft (data2.peek(), nfft, 1);
-			data2 [1] *= data1 [1];
-			data2 [2] *= data1 [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				double temp = data1 [i] * data2 [i] + data1 [i + 1] * data2 [i + 1];   // reverse me by taking the conjugate of data1
-				data2 [i + 1] = data1 [i] * data2 [i + 1] - data1 [i + 1] * data2 [i];   // reverse me by taking the conjugate of data1
-				data2 [i] = temp;
-			}
-			NUMrealft (data2.peek(), nfft, -1);
-			a = him -> z [channel];
-			for (long i = 1; i < n1; i ++) {
-				a [i] = data2 [i + (nfft - (n1 - 1))];   // data for the first part ("negative lags") is at the end of data2
-			}
-			for (long i = 1; i <= n2; i ++) {
-				a [i + (n1 - 1)] = data2 [i];   // data for the second part ("positive lags") is at the beginning of data2
-			}
-		}
+		Sounds_into_Sound_convolve (me, true, thee, false, him.get());   // reverse me
 		switch (signalOutsideTimeDomain) {
 			case kSounds_convolve_signalOutsideTimeDomain_ZERO: {
 				// do nothing
@@ -649,15 +781,15 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (him.get(), my dx / nfft);
+				Vector_multiplyByScalar (him.get(), my dx);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (him.get(), 1.0 / nfft);
+				// do nothing
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (thee);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (him.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (him.get(), 1.0 / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -673,31 +805,10 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 
 autoSound Sound_autoCorrelate (Sound me, enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain) {
 	try {
-		long numberOfChannels = my ny, n1 = my nx, n2 = n1 + n1 - 1, nfft = 1;
-		while (nfft < n2) nfft *= 2;
-		autoNUMvector <double> data (1, nfft);
+		long numberOfChannels = my ny, n1 = my nx, n2 = n1 + n1 - 1;
 		double my_xlast = my x1 + (n1 - 1) * my dx;
 		autoSound thee = Sound_create (numberOfChannels, my xmin - my xmax, my xmax - my xmin, n2, my dx, my x1 - my_xlast);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [channel];
-			for (long i = n1; i > 0; i --) data [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data [i] = 0.0;
-			NUMrealft (data.peek(), nfft, 1);
-			data [1] *= data [1];
-			data [2] *= data [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				data [i] = data [i] * data [i] + data [i + 1] * data [i + 1];
-				data [i + 1] = 0.0;   // reverse me by taking the conjugate of data1
-			}
-			NUMrealft (data.peek(), nfft, -1);
-			a = thy z [channel];
-			for (long i = 1; i < n1; i ++) {
-				a [i] = data [i + (nfft - (n1 - 1))];   // data for the first part ("negative lags") is at the end of data
-			}
-			for (long i = 1; i <= n1; i ++) {
-				a [i + (n1 - 1)] = data [i];   // data for the second part ("positive lags") is at the beginning of data
-			}
-		}
+		Sounds_into_Sound_convolve (me, true, me, false, thee.get());
 		switch (signalOutsideTimeDomain) {
 			case kSounds_convolve_signalOutsideTimeDomain_ZERO: {
 				// do nothing
@@ -720,15 +831,15 @@ autoSound Sound_autoCorrelate (Sound me, enum kSounds_convolve_scaling scaling,
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (thee.get(), my dx / nfft);
+				Vector_multiplyByScalar (thee.get(), my dx);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (thee.get(), 1.0 / nfft);
+				// do nothing
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (me);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (thee.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (thee.get(), 1.0 / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -40,7 +40,8 @@
 #include "enums_getValue.h"
 #include "Sound_and_Spectrogram_enums.h"
 
-autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, double fmax,
+template <typename Samples>
+static autoSpectrogram Sampled_to_Spectrogram (Sampled me, long numberOfChannels, double effectiveAnalysisWidth, double fmax,
 	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
 	double maximumTimeOversampling, double maximumFreqOversampling)
 {
@@ -102,6 +103,7 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 		autoNUMfft_Table fftTable;
 		NUMfft_Table_init (& fftTable, nsampFFT);
 
+		Samples samples (me);
 		autoMelderProgress progress (U"Sound to Spectrogram...");
 		for (long i = 1; i <= nsamp_window; i ++) {
 			double nSamplesPerWindow_f = physicalAnalysisWidth / my dx;
@@ -143,9 +145,9 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 			for (long i = 1; i <= half_nsampFFT; i ++) {
 				spec [i] = 0.0;
 			}
-			for (long channel = 1; channel <= my ny; channel ++) {
+			for (long channel = 1; channel <= numberOfChannels; channel ++) {
 				for (long j = 1, i = startSample; j <= nsamp_window; j ++) {
-					frame [j] = my z [channel] [i ++] * window [j];
+					frame [j] = samples (channel, i ++) * window [j];
 				}
 				for (long j = nsamp_window + 1; j <= nsampFFT; j ++) frame [j] = 0.0f;
 
@@ -163,8 +165,8 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 					spec [i] += frame [i + i - 2] * frame [i + i - 2] + frame [i + i - 1] * frame [i + i - 1];
 				spec [half_nsampFFT + 1] += frame [nsampFFT] * frame [nsampFFT];   // Nyquist frequency. Correct??
 			}
-			if (my ny > 1 ) for (long i = 1; i <= half_nsampFFT; i ++) {
-				spec [i] /= my ny;
+			if (numberOfChannels > 1 ) for (long i = 1; i <= half_nsampFFT; i ++) {
+				spec [i] /= numberOfChannels;
 			}
 
 			/* Bin into frame [1..nBands]. */
@@ -181,6 +183,25 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 	}
 }
 
+autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
+	double maximumTimeOversampling, double maximumFreqOversampling)
+{
+	return Sampled_to_Spectrogram <Sound_SampleAccessor> (me, my ny, effectiveAnalysisWidth, fmax,
+		minimumTimeStep1, minimumFreqStep1, windowType, maximumTimeOversampling, maximumFreqOversampling);
+}
+
+autoSpectrogram CompactSound_to_Spectrogram (CompactSound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
+	double maximumTimeOversampling, double maximumFreqOversampling)
+{
+	return my storage == CompactSound_INT16 ?
+		Sampled_to_Spectrogram <CompactSound_Int16Accessor> (me, my numberOfChannels, effectiveAnalysisWidth, fmax,
+			minimumTimeStep1, minimumFreqStep1, windowType, maximumTimeOversampling, maximumFreqOversampling) :
+		Sampled_to_Spectrogram <CompactSound_Float32Accessor> (me, my numberOfChannels, effectiveAnalysisWidth, fmax,
+			minimumTimeStep1, minimumFreqStep1, windowType, maximumTimeOversampling, maximumFreqOversampling);
+}
+
 autoSound Spectrogram_to_Sound (Spectrogram me, double fsamp) {
 	try {
 		double dt = 1 / fsamp;
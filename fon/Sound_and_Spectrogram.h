@@ -18,7 +18,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "CompactSound.h"
 #include "Spectrogram.h"
 
 #include "Sound_and_Spectrogram_enums.h"
@@ -27,6 +27,10 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
 	double maximumTimeOversampling, double maximumFreqOversampling);
 
+autoSpectrogram CompactSound_to_Spectrogram (CompactSound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
+	double maximumTimeOversampling, double maximumFreqOversampling);
+
 autoSound Spectrogram_to_Sound (Spectrogram me, double fsamp);
 
 /* End of Sound_and_Spectrogram.h */
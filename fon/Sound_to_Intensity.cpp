@@ -33,7 +33,8 @@
 
 #include "Sound_to_Intensity.h"
 
-static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double timeStep, int subtractMeanPressure) {
+template <typename Samples>
+static autoIntensity Sampled_to_Intensity_ (Sampled me, long numberOfChannels, double minimumPitch, double timeStep, int subtractMeanPressure) {
 	try {
 		/*
 		 * Preconditions.
@@ -69,6 +70,7 @@ static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double
 				U"i.e. at least ", 6.4 / minimumPitch, U" s, instead of ", my xmax - my xmin, U" s.");
 		}
 		autoIntensity thee = Intensity_create (my xmin, my xmax, numberOfFrames, timeStep, thyFirstTime);
+		Samples samples (me);
 		for (long iframe = 1; iframe <= numberOfFrames; iframe ++) {
 			double midTime = Sampled_indexToX (thee.get(), iframe);
 			long midSample = Sampled_xToNearestIndex (me, midTime);
@@ -77,9 +79,9 @@ static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double
 			if (leftSample < 1) leftSample = 1;
 			if (rightSample > my nx) rightSample = my nx;
 
-			for (long channel = 1; channel <= my ny; channel ++) {
+			for (long channel = 1; channel <= numberOfChannels; channel ++) {
 				for (long i = leftSample; i <= rightSample; i ++) {
-					amplitude [i - midSample] = my z [channel] [i];
+					amplitude [i - midSample] = samples (channel, i);
 				}
 				if (subtractMeanPressure) {
 					double sum = 0.0;
@@ -110,12 +112,18 @@ autoIntensity Sound_to_Intensity (Sound me, double minimumPitch, double timeStep
 	bool veryAccurate = false;
 	if (veryAccurate) {
 		autoSound up = Sound_upsample (me);   // because squaring doubles the frequency content, i.e. you get super-Nyquist components
-		return Sound_to_Intensity_ (up.get(), minimumPitch, timeStep, subtractMeanPressure);
+		return Sampled_to_Intensity_ <Sound_SampleAccessor> (up.get(), up -> ny, minimumPitch, timeStep, subtractMeanPressure);
 	} else {
-		return Sound_to_Intensity_ (me, minimumPitch, timeStep, subtractMeanPressure);
+		return Sampled_to_Intensity_ <Sound_SampleAccessor> (me, my ny, minimumPitch, timeStep, subtractMeanPressure);
 	}
 }
 
+autoIntensity CompactSound_to_Intensity (CompactSound me, double minimumPitch, double timeStep, int subtractMeanPressure) {
+	return my storage == CompactSound_INT16 ?
+		Sampled_to_Intensity_ <CompactSound_Int16Accessor> (me, my numberOfChannels, minimumPitch, timeStep, subtractMeanPressure) :
+		Sampled_to_Intensity_ <CompactSound_Float32Accessor> (me, my numberOfChannels, minimumPitch, timeStep, subtractMeanPressure);
+}
+
 autoIntensityTier Sound_to_IntensityTier (Sound me, double minimumPitch, double timeStep, int subtractMean) {
 	try {
 		autoIntensity intensity = Sound_to_Intensity (me, minimumPitch, timeStep, subtractMean);
@@ -16,7 +16,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "CompactSound.h"
 #include "Intensity.h"
 #include "IntensityTier.h"
 
@@ -45,6 +45,11 @@ autoIntensity Sound_to_Intensity (Sound me, double minimumPitch, double timeStep
 		actual window duration = 64 ms;
 */
 
+autoIntensity CompactSound_to_Intensity (CompactSound me, double minimumPitch, double timeStep, int subtractMean);
+/*
+	The same as Sound_to_Intensity, reading the samples as they are stored.
+*/
+
 autoIntensityTier Sound_to_IntensityTier (Sound me, double minimumPitch, double timeStep, int subtractMean);
 
 /* End of file Sound_to_Intensity.h */
@@ -41,7 +41,8 @@
 #define FCC_NORMAL  2
 #define FCC_ACCURATE  3
 
-static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
+template <typename Samples>
+static void Sound_into_PitchFrame (Sampled me, long numberOfChannels, const Samples& samples, Pitch_Frame pitchFrame, double t,
 	double minimumPitch, int maxnCandidates, int method, double voicingThreshold, double octaveCost,
 	NUMfft_Table fftTable, double dt_window, long nsamp_window, long halfnsamp_window,
 	long maximumLag, long nsampFFT, long nsamp_period, long halfnsamp_period,
@@ -53,7 +54,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
 	long startSample, endSample;
 
-	for (long channel = 1; channel <= my ny; channel ++) {
+	for (long channel = 1; channel <= numberOfChannels; channel ++) {
 		/*
 		 * Compute the local mean; look one longest period to both sides.
 		 */
@@ -63,7 +64,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		Melder_assert (endSample <= my nx);
 		localMean [channel] = 0.0;
 		for (long i = startSample; i <= endSample; i ++) {
-			localMean [channel] += my z [channel] [i];
+			localMean [channel] += samples (channel, i);
 		}
 		localMean [channel] /= 2 * nsamp_period;
 
@@ -77,12 +78,12 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		Melder_assert (endSample <= my nx);
 		if (method < FCC_NORMAL) {
 			for (long j = 1, i = startSample; j <= nsamp_window; j ++)
-				frame [channel] [j] = (my z [channel] [i ++] - localMean [channel]) * window [j];
+				frame [channel] [j] = (samples (channel, i ++) - localMean [channel]) * window [j];
 			for (long j = nsamp_window + 1; j <= nsampFFT; j ++)
 				frame [channel] [j] = 0.0;
 		} else {
 			for (long j = 1, i = startSample; j <= nsamp_window; j ++)
-				frame [channel] [j] = my z [channel] [i ++] - localMean [channel];
+				frame [channel] [j] = samples (channel, i ++) - localMean [channel];
 		}
 	}
 
@@ -92,7 +93,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	localPeak = 0.0;
 	if ((startSample = halfnsamp_window + 1 - halfnsamp_period) < 1) startSample = 1;
 	if ((endSample = halfnsamp_window + halfnsamp_period) > nsamp_window) endSample = nsamp_window;
-	for (long channel = 1; channel <= my ny; channel ++) {
+	for (long channel = 1; channel <= numberOfChannels; channel ++) {
 		for (long j = startSample; j <= endSample; j ++) {
 			double value = fabs (frame [channel] [j]);
 			if (value > localPeak) localPeak = value;
@@ -111,10 +112,9 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		localMaximumLag = localSpan - nsamp_window;
 		offset = startSample - 1;
 		double sumx2 = 0;   // sum of squares
-		for (long channel = 1; channel <= my ny; channel ++) {
-			double *amp = my z [channel] + offset;
+		for (long channel = 1; channel <= numberOfChannels; channel ++) {
 			for (long i = 1; i <= nsamp_window; i ++) {
-				double x = amp [i] - localMean [channel];
+				double x = samples (channel, offset + i) - localMean [channel];
 				sumx2 += x * x;
 			}
 		}
@@ -122,14 +122,13 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		r [0] = 1.0;
 		for (long i = 1; i <= localMaximumLag; i ++) {
 			double product = 0.0;
-			for (long channel = 1; channel <= my ny; channel ++) {
-				double *amp = my z [channel] + offset;
-				double y0 = amp [i] - localMean [channel];
-				double yZ = amp [i + nsamp_window] - localMean [channel];
+			for (long channel = 1; channel <= numberOfChannels; channel ++) {
+				double y0 = samples (channel, offset + i) - localMean [channel];
+				double yZ = samples (channel, offset + i + nsamp_window) - localMean [channel];
 				sumy2 += yZ * yZ - y0 * y0;
 				for (long j = 1; j <= nsamp_window; j ++) {
-					double x = amp [j] - localMean [channel];
-					double y = amp [i + j] - localMean [channel];
+					double x = samples (channel, offset + j) - localMean [channel];
+					double y = samples (channel, offset + i + j) - localMean [channel];
 					product += x * y;
 				}
 			}
@@ -143,7 +142,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		for (long i = 1; i <= nsampFFT; i ++) {
 			ac [i] = 0.0;
 		}
-		for (long channel = 1; channel <= my ny; channel ++) {
+		for (long channel = 1; channel <= numberOfChannels; channel ++) {
 			NUMfft_forward (fftTable, frame [channel]);   // complex spectrum
 			ac [1] += frame [channel] [1] * frame [channel] [1];   // DC component
 			for (long i = 2; i < nsampFFT; i += 2) {
@@ -243,7 +242,8 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 }
 
 Thing_define (Sound_into_Pitch_Args, Thing) { public:
-	Sound sound;
+	Sampled sound;   // a Sound or a CompactSound
+	long numberOfChannels;
 	Pitch pitch;
 	long firstFrame, lastFrame;
 	double minimumPitch;
@@ -257,7 +257,7 @@ Thing_define (Sound_into_Pitch_Args, Thing) { public:
 
 Thing_implement (Sound_into_Pitch_Args, Thing, 0);
 
-static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sound sound, Pitch pitch,
+static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sampled sound, long numberOfChannels, Pitch pitch,
 	long firstFrame, long lastFrame, double minimumPitch, int maxnCandidates, int method,
 	double voicingThreshold, double octaveCost,
 	double dt_window, long nsamp_window, long halfnsamp_window, long maximumLag, long nsampFFT,
@@ -267,6 +267,7 @@ static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sound sound, Pitc
 {
 	autoSound_into_Pitch_Args me = Thing_new (Sound_into_Pitch_Args);
 	my sound = sound;
+	my numberOfChannels = numberOfChannels;
 	my pitch = pitch;
 	my firstFrame = firstFrame;
 	my lastFrame = lastFrame;
@@ -295,8 +296,10 @@ static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sound sound, Pitc
 MelderThread_MUTEX (mutex);
 bool mutex_inited;
 
+template <typename Samples>
 static MelderThread_RETURN_TYPE Sound_into_Pitch (Sound_into_Pitch_Args me)
 {
+	Samples samples (my sound);
 	autoNUMfft_Table fftTable;
 	autoNUMmatrix <double> frame;
 	autoNUMvector <double> ac, r, localMean;
@@ -304,15 +307,15 @@ static MelderThread_RETURN_TYPE Sound_into_Pitch (Sound_into_Pitch_Args me)
 	{// scope
 		MelderThread_LOCK (mutex);
 		if (my method >= FCC_NORMAL) {   // cross-correlation
-			frame.reset (1, my sound -> ny, 1, my nsamp_window);
+			frame.reset (1, my numberOfChannels, 1, my nsamp_window);
 		} else {   // autocorrelation
 			NUMfft_Table_init (& fftTable, my nsampFFT);
-			frame.reset (1, my sound -> ny, 1, my nsampFFT);
+			frame.reset (1, my numberOfChannels, 1, my nsampFFT);
 			ac.reset (1, my nsampFFT);
 		}
 		r.reset (- my nsamp_window, my nsamp_window);
 		imax.reset (1, my maxnCandidates);
-		localMean.reset (1, my sound -> ny);
+		localMean.reset (1, my numberOfChannels);
 		MelderThread_UNLOCK (mutex);
 	}
 	for (long iframe = my firstFrame; iframe <= my lastFrame; iframe ++) {
@@ -329,7 +332,7 @@ static MelderThread_RETURN_TYPE Sound_into_Pitch (Sound_into_Pitch_Args me)
 		} else if (*my cancelled) {
 			MelderThread_RETURN;
 		}
-		Sound_into_PitchFrame (my sound, pitchFrame, t,
+		Sound_into_PitchFrame (my sound, my numberOfChannels, samples, pitchFrame, t,
 			my minimumPitch, my maxnCandidates, my method, my voicingThreshold, my octaveCost,
 			& fftTable, my dt_window, my nsamp_window, my halfnsamp_window,
 			my maximumLag, my nsampFFT, my nsamp_period, my halfnsamp_period,
@@ -340,11 +343,12 @@ static MelderThread_RETURN_TYPE Sound_into_Pitch (Sound_into_Pitch_Args me)
 	MelderThread_RETURN;
 }
 
-autoPitch Sound_to_Pitch_any (Sound me,
+template <typename Samples>
+static autoPitch Sampled_to_Pitch_any (Sampled me, long numberOfChannels,
 	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
 	int method,
 	double silenceThreshold, double voicingThreshold,
-	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling, double globalPeak)
 {
 	try {
 		autoNUMfft_Table fftTable;
@@ -356,7 +360,6 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		double interpolation_depth;
 		long nsamp_period, halfnsamp_period;   // number of samples in longest period
 		long brent_ixmax, brent_depth;
-		double globalPeak;
 
 		Melder_assert (maxnCandidates >= 2);
 		Melder_assert (method >= AC_HANNING && method <= FCC_ACCURATE);
@@ -442,18 +445,22 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		}
 
 		/*
-		 * Compute the global absolute peak for determination of silence threshold.
+		 * Compute the global absolute peak for determination of silence threshold,
+		 * unless the caller supplies it.
 		 */
-		globalPeak = 0.0;
-		for (long channel = 1; channel <= my ny; channel ++) {
-			double mean = 0.0;
-			for (long i = 1; i <= my nx; i ++) {
-				mean += my z [channel] [i];
-			}
-			mean /= my nx;
-			for (long i = 1; i <= my nx; i ++) {
-				double value = fabs (my z [channel] [i] - mean);
-				if (value > globalPeak) globalPeak = value;
+		Samples samples (me);
+		if (globalPeak == NUMundefined) {
+			globalPeak = 0.0;
+			for (long channel = 1; channel <= numberOfChannels; channel ++) {
+				double mean = 0.0;
+				for (long i = 1; i <= my nx; i ++) {
+					mean += samples (channel, i);
+				}
+				mean /= my nx;
+				for (long i = 1; i <= my nx; i ++) {
+					double value = fabs (samples (channel, i) - mean);
+					if (value > globalPeak) globalPeak = value;
+				}
 			}
 		}
 		if (globalPeak == 0.0) {
@@ -534,7 +541,7 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		volatile int cancelled = 0;
 		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
 			if (ithread == numberOfThreads) lastFrame = nFrames;
-			args [ithread - 1] = Sound_into_Pitch_Args_create (me, thee.get(),
+			args [ithread - 1] = Sound_into_Pitch_Args_create (me, numberOfChannels, thee.get(),
 				firstFrame, lastFrame, minimumPitch, maxnCandidates, method,
 				voicingThreshold, octaveCost,
 				dt_window, nsamp_window, halfnsamp_window, maximumLag,
@@ -544,7 +551,7 @@ autoPitch Sound_to_Pitch_any (Sound me,
 			firstFrame = lastFrame + 1;
 			lastFrame += numberOfFramesPerThread;
 		}
-		MelderThread_run (Sound_into_Pitch, args, numberOfThreads);
+		MelderThread_run (Sound_into_Pitch <Samples>, args, numberOfThreads);
 
 		Melder_progress (0.95, U"Sound to Pitch: path finder");
 		Pitch_pathFinder (thee.get(), silenceThreshold, voicingThreshold,
@@ -556,6 +563,39 @@ autoPitch Sound_to_Pitch_any (Sound me,
 	}
 }
 
+autoPitch Sound_to_Pitch_any (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+{
+	return Sampled_to_Pitch_any <Sound_SampleAccessor> (me, my ny, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling, NUMundefined);
+}
+
+autoPitch Sound_to_Pitch_any_withGlobalPeak (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling, double globalPeak)
+{
+	return Sampled_to_Pitch_any <Sound_SampleAccessor> (me, my ny, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling, globalPeak);
+}
+
+autoPitch CompactSound_to_Pitch_any (CompactSound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+{
+	return my storage == CompactSound_INT16 ?
+		Sampled_to_Pitch_any <CompactSound_Int16Accessor> (me, my numberOfChannels, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+			silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling, NUMundefined) :
+		Sampled_to_Pitch_any <CompactSound_Float32Accessor> (me, my numberOfChannels, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+			silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling, NUMundefined);
+}
+
 autoPitch Sound_to_Pitch (Sound me, double timeStep, double minimumPitch, double maximumPitch) {
 	return Sound_to_Pitch_ac (me, timeStep, minimumPitch,
 		3.0, 15, false, 0.03, 0.45, 0.01, 0.35, 0.14, maximumPitch);
@@ -579,4 +619,9 @@ autoPitch Sound_to_Pitch_cc (Sound me,
 		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling);
 }
 
+autoPitch CompactSound_to_Pitch (CompactSound me, double timeStep, double minimumPitch, double maximumPitch) {
+	return CompactSound_to_Pitch_any (me, timeStep, minimumPitch,
+		3.0, 15, AC_HANNING, 0.03, 0.45, 0.01, 0.35, 0.14, maximumPitch);
+}
+
 /* End of file Sound_to_Pitch.cpp */
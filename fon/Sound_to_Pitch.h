@@ -16,7 +16,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "CompactSound.h"
 #include "Pitch.h"
 
 autoPitch Sound_to_Pitch (Sound me, double timeStep,
@@ -84,4 +84,21 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		pitches above a certain value "voiceless".
 */
 
+autoPitch Sound_to_Pitch_any_withGlobalPeak (Sound me, double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method, double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double maximumPitch, double globalPeak);
+/*
+	The same as Sound_to_Pitch_any, except that the intensity of every frame is relative to globalPeak
+	instead of to the absolute peak of the Sound, so that parts of a longer sound can be analysed separately
+	with comparable intensities.
+*/
+
+autoPitch CompactSound_to_Pitch_any (CompactSound me, double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method, double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double maximumPitch);
+autoPitch CompactSound_to_Pitch (CompactSound me, double timeStep, double minimumPitch, double maximumPitch);
+/*
+	The same as Sound_to_Pitch_any and Sound_to_Pitch, reading the samples as they are stored.
+*/
+
 /* End of file Sound_to_Pitch.h */
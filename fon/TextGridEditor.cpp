@@ -501,10 +501,8 @@ static void menu_cb_DrawTextGridAndPitch (TextGridEditor me, EDITOR_ARGS_FORM) {
 		my pref_picture_garnish () = GET_INTEGER (U"Garnish");
 		if (! my p_pitch_show)
 			Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-		if (! my d_pitch) {
-			TimeSoundAnalysisEditor_computePitch (me);
-			if (! my d_pitch) Melder_throw (U"Cannot compute pitch.");
-		}
+		TimeSoundAnalysisEditor_computePitch (me);
+		if (! my d_pitch) Melder_throw (U"Cannot compute pitch.");
 		Editor_openPraatPicture (me);
 		double pitchFloor_hidden = Function_convertStandardToSpecialUnit (my d_pitch.get(), my p_pitch_floor, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
 		double pitchCeiling_hidden = Function_convertStandardToSpecialUnit (my d_pitch.get(), my p_pitch_ceiling, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
@@ -49,7 +49,10 @@ static const char32 * theMessage_Cannot_compute_formant = U"The formants are not
 static const char32 * theMessage_Cannot_compute_intensity = U"The intensity curve is not defined at the edge of the sound.";
 static const char32 * theMessage_Cannot_compute_pulses = U"The pulses are not defined at the edge of the sound.";
 
+static void stopAnalysis (TimeSoundAnalysisEditor me);
+
 void structTimeSoundAnalysisEditor :: v_destroy () noexcept {
+	stopAnalysis (this);
 	TimeSoundAnalysisEditor_Parent :: v_destroy ();
 }
 
@@ -131,6 +134,7 @@ void structTimeSoundAnalysisEditor :: v_reset_analysis () {
 	d_intensity. reset();
 	d_formant. reset();
 	d_pulses. reset();
+	d_spectrogram_tiles.failed = d_pitch_tiles.failed = d_intensity_tiles.failed = d_formant_tiles.failed = d_pulses_tiles.failed = false;
 }
 
 enum {
@@ -270,9 +274,8 @@ static void do_log (TimeSoundAnalysisEditor me, int which) {
 		} else if (str32equ (varName, U"f0")) {
 			if (! my p_pitch_show)
 				Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-			if (! my d_pitch) {
-				Melder_throw (theMessage_Cannot_compute_pitch);
-			}
+			TimeSoundAnalysisEditor_computePitch (me);
+			if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 			if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 				value = Pitch_getValueAtTime (my d_pitch.get(), tmin, my p_pitch_unit, 1);
 			} else {
@@ -281,9 +284,8 @@ static void do_log (TimeSoundAnalysisEditor me, int which) {
 		} else if (varName [0] == 'f' && varName [1] >= '1' && varName [1] <= '5' && varName [2] == '\0') {
 			if (! my p_formant_show)
 				Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formants\" from the Formant menu.");
-			if (! my d_formant) {
-				Melder_throw (theMessage_Cannot_compute_formant);
-			}
+			TimeSoundAnalysisEditor_computeFormants (me);
+			if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
 			if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 				value = Formant_getValueAtTime (my d_formant.get(), (int) (varName [1] - U'0'), tmin, 0);
 			} else {
@@ -292,16 +294,14 @@ static void do_log (TimeSoundAnalysisEditor me, int which) {
 		} else if (varName [0] == U'b' && varName [1] >= U'1' && varName [1] <= U'5' && varName [2] == U'\0') {
 			if (! my p_formant_show)
 				Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formants\" from the Formant menu.");
-			if (! my d_formant) {
-				Melder_throw (theMessage_Cannot_compute_formant);
-			}
+			TimeSoundAnalysisEditor_computeFormants (me);
+			if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
 			value = Formant_getBandwidthAtTime (my d_formant.get(), (int) (varName [1] - U'0'), 0.5 * (tmin + tmax), 0);
 		} else if (str32equ (varName, U"intensity")) {
 			if (! my p_intensity_show)
 				Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-			if (! my d_intensity) {
-				Melder_throw (theMessage_Cannot_compute_intensity);
-			}
+			TimeSoundAnalysisEditor_computeIntensity (me);
+			if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
 			if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 				value = Vector_getValueAtX (my d_intensity.get(), tmin, Vector_CHANNEL_1, Vector_VALUE_INTERPOLATION_LINEAR);
 			} else {
@@ -310,9 +310,8 @@ static void do_log (TimeSoundAnalysisEditor me, int which) {
 		} else if (str32equ (varName, U"power")) {
 			if (! my p_spectrogram_show)
 				Melder_throw (U"No spectrogram is visible.\nFirst choose \"Show spectrogram\" from the Spectrum menu.");
-			if (! my d_spectrogram) {
-				Melder_throw (theMessage_Cannot_compute_spectrogram);
-			}
+			TimeSoundAnalysisEditor_computeSpectrogram (me);
+			if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
 			if (part != TimeSoundAnalysisEditor_PART_CURSOR) Melder_throw (U"Click inside the spectrogram first.");
 			value = Matrix_getValueAtXY (my d_spectrogram.get(), tmin, my d_spectrogram_cursor);
 		}
@@ -410,6 +409,7 @@ static void menu_cb_timeStepSettings (TimeSoundAnalysisEditor me, EDITOR_ARGS_FO
 		my d_formant. reset();
 		my d_intensity. reset();
 		my d_pulses. reset();
+		my d_pitch_tiles.failed = my d_formant_tiles.failed = my d_intensity_tiles.failed = my d_pulses_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -459,6 +459,7 @@ static void menu_cb_spectrogramSettings (TimeSoundAnalysisEditor me, EDITOR_ARGS
 		my pref_spectrogram_windowLength () = my p_spectrogram_windowLength = GET_REAL (U"Window length");
 		my pref_spectrogram_dynamicRange () = my p_spectrogram_dynamicRange = GET_REAL (U"Dynamic range");
 		my d_spectrogram. reset();
+		my d_spectrogram_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -495,6 +496,7 @@ static void menu_cb_advancedSpectrogramSettings (TimeSoundAnalysisEditor me, EDI
 		my pref_spectrogram_preemphasis        () = my p_spectrogram_preemphasis        = GET_REAL (U"Pre-emphasis");
 		my pref_spectrogram_dynamicCompression () = my p_spectrogram_dynamicCompression = GET_REAL (U"Dynamic compression");
 		my d_spectrogram. reset();
+		my d_spectrogram_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -508,10 +510,8 @@ static void menu_cb_getSpectralPowerAtCursorCross (TimeSoundAnalysisEditor me, E
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_spectrogram_show)
 		Melder_throw (U"No spectrogram is visible.\nFirst choose \"Show spectrogram\" from the Spectrum menu.");
-	if (! my d_spectrogram) {
-		TimeSoundAnalysisEditor_computeSpectrogram (me);
-		if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
-	}
+	TimeSoundAnalysisEditor_computeSpectrogram (me);
+	if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
 	if (part != TimeSoundAnalysisEditor_PART_CURSOR) Melder_throw (U"Click inside the spectrogram first.");
 	MelderInfo_open ();
 	MelderInfo_write (Matrix_getValueAtXY (my d_spectrogram.get(), tmin, my d_spectrogram_cursor),
@@ -547,14 +547,168 @@ static autoSound extractSound (TimeSoundAnalysisEditor me, double tmin, double t
 	return sound;
 }
 
+/*
+	The intensity of a pitch frame is relative to the absolute peak of the analysed sound,
+	and the unvoiced strength depends on it. The tiles are therefore all analysed relative to one reference peak,
+	which no sample of the sound can exceed, and the frames in the window are rescaled
+	to the peak of the window (as "To Pitch" does for an extracted part) before the path is found.
+*/
+static double pitchReferencePeak (TimeSoundAnalysisEditor me) {
+	if (my d_longSound.data) return 2.0;   // the samples are read as values between -1 and +1
+	Sound sound = my d_sound.data;
+	double peak = 0.0;
+	for (long channel = 1; channel <= sound -> ny; channel ++) {
+		for (long i = 1; i <= sound -> nx; i ++) {
+			double value = fabs (sound -> z [channel] [i]);
+			if (value > peak) peak = value;
+		}
+	}
+	return 2.0 * peak;   // room for the subtraction of the mean
+}
+
+static double pitchWindowPeak (TimeSoundAnalysisEditor me) {
+	double margin = my p_pitch_veryAccurate ? 3.0 / my p_pitch_floor : 1.5 / my p_pitch_floor;
+	autoSound part = extractSound (me, my d_startWindow - margin, my d_endWindow + margin);
+	double peak = 0.0;
+	for (long channel = 1; channel <= part -> ny; channel ++) {
+		double mean = 0.0;
+		for (long i = 1; i <= part -> nx; i ++)
+			mean += part -> z [channel] [i];
+		mean /= part -> nx;
+		for (long i = 1; i <= part -> nx; i ++) {
+			double value = fabs (part -> z [channel] [i] - mean);
+			if (value > peak) peak = value;
+		}
+	}
+	return peak;
+}
+
+static void rescalePitchIntensities (TimeSoundAnalysisEditor me, Pitch pitch) {
+	double windowPeak = pitchWindowPeak (me);
+	for (long iframe = 1; iframe <= pitch -> nx; iframe ++) {
+		Pitch_Frame frame = & pitch -> frame [iframe];
+		if (windowPeak == 0.0) {
+			frame -> intensity = 0.0;   // silence
+		} else {
+			frame -> intensity *= my d_pitch_referencePeak / windowPeak;
+			if (frame -> intensity > 1.0) frame -> intensity = 1.0;
+		}
+	}
+}
+
+/********** ANALYSIS TILES **********/
+
+static const long theNumberOfFramesPerTile = 100;
+
+static Sampled analysedSound (TimeSoundAnalysisEditor me) {
+	return my d_longSound.data ? (Sampled) my d_longSound.data : (Sampled) my d_sound.data;
+}
+
+static autoSound extractSamples (TimeSoundAnalysisEditor me, long first, long n) {
+	/*
+		Samples outside the sound are zero, so that every tile is analysed from the same number of samples.
+	*/
+	Sampled sound = analysedSound (me);
+	long numberOfChannels = my d_longSound.data ? my d_longSound.data -> numberOfChannels : my d_sound.data -> ny;
+	double x1 = sound -> x1 + (first - 1) * sound -> dx;
+	autoSound thee = Sound_create (numberOfChannels, x1 - 0.5 * sound -> dx, x1 + (n - 0.5) * sound -> dx, n, sound -> dx, x1);
+	long ifirst = first < 1 ? 1 : first, ilast = first + n - 1 > sound -> nx ? sound -> nx : first + n - 1;
+	if (ilast < ifirst) return thee;
+	if (my d_longSound.data) {
+		autoNUMmatrix <double> buffer (1, numberOfChannels, 1, ilast - ifirst + 1);
+		LongSound_readAudioToFloat (my d_longSound.data, buffer.peek(), ifirst, ilast - ifirst + 1);
+		for (long channel = 1; channel <= numberOfChannels; channel ++)
+			for (long i = ifirst; i <= ilast; i ++)
+				thy z [channel] [i - first + 1] = buffer [channel] [i - ifirst + 1];
+	} else {
+		for (long channel = 1; channel <= numberOfChannels; channel ++)
+			for (long i = ifirst; i <= ilast; i ++)
+				thy z [channel] [i - first + 1] = my d_sound.data -> z [channel] [i];
+	}
+	return thee;
+}
+
+/*
+	A frame joiner creates an analysis that consists of frames ifirst..ilast of me followed by frames jfirst..jlast of thee,
+	on the time grid of the first of these frames; either range can be empty.
+	The caller sets the time domain.
+*/
+typedef autoSampled (*TimeSoundAnalysisEditor_FrameJoiner) (Sampled me, long ifirst, long ilast, Sampled thee, long jfirst, long jlast);
+
+static autoSampled joinSpectrogramFrames (Sampled void_me, long ifirst, long ilast, Sampled void_thee, long jfirst, long jlast) {
+	Spectrogram me = static_cast <Spectrogram> (void_me), thee = static_cast <Spectrogram> (void_thee);
+	long n1 = ilast - ifirst + 1, n2 = jlast - jfirst + 1;
+	Spectrogram model = n1 > 0 ? me : thee;
+	autoSpectrogram him = Spectrogram_create (model -> xmin, model -> xmax, n1 + n2, model -> dx,
+		n1 > 0 ? Sampled_indexToX (me, ifirst) : Sampled_indexToX (thee, jfirst),
+		model -> ymin, model -> ymax, model -> ny, model -> dy, model -> y1);
+	for (long ifreq = 1; ifreq <= model -> ny; ifreq ++) {
+		for (long i = 1; i <= n1; i ++)
+			his z [ifreq] [i] = my z [ifreq] [ifirst - 1 + i];
+		for (long j = 1; j <= n2; j ++)
+			his z [ifreq] [n1 + j] = thy z [ifreq] [jfirst - 1 + j];
+	}
+	return him.move();
+}
+
+static autoSampled joinPitchFrames (Sampled void_me, long ifirst, long ilast, Sampled void_thee, long jfirst, long jlast) {
+	Pitch me = static_cast <Pitch> (void_me), thee = static_cast <Pitch> (void_thee);
+	long n1 = ilast - ifirst + 1, n2 = jlast - jfirst + 1;
+	Pitch model = n1 > 0 ? me : thee;
+	int maxnCandidates = n1 > 0 && n2 > 0 && thy maxnCandidates > my maxnCandidates ? thy maxnCandidates : model -> maxnCandidates;
+	autoPitch him = Pitch_create (model -> xmin, model -> xmax, n1 + n2, model -> dx,
+		n1 > 0 ? Sampled_indexToX (me, ifirst) : Sampled_indexToX (thee, jfirst), model -> ceiling, maxnCandidates);
+	for (long i = 1; i <= n1 + n2; i ++) {
+		Pitch_Frame frame = i <= n1 ? & my frame [ifirst - 1 + i] : & thy frame [jfirst - 1 + i - n1];
+		his frame [i]. destroy ();
+		frame -> copy (& his frame [i]);
+	}
+	return him.move();
+}
+
+static autoSampled joinIntensityFrames (Sampled void_me, long ifirst, long ilast, Sampled void_thee, long jfirst, long jlast) {
+	Intensity me = static_cast <Intensity> (void_me), thee = static_cast <Intensity> (void_thee);
+	long n1 = ilast - ifirst + 1, n2 = jlast - jfirst + 1;
+	Intensity model = n1 > 0 ? me : thee;
+	autoIntensity him = Intensity_create (model -> xmin, model -> xmax, n1 + n2, model -> dx,
+		n1 > 0 ? Sampled_indexToX (me, ifirst) : Sampled_indexToX (thee, jfirst));
+	for (long i = 1; i <= n1; i ++)
+		his z [1] [i] = my z [1] [ifirst - 1 + i];
+	for (long j = 1; j <= n2; j ++)
+		his z [1] [n1 + j] = thy z [1] [jfirst - 1 + j];
+	return him.move();
+}
+
+static autoSampled joinFormantFrames (Sampled void_me, long ifirst, long ilast, Sampled void_thee, long jfirst, long jlast) {
+	Formant me = static_cast <Formant> (void_me), thee = static_cast <Formant> (void_thee);
+	long n1 = ilast - ifirst + 1, n2 = jlast - jfirst + 1;
+	Formant model = n1 > 0 ? me : thee;
+	int maxnFormants = n1 > 0 && n2 > 0 && thy maxnFormants > my maxnFormants ? thy maxnFormants : model -> maxnFormants;
+	autoFormant him = Formant_create (model -> xmin, model -> xmax, n1 + n2, model -> dx,
+		n1 > 0 ? Sampled_indexToX (me, ifirst) : Sampled_indexToX (thee, jfirst), maxnFormants);
+	for (long i = 1; i <= n1 + n2; i ++) {
+		Formant_Frame frame = i <= n1 ? & my d_frames [ifirst - 1 + i] : & thy d_frames [jfirst - 1 + i - n1];
+		frame -> copy (& his d_frames [i]);
+	}
+	return him.move();
+}
+
+static autoSampled extractVisibleFrames (TimeSoundAnalysisEditor me, Sampled analysis, TimeSoundAnalysisEditor_FrameJoiner join) {
+	long ifirst, ilast;
+	if (Sampled_getWindowSamples (analysis, my d_startWindow, my d_endWindow, & ifirst, & ilast) < 1)
+		Melder_throw (U"No analysis frames are visible.");
+	autoSampled thee = join (analysis, ifirst, ilast, nullptr, 1, 0);
+	thy xmin = my d_startWindow;
+	thy xmax = my d_endWindow;
+	return thee;
+}
+
 static void menu_cb_extractVisibleSpectrogram (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_spectrogram_show)
 		Melder_throw (U"No spectrogram is visible.\nFirst choose \"Show spectrogram\" from the Spectrum menu.");
-	if (! my d_spectrogram) {
-		TimeSoundAnalysisEditor_computeSpectrogram (me);
-		if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
-	}
-	autoSpectrogram publish = Data_copy (my d_spectrogram.get());
+	TimeSoundAnalysisEditor_computeSpectrogram (me);
+	if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
+	autoSpectrogram publish = extractVisibleFrames (me, my d_spectrogram.get(), joinSpectrogramFrames).static_cast_move <structSpectrogram> ();
 	Editor_broadcastPublication (me, publish.move());
 }
 
@@ -597,10 +751,8 @@ static void menu_cb_paintVisibleSpectrogram (TimeSoundAnalysisEditor me, EDITOR_
 		my pref_spectrogram_picture_garnish () = my p_spectrogram_picture_garnish = GET_INTEGER (U"Garnish");
 		if (! my p_spectrogram_show)
 			Melder_throw (U"No spectrogram is visible.\nFirst choose \"Show spectrogram\" from the Spectrum menu.");
-		if (! my d_spectrogram) {
-			TimeSoundAnalysisEditor_computeSpectrogram (me);
-			if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
-		}
+		TimeSoundAnalysisEditor_computeSpectrogram (me);
+		if (! my d_spectrogram) Melder_throw (theMessage_Cannot_compute_spectrogram);
 		Editor_openPraatPicture (me);
 		Spectrogram_paint (my d_spectrogram.get(), my pictureGraphics, my d_startWindow, my d_endWindow, my p_spectrogram_viewFrom, my p_spectrogram_viewTo,
 			my p_spectrogram_maximum, my p_spectrogram_autoscaling, my p_spectrogram_dynamicRange, my p_spectrogram_preemphasis,
@@ -663,6 +815,7 @@ static void menu_cb_pitchSettings (TimeSoundAnalysisEditor me, EDITOR_ARGS_FORM)
 		my d_pitch. reset();
 		my d_intensity. reset();
 		my d_pulses. reset();
+		my d_pitch_tiles.failed = my d_intensity_tiles.failed = my d_pulses_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -705,6 +858,7 @@ static void menu_cb_advancedPitchSettings (TimeSoundAnalysisEditor me, EDITOR_AR
 		my d_pitch. reset();
 		my d_intensity. reset();
 		my d_pulses. reset();
+		my d_pitch_tiles.failed = my d_intensity_tiles.failed = my d_pulses_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -714,10 +868,8 @@ static void menu_cb_pitchListing (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-	}
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 	MelderInfo_open ();
 	MelderInfo_writeLine (U"Time_s   F0_", Function_getUnitText (my d_pitch.get(), Pitch_LEVEL_FREQUENCY, my p_pitch_unit, Function_UNIT_TEXT_SHORT));
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
@@ -742,10 +894,8 @@ static void menu_cb_getPitch (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-	}
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 		double f0 = Pitch_getValueAtTime (my d_pitch.get(), tmin, my p_pitch_unit, true);
 		f0 = Function_convertToNonlogarithmic (my d_pitch.get(), f0, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
@@ -764,10 +914,8 @@ static void menu_cb_getMinimumPitch (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIR
 	int part = makeQueriable (me, false, & tmin, & tmax);
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-	}
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 	f0 = Pitch_getMinimum (my d_pitch.get(), tmin, tmax, my p_pitch_unit, true);
 	f0 = Function_convertToNonlogarithmic (my d_pitch.get(), f0, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
 	Melder_information (f0, U" ", Function_getUnitText (my d_pitch.get(), Pitch_LEVEL_FREQUENCY, my p_pitch_unit, 0),
@@ -779,10 +927,8 @@ static void menu_cb_getMaximumPitch (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIR
 	int part = makeQueriable (me, false, & tmin, & tmax);
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);   // BUG
-	}
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);   // BUG
 	f0 = Pitch_getMaximum (my d_pitch.get(), tmin, tmax, my p_pitch_unit, true);
 	f0 = Function_convertToNonlogarithmic (my d_pitch.get(), f0, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
 	Melder_information (f0, U" ", Function_getUnitText (my d_pitch.get(), Pitch_LEVEL_FREQUENCY, my p_pitch_unit, 0),
@@ -792,10 +938,8 @@ static void menu_cb_getMaximumPitch (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIR
 static void menu_cb_moveCursorToMinimumPitch (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the View menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-	}
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 	if (my d_startSelection == my d_endSelection) {
 		Melder_throw (U"Empty selection.");
 	} else {
@@ -812,10 +956,8 @@ static void menu_cb_moveCursorToMinimumPitch (TimeSoundAnalysisEditor me, EDITOR
 static void menu_cb_moveCursorToMaximumPitch (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the View menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-	}
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 	if (my d_startSelection == my d_endSelection) {
 		Melder_throw (U"Empty selection.");
 	} else {
@@ -832,11 +974,10 @@ static void menu_cb_moveCursorToMaximumPitch (TimeSoundAnalysisEditor me, EDITOR
 static void menu_cb_extractVisiblePitchContour (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_pitch_show)
 		Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-	if (! my d_pitch) {
-		TimeSoundAnalysisEditor_computePitch (me);
-		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-	}
-	autoPitch publish = Data_copy (my d_pitch.get());
+	TimeSoundAnalysisEditor_computePitch (me);
+	if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
+	autoPitch publish = extractVisibleFrames (me, my d_pitch.get(), joinPitchFrames).static_cast_move <structPitch> ();
+	rescalePitchIntensities (me, publish.get());
 	Editor_broadcastPublication (me, publish.move());
 }
 
@@ -862,10 +1003,8 @@ static void menu_cb_drawVisiblePitchContour (TimeSoundAnalysisEditor me, EDITOR_
 		my pref_pitch_picture_garnish () = my p_pitch_picture_garnish = GET_INTEGER (U"Garnish");
 		if (! my p_pitch_show)
 			Melder_throw (U"No pitch contour is visible.\nFirst choose \"Show pitch\" from the Pitch menu.");
-		if (! my d_pitch) {
-			TimeSoundAnalysisEditor_computePitch (me);
-			if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
-		}
+		TimeSoundAnalysisEditor_computePitch (me);
+		if (! my d_pitch) Melder_throw (theMessage_Cannot_compute_pitch);
 		Editor_openPraatPicture (me);
 		double pitchFloor_hidden = Function_convertStandardToSpecialUnit (my d_pitch.get(), my p_pitch_floor, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
 		double pitchCeiling_hidden = Function_convertStandardToSpecialUnit (my d_pitch.get(), my p_pitch_ceiling, Pitch_LEVEL_FREQUENCY, my p_pitch_unit);
@@ -912,6 +1051,7 @@ static void menu_cb_intensitySettings (TimeSoundAnalysisEditor me, EDITOR_ARGS_F
 		my pref_intensity_averagingMethod      () = my p_intensity_averagingMethod      = GET_ENUM    (kTimeSoundAnalysisEditor_intensity_averagingMethod, U"Averaging method");
 		my pref_intensity_subtractMeanPressure () = my p_intensity_subtractMeanPressure = GET_INTEGER (U"Subtract mean pressure");
 		my d_intensity. reset();
+		my d_intensity_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -919,11 +1059,9 @@ static void menu_cb_intensitySettings (TimeSoundAnalysisEditor me, EDITOR_ARGS_F
 static void menu_cb_extractVisibleIntensityContour (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_intensity_show)
 		Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-	if (! my d_intensity) {
-		TimeSoundAnalysisEditor_computeIntensity (me);
-		if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
-	}
-	autoIntensity publish = Data_copy (my d_intensity.get());
+	TimeSoundAnalysisEditor_computeIntensity (me);
+	if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
+	autoIntensity publish = extractVisibleFrames (me, my d_intensity.get(), joinIntensityFrames).static_cast_move <structIntensity> ();
 	Editor_broadcastPublication (me, publish.move());
 }
 
@@ -945,10 +1083,8 @@ static void menu_cb_drawVisibleIntensityContour (TimeSoundAnalysisEditor me, EDI
 		my pref_intensity_picture_garnish () = my p_intensity_picture_garnish = GET_INTEGER (U"Garnish");
 		if (! my p_intensity_show)
 			Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-		if (! my d_intensity) {
-			TimeSoundAnalysisEditor_computeIntensity (me);
-			if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
-		}
+		TimeSoundAnalysisEditor_computeIntensity (me);
+		if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
 		Editor_openPraatPicture (me);
 		Intensity_draw (my d_intensity.get(), my pictureGraphics, my d_startWindow, my d_endWindow, my p_intensity_viewFrom, my p_intensity_viewTo,
 			my p_intensity_picture_garnish);
@@ -962,10 +1098,8 @@ static void menu_cb_intensityListing (TimeSoundAnalysisEditor me, EDITOR_ARGS_DI
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_intensity_show)
 		Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-	if (! my d_intensity) {
-		TimeSoundAnalysisEditor_computeIntensity (me);
-		if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
-	}
+	TimeSoundAnalysisEditor_computeIntensity (me);
+	if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
 	MelderInfo_open ();
 	MelderInfo_writeLine (U"Time_s   Intensity_dB");
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
@@ -988,10 +1122,8 @@ static void menu_cb_getIntensity (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_intensity_show)
 		Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-	if (! my d_intensity) {
-		TimeSoundAnalysisEditor_computeIntensity (me);
-		if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
-	}
+	TimeSoundAnalysisEditor_computeIntensity (me);
+	if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 		Melder_information (Vector_getValueAtX (my d_intensity.get(), tmin, Vector_CHANNEL_1, Vector_VALUE_INTERPOLATION_LINEAR), U" dB (intensity at CURSOR)");
 	} else {
@@ -1006,10 +1138,8 @@ static void menu_cb_getMinimumIntensity (TimeSoundAnalysisEditor me, EDITOR_ARGS
 	int part = makeQueriable (me, false, & tmin, & tmax);
 	if (! my p_intensity_show)
 		Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-	if (! my d_intensity) {
-		TimeSoundAnalysisEditor_computeIntensity (me);
-		if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
-	}
+	TimeSoundAnalysisEditor_computeIntensity (me);
+	if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
 	double intensity = Vector_getMinimum (my d_intensity.get(), tmin, tmax, NUM_PEAK_INTERPOLATE_PARABOLIC);
 	Melder_information (intensity, U" dB (minimum intensity ", TimeSoundAnalysisEditor_partString_locative (part), U")");
 }
@@ -1019,10 +1149,8 @@ static void menu_cb_getMaximumIntensity (TimeSoundAnalysisEditor me, EDITOR_ARGS
 	int part = makeQueriable (me, false, & tmin, & tmax);
 	if (! my p_intensity_show)
 		Melder_throw (U"No intensity contour is visible.\nFirst choose \"Show intensity\" from the Intensity menu.");
-	if (! my d_intensity) {
-		TimeSoundAnalysisEditor_computeIntensity (me);
-		if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
-	}
+	TimeSoundAnalysisEditor_computeIntensity (me);
+	if (! my d_intensity) Melder_throw (theMessage_Cannot_compute_intensity);
 	double intensity = Vector_getMaximum (my d_intensity.get(), tmin, tmax, NUM_PEAK_INTERPOLATE_PARABOLIC);
 	Melder_information (intensity, U" dB (maximum intensity ", TimeSoundAnalysisEditor_partString_locative (part), U")");
 }
@@ -1067,6 +1195,7 @@ static void menu_cb_formantSettings (TimeSoundAnalysisEditor me, EDITOR_ARGS_FOR
 		my pref_formant_dynamicRange     () = my p_formant_dynamicRange     = GET_REAL (U"Dynamic range");
 		my pref_formant_dotSize          () = my p_formant_dotSize          = GET_REAL (U"Dot size");
 		my d_formant. reset();
+		my d_formant_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -1082,6 +1211,7 @@ static void menu_cb_advancedFormantSettings (TimeSoundAnalysisEditor me, EDITOR_
 		my pref_formant_method          () = my p_formant_method          = GET_ENUM (kTimeSoundAnalysisEditor_formant_analysisMethod, U"Method");
 		my pref_formant_preemphasisFrom () = my p_formant_preemphasisFrom = GET_REAL (U"Pre-emphasis from");
 		my d_formant. reset();
+		my d_formant_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -1089,11 +1219,9 @@ static void menu_cb_advancedFormantSettings (TimeSoundAnalysisEditor me, EDITOR_
 static void menu_cb_extractVisibleFormantContour (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_formant_show)
 		Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formants\" from the Formant menu.");
-	if (! my d_formant) {
-		TimeSoundAnalysisEditor_computeFormants (me);
-		if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
-	}
-	autoFormant publish = Data_copy (my d_formant.get());
+	TimeSoundAnalysisEditor_computeFormants (me);
+	if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
+	autoFormant publish = extractVisibleFrames (me, my d_formant.get(), joinFormantFrames).static_cast_move <structFormant> ();
 	Editor_broadcastPublication (me, publish.move());
 }
 
@@ -1115,10 +1243,8 @@ static void menu_cb_drawVisibleFormantContour (TimeSoundAnalysisEditor me, EDITO
 		my pref_formant_picture_garnish () = my p_formant_picture_garnish = GET_INTEGER (U"Garnish");
 		if (! my p_formant_show)
 			Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formant\" from the Formant menu.");
-		if (! my d_formant) {
-			TimeSoundAnalysisEditor_computeFormants (me);
-			if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
-		}
+		TimeSoundAnalysisEditor_computeFormants (me);
+		if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
 		Editor_openPraatPicture (me);
 		Formant_drawSpeckles (my d_formant.get(), my pictureGraphics, my d_startWindow, my d_endWindow,
 			my p_spectrogram_viewTo, my p_formant_dynamicRange,
@@ -1133,10 +1259,8 @@ static void menu_cb_formantListing (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRE
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_formant_show)
 		Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formants\" from the Formant menu.");
-	if (! my d_formant) {
-		TimeSoundAnalysisEditor_computeFormants (me);
-		if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
-	}
+	TimeSoundAnalysisEditor_computeFormants (me);
+	if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
 	MelderInfo_open ();
 	MelderInfo_writeLine (U"Time_s   F1_Hz   F2_Hz   F3_Hz   F4_Hz");
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
@@ -1165,10 +1289,8 @@ static void do_getFormant (TimeSoundAnalysisEditor me, int iformant) {
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_formant_show)
 		Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formants\" from the Formant menu.");
-	if (! my d_formant) {
-		TimeSoundAnalysisEditor_computeFormants (me);
-		if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
-	}
+	TimeSoundAnalysisEditor_computeFormants (me);
+	if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 		Melder_information (Formant_getValueAtTime (my d_formant.get(), iformant, tmin, 0),
 			U" Hz (nearest F", iformant, U" to CURSOR)");
@@ -1182,10 +1304,8 @@ static void do_getBandwidth (TimeSoundAnalysisEditor me, int iformant) {
 	int part = makeQueriable (me, true, & tmin, & tmax);
 	if (! my p_formant_show)
 		Melder_throw (U"No formant contour is visible.\nFirst choose \"Show formants\" from the Formant menu.");
-	if (! my d_formant) {
-		TimeSoundAnalysisEditor_computeFormants (me);
-		if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
-	}
+	TimeSoundAnalysisEditor_computeFormants (me);
+	if (! my d_formant) Melder_throw (theMessage_Cannot_compute_formant);
 	if (part == TimeSoundAnalysisEditor_PART_CURSOR) {
 		Melder_information (Formant_getBandwidthAtTime (my d_formant.get(), iformant, tmin, 0),
 			U" Hz (nearest B", iformant, U" to CURSOR)");
@@ -1248,6 +1368,7 @@ static void menu_cb_advancedPulsesSettings (TimeSoundAnalysisEditor me, EDITOR_A
 		my pref_pulses_maximumPeriodFactor    () = my p_pulses_maximumPeriodFactor    = GET_REAL (U"Maximum period factor");
 		my pref_pulses_maximumAmplitudeFactor () = my p_pulses_maximumAmplitudeFactor = GET_REAL (U"Maximum amplitude factor");
 		my d_pulses. reset();
+		my d_pulses_tiles.failed = false;
 		FunctionEditor_redraw (me);
 	EDITOR_END
 }
@@ -1255,11 +1376,15 @@ static void menu_cb_advancedPulsesSettings (TimeSoundAnalysisEditor me, EDITOR_A
 static void menu_cb_extractVisiblePulses (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT) {
 	if (! my p_pulses_show)
 		Melder_throw (U"No pulses are visible.\nFirst choose \"Show pulses\" from the Pulses menu.");
-	if (! my d_pulses) {
-		TimeSoundAnalysisEditor_computePulses (me);
-		if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
+	TimeSoundAnalysisEditor_computePulses (me);
+	if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
+	autoPointProcess publish = PointProcess_create (my d_startWindow, my d_endWindow, 10);
+	if (my d_pulses -> nt > 0) {
+		long ifirst = PointProcess_getHighIndex (my d_pulses.get(), my d_startWindow);
+		long ilast = PointProcess_getLowIndex (my d_pulses.get(), my d_endWindow);
+		for (long i = ifirst; i <= ilast; i ++)
+			PointProcess_addPoint (publish.get(), my d_pulses -> t [i]);
 	}
-	autoPointProcess publish = Data_copy (my d_pulses.get());
 	Editor_broadcastPublication (me, publish.move());
 }
 
@@ -1281,10 +1406,8 @@ static void menu_cb_drawVisiblePulses (TimeSoundAnalysisEditor me, EDITOR_ARGS_F
 		my pref_pulses_picture_garnish () = my p_pulses_picture_garnish = GET_INTEGER (U"Garnish");
 		if (! my p_pulses_show)
 			Melder_throw (U"No pulses are visible.\nFirst choose \"Show pulses\" from the Pulses menu.");
-		if (! my d_pulses) {
-			TimeSoundAnalysisEditor_computePulses (me);
-			if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
-		}
+		TimeSoundAnalysisEditor_computePulses (me);
+		if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
 		Editor_openPraatPicture (me);
 		PointProcess_draw (my d_pulses.get(), my pictureGraphics, my d_startWindow, my d_endWindow,
 			my p_pulses_picture_garnish);
@@ -1299,10 +1422,8 @@ static void menu_cb_voiceReport (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT)
 	int part = makeQueriable (me, false, & tmin, & tmax);
 	if (! my p_pulses_show)
 		Melder_throw (U"No pulses are visible.\nFirst choose \"Show pulses\" from the Pulses menu.");
-	if (! my d_pulses) {
-		TimeSoundAnalysisEditor_computePulses (me);
-		if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
-	}
+	TimeSoundAnalysisEditor_computePulses (me);
+	if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
 	autoSound sound = extractSound (me, tmin, tmax);
 	MelderInfo_open ();
 	MelderInfo_writeLine (U"-- Voice report for ", my name, U" --\nDate: ", Melder_peek8to32 (ctime (& today)));
@@ -1321,10 +1442,8 @@ static void menu_cb_pulseListing (TimeSoundAnalysisEditor me, EDITOR_ARGS_DIRECT
 	makeQueriable (me, false, & tmin, & tmax);
 	if (! my p_pulses_show)
 		Melder_throw (U"No pulses are visible.\nFirst choose \"Show pulses\" from the Pulses menu.");
-	if (! my d_pulses) {
-		TimeSoundAnalysisEditor_computePulses (me);
-		if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
-	}
+	TimeSoundAnalysisEditor_computePulses (me);
+	if (! my d_pulses) Melder_throw (theMessage_Cannot_compute_pulses);
 	MelderInfo_open ();
 	MelderInfo_writeLine (U"Time_s");
 	i1 = PointProcess_getHighIndex (my d_pulses.get(), tmin);
@@ -1556,127 +1675,434 @@ void structTimeSoundAnalysisEditor :: v_createMenuItems_pulses_picture (EditorMe
 	EditorMenu_addCommand (menu, U"Draw visible pulses...", 0, menu_cb_drawVisiblePulses);
 }
 
-void TimeSoundAnalysisEditor_computeSpectrogram (TimeSoundAnalysisEditor me) {
-	autoMelderProgressOff progress;
-	if (my p_spectrogram_show && my d_endWindow - my d_startWindow <= my p_longestAnalysis &&
-		(! my d_spectrogram || my d_spectrogram -> xmin != my d_startWindow || my d_spectrogram -> xmax != my d_endWindow))
-	{
-		double margin = my p_spectrogram_windowShape == kSound_to_Spectrogram_windowShape_GAUSSIAN ? my p_spectrogram_windowLength : 0.5 * my p_spectrogram_windowLength;
-		my d_spectrogram.reset();
-		try {
-			autoSound sound = extractSound (me, my d_startWindow - margin, my d_endWindow + margin);
-			my d_spectrogram = Sound_to_Spectrogram (sound.get(), my p_spectrogram_windowLength,
-				my p_spectrogram_viewTo, (my d_endWindow - my d_startWindow) / my p_spectrogram_timeSteps,
-				my p_spectrogram_viewTo / my p_spectrogram_frequencySteps, my p_spectrogram_windowShape, 8.0, 8.0);
-			my d_spectrogram -> xmin = my d_startWindow;
-			my d_spectrogram -> xmax = my d_endWindow;
-		} catch (MelderError) {
-			Melder_clearError ();
+/*
+	The tiles of an analysis with time step dt hold theNumberOfFramesPerTile frames each;
+	tile i is centred at xmin + (i + 0.5) * theNumberOfFramesPerTile * dt, where xmin is the start of the sound.
+	Frames whose analysis window would stick out of the sound, i.e. that lie closer than the margin to an edge, are not computed.
+*/
+typedef autoSampled (*TimeSoundAnalysisEditor_TileAnalyser) (TimeSoundAnalysisEditor me, Sound part, double timeStep);
+
+static long getTile (Sampled sound, double tileDuration, double t) {
+	return (long) floor ((t - sound -> xmin) / tileDuration);
+}
+
+static autoSampled analyseTile (TimeSoundAnalysisEditor me, long itile, double timeStep, double margin,
+	TimeSoundAnalysisEditor_TileAnalyser analyse, TimeSoundAnalysisEditor_FrameJoiner join)
+{
+	Sampled sound = analysedSound (me);
+	double tileDuration = theNumberOfFramesPerTile * timeStep;
+	double midTime = sound -> xmin + (itile + 0.5) * tileDuration;
+	/*
+		Every tile is analysed from the same odd number of samples around the sample nearest to its midpoint,
+		so that the analysis frames of all tiles lie at the same distances from their midpoints.
+	*/
+	long halfNumberOfSamples = (long) ceil ((0.5 * tileDuration + margin + 2.0 * timeStep) / sound -> dx);
+	long midSample = lround ((midTime - sound -> x1) / sound -> dx) + 1;
+	autoSound part = extractSamples (me, midSample - halfNumberOfSamples, 2 * halfNumberOfSamples + 1);
+	double midSampleTime = Sampled_indexToX (part.get(), halfNumberOfSamples + 1);
+	autoSampled analysis = analyse (me, part.get(), timeStep);
+	if (fabs (analysis -> dx - timeStep) > 1e-9 * timeStep)
+		Melder_throw (U"Unexpected time step in analysis.");
+	/*
+		Keep the frames that lie within half a tile from the midpoint, measured in half time steps,
+		and put them on the grid of the nominal midpoint, from which the sample grid differs by less than half a sample.
+	*/
+	long ifirst = 1, ilast = 0;
+	double firstTime = 0.0;
+	for (long iframe = 1; iframe <= analysis -> nx; iframe ++) {
+		long doubledOffset = lround (2.0 * (Sampled_indexToX (analysis.get(), iframe) - midSampleTime) / timeStep);
+		if (doubledOffset < - theNumberOfFramesPerTile || doubledOffset >= theNumberOfFramesPerTile) continue;
+		double t = midTime + 0.5 * doubledOffset * timeStep;
+		if (t < sound -> xmin + margin || t > sound -> xmax - margin) continue;
+		if (ilast < ifirst) {
+			ifirst = iframe;
+			firstTime = t;
 		}
+		ilast = iframe;
 	}
+	if (ilast < ifirst)
+		Melder_throw (U"No analysis frames in tile ", itile, U".");
+	autoSampled thee = join (analysis.get(), ifirst, ilast, nullptr, 1, 0);
+	thy x1 = firstTime;
+	thy xmin = midTime - 0.5 * tileDuration;
+	if (thy xmin < sound -> xmin) thy xmin = sound -> xmin;
+	thy xmax = midTime + 0.5 * tileDuration;
+	if (thy xmax > sound -> xmax) thy xmax = sound -> xmax;
+	return thee;
 }
 
-static void computePitch_inside (TimeSoundAnalysisEditor me) {
-	double margin = my p_pitch_veryAccurate ? 3.0 / my p_pitch_floor : 1.5 / my p_pitch_floor;
-	my d_pitch. reset();
+/*
+	Make the analysis cover the tiles of the window, plus numberOfExtraTiles on either side,
+	computing at most maximumNumberOfNewTiles of them, starting in the middle of the window.
+	Tiles too far from the window are forgotten.
+	Returns the number of tiles that are still missing.
+	If a tile cannot be computed, the analysis is removed (as the analyses were before tiling),
+	and later calls that are not allowed to compute anything report nothing missing until tiles->failed is cleared,
+	which happens when the analysis is reset (v_reset_analysis, or a change of its settings).
+*/
+static long computeTiles (TimeSoundAnalysisEditor me, autoSampled *analysis, struct TimeSoundAnalysisEditor_tiles *tiles,
+	double timeStep, double margin, TimeSoundAnalysisEditor_TileAnalyser analyse, TimeSoundAnalysisEditor_FrameJoiner join,
+	long numberOfExtraTiles, long maximumNumberOfNewTiles)
+{
+	Sampled sound = analysedSound (me);
+	if (! sound) return 0;
+	if (! *analysis && tiles -> failed && maximumNumberOfNewTiles == 0) return 0;
 	try {
-		autoSound sound = extractSound (me, my d_startWindow - margin, my d_endWindow + margin);
-		double pitchTimeStep =
-			my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_FIXED ? my p_fixedTimeStep :
-			my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_VIEW_DEPENDENT ? (my d_endWindow - my d_startWindow) / my p_numberOfTimeStepsPerView :
-			0.0;   // the default: determined by pitch floor
-		my d_pitch = Sound_to_Pitch_any (sound.get(), pitchTimeStep,
-			my p_pitch_floor,
-			my p_pitch_method == kTimeSoundAnalysisEditor_pitch_analysisMethod_AUTOCORRELATION ? 3.0 : 1.0,
-			my p_pitch_maximumNumberOfCandidates,
-			(my p_pitch_method - 1) * 2 + my p_pitch_veryAccurate,
-			my p_pitch_silenceThreshold, my p_pitch_voicingThreshold,
-			my p_pitch_octaveCost, my p_pitch_octaveJumpCost, my p_pitch_voicedUnvoicedCost, my p_pitch_ceiling);
-		my d_pitch -> xmin = my d_startWindow;
-		my d_pitch -> xmax = my d_endWindow;
+		if (*analysis) {
+			if (fabs (tiles -> timeStep - timeStep) > 1e-9 * timeStep)
+				analysis -> reset ();   // another time grid
+			else
+				timeStep = tiles -> timeStep;   // ignore rounding differences in view-dependent time steps
+		}
+		double tileDuration = theNumberOfFramesPerTile * timeStep;
+		long firstPossibleTile = getTile (sound, tileDuration, sound -> xmin + margin + timeStep);
+		long lastPossibleTile = getTile (sound, tileDuration, sound -> xmax - margin - timeStep);
+		long firstWantedTile = getTile (sound, tileDuration, my d_startWindow) - numberOfExtraTiles;
+		long lastWantedTile = getTile (sound, tileDuration, my d_endWindow) + numberOfExtraTiles;
+		if (firstWantedTile < firstPossibleTile) firstWantedTile = firstPossibleTile;
+		if (lastWantedTile > lastPossibleTile) lastWantedTile = lastPossibleTile;
+		if (firstWantedTile > lastWantedTile) return 0;   // nothing can be analysed near the window
+		long numberOfWantedTiles = lastWantedTile - firstWantedTile + 1;
+		if (*analysis) {
+			if (tiles -> lastTile < firstWantedTile - 1 || tiles -> firstTile > lastWantedTile + 1) {
+				analysis -> reset ();   // too far away to join
+			} else if (tiles -> firstTile < firstWantedTile - numberOfWantedTiles || tiles -> lastTile > lastWantedTile + numberOfWantedTiles) {
+				long firstKeptTile = tiles -> firstTile < firstWantedTile - numberOfWantedTiles ? firstWantedTile - numberOfWantedTiles : tiles -> firstTile;
+				long lastKeptTile = tiles -> lastTile > lastWantedTile + numberOfWantedTiles ? lastWantedTile + numberOfWantedTiles : tiles -> lastTile;
+				Sampled old = analysis -> get();
+				double xmin = firstKeptTile == tiles -> firstTile ? old -> xmin : sound -> xmin + firstKeptTile * tileDuration;
+				double xmax = lastKeptTile == tiles -> lastTile ? old -> xmax : sound -> xmin + (lastKeptTile + 1) * tileDuration;
+				long ifirst = (long) ceil ((xmin - old -> x1) / old -> dx - 1e-6) + 1, ilast = (long) ceil ((xmax - old -> x1) / old -> dx - 1e-6);
+				if (ifirst < 1) ifirst = 1;
+				if (ilast > old -> nx) ilast = old -> nx;
+				*analysis = join (old, ifirst, ilast, nullptr, 1, 0);
+				(*analysis) -> xmin = xmin;
+				(*analysis) -> xmax = xmax;
+				tiles -> firstTile = firstKeptTile;
+				tiles -> lastTile = lastKeptTile;
+			}
+		}
+		long numberOfMissingTiles = ! *analysis ? numberOfWantedTiles :
+			(tiles -> firstTile > firstWantedTile ? tiles -> firstTile - firstWantedTile : 0) +
+			(tiles -> lastTile < lastWantedTile ? lastWantedTile - tiles -> lastTile : 0);
+		for (long itile = 1; itile <= maximumNumberOfNewTiles && numberOfMissingTiles > 0; itile ++) {
+			if (! *analysis) {
+				long middleTile = (firstWantedTile + lastWantedTile) / 2;
+				*analysis = analyseTile (me, middleTile, timeStep, margin, analyse, join);
+				tiles -> timeStep = timeStep;
+				tiles -> firstTile = tiles -> lastTile = middleTile;
+			} else if (tiles -> firstTile - firstWantedTile >= lastWantedTile - tiles -> lastTile) {
+				autoSampled tile = analyseTile (me, tiles -> firstTile - 1, timeStep, margin, analyse, join);
+				Sampled old = analysis -> get();
+				if (fabs (Sampled_indexToX (tile.get(), (long) tile -> nx) + timeStep - old -> x1) > 1e-6 * timeStep)
+					Melder_throw (U"Tile ", tiles -> firstTile - 1, U" does not fit.");
+				double xmin = tile -> xmin, xmax = old -> xmax;
+				*analysis = join (tile.get(), 1, tile -> nx, old, 1, old -> nx);
+				(*analysis) -> xmin = xmin;
+				(*analysis) -> xmax = xmax;
+				tiles -> firstTile -= 1;
+			} else {
+				autoSampled tile = analyseTile (me, tiles -> lastTile + 1, timeStep, margin, analyse, join);
+				Sampled old = analysis -> get();
+				if (fabs (Sampled_indexToX (old, (long) old -> nx) + timeStep - tile -> x1) > 1e-6 * timeStep)
+					Melder_throw (U"Tile ", tiles -> lastTile + 1, U" does not fit.");
+				double xmin = old -> xmin, xmax = tile -> xmax;
+				*analysis = join (old, 1, old -> nx, tile.get(), 1, tile -> nx);
+				(*analysis) -> xmin = xmin;
+				(*analysis) -> xmax = xmax;
+				tiles -> lastTile += 1;
+			}
+			numberOfMissingTiles -= 1;
+		}
+		tiles -> failed = false;
+		return numberOfMissingTiles;
 	} catch (MelderError) {
 		Melder_clearError ();
+		analysis -> reset ();
+		tiles -> failed = true;
+		return 0;
 	}
 }
 
-void TimeSoundAnalysisEditor_computePitch (TimeSoundAnalysisEditor me) {
+static autoSampled analyseSpectrogramTile (TimeSoundAnalysisEditor me, Sound part, double timeStep) {
+	return Sound_to_Spectrogram (part, my p_spectrogram_windowLength, my p_spectrogram_viewTo, timeStep,
+		my p_spectrogram_viewTo / my p_spectrogram_frequencySteps, my p_spectrogram_windowShape, 8.0, 8.0);
+}
+
+static long computeSpectrogramTiles (TimeSoundAnalysisEditor me, long numberOfExtraTiles, long maximumNumberOfNewTiles) {
+	if (! my p_spectrogram_show || my d_endWindow - my d_startWindow > my p_longestAnalysis) return 0;
+	double margin = my p_spectrogram_windowShape == kSound_to_Spectrogram_windowShape_GAUSSIAN ? my p_spectrogram_windowLength : 0.5 * my p_spectrogram_windowLength;
+	/*
+		The number of time steps is a maximum (see "Advanced spectrogram settings..."),
+		so we may round the time step up to a power of the square root of 2;
+		the tiles then survive zooming by small factors.
+	*/
+	double timeStep = pow (2.0, 0.5 * ceil (2.0 * log2 ((my d_endWindow - my d_startWindow) / my p_spectrogram_timeSteps)));
+	double minimumTimeStep = my p_spectrogram_windowLength / sqrt (NUMpi) / 8.0;   // as in Sound_to_Spectrogram
+	if (timeStep < minimumTimeStep) timeStep = minimumTimeStep;
+	autoSampled analysis = my d_spectrogram.move();
+	long numberOfMissingTiles = computeTiles (me, & analysis, & my d_spectrogram_tiles, timeStep, margin,
+		analyseSpectrogramTile, joinSpectrogramFrames, numberOfExtraTiles, maximumNumberOfNewTiles);
+	my d_spectrogram = analysis.static_cast_move <structSpectrogram> ();
+	return numberOfMissingTiles;
+}
+
+void TimeSoundAnalysisEditor_computeSpectrogram (TimeSoundAnalysisEditor me) {
 	autoMelderProgressOff progress;
-	if (my p_pitch_show && my d_endWindow - my d_startWindow <= my p_longestAnalysis &&
-		(! my d_pitch || my d_pitch -> xmin != my d_startWindow || my d_pitch -> xmax != my d_endWindow))
+	computeSpectrogramTiles (me, 0, INT32_MAX);
+}
+
+static autoSampled analysePitchTile (TimeSoundAnalysisEditor me, Sound part, double timeStep) {
+	return Sound_to_Pitch_any_withGlobalPeak (part, timeStep,
+		my p_pitch_floor,
+		my p_pitch_method == kTimeSoundAnalysisEditor_pitch_analysisMethod_AUTOCORRELATION ? 3.0 : 1.0,
+		my p_pitch_maximumNumberOfCandidates,
+		(my p_pitch_method - 1) * 2 + my p_pitch_veryAccurate,
+		my p_pitch_silenceThreshold, my p_pitch_voicingThreshold,
+		my p_pitch_octaveCost, my p_pitch_octaveJumpCost, my p_pitch_voicedUnvoicedCost, my p_pitch_ceiling,
+		my d_pitch_referencePeak);
+}
+
+/*
+	Each tile comes with its own path through the pitch candidates, which may not match up with that of its neighbours.
+	The candidates are all kept, so the path is found anew, in one go, for the frames in the window
+	(as it was before tiling), whenever the frames or the window have changed.
+	The pulses follow the path, so they have to be computed anew.
+*/
+static void findPitchPath (TimeSoundAnalysisEditor me) {
+	if (! my d_pitch || (my d_pitch_pathStart == my d_startWindow && my d_pitch_pathEnd == my d_endWindow)) return;
+	Pitch pitch = my d_pitch.get();
+	long ifirst, ilast;
+	if (Sampled_getWindowSamples (pitch, my d_startWindow, my d_endWindow, & ifirst, & ilast) < 2) return;
+	try {
+		autoPitch visible = joinPitchFrames (pitch, ifirst, ilast, nullptr, 1, 0).static_cast_move <structPitch> ();
+		rescalePitchIntensities (me, visible.get());
+		Pitch_pathFinder (visible.get(), my p_pitch_silenceThreshold, my p_pitch_voicingThreshold,
+			my p_pitch_octaveCost, my p_pitch_octaveJumpCost, my p_pitch_voicedUnvoicedCost, my p_pitch_ceiling, Melder_debug == 31);
+		for (long iframe = ifirst; iframe <= ilast; iframe ++) {
+			Pitch_Frame from = & visible -> frame [iframe - ifirst + 1], to = & pitch -> frame [iframe];
+			for (long icand = 1; icand <= to -> nCandidates; icand ++)
+				to -> candidate [icand] = from -> candidate [icand];
+		}
+	} catch (MelderError) {
+		Melder_clearError ();   // keep the paths of the tiles
+	}
+	my d_pitch_pathStart = my d_startWindow;
+	my d_pitch_pathEnd = my d_endWindow;
+	my d_pulses. reset();
+}
+
+static long computePitchTiles (TimeSoundAnalysisEditor me, long numberOfExtraTiles, long maximumNumberOfNewTiles) {
+	if (! (my p_pitch_show || my p_pulses_show) || my d_endWindow - my d_startWindow > my p_longestAnalysis) return 0;
+	double margin = my p_pitch_veryAccurate ? 3.0 / my p_pitch_floor : 1.5 / my p_pitch_floor;
+	double periodsPerWindow = my p_pitch_method == kTimeSoundAnalysisEditor_pitch_analysisMethod_AUTOCORRELATION ? 3.0 : 1.0;
+	double timeStep =
+		my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_FIXED ? my p_fixedTimeStep :
+		my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_VIEW_DEPENDENT ? (my d_endWindow - my d_startWindow) / my p_numberOfTimeStepsPerView :
+		periodsPerWindow / my p_pitch_floor / 4.0;   // the default: determined by pitch floor, as in Sound_to_Pitch
+	struct TimeSoundAnalysisEditor_tiles previousTiles = my d_pitch_tiles;
+	bool hadPitch = !! my d_pitch;
+	if (! hadPitch)
+		my d_pitch_referencePeak = pitchReferencePeak (me);
+	autoSampled analysis = my d_pitch.move();
+	long numberOfMissingTiles = computeTiles (me, & analysis, & my d_pitch_tiles, timeStep, margin,
+		analysePitchTile, joinPitchFrames, numberOfExtraTiles, maximumNumberOfNewTiles);
+	my d_pitch = analysis.static_cast_move <structPitch> ();
+	if (! hadPitch || my d_pitch_tiles.timeStep != previousTiles.timeStep ||
+		my d_pitch_tiles.firstTile != previousTiles.firstTile || my d_pitch_tiles.lastTile != previousTiles.lastTile)
 	{
-		computePitch_inside (me);
+		my d_pitch_pathStart = my d_pitch_pathEnd = NUMundefined;   // other frames
 	}
+	findPitchPath (me);
+	return numberOfMissingTiles;
+}
+
+void TimeSoundAnalysisEditor_computePitch (TimeSoundAnalysisEditor me) {
+	autoMelderProgressOff progress;
+	if (my p_pitch_show)
+		computePitchTiles (me, 0, INT32_MAX);
+}
+
+static autoSampled analyseIntensityTile (TimeSoundAnalysisEditor me, Sound part, double timeStep) {
+	return Sound_to_Intensity (part, my p_pitch_floor, timeStep, my p_intensity_subtractMeanPressure);
+}
+
+static long computeIntensityTiles (TimeSoundAnalysisEditor me, long numberOfExtraTiles, long maximumNumberOfNewTiles) {
+	if (! my p_intensity_show || my d_endWindow - my d_startWindow > my p_longestAnalysis) return 0;
+	double margin = 3.2 / my p_pitch_floor;
+	double timeStep = 0.8 / my p_pitch_floor;   // the default of Sound_to_Intensity
+	autoSampled analysis = my d_intensity.move();
+	long numberOfMissingTiles = computeTiles (me, & analysis, & my d_intensity_tiles, timeStep, margin,
+		analyseIntensityTile, joinIntensityFrames, numberOfExtraTiles, maximumNumberOfNewTiles);
+	my d_intensity = analysis.static_cast_move <structIntensity> ();
+	return numberOfMissingTiles;
 }
 
 void TimeSoundAnalysisEditor_computeIntensity (TimeSoundAnalysisEditor me) {
 	autoMelderProgressOff progress;
-	if (my p_intensity_show && my d_endWindow - my d_startWindow <= my p_longestAnalysis &&
-		(! my d_intensity || my d_intensity -> xmin != my d_startWindow || my d_intensity -> xmax != my d_endWindow))
-	{
-		double margin = 3.2 / my p_pitch_floor;
-		my d_intensity. reset();
-		try {
-			autoSound sound = extractSound (me, my d_startWindow - margin, my d_endWindow + margin);
-			my d_intensity = Sound_to_Intensity (sound.get(), my p_pitch_floor,
-				my d_endWindow - my d_startWindow > my p_longestAnalysis ? (my d_endWindow - my d_startWindow) / 100 : 0.0,
-				my p_intensity_subtractMeanPressure);
-			my d_intensity -> xmin = my d_startWindow;
-			my d_intensity -> xmax = my d_endWindow;
-		} catch (MelderError) {
-			Melder_clearError ();
-		}
-	}
+	computeIntensityTiles (me, 0, INT32_MAX);
+}
+
+static autoSampled analyseFormantTile (TimeSoundAnalysisEditor me, Sound part, double timeStep) {
+	return Sound_to_Formant_any (part, timeStep,
+		lround (my p_formant_numberOfFormants * 2), my p_formant_maximumFormant,
+		my p_formant_windowLength, my p_formant_method, my p_formant_preemphasisFrom, 50.0);
+}
+
+static long computeFormantTiles (TimeSoundAnalysisEditor me, long numberOfExtraTiles, long maximumNumberOfNewTiles) {
+	if (! my p_formant_show || my d_endWindow - my d_startWindow > my p_longestAnalysis) return 0;
+	double margin = my p_formant_windowLength;
+	double timeStep =
+		my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_FIXED ? my p_fixedTimeStep :
+		my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_VIEW_DEPENDENT ? (my d_endWindow - my d_startWindow) / my p_numberOfTimeStepsPerView :
+		my p_formant_windowLength / 4.0;   // the default: determined by analysis window length, as in Sound_to_Formant
+	autoSampled analysis = my d_formant.move();
+	long numberOfMissingTiles = computeTiles (me, & analysis, & my d_formant_tiles, timeStep, margin,
+		analyseFormantTile, joinFormantFrames, numberOfExtraTiles, maximumNumberOfNewTiles);
+	my d_formant = analysis.static_cast_move <structFormant> ();
+	return numberOfMissingTiles;
 }
 
 void TimeSoundAnalysisEditor_computeFormants (TimeSoundAnalysisEditor me) {
 	autoMelderProgressOff progress;
-	if (my p_formant_show && my d_endWindow - my d_startWindow <= my p_longestAnalysis &&
-		(! my d_formant || my d_formant -> xmin != my d_startWindow || my d_formant -> xmax != my d_endWindow))
-	{
-		double margin = my p_formant_windowLength;
-		my d_formant. reset();
-		try {
-			autoSound sound =
-				my d_endWindow - my d_startWindow > my p_longestAnalysis ?
-					extractSound (me,
-						0.5 * (my d_startWindow + my d_endWindow - my p_longestAnalysis) - margin,
-						0.5 * (my d_startWindow + my d_endWindow + my p_longestAnalysis) + margin) :
-					extractSound (me, my d_startWindow - margin, my d_endWindow + margin);
-			double formantTimeStep =
-				my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_FIXED ? my p_fixedTimeStep :
-				my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_VIEW_DEPENDENT ? (my d_endWindow - my d_startWindow) / my p_numberOfTimeStepsPerView :
-				0.0;   // the default: determined by analysis window length
-			my d_formant = Sound_to_Formant_any (sound.get(), formantTimeStep,
-				lround (my p_formant_numberOfFormants * 2), my p_formant_maximumFormant,
-				my p_formant_windowLength, my p_formant_method, my p_formant_preemphasisFrom, 50.0);
-			my d_formant -> xmin = my d_startWindow;
-			my d_formant -> xmax = my d_endWindow;
-		} catch (MelderError) {
-			Melder_clearError ();
-		}
+	computeFormantTiles (me, 0, INT32_MAX);
+}
+
+/*
+	The pulses are computed in one go for all the pitch tiles,
+	because a voiced stretch has to be followed from its middle outwards;
+	they are kept as long as they were computed on the same time grid and cover the visible part of the pitch contour.
+*/
+static bool pulsesAreMissing (TimeSoundAnalysisEditor me) {
+	if (! my p_pulses_show || my d_endWindow - my d_startWindow > my p_longestAnalysis || ! my d_pitch) return false;
+	if (! my d_pulses) return ! my d_pulses_tiles.failed;
+	double tmin = my d_startWindow > my d_pitch -> xmin ? my d_startWindow : my d_pitch -> xmin;
+	double tmax = my d_endWindow < my d_pitch -> xmax ? my d_endWindow : my d_pitch -> xmax;
+	return my d_pulses_tiles.timeStep != my d_pitch_tiles.timeStep || my d_pulses -> xmin > tmin || my d_pulses -> xmax < tmax;
+}
+
+static void computePulses_inside (TimeSoundAnalysisEditor me) {
+	my d_pulses. reset();
+	try {
+		autoSound sound = extractSound (me, my d_pitch -> xmin, my d_pitch -> xmax);
+		my d_pulses = Sound_Pitch_to_PointProcess_cc (sound.get(), my d_pitch.get());
+		my d_pulses_tiles = my d_pitch_tiles;
+		my d_pulses_tiles.failed = false;
+	} catch (MelderError) {
+		Melder_clearError ();
+		my d_pulses_tiles.failed = true;
 	}
 }
 
 void TimeSoundAnalysisEditor_computePulses (TimeSoundAnalysisEditor me) {
 	autoMelderProgressOff progress;
-	if (my p_pulses_show && my d_endWindow - my d_startWindow <= my p_longestAnalysis &&
-		(! my d_pulses || my d_pulses -> xmin != my d_startWindow || my d_pulses -> xmax != my d_endWindow))
-	{
-		my d_pulses. reset();
-		if (! my d_pitch || my d_pitch -> xmin != my d_startWindow || my d_pitch -> xmax != my d_endWindow) {
-			computePitch_inside (me);
-		}
-		if (my d_pitch) {
-			try {
-				autoSound sound = extractSound (me, my d_startWindow, my d_endWindow);
-				my d_pulses = Sound_Pitch_to_PointProcess_cc (sound.get(), my d_pitch.get());
-			} catch (MelderError) {
-				Melder_clearError ();
-			}
-		}
+	if (my p_pulses_show && my d_endWindow - my d_startWindow <= my p_longestAnalysis) {
+		computePitchTiles (me, 0, INT32_MAX);
+		my d_pulses_tiles.failed = false;
+		if (! my d_pitch)
+			my d_pulses. reset();
+		else if (pulsesAreMissing (me))
+			computePulses_inside (me);
 	}
 }
 
+/*
+	Drawing shows the tiles that are there, and leaves the missing ones to idle time,
+	when they are computed one by one, each followed by a redraw, so that the editor stays responsive.
+	Once the visible part is complete, one tile beyond either edge of the window is computed ahead of scrolling.
+	The analyses are not computed on a separate thread, because reading a LongSound
+	and the analysis routines' progress and threading machinery are not safe to use concurrently with drawing.
+	Without a GUI, scheduleAnalysis () computes everything at once instead.
+*/
+#if cocoa || gtk || motif
+static bool analyseInIdleTime (TimeSoundAnalysisEditor me, bool *visible) {
+	autoMelderProgressOff progress;
+	*visible = true;
+	if (computeSpectrogramTiles (me, 0, 0) > 0) { computeSpectrogramTiles (me, 0, 1); return true; }
+	if (computePitchTiles (me, 0, 0) > 0) { computePitchTiles (me, 0, 1); return true; }
+	if (computeIntensityTiles (me, 0, 0) > 0) { computeIntensityTiles (me, 0, 1); return true; }
+	if (computeFormantTiles (me, 0, 0) > 0) { computeFormantTiles (me, 0, 1); return true; }
+	if (pulsesAreMissing (me)) { computePulses_inside (me); return true; }
+	*visible = false;
+	if (computeSpectrogramTiles (me, 1, 0) > 0) { computeSpectrogramTiles (me, 1, 1); return true; }
+	if (computePitchTiles (me, 1, 0) > 0) { computePitchTiles (me, 1, 1); return true; }
+	if (computeIntensityTiles (me, 1, 0) > 0) { computeIntensityTiles (me, 1, 1); return true; }
+	if (computeFormantTiles (me, 1, 0) > 0) { computeFormantTiles (me, 1, 1); return true; }
+	return false;
+}
+
+#if cocoa
+	#define WORKPROC_RETURN  void
+	#define WORKPROC_ARGS  CFRunLoopTimerRef /* timer */, void *void_me
+#elif gtk
+	#define WORKPROC_RETURN  gboolean
+	#define WORKPROC_ARGS  void *void_me
+#else
+	#define WORKPROC_RETURN  bool
+	#define WORKPROC_ARGS  void *void_me
+#endif
+
+static WORKPROC_RETURN analysisWorkProc (WORKPROC_ARGS) {
+	TimeSoundAnalysisEditor me = static_cast <TimeSoundAnalysisEditor> (void_me);
+	bool visible;
+	bool more = analyseInIdleTime (me, & visible);
+	if (more && visible)
+		FunctionEditor_redraw (me);
+	if (! more) {
+		my d_analysisPending = false;
+		#if cocoa
+			CFRunLoopTimerInvalidate (my d_analysisTimer);
+			CFRelease (my d_analysisTimer);
+			my d_analysisTimer = nullptr;
+		#endif
+	}
+	#if cocoa
+		return;
+	#elif gtk
+		return more;
+	#else
+		return ! more;
+	#endif
+}
+#endif
+
+static void scheduleAnalysis (TimeSoundAnalysisEditor me) {
+	if (my d_analysisPending) return;
+	#if cocoa || gtk || motif
+		my d_analysisPending = true;
+		#if cocoa
+			CFRunLoopTimerContext context = { 0, me, nullptr, nullptr, nullptr };
+			my d_analysisTimer = CFRunLoopTimerCreate (nullptr, CFAbsoluteTimeGetCurrent () + 0.02,
+				0.02, 0, 0, analysisWorkProc, & context);
+			CFRunLoopAddTimer (CFRunLoopGetCurrent (), my d_analysisTimer, kCFRunLoopCommonModes);
+		#elif gtk
+			g_idle_add (analysisWorkProc, me);
+		#elif motif
+			my d_analysisWorkProcId = GuiAddWorkProc (analysisWorkProc, me);
+		#endif
+	#else
+		TimeSoundAnalysisEditor_computeSpectrogram (me);
+		TimeSoundAnalysisEditor_computePitch (me);
+		TimeSoundAnalysisEditor_computeIntensity (me);
+		TimeSoundAnalysisEditor_computeFormants (me);
+		TimeSoundAnalysisEditor_computePulses (me);
+	#endif
+}
+
+static void stopAnalysis (TimeSoundAnalysisEditor me) {
+	if (! my d_analysisPending) return;
+	#if cocoa
+		CFRunLoopTimerInvalidate (my d_analysisTimer);
+		CFRelease (my d_analysisTimer);
+		my d_analysisTimer = nullptr;
+	#elif gtk
+		g_idle_remove_by_data (me);
+	#elif motif
+		XtRemoveWorkProc (my d_analysisWorkProcId);
+	#endif
+	my d_analysisPending = false;
+}
+
 static void TimeSoundAnalysisEditor_v_draw_analysis (TimeSoundAnalysisEditor me) {
 	/*
 	 * d_pitch may not exist yet (if shown at all, it may be going to be created in TimeSoundAnalysisEditor_computePitch (),
@@ -1706,13 +2132,13 @@ static void TimeSoundAnalysisEditor_v_draw_analysis (TimeSoundAnalysisEditor me)
 		Graphics_setFontSize (my d_graphics.get(), 12);
 		return;
 	}
-	TimeSoundAnalysisEditor_computeSpectrogram (me);
+	findPitchPath (me);
+	scheduleAnalysis (me);
 	if (my p_spectrogram_show && my d_spectrogram) {
 		Spectrogram_paintInside (my d_spectrogram.get(), my d_graphics.get(), my d_startWindow, my d_endWindow,
 			my p_spectrogram_viewFrom, my p_spectrogram_viewTo, my p_spectrogram_maximum, my p_spectrogram_autoscaling,
 			my p_spectrogram_dynamicRange, my p_spectrogram_preemphasis, my p_spectrogram_dynamicCompression);
 	}
-	TimeSoundAnalysisEditor_computePitch (me);
 	if (my p_pitch_show && my d_pitch) {
 		double periodsPerAnalysisWindow = my p_pitch_method == kTimeSoundAnalysisEditor_pitch_analysisMethod_AUTOCORRELATION ? 3.0 : 1.0;
 		double greatestNonUndersamplingTimeStep = 0.5 * periodsPerAnalysisWindow / my p_pitch_floor;
@@ -1749,7 +2175,6 @@ static void TimeSoundAnalysisEditor_v_draw_analysis (TimeSoundAnalysisEditor me)
 		}
 		Graphics_setColour (my d_graphics.get(), Graphics_BLACK);
 	}
-	TimeSoundAnalysisEditor_computeIntensity (me);
 	if (my p_intensity_show && my d_intensity) {
 		Graphics_setColour (my d_graphics.get(), my p_spectrogram_show ? Graphics_YELLOW : Graphics_LIME);
 		Graphics_setLineWidth (my d_graphics.get(), my p_spectrogram_show ? 1.0 : 3.0);
@@ -1758,7 +2183,6 @@ static void TimeSoundAnalysisEditor_v_draw_analysis (TimeSoundAnalysisEditor me)
 		Graphics_setLineWidth (my d_graphics.get(), 1.0);
 		Graphics_setColour (my d_graphics.get(), Graphics_BLACK);
 	}
-	TimeSoundAnalysisEditor_computeFormants (me);
 	if (my p_formant_show && my d_formant) {
 		Graphics_setColour (my d_graphics.get(), Graphics_RED);
 		Graphics_setSpeckleSize (my d_graphics.get(), my p_formant_dotSize);
@@ -1797,7 +2221,7 @@ static void TimeSoundAnalysisEditor_v_draw_analysis (TimeSoundAnalysisEditor me)
 					Melder_float (Melder_half (pitchViewTo_overt)), U" ",
 					Function_getUnitText (my d_pitch.get(), Pitch_LEVEL_FREQUENCY, my p_pitch_unit, Function_UNIT_TEXT_SHORT | Function_UNIT_TEXT_GRAPHICAL));
 			}
-		} else {
+		} else if (! my d_analysisPending) {
 			Graphics_setTextAlignment (my d_graphics.get(), Graphics_CENTRE, Graphics_HALF);
 			Graphics_setFontSize (my d_graphics.get(), 10);
 			Graphics_text (my d_graphics.get(), 0.5 * (my d_startWindow + my d_endWindow), 0.5 * (pitchViewFrom_hidden + pitchViewTo_hidden),
@@ -1893,15 +2317,15 @@ void structTimeSoundAnalysisEditor :: v_draw_analysis () {
 }
 
 void structTimeSoundAnalysisEditor :: v_draw_analysis_pulses () {
-	TimeSoundAnalysisEditor_computePulses (this);
-	if (our p_pulses_show && our d_endWindow - our d_startWindow <= our p_longestAnalysis && our d_pulses) {
+	scheduleAnalysis (this);
+	if (our p_pulses_show && our d_endWindow - our d_startWindow <= our p_longestAnalysis && our d_pulses && our d_pulses -> nt > 0) {
 		PointProcess point = our d_pulses.get();
 		Graphics_setWindow (our d_graphics.get(), our d_startWindow, our d_endWindow, -1.0, 1.0);
 		Graphics_setColour (our d_graphics.get(), Graphics_BLUE);
-		if (point -> nt < 2000) for (long i = 1; i <= point -> nt; i ++) {
+		long ifirst = PointProcess_getHighIndex (point, our d_startWindow), ilast = PointProcess_getLowIndex (point, our d_endWindow);
+		if (ilast - ifirst < 2000) for (long i = ifirst; i <= ilast; i ++) {
 			double t = point -> t [i];
-			if (t >= our d_startWindow && t <= our d_endWindow)
-				Graphics_line (our d_graphics.get(), t, -0.9, t, 0.9);
+			Graphics_line (our d_graphics.get(), t, -0.9, t, 0.9);
 		}
 		Graphics_setColour (our d_graphics.get(), Graphics_BLACK);
 	}
@@ -1915,6 +2339,7 @@ bool structTimeSoundAnalysisEditor :: v_click (double xbegin, double ybegin, boo
 			our d_pitch. reset();
 			our d_intensity.reset();
 			our d_pulses. reset();
+			our d_pitch_tiles.failed = our d_intensity_tiles.failed = our d_pulses_tiles.failed = false;
 			return FunctionEditor_UPDATE_NEEDED;
 		}
 		if (xbegin >= our d_endWindow && ybegin > 0.46 && ybegin <= 0.48) {
@@ -1922,6 +2347,7 @@ bool structTimeSoundAnalysisEditor :: v_click (double xbegin, double ybegin, boo
 			our d_pitch. reset();
 			our d_intensity. reset();
 			our d_pulses. reset();
+			our d_pitch_tiles.failed = our d_intensity_tiles.failed = our d_pulses_tiles.failed = false;
 			return FunctionEditor_UPDATE_NEEDED;
 		}
 	}
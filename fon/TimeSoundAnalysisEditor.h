@@ -27,6 +27,17 @@
 
 #include "TimeSoundAnalysisEditor_enums.h"
 
+/*
+	The analyses are cached in tiles of a fixed number of frames on a time grid that starts at the start of the sound.
+	An analysis object holds the frames of the consecutive tiles firstTile..lastTile,
+	computed with the given time step; scrolling and zooming reuse the tiles that are already there.
+*/
+struct TimeSoundAnalysisEditor_tiles {
+	double timeStep;
+	long firstTile, lastTile;
+	bool failed;   // the last attempt to compute a tile did not succeed; do not retry in idle time until the analysis is reset
+};
+
 Thing_define (TimeSoundAnalysisEditor, TimeSoundEditor) {
 	autoSpectrogram d_spectrogram;
 	double d_spectrogram_cursor;
@@ -34,6 +45,15 @@ Thing_define (TimeSoundAnalysisEditor, TimeSoundEditor) {
 	autoIntensity d_intensity;
 	autoFormant d_formant;
 	autoPointProcess d_pulses;
+	struct TimeSoundAnalysisEditor_tiles d_spectrogram_tiles, d_pitch_tiles, d_intensity_tiles, d_formant_tiles, d_pulses_tiles;
+	double d_pitch_pathStart, d_pitch_pathEnd;   // the window for which the path through the pitch candidates was last found
+	double d_pitch_referencePeak;   // the peak to which the intensities of all pitch tiles are relative
+	bool d_analysisPending;   // tiles of the visible part are being computed in idle time
+	#if cocoa
+		CFRunLoopTimerRef d_analysisTimer;
+	#elif motif
+		XtWorkProcId d_analysisWorkProcId;
+	#endif
 	GuiMenuItem spectrogramToggle, pitchToggle, intensityToggle, formantToggle, pulsesToggle;
 
 	void v_destroy () noexcept
@@ -258,106 +258,290 @@ void PointProcess_Sound_getShimmer_multi (PointProcess me, Sound thee, double tm
 	}
 }
 
+static void PointProcess_getJitter_multi (PointProcess me, double tmin, double tmax,
+	double pmin, double pmax, double maximumPeriodFactor, double meanPeriod,
+	double *local, double *local_absolute, double *rap, double *ppq5, double *ddp)
+{
+	/*
+		The same sums as in the separate PointProcess_getJitter_XXX functions, in the same order, but in a single loop.
+	*/
+	*local = *local_absolute = *rap = *ppq5 = *ddp = NUMundefined;
+	long imin, imax;
+	long numberOfPeriods = PointProcess_getWindowPoints (me, tmin, tmax, & imin, & imax) - 1;
+	if (numberOfPeriods < 2) return;
+	long numberOfPeriods_local = numberOfPeriods, numberOfPeriods_rap = numberOfPeriods, numberOfPeriods_ppq5 = numberOfPeriods;
+	double sum_local = 0.0, sum_rap = 0.0, sum_ppq5 = 0.0;
+	for (long i = imin + 1; i <= imax; i ++) {
+		double p4 = my t [i - 1] - (i - 2 >= imin ? my t [i - 2] : 0.0), p5 = my t [i] - my t [i - 1];
+		if (i < imax) {
+			double p1 = p5, p2 = my t [i + 1] - my t [i];
+			double intervalFactor = p1 > p2 ? p1 / p2 : p2 / p1;
+			if (pmin == pmax || (p1 >= pmin && p1 <= pmax && p2 >= pmin && p2 <= pmax && intervalFactor <= maximumPeriodFactor)) {
+				sum_local += fabs (p1 - p2);
+			} else {
+				numberOfPeriods_local --;
+			}
+			if (i >= imin + 2) {
+				double r1 = p4, r2 = p5, r3 = my t [i + 1] - my t [i];
+				double intervalFactor1 = r1 > r2 ? r1 / r2 : r2 / r1, intervalFactor2 = r2 > r3 ? r2 / r3 : r3 / r2;
+				if (pmin == pmax || (r1 >= pmin && r1 <= pmax && r2 >= pmin && r2 <= pmax && r3 >= pmin && r3 <= pmax
+					&& intervalFactor1 <= maximumPeriodFactor && intervalFactor2 <= maximumPeriodFactor))
+				{
+					sum_rap += fabs (r2 - (r1 + r2 + r3) / 3.0);
+				} else {
+					numberOfPeriods_rap --;
+				}
+			}
+		}
+		if (i >= imin + 5) {
+			double
+				p1 = my t [i - 4] - my t [i - 5],
+				p2 = my t [i - 3] - my t [i - 4],
+				p3 = my t [i - 2] - my t [i - 3];
+			double
+				f1 = p1 > p2 ? p1 / p2 : p2 / p1,
+				f2 = p2 > p3 ? p2 / p3 : p3 / p2,
+				f3 = p3 > p4 ? p3 / p4 : p4 / p3,
+				f4 = p4 > p5 ? p4 / p5 : p5 / p4;
+			if (pmin == pmax || (p1 >= pmin && p1 <= pmax && p2 >= pmin && p2 <= pmax && p3 >= pmin && p3 <= pmax &&
+				p4 >= pmin && p4 <= pmax && p5 >= pmin && p5 <= pmax &&
+				f1 <= maximumPeriodFactor && f2 <= maximumPeriodFactor && f3 <= maximumPeriodFactor && f4 <= maximumPeriodFactor))
+			{
+				sum_ppq5 += fabs (p3 - (p1 + p2 + p3 + p4 + p5) / 5.0);
+			} else {
+				numberOfPeriods_ppq5 --;
+			}
+		}
+	}
+	if (numberOfPeriods_local >= 2) {
+		*local = sum_local / (numberOfPeriods_local - 1) / meanPeriod;
+		*local_absolute = sum_local / (numberOfPeriods_local - 1);
+	}
+	if (numberOfPeriods >= 3 && numberOfPeriods_rap >= 3) {
+		*rap = sum_rap / (numberOfPeriods_rap - 2) / meanPeriod;
+		*ddp = 3.0 * *rap;
+	}
+	if (numberOfPeriods >= 5 && numberOfPeriods_ppq5 >= 5)
+		*ppq5 = sum_ppq5 / (numberOfPeriods_ppq5 - 4) / meanPeriod;
+}
+
+static void Sound_Pitch_PointProcess_getVoiceReport_cached (Sound sound, Pitch pitch, PointProcess pulses, double tmin, double tmax,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor, double silenceThreshold, double voicingThreshold,
+	double *peakCache, struct structVoiceReport *report)
+{
+	if (tmin >= tmax) tmin = sound -> xmin, tmax = sound -> xmax;
+	report -> tmin = tmin;
+	report -> tmax = tmax;
+	/*
+	 * Pitch statistics.
+	 */
+	report -> medianPitch = Pitch_getQuantile (pitch, tmin, tmax, 0.50, kPitch_unit_HERTZ);
+	report -> meanPitch = Pitch_getMean (pitch, tmin, tmax, kPitch_unit_HERTZ);
+	report -> stdevPitch = Pitch_getStandardDeviation (pitch, tmin, tmax, kPitch_unit_HERTZ);
+	report -> minimumPitch = Pitch_getMinimum (pitch, tmin, tmax, kPitch_unit_HERTZ, 1);
+	report -> maximumPitch = Pitch_getMaximum (pitch, tmin, tmax, kPitch_unit_HERTZ, 1);
+	/*
+	 * Pulses statistics.
+	 */
+	double pmin = 0.8 / ceiling, pmax = 1.25 / floor;
+	report -> numberOfPulses = PointProcess_getWindowPoints (pulses, tmin, tmax, nullptr, nullptr);
+	report -> numberOfPeriods = PointProcess_getNumberOfPeriods (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor);
+	report -> meanPeriod = PointProcess_getMeanPeriod (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor);
+	report -> stdevPeriod = PointProcess_getStdevPeriod (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor);
+	/*
+	 * Voicing.
+	 */
+	long imin, imax, n = Sampled_getWindowSamples (pitch, tmin, tmax, & imin, & imax), nunvoiced = n;
+	for (long i = imin; i <= imax; i ++) {
+		Pitch_Frame frame = & pitch -> frame [i];
+		if (frame -> intensity >= silenceThreshold) {
+			for (long icand = 1; icand <= frame -> nCandidates; icand ++) {
+				Pitch_Candidate cand = & frame -> candidate [icand];
+				if (cand -> frequency > 0.0 && cand -> frequency < ceiling && cand -> strength >= voicingThreshold) {
+					nunvoiced --;
+					break;   // next frame
+				}
+			}
+		}
+	}
+	report -> numberOfFrames = n;
+	report -> numberOfUnvoicedFrames = nunvoiced;
+	report -> fractionOfLocallyUnvoicedFrames = n <= 0 ? NUMundefined : (double) nunvoiced / n;
+	n = PointProcess_getWindowPoints (pulses, tmin, tmax, & imin, & imax);
+	long numberOfVoiceBreaks = 0;
+	double durationOfVoiceBreaks = 0.0;
+	if (n > 1) {
+		bool previousPeriodVoiced = true;
+		for (long i = imin + 1; i < imax; i ++) {
+			double period = pulses -> t [i] - pulses -> t [i - 1];
+			if (period > pmax) {
+				durationOfVoiceBreaks += period;
+				if (previousPeriodVoiced) {
+					numberOfVoiceBreaks ++;
+					previousPeriodVoiced = false;
+				}
+			} else {
+				previousPeriodVoiced = true;
+			}
+		}
+	}
+	report -> numberOfVoiceBreaks = numberOfVoiceBreaks;
+	report -> durationOfVoiceBreaks = durationOfVoiceBreaks;
+	report -> degreeOfVoiceBreaks = durationOfVoiceBreaks / (tmax - tmin);
+	/*
+	 * Jitter.
+	 */
+	PointProcess_getJitter_multi (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor, report -> meanPeriod,
+		& report -> jitter_local, & report -> jitter_local_absolute, & report -> jitter_rap, & report -> jitter_ppq5, & report -> jitter_ddp);
+	/*
+	 * Shimmer.
+	 */
+	if (PointProcess_getWindowPoints (pulses, tmin, tmax, nullptr, nullptr) < 3) {
+		report -> shimmer_local = report -> shimmer_local_dB = report -> shimmer_apq3 =
+			report -> shimmer_apq5 = report -> shimmer_apq11 = report -> shimmer_dda = NUMundefined;
+	} else {
+		autoAmplitudeTier peaks = PointProcess_Sound_to_AmplitudeTier_period (pulses, sound, tmin, tmax, pmin, pmax, maximumPeriodFactor, peakCache);
+		report -> shimmer_local = AmplitudeTier_getShimmer_local (peaks.get(), pmin, pmax, maximumAmplitudeFactor);
+		report -> shimmer_local_dB = AmplitudeTier_getShimmer_local_dB (peaks.get(), pmin, pmax, maximumAmplitudeFactor);
+		report -> shimmer_apq3 = AmplitudeTier_getShimmer_apq3 (peaks.get(), pmin, pmax, maximumAmplitudeFactor);
+		report -> shimmer_apq5 = AmplitudeTier_getShimmer_apq5 (peaks.get(), pmin, pmax, maximumAmplitudeFactor);
+		report -> shimmer_apq11 = AmplitudeTier_getShimmer_apq11 (peaks.get(), pmin, pmax, maximumAmplitudeFactor);
+		report -> shimmer_dda = 3.0 * report -> shimmer_apq3;
+	}
+	/*
+	 * Harmonicity.
+	 */
+	report -> meanAutocorrelation = Pitch_getMeanStrength (pitch, tmin, tmax, Pitch_STRENGTH_UNIT_AUTOCORRELATION);
+	report -> meanNoiseToHarmonicsRatio = Pitch_getMeanStrength (pitch, tmin, tmax, Pitch_STRENGTH_UNIT_NOISE_HARMONICS_RATIO);
+	report -> meanHarmonicsToNoiseRatio = Pitch_getMeanStrength (pitch, tmin, tmax, Pitch_STRENGTH_UNIT_HARMONICS_NOISE_DB);
+}
+
+void Sound_Pitch_PointProcess_getVoiceReport (Sound sound, Pitch pitch, PointProcess pulses, double tmin, double tmax,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor, double silenceThreshold, double voicingThreshold,
+	struct structVoiceReport *report)
+{
+	try {
+		Sound_Pitch_PointProcess_getVoiceReport_cached (sound, pitch, pulses, tmin, tmax,
+			floor, ceiling, maximumPeriodFactor, maximumAmplitudeFactor, silenceThreshold, voicingThreshold, nullptr, report);
+	} catch (MelderError) {
+		Melder_throw (sound, U" & ", pitch, U" & ", pulses, U": voice report not computed.");
+	}
+}
+
 void Sound_Pitch_PointProcess_voiceReport (Sound sound, Pitch pitch, PointProcess pulses, double tmin, double tmax,
 	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor, double silenceThreshold, double voicingThreshold)
 {
 	try {
-		if (tmin >= tmax) tmin = sound -> xmin, tmax = sound -> xmax;
+		struct structVoiceReport report;
+		Sound_Pitch_PointProcess_getVoiceReport_cached (sound, pitch, pulses, tmin, tmax,
+			floor, ceiling, maximumPeriodFactor, maximumAmplitudeFactor, silenceThreshold, voicingThreshold, nullptr, & report);
+		tmin = report.tmin;
+		tmax = report.tmax;
 		/*
 		 * Time domain. Should be preceded by something like "Time range of SELECTION:" or so.
 		 */
 		MelderInfo_write (U"   From ", Melder_fixed (tmin, 6), U" to ", Melder_fixed (tmax, 6), U" seconds");
 		MelderInfo_writeLine (U" (duration: ", Melder_fixed (tmax - tmin, 6), U" seconds)");
-		/*
-		 * Pitch statistics.
-		 */
 		MelderInfo_writeLine (U"Pitch:");
-		MelderInfo_writeLine (U"   Median pitch: ", Melder_fixed (Pitch_getQuantile (pitch, tmin, tmax, 0.50, kPitch_unit_HERTZ), 3), U" Hz");
-		MelderInfo_writeLine (U"   Mean pitch: ", Melder_fixed (Pitch_getMean (pitch, tmin, tmax, kPitch_unit_HERTZ), 3), U" Hz");
-		MelderInfo_writeLine (U"   Standard deviation: ", Melder_fixed (Pitch_getStandardDeviation (pitch, tmin, tmax, kPitch_unit_HERTZ), 3), U" Hz");
-		MelderInfo_writeLine (U"   Minimum pitch: ", Melder_fixed (Pitch_getMinimum (pitch, tmin, tmax, kPitch_unit_HERTZ, 1), 3), U" Hz");
-		MelderInfo_writeLine (U"   Maximum pitch: ", Melder_fixed (Pitch_getMaximum (pitch, tmin, tmax, kPitch_unit_HERTZ, 1), 3), U" Hz");
-		/*
-		 * Pulses statistics.
-		 */
-		double pmin = 0.8 / ceiling, pmax = 1.25 / floor;
+		MelderInfo_writeLine (U"   Median pitch: ", Melder_fixed (report.medianPitch, 3), U" Hz");
+		MelderInfo_writeLine (U"   Mean pitch: ", Melder_fixed (report.meanPitch, 3), U" Hz");
+		MelderInfo_writeLine (U"   Standard deviation: ", Melder_fixed (report.stdevPitch, 3), U" Hz");
+		MelderInfo_writeLine (U"   Minimum pitch: ", Melder_fixed (report.minimumPitch, 3), U" Hz");
+		MelderInfo_writeLine (U"   Maximum pitch: ", Melder_fixed (report.maximumPitch, 3), U" Hz");
 		MelderInfo_writeLine (U"Pulses:");
-		MelderInfo_writeLine (U"   Number of pulses: ", PointProcess_getWindowPoints (pulses, tmin, tmax, nullptr, nullptr));
-		MelderInfo_writeLine (U"   Number of periods: ", PointProcess_getNumberOfPeriods (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor));
-		MelderInfo_writeLine (U"   Mean period: ", Melder_fixedExponent (PointProcess_getMeanPeriod (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), -3, 6), U" seconds");
-		MelderInfo_writeLine (U"   Standard deviation of period: ", Melder_fixedExponent (PointProcess_getStdevPeriod (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), -3, 6), U" seconds");
-		/*
-		 * Voicing.
-		 */
-		long imin, imax, n = Sampled_getWindowSamples (pitch, tmin, tmax, & imin, & imax), nunvoiced = n;
-		for (long i = imin; i <= imax; i ++) {
-			Pitch_Frame frame = & pitch -> frame [i];
-			if (frame -> intensity >= silenceThreshold) {
-				for (long icand = 1; icand <= frame -> nCandidates; icand ++) {
-					Pitch_Candidate cand = & frame -> candidate [icand];
-					if (cand -> frequency > 0.0 && cand -> frequency < ceiling && cand -> strength >= voicingThreshold) {
-						nunvoiced --;
-						break;   // next frame
-					}
-				}
-			}
-		}
+		MelderInfo_writeLine (U"   Number of pulses: ", report.numberOfPulses);
+		MelderInfo_writeLine (U"   Number of periods: ", report.numberOfPeriods);
+		MelderInfo_writeLine (U"   Mean period: ", Melder_fixedExponent (report.meanPeriod, -3, 6), U" seconds");
+		MelderInfo_writeLine (U"   Standard deviation of period: ", Melder_fixedExponent (report.stdevPeriod, -3, 6), U" seconds");
 		MelderInfo_writeLine (U"Voicing:");
-		MelderInfo_write (U"   Fraction of locally unvoiced frames: ", Melder_percent (n <= 0 ? NUMundefined : (double) nunvoiced / n, 3));
-		MelderInfo_writeLine (U"   (", nunvoiced, U" / ", n, U")");
-		n = PointProcess_getWindowPoints (pulses, tmin, tmax, & imin, & imax);
-		long numberOfVoiceBreaks = 0;
-		double durationOfVoiceBreaks = 0.0;
-		if (n > 1) {
-			bool previousPeriodVoiced = true;
-			for (long i = imin + 1; i < imax; i ++) {
-				double period = pulses -> t [i] - pulses -> t [i - 1];
-				if (period > pmax) {
-					durationOfVoiceBreaks += period;
-					if (previousPeriodVoiced) {
-						numberOfVoiceBreaks ++;
-						previousPeriodVoiced = false;
-					}
-				} else {
-					previousPeriodVoiced = true;
-				}
-			}
-		}
-		MelderInfo_writeLine (U"   Number of voice breaks: ", numberOfVoiceBreaks);
-		MelderInfo_write (U"   Degree of voice breaks: ", Melder_percent (durationOfVoiceBreaks / (tmax - tmin), 3));
-		MelderInfo_writeLine (U"   (", Melder_fixed (durationOfVoiceBreaks, 6), U" seconds / ", Melder_fixed (tmax - tmin, 6), U" seconds)");
-		/*
-		 * Jitter.
-		 */
-		double shimmerLocal, shimmerLocal_dB, apq3, apq5, apq11, dda;
+		MelderInfo_write (U"   Fraction of locally unvoiced frames: ", Melder_percent (report.fractionOfLocallyUnvoicedFrames, 3));
+		MelderInfo_writeLine (U"   (", report.numberOfUnvoicedFrames, U" / ", report.numberOfFrames, U")");
+		MelderInfo_writeLine (U"   Number of voice breaks: ", report.numberOfVoiceBreaks);
+		MelderInfo_write (U"   Degree of voice breaks: ", Melder_percent (report.degreeOfVoiceBreaks, 3));
+		MelderInfo_writeLine (U"   (", Melder_fixed (report.durationOfVoiceBreaks, 6), U" seconds / ", Melder_fixed (tmax - tmin, 6), U" seconds)");
 		MelderInfo_writeLine (U"Jitter:");
-		MelderInfo_writeLine (U"   Jitter (local): ", Melder_percent (PointProcess_getJitter_local (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), 3));
-		MelderInfo_writeLine (U"   Jitter (local, absolute): ", Melder_fixedExponent (PointProcess_getJitter_local_absolute (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), -6, 3), U" seconds");
-		MelderInfo_writeLine (U"   Jitter (rap): ", Melder_percent (PointProcess_getJitter_rap (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), 3));
-		MelderInfo_writeLine (U"   Jitter (ppq5): ", Melder_percent (PointProcess_getJitter_ppq5 (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), 3));
-		MelderInfo_writeLine (U"   Jitter (ddp): ", Melder_percent (PointProcess_getJitter_ddp (pulses, tmin, tmax, pmin, pmax, maximumPeriodFactor), 3));
-		/*
-		 * Shimmer.
-		 */
-		PointProcess_Sound_getShimmer_multi (pulses, sound, tmin, tmax, pmin, pmax, maximumPeriodFactor, maximumAmplitudeFactor,
-			& shimmerLocal, & shimmerLocal_dB, & apq3, & apq5, & apq11, & dda);
+		MelderInfo_writeLine (U"   Jitter (local): ", Melder_percent (report.jitter_local, 3));
+		MelderInfo_writeLine (U"   Jitter (local, absolute): ", Melder_fixedExponent (report.jitter_local_absolute, -6, 3), U" seconds");
+		MelderInfo_writeLine (U"   Jitter (rap): ", Melder_percent (report.jitter_rap, 3));
+		MelderInfo_writeLine (U"   Jitter (ppq5): ", Melder_percent (report.jitter_ppq5, 3));
+		MelderInfo_writeLine (U"   Jitter (ddp): ", Melder_percent (report.jitter_ddp, 3));
 		MelderInfo_writeLine (U"Shimmer:");
-		MelderInfo_writeLine (U"   Shimmer (local): ", Melder_percent (shimmerLocal, 3));
-		MelderInfo_writeLine (U"   Shimmer (local, dB): ", Melder_fixed (shimmerLocal_dB, 3), U" dB");
-		MelderInfo_writeLine (U"   Shimmer (apq3): ", Melder_percent (apq3, 3));
-		MelderInfo_writeLine (U"   Shimmer (apq5): ", Melder_percent (apq5, 3));
-		MelderInfo_writeLine (U"   Shimmer (apq11): ", Melder_percent (apq11, 3));
-		MelderInfo_writeLine (U"   Shimmer (dda): ", Melder_percent (dda, 3));
-		/*
-		 * Harmonicity.
-		 */
+		MelderInfo_writeLine (U"   Shimmer (local): ", Melder_percent (report.shimmer_local, 3));
+		MelderInfo_writeLine (U"   Shimmer (local, dB): ", Melder_fixed (report.shimmer_local_dB, 3), U" dB");
+		MelderInfo_writeLine (U"   Shimmer (apq3): ", Melder_percent (report.shimmer_apq3, 3));
+		MelderInfo_writeLine (U"   Shimmer (apq5): ", Melder_percent (report.shimmer_apq5, 3));
+		MelderInfo_writeLine (U"   Shimmer (apq11): ", Melder_percent (report.shimmer_apq11, 3));
+		MelderInfo_writeLine (U"   Shimmer (dda): ", Melder_percent (report.shimmer_dda, 3));
 		MelderInfo_writeLine (U"Harmonicity of the voiced parts only:");
-		MelderInfo_writeLine (U"   Mean autocorrelation: ", Melder_fixed (Pitch_getMeanStrength (pitch, tmin, tmax, Pitch_STRENGTH_UNIT_AUTOCORRELATION), 6));
-		MelderInfo_writeLine (U"   Mean noise-to-harmonics ratio: ", Melder_fixed (Pitch_getMeanStrength (pitch, tmin, tmax, Pitch_STRENGTH_UNIT_NOISE_HARMONICS_RATIO), 6));
-		MelderInfo_writeLine (U"   Mean harmonics-to-noise ratio: ", Melder_fixed (Pitch_getMeanStrength (pitch, tmin, tmax, Pitch_STRENGTH_UNIT_HARMONICS_NOISE_DB), 3), U" dB");
+		MelderInfo_writeLine (U"   Mean autocorrelation: ", Melder_fixed (report.meanAutocorrelation, 6));
+		MelderInfo_writeLine (U"   Mean noise-to-harmonics ratio: ", Melder_fixed (report.meanNoiseToHarmonicsRatio, 6));
+		MelderInfo_writeLine (U"   Mean harmonics-to-noise ratio: ", Melder_fixed (report.meanHarmonicsToNoiseRatio, 3), U" dB");
 	} catch (MelderError) {
 		Melder_throw (sound, U" & ", pitch, U" & ", pulses, U": voice report not computed.");
 	}
 }
 
+autoTable Sound_Pitch_PointProcess_to_Table_voiceReport (Sound sound, Pitch pitch, PointProcess pulses,
+	const double tmin [], const double tmax [], long numberOfWindows,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor,
+	double silenceThreshold, double voicingThreshold)
+{
+	try {
+		autoTable thee = Table_createWithColumnNames (numberOfWindows,
+			U"tmin tmax medianPitch meanPitch stdevPitch minimumPitch maximumPitch "
+			"numberOfPulses numberOfPeriods meanPeriod stdevPeriod "
+			"unvoicedFrames numberOfVoiceBreaks voiceBreaks "
+			"jitterLocal jitterLocalAbsolute jitterRap jitterPpq5 jitterDdp "
+			"shimmerLocal shimmerLocalDB shimmerApq3 shimmerApq5 shimmerApq11 shimmerDda "
+			"meanAutocorrelation meanNHR meanHNR");
+		autoNUMvector <double> peakCache (1, pulses -> nt);
+		for (long i = 1; i <= pulses -> nt; i ++) peakCache [i] = -1.0;   // not yet measured
+		autoMelderProgress progress (U"Voice report...");
+		for (long iwindow = 1; iwindow <= numberOfWindows; iwindow ++) {
+			Melder_progress ((double) (iwindow - 1) / numberOfWindows, U"Voice report: window ", iwindow, U" out of ", numberOfWindows);
+			struct structVoiceReport report;
+			Sound_Pitch_PointProcess_getVoiceReport_cached (sound, pitch, pulses, tmin [iwindow], tmax [iwindow],
+				floor, ceiling, maximumPeriodFactor, maximumAmplitudeFactor, silenceThreshold, voicingThreshold,
+				peakCache.peek(), & report);
+			const double values [] = { report.tmin, report.tmax,
+				report.medianPitch, report.meanPitch, report.stdevPitch, report.minimumPitch, report.maximumPitch,
+				(double) report.numberOfPulses, (double) report.numberOfPeriods, report.meanPeriod, report.stdevPeriod,
+				report.fractionOfLocallyUnvoicedFrames, (double) report.numberOfVoiceBreaks, report.degreeOfVoiceBreaks,
+				report.jitter_local, report.jitter_local_absolute, report.jitter_rap, report.jitter_ppq5, report.jitter_ddp,
+				report.shimmer_local, report.shimmer_local_dB, report.shimmer_apq3, report.shimmer_apq5, report.shimmer_apq11, report.shimmer_dda,
+				report.meanAutocorrelation, report.meanNoiseToHarmonicsRatio, report.meanHarmonicsToNoiseRatio };
+			Melder_assert (sizeof values / sizeof values [0] == (size_t) thy numberOfColumns);
+			for (long icol = 1; icol <= thy numberOfColumns; icol ++)
+				Table_setNumericValue (thee.get(), iwindow, icol, values [icol - 1]);
+		}
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (sound, U" & ", pitch, U" & ", pulses, U": voice report not converted to Table.");
+	}
+}
+
+autoTable Sound_Pitch_PointProcess_to_Table_voiceReport_slidingWindows (Sound sound, Pitch pitch, PointProcess pulses,
+	double windowLength, double timeStep,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor,
+	double silenceThreshold, double voicingThreshold)
+{
+	try {
+		if (windowLength <= 0.0 || timeStep <= 0.0)
+			Melder_throw (U"The window length and the time step should be positive.");
+		double duration = sound -> xmax - sound -> xmin;
+		if (windowLength > duration)
+			Melder_throw (U"The window length (", windowLength, U" seconds) should not be greater than the duration of the sound (", duration, U" seconds).");
+		long numberOfWindows = (long) ((duration - windowLength) / timeStep + 1e-9) + 1;   // not floor (), which is hidden by the pitch floor
+		autoNUMvector <double> tmin (1, numberOfWindows), tmax (1, numberOfWindows);
+		for (long iwindow = 1; iwindow <= numberOfWindows; iwindow ++) {
+			tmin [iwindow] = sound -> xmin + (iwindow - 1) * timeStep;
+			tmax [iwindow] = tmin [iwindow] + windowLength;
+		}
+		return Sound_Pitch_PointProcess_to_Table_voiceReport (sound, pitch, pulses, tmin.peek(), tmax.peek(), numberOfWindows,
+			floor, ceiling, maximumPeriodFactor, maximumAmplitudeFactor, silenceThreshold, voicingThreshold);
+	} catch (MelderError) {
+		Melder_throw (sound, U" & ", pitch, U" & ", pulses, U": voice report not converted to Table.");
+	}
+}
+
 /* End of file VoiceAnalysis.cpp */
@@ -19,6 +19,7 @@
 #include "Sound.h"
 #include "PointProcess.h"
 #include "Pitch.h"
+#include "Table.h"
 
 double PointProcess_getJitter_local (PointProcess me, double tmin, double tmax,
 	double minimumPeriod, double maximumPeriod, double maximumPeriodFactor);
@@ -47,9 +48,55 @@ void PointProcess_Sound_getShimmer_multi (PointProcess me, Sound thee, double tm
 	double minimumPeriod, double maximumPeriod, double maximumPeriodFactor, double maximumAmplitudeFactor,
 	double *local, double *local_dB, double *apq3, double *apq5, double *apq11, double *dda);
 
+/*
+	All the measures of a voice report in a single time window.
+	Jitter, shimmer and the fractions of unvoiced frames and voice breaks are fractions, not percentages.
+*/
+struct structVoiceReport {
+	double tmin, tmax;
+	double medianPitch, meanPitch, stdevPitch, minimumPitch, maximumPitch;   // Hz
+	long numberOfPulses, numberOfPeriods;
+	double meanPeriod, stdevPeriod;   // seconds
+	long numberOfFrames, numberOfUnvoicedFrames;
+	double fractionOfLocallyUnvoicedFrames;
+	long numberOfVoiceBreaks;
+	double durationOfVoiceBreaks, degreeOfVoiceBreaks;
+	double jitter_local, jitter_local_absolute, jitter_rap, jitter_ppq5, jitter_ddp;
+	double shimmer_local, shimmer_local_dB, shimmer_apq3, shimmer_apq5, shimmer_apq11, shimmer_dda;
+	double meanAutocorrelation, meanNoiseToHarmonicsRatio, meanHarmonicsToNoiseRatio;
+};
+
+void Sound_Pitch_PointProcess_getVoiceReport (Sound sound, Pitch pitch, PointProcess pulses,
+	double tmin, double tmax,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor,
+	double silenceThreshold, double voicingThreshold,
+	struct structVoiceReport *report);
+/*
+	One pass over the periods computes all jitter measures,
+	and the amplitudes of the periods are measured once for all shimmer measures.
+*/
+
 void Sound_Pitch_PointProcess_voiceReport (Sound sound, Pitch pitch, PointProcess pulses,
 	double tmin, double tmax,
 	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor,
 	double silenceThreshold, double voicingThreshold);
 
+autoTable Sound_Pitch_PointProcess_to_Table_voiceReport (Sound sound, Pitch pitch, PointProcess pulses,
+	const double tmin [], const double tmax [], long numberOfWindows,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor,
+	double silenceThreshold, double voicingThreshold);
+/*
+	One row per window, with the windows in tmin [1..numberOfWindows] and tmax [1..numberOfWindows];
+	the amplitude of a pulse is measured only once, however many windows contain it.
+*/
+
+autoTable Sound_Pitch_PointProcess_to_Table_voiceReport_slidingWindows (Sound sound, Pitch pitch, PointProcess pulses,
+	double windowLength, double timeStep,
+	double floor, double ceiling, double maximumPeriodFactor, double maximumAmplitudeFactor,
+	double silenceThreshold, double voicingThreshold);
+/*
+	Windows of the given length, starting at the start of the sound and every timeStep seconds thereafter,
+	as long as they fit within the sound.
+*/
+
 /* End of file VoiceAnalysis.h */
@@ -483,6 +483,20 @@ NORMAL (U"There are no commands in the menu for text styles (bold, italic), "
 	"but you can still use them in the Picture window: see @@text styles@.")
 MAN_END
 
+MAN_BEGIN (U"Function precision...", U"ppgb", 20261019)
+INTRO (U"A command in the File menu of the @@Picture window@.")
+NORMAL (U"It determines how the Picture window remembers drawings of sounds and other functions "
+	"that have many more samples than any printer or screen can show, such as a drawing of a long Sound.")
+ENTRY (U"Setting")
+TAG (U"##Keep all samples# (standard: off)")
+DEFINITION (U"if off, a function with more than two samples per 1/1200 inch is remembered as the minima and maxima "
+	"of stretches of 1/1200 inch. This keeps the picture small and quick to redraw and to save, "
+	"and on screens, printers and in PDF or EPS files it looks the same as the drawing of all the samples. "
+	"If on, all the samples are remembered, which you may want if you save the picture to a vector format "
+	"that will later be magnified very much.")
+NORMAL (U"The setting affects only drawings made after you change it, and is remembered across Praat sessions.")
+MAN_END
+
 MAN_BEGIN (U"Logarithmic marks left/right/top/bottom...", U"ppgb", 19970330)
 INTRO (U"Four of the commands in the #Margins menu of the @@Picture window@.")
 ENTRY (U"Purpose")
@@ -680,6 +694,7 @@ LIST_ITEM (U"\\bu @@Save as PNG file...")
 LIST_ITEM (U"\\bu @@Save as EPS file...")
 LIST_ITEM (U"\\bu @@Save as Windows metafile...@")
 LIST_ITEM (U"\\bu @@Read from Praat picture file...@, @@Save as Praat picture file...")
+LIST_ITEM (U"\\bu @@Function precision...")
 LIST_ITEM (U"\\bu @@PostScript settings...")
 LIST_ITEM (U"\\bu @@Print...")
 TAG (U"Edit menu")
@@ -2379,6 +2379,21 @@ CODE (U"#endfor")
 NORMAL (U"The stop value of the #for loop is evaluated on each turn. If the second expression "
 	"is already less than the first expression to begin with, the statements between #for and #endfor "
 	"are not executed even once.")
+ENTRY (U"Parallel \"for\" loops")
+TAG (U"#for %variable #from %expression__1_ #to %expression__2_ #in #parallel")
+DEFINITION (U"when Praat runs a script from the command line (see @@Scripting 6.9. Calling from the command line@), "
+	"the turns of the loop are distributed over as many worker processes as your computer has processors. "
+	"Each worker starts with its own copy of the object list and of all variables. "
+	"When all workers have finished, the objects that each turn of the loop left in the list "
+	"are added to the list of the script, in the order of the turns, and selected.")
+NORMAL (U"The following script computes the intensity contours of 1000 sound files on all processors:")
+CODE (U"#for i #to 1000 #in #parallel")
+CODE1 (U"sound = Read from file: \"sound\" + string\\$  (i) + \".wav\"")
+CODE1 (U"To Intensity: 100, 0, \"yes\"")
+CODE1 (U"removeObject: sound")
+CODE (U"#endfor")
+NORMAL (U"Changes that the statements in the loop make to variables are not visible after the loop. "
+	"In the Praat shell, and on Windows, a parallel loop runs as an ordinary #for loop.")
 ENTRY (U"\"Repeat\" loops")
 TAG (U"#until %expression")
 DEFINITION (U"the statements between the matching preceding #repeat and the #until line "
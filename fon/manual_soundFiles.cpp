@@ -340,6 +340,23 @@ LIST_ITEM (U"• @@Save as NIST file...@ (little-endian)")
 LIST_ITEM (U"• @@Save as FLAC file...@")
 MAN_END
 
+MAN_BEGIN (U"CompactSound", U"ppgb", 20161019)
+INTRO (U"One of the @@types of objects@ in Praat.")
+NORMAL (U"A CompactSound object holds a sound in memory like a @Sound object does, "
+	"but stores each sample in 2 bytes (16-bit integer) or 4 bytes (32-bit floating point) instead of 8. "
+	"Use it when you have to keep many long recordings in memory at the same time.")
+ENTRY (U"How to create a CompactSound object")
+NORMAL (U"Choose ##Read compact Sound from file...# from the @@Open menu@. "
+	"Sound files with at most 16 bits per sample are stored as 16-bit integers, which is exact; "
+	"other sound files are stored as 32-bit floating-point numbers. "
+	"You can also convert a Sound with ##To CompactSound...# from the #Convert menu.")
+ENTRY (U"What you can do with a CompactSound object")
+NORMAL (U"The commands ##To Pitch...#, ##To Intensity...# and ##To Spectrogram...# "
+	"read the samples as they are stored, and give the same results "
+	"as the corresponding commands for the Sound that ##To Sound# would create. "
+	"For all other analyses, convert the CompactSound to a Sound first.")
+MAN_END
+
 MAN_BEGIN (U"LongSound", U"ppgb", 20110131)
 INTRO (U"One of the @@types of objects@ in Praat. See the @@Sound files@ tutorial.")
 NORMAL (U"A LongSound object gives you the ability to view and label "
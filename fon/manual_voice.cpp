@@ -214,7 +214,7 @@ NORMAL (U"The difference between Praat's and MDVP's jitter measures is due to a
 	"For detailed illustrations, see @@Boersma (2009a)@.")
 MAN_END
 
-MAN_BEGIN (U"Voice 6. Automating voice analysis with a script", U"ppgb", 20140421)
+MAN_BEGIN (U"Voice 6. Automating voice analysis with a script", U"ppgb", 20161019)
 INTRO (U"In a Praat script you usually do not want to raise a Sound window. "
 	"Instead, you probably want to work with objects in the Objects window only. "
 	"This page tells you how to do that for voice analysis.")
@@ -254,7 +254,16 @@ CODE (U"voiceReport\\$  = Voice report: 0, 0, 75, 500, 1.3, 1.6, 0.03, 0.45")
 CODE (U"jitter = extractNumber (voiceReport\\$ , \"Jitter (local): \")")
 CODE (U"shimmer = extractNumber (voiceReport\\$ , \"Shimmer (local): \")")
 CODE (U"writeInfoLine: \"Jitter = \", percent\\$  (jitter, 3), \", shimmer = \", percent\\$  (shimmer, 3)")
-ENTRY (U"5. Disadvantage of automating voice analysis")
+ENTRY (U"5. Voice reports for many time windows")
+NORMAL (U"If you want to follow the voice parameters through time, select the Sound, the Pitch, and the PointProcess together "
+	"and choose ##To Table (voice report)...#. This computes the voice report for windows of a given length that start "
+	"at the start of the sound and then every %%time step% seconds, and puts all the numbers into a @Table with one row per window. "
+	"Jitter, shimmer, and the fractions of unvoiced frames and voice breaks are given as fractions, not as percentages. "
+	"The amplitude of every period is measured only once, even if the windows overlap, so this is much faster than asking for a voice report "
+	"in every window separately:")
+CODE (U"table = To Table (voice report): 1.0, 0.5, 75, 500, 1.3, 1.6, 0.03, 0.45")
+CODE (U"jitter = Get value: 3, \"jitterLocal\"")
+ENTRY (U"6. Disadvantage of automating voice analysis")
 NORMAL (U"In all the commands mentioned above, you have to guess the time range, "
 	"and you would usually supply \"0.0\" and \"0.0\", in which case "
 	"you will get the average jitter and shimmer for the whole sound. "
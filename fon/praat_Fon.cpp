@@ -5207,6 +5207,26 @@ DO
 	MelderInfo_close ();
 END2 }
 
+FORM (Sound_Pitch_PointProcess_to_Table_voiceReport, U"Sound & Pitch & PointProcess: To Table (voice report)", U"Voice") {
+	POSITIVE (U"Window length (s)", U"1.0")
+	POSITIVE (U"Time step (s)", U"0.5")
+	POSITIVE (U"left Pitch range (Hz)", U"75.0")
+	POSITIVE (U"right Pitch range (Hz)", U"600.0")
+	POSITIVE (U"Maximum period factor", U"1.3")
+	POSITIVE (U"Maximum amplitude factor", U"1.6")
+	REAL (U"Silence threshold", U"0.03")
+	REAL (U"Voicing threshold", U"0.45")
+	OK2
+DO
+	Sound sound = FIRST (Sound);
+	autoTable thee = Sound_Pitch_PointProcess_to_Table_voiceReport_slidingWindows (sound, FIRST (Pitch), FIRST (PointProcess),
+		GET_REAL (U"Window length"), GET_REAL (U"Time step"),
+		GET_REAL (U"left Pitch range"), GET_REAL (U"right Pitch range"),
+		GET_REAL (U"Maximum period factor"), GET_REAL (U"Maximum amplitude factor"),
+		GET_REAL (U"Silence threshold"), GET_REAL (U"Voicing threshold"));
+	praat_new (thee.move(), sound -> name, U"_voiceReport");
+END2 }
+
 /***** SOUND & POINTPROCESS & PITCHTIER & DURATIONTIER *****/
 
 FORM (Sound_Point_Pitch_Duration_to_Sound, U"To Sound", nullptr) {
@@ -6472,7 +6492,7 @@ void praat_uvafon_init () {
 		classTransition,
 		classRealPoint, classRealTier, classPitchTier, classIntensityTier, classDurationTier, classAmplitudeTier, classSpectrumTier,
 		classManipulation, classTextPoint, classTextInterval, classTextTier,
-		classIntervalTier, classTextGrid, classLongSound, classWordList, classSpellingChecker,
+		classIntervalTier, classTextGrid, classLongSound, classCompactSound, classWordList, classSpellingChecker,
 		classMovie, classCorpus, classPhoto,
 		nullptr);
 	Thing_recognizeClassByOtherName (classManipulation, U"Psola");
@@ -7251,6 +7271,7 @@ praat_addAction1 (classTransition, 0, U"Cast", nullptr, 0, nullptr);
 	praat_addAction2 (classPitch, 1, classPitchTier, 1, U"To Pitch", nullptr, 0, DO_Pitch_PitchTier_to_Pitch);
 	praat_addAction2 (classPitch, 1, classPointProcess, 1, U"To PitchTier", nullptr, 0, DO_Pitch_PointProcess_to_PitchTier);
 	praat_addAction3 (classPitch, 1, classPointProcess, 1, classSound, 1, U"Voice report...", nullptr, 0, DO_Sound_Pitch_PointProcess_voiceReport);
+	praat_addAction3 (classPitch, 1, classPointProcess, 1, classSound, 1, U"To Table (voice report)...", nullptr, 0, DO_Sound_Pitch_PointProcess_to_Table_voiceReport);
 	praat_addAction2 (classPitch, 1, classSound, 1, U"To PointProcess (cc)", nullptr, 0, DO_Sound_Pitch_to_PointProcess_cc);
 	praat_addAction2 (classPitch, 1, classSound, 1, U"To PointProcess (peaks)...", nullptr, 0, DO_Sound_Pitch_to_PointProcess_peaks);
 	praat_addAction2 (classPitch, 1, classSound, 1, U"To Manipulation", nullptr, 0, DO_Sound_Pitch_to_Manipulation);
@@ -18,6 +18,7 @@
 
 #include "praat.h"
 
+#include "CompactSound.h"
 #include "Ltas.h"
 #include "LongSound.h"
 #include "Manipulation.h"
@@ -43,6 +44,78 @@
 void praat_TimeFunction_query_init (ClassInfo klas);
 void praat_TimeFunction_modify_init (ClassInfo klas);
 
+/***** COMPACTSOUND *****/
+
+FORM_READ3 (READ1_CompactSound_readFromSoundFile, U"Read compact Sound from file", nullptr, true) {
+	autoCompactSound me = CompactSound_readFromSoundFile (file);
+	praat_new (me.move(), MelderFile_name (file));
+END2 }
+
+DIRECT3 (NEW_CompactSound_to_Sound) {
+	LOOP {
+		iam (CompactSound);
+		autoSound thee = CompactSound_to_Sound (me);
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
+FORM3 (NEW_CompactSound_to_Intensity, U"CompactSound: To Intensity", U"Sound: To Intensity...") {
+	POSITIVE (U"Minimum pitch (Hz)", U"100.0")
+	REAL (U"Time step (s)", U"0.0 (= auto)")
+	BOOLEAN (U"Subtract mean", true)
+	OK2
+DO
+	LOOP {
+		iam (CompactSound);
+		autoIntensity thee = CompactSound_to_Intensity (me,
+			GET_REAL (U"Minimum pitch"), GET_REAL (U"Time step"), GET_INTEGER (U"Subtract mean"));
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
+FORM3 (NEW_CompactSound_to_Pitch, U"CompactSound: To Pitch", U"Sound: To Pitch...") {
+	REAL (U"Time step (s)", U"0.0 (= auto)")
+	POSITIVE (U"Pitch floor (Hz)", U"75.0")
+	POSITIVE (U"Pitch ceiling (Hz)", U"600.0")
+	OK2
+DO
+	LOOP {
+		iam (CompactSound);
+		autoPitch thee = CompactSound_to_Pitch (me, GET_REAL (U"Time step"), GET_REAL (U"Pitch floor"), GET_REAL (U"Pitch ceiling"));
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
+FORM3 (NEW_CompactSound_to_Spectrogram, U"CompactSound: To Spectrogram", U"Sound: To Spectrogram...") {
+	POSITIVE (U"Window length (s)", U"0.005")
+	POSITIVE (U"Maximum frequency (Hz)", U"5000.0")
+	POSITIVE (U"Time step (s)", U"0.002")
+	POSITIVE (U"Frequency step (Hz)", U"20.0")
+	RADIO_ENUM (U"Window shape", kSound_to_Spectrogram_windowShape, DEFAULT)
+	OK2
+DO
+	LOOP {
+		iam (CompactSound);
+		autoSpectrogram thee = CompactSound_to_Spectrogram (me, GET_REAL (U"Window length"),
+			GET_REAL (U"Maximum frequency"), GET_REAL (U"Time step"),
+			GET_REAL (U"Frequency step"), GET_ENUM (kSound_to_Spectrogram_windowShape, U"Window shape"), 8.0, 8.0);
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
+FORM3 (NEW_Sound_to_CompactSound, U"Sound: To CompactSound", nullptr) {
+	OPTIONMENU (U"Sample storage", 1)
+		OPTION (U"16-bit integer")
+		OPTION (U"32-bit floating point")
+	OK2
+DO
+	LOOP {
+		iam (Sound);
+		autoCompactSound thee = Sound_to_CompactSound (me, GET_INTEGER (U"Sample storage"));   // 1 = CompactSound_INT16, 2 = CompactSound_FLOAT32
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
 /***** LONGSOUND *****/
 
 DIRECT3 (INFO_LongSound_concatenate) {
@@ -2493,6 +2566,7 @@ void praat_uvafon_Sound_init () {
 
 	praat_addMenuCommand (U"Objects", U"Open", U"-- read sound --", nullptr, 0, nullptr);
 	praat_addMenuCommand (U"Objects", U"Open", U"Open long sound file...", nullptr, 'L', READ1_LongSound_open);
+	praat_addMenuCommand (U"Objects", U"Open", U"Read compact Sound from file...", nullptr, 0, READ1_CompactSound_readFromSoundFile);
 	praat_addMenuCommand (U"Objects", U"Open", U"Read two Sounds from stereo file...", nullptr, praat_DEPRECATED_2010, READMANY_Sound_readSeparateChannelsFromSoundFile);
 	praat_addMenuCommand (U"Objects", U"Open", U"Read separate channels from sound file...", nullptr, 0, READMANY_Sound_readSeparateChannelsFromSoundFile);
 	praat_addMenuCommand (U"Objects", U"Open", U"Read from special sound file", nullptr, 0, nullptr);
@@ -2507,6 +2581,15 @@ void praat_uvafon_Sound_init () {
 	praat_addMenuCommand (U"Objects", U"Technical", U"Report sound server properties", U"Report system properties", 0, INFO_Praat_reportSoundServerProperties);
 #endif
 
+	praat_addAction1 (classCompactSound, 1, U"Query -", nullptr, 0, nullptr);
+		praat_TimeFunction_query_init (classCompactSound);
+	praat_addAction1 (classCompactSound, 0, U"Analyse -", nullptr, 0, nullptr);
+		praat_addAction1 (classCompactSound, 0, U"To Pitch...", nullptr, 1, NEW_CompactSound_to_Pitch);
+		praat_addAction1 (classCompactSound, 0, U"To Intensity...", nullptr, 1, NEW_CompactSound_to_Intensity);
+		praat_addAction1 (classCompactSound, 0, U"To Spectrogram...", nullptr, 1, NEW_CompactSound_to_Spectrogram);
+	praat_addAction1 (classCompactSound, 0, U"Convert -", nullptr, 0, nullptr);
+		praat_addAction1 (classCompactSound, 0, U"To Sound", nullptr, 1, NEW_CompactSound_to_Sound);
+
 	praat_addAction1 (classLongSound, 0, U"LongSound help", nullptr, 0, HELP_LongSound_help);
 	praat_addAction1 (classLongSound, 1, U"View", nullptr, praat_ATTRACTIVE, WINDOW_LongSound_view);
 	praat_addAction1 (classLongSound, 1,   U"Open", U"*View", praat_DEPRECATED_2011, WINDOW_LongSound_view);
@@ -2722,6 +2805,7 @@ void praat_uvafon_Sound_init () {
 	praat_addAction1 (classSound, 0, U"Convert -", nullptr, 0, nullptr);
 		praat_addAction1 (classSound, 0, U"Convert to mono", nullptr, 1, NEW_Sound_convertToMono);
 		praat_addAction1 (classSound, 0, U"Convert to stereo", nullptr, 1, NEW_Sound_convertToStereo);
+		praat_addAction1 (classSound, 0, U"To CompactSound...", nullptr, 1, NEW_Sound_to_CompactSound);
 		praat_addAction1 (classSound, 0, U"Extract all channels", nullptr, 1, NEWMANY_Sound_extractAllChannels);
 		praat_addAction1 (classSound, 0, U"Extract one channel...", nullptr, 1, NEW_Sound_extractChannel);
 		praat_addAction1 (classSound, 0,   U"Extract left channel", U"*Extract one channel...", praat_DEPTH_1 | praat_DEPRECATED_2010, NEW_Sound_extractLeftChannel);
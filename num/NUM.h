@@ -213,6 +213,25 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 
 long NUM_getTotalNumberOfArrays ();   // for debugging
 
+void NUMnativeBinary_startWriting (FILE *f);
+void NUMnativeBinary_startReading (FILE *f, bool byteSwapped);
+void NUMnativeBinary_stop (FILE *f);
+/*
+	Between start and stop, the NUMvector_writeBinary and NUMmatrix_writeBinary routines write to f,
+	and the NUMvector_readBinary and NUMmatrix_readBinary routines read from f,
+	the elements in the machine representation of their storage type, aligned at multiples of 8 bytes in the file.
+	When reading in the native byte order, the file is mapped into memory (copy-on-write) where possible,
+	and the r8, c8, c16, i1 and u1 arrays that are read point into the mapping instead of being copied;
+	the mapping is removed when the last of those arrays has been freed with NUMvector_free or NUMmatrix_free.
+	Other files are not affected, so a native file can be read while another one is being read or written.
+*/
+bool NUMnativeBinary_fileIsMapped (const char *path);
+/*
+	Whether arrays still point into a mapping of the file at path (in the file-system representation).
+	A mapped file must not be truncated or overwritten, because the arrays would change or become unreadable;
+	Melder_fopen therefore replaces such a file instead of overwriting it.
+*/
+
 /********** Special functions (NUM.cpp) **********/
 
 double NUMlnGamma (double x);
@@ -324,6 +343,12 @@ int NUMrotationsPointInPolygon
 /********** Random numbers (NUMrandom.cpp) **********/
 
 void NUMrandom_init ();   // automatically called by NUMinit ();
+void NUMrandom_initializeSafelyAndUnpredictably ();   // the same as NUMrandom_init ()
+void NUMrandom_initializeWithSeedUnsafelyButPredictably (uint64_t seed);
+	/*
+		Gives every thread's generator a state that depends only on the seed,
+		so that a script or a test can repeat a random computation exactly.
+	*/
 
 double NUMrandomFraction ();
 double NUMrandomFraction_mt (int threadNumber);
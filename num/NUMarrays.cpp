@@ -18,9 +18,93 @@
 
 #include "NUM.h"
 #include "melder.h"
+#include "MelderThread.h"
+#include <atomic>
+#if ! defined (_WIN32)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
 
 static long theTotalNumberOfArrays;
 
+/*
+	Arrays read from a native binary file may live in a copy-on-write mapping of that file.
+	A mapping stays alive as long as any array points into it;
+	NUMvector_free and NUMmatrix_free release such arrays instead of freeing them.
+	Arrays can be freed in any thread, so the table is guarded by a mutex,
+	which is not taken as long as there are no mappings (the usual case).
+*/
+#define NUM_MAXIMUM_NUMBER_OF_MAPPINGS  100
+static struct NUMmapping {
+	char *base;
+	int64 size;
+	int64 device, inode;   // the identity of the file, which Melder_fopen needs to protect the mapping
+	long numberOfArrays;   // plus one while the file is being read
+} theMappings [1 + NUM_MAXIMUM_NUMBER_OF_MAPPINGS];
+static std::atomic <long> theNumberOfMappings;
+MelderThread_MUTEX (theMappingMutex);
+static bool theMappingMutexInited;
+
+static void NUMmapping_initMutex () {
+	if (! theMappingMutexInited) { MelderThread_MUTEX_INIT (theMappingMutex); theMappingMutexInited = true; }
+}
+
+static NUMmapping * NUMmapping_find (const char *data) {   // call with the mutex locked
+	for (long i = 1; i <= theNumberOfMappings; i ++) {
+		NUMmapping *mapping = & theMappings [i];
+		if (data >= mapping -> base && data < mapping -> base + mapping -> size)
+			return mapping;
+	}
+	return nullptr;
+}
+
+static void NUMmapping_release (NUMmapping *mapping) {   // call with the mutex locked
+	if (-- mapping -> numberOfArrays > 0) return;
+	#if ! defined (_WIN32)
+		munmap (mapping -> base, mapping -> size);
+	#endif
+	* mapping = theMappings [theNumberOfMappings];
+	theNumberOfMappings -= 1;
+}
+
+static bool NUMmapping_releaseArray (const char *data) {
+	if (theNumberOfMappings == 0) return false;   // the usual case
+	MelderThread_LOCK (theMappingMutex);
+	NUMmapping *mapping = NUMmapping_find (data);
+	if (mapping) NUMmapping_release (mapping);
+	MelderThread_UNLOCK (theMappingMutex);
+	return !! mapping;
+}
+
+static bool NUMmapping_contains (const char *data) {
+	if (theNumberOfMappings == 0) return false;
+	MelderThread_LOCK (theMappingMutex);
+	bool found = !! NUMmapping_find (data);
+	MelderThread_UNLOCK (theMappingMutex);
+	return found;
+}
+
+bool NUMnativeBinary_fileIsMapped (const char *path) {
+	if (theNumberOfMappings == 0) return false;
+	#if defined (_WIN32)
+		(void) path;
+		return false;
+	#else
+		struct stat status;
+		if (stat (path, & status) != 0) return false;
+		MelderThread_LOCK (theMappingMutex);
+		bool found = false;
+		for (long i = 1; i <= theNumberOfMappings; i ++) {
+			if (theMappings [i]. device == (int64) status.st_dev && theMappings [i]. inode == (int64) status.st_ino) {
+				found = true;
+				break;
+			}
+		}
+		MelderThread_UNLOCK (theMappingMutex);
+		return found;
+	#endif
+}
+
 long NUM_getTotalNumberOfArrays () { return theTotalNumberOfArrays; }
 
 /*** Generic memory routines for vectors. ***/
@@ -45,7 +129,8 @@ void * NUMvector (long elementSize, long lo, long hi) {
 void NUMvector_free (long elementSize, void *v, long lo) {
 	if (! v) return;   // no error
 	char *dum = (char *) v + lo * elementSize;
-	Melder_free (dum);
+	if (! NUMmapping_releaseArray (dum))
+		Melder_free (dum);
 	theTotalNumberOfArrays -= 1;
 }
 
@@ -79,6 +164,9 @@ void NUMvector_append (long elementSize, void **v, long lo, long *hi) {
 		if (! *v) {
 			result = reinterpret_cast <char *> (NUMvector (elementSize, lo, lo));
 			*hi = lo;
+		} else if (NUMmapping_contains ((char *) *v + lo * elementSize)) {
+			NUMvector_insert (elementSize, v, lo, hi, *hi + 1);   // a mapped vector cannot be reallocated, so copy it
+			return;
 		} else {
 			long offset = lo * elementSize;
 			for (;;) {   // not very infinite: 99.999 % of the time once, 0.001 % twice
@@ -162,7 +250,8 @@ void * NUMmatrix (long elementSize, long row1, long row2, long col1, long col2)
 void NUMmatrix_free (long elementSize, void *m, long row1, long col1) {
 	if (! m) return;
 	char *dummy1 = ((char **) m) [row1] + col1 * elementSize;
-	Melder_free (dummy1);
+	if (! NUMmapping_releaseArray (dummy1))
+		Melder_free (dummy1);
 	char **dummy2 = (char **) m + row1;
 	Melder_free (dummy2);
 	theTotalNumberOfArrays -= 1;
@@ -198,7 +287,262 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 
 /*** Typed I/O routines for vectors and matrices. ***/
 
+/*** Native binary arrays. ***/
+
+/*
+	While a native binary file is being written or read, every array goes to and comes from the file
+	in the machine representation of its storage type (e.g. r4 as a float, i2 as a 16-bit integer),
+	starting at a file position that is a multiple of 8 bytes.
+	Several native files can be open at the same time, in the same thread or in different threads;
+	the arrays find their file in a table, which is guarded by a mutex.
+	If a file that is read has the byte order of the machine, it is mapped into memory (copy-on-write),
+	and arrays whose representation in memory equals that in the file (r8, c8, c16, i1, u1)
+	point straight into the mapping instead of being copied.
+*/
+#define NUM_MAXIMUM_NUMBER_OF_NATIVE_FILES  20
+struct NUMnativeFile {
+	FILE *file;
+	bool byteSwapped;
+	char *mappingBase;
+};
+static NUMnativeFile theNativeFiles [1 + NUM_MAXIMUM_NUMBER_OF_NATIVE_FILES];
+static std::atomic <long> theNumberOfNativeFiles;
+MelderThread_MUTEX (theNativeFileMutex);
+static bool theNativeFileMutexInited;
+
+static void NUMnativeBinary_start (FILE *f, bool byteSwapped, char *mappingBase) {
+	if (! theNativeFileMutexInited) { MelderThread_MUTEX_INIT (theNativeFileMutex); theNativeFileMutexInited = true; }
+	MelderThread_LOCK (theNativeFileMutex);
+	bool full = ( theNumberOfNativeFiles == NUM_MAXIMUM_NUMBER_OF_NATIVE_FILES );
+	if (! full) {
+		NUMnativeFile *native = & theNativeFiles [theNumberOfNativeFiles + 1];
+		native -> file = f;
+		native -> byteSwapped = byteSwapped;
+		native -> mappingBase = mappingBase;
+		theNumberOfNativeFiles += 1;
+	}
+	MelderThread_UNLOCK (theNativeFileMutex);
+	if (full) {
+		if (mappingBase) NUMmapping_releaseArray (mappingBase);
+		Melder_throw (U"Too many native binary files open at the same time.");
+	}
+}
+
+void NUMnativeBinary_startWriting (FILE *f) {
+	NUMnativeBinary_start (f, false, nullptr);
+}
+
+void NUMnativeBinary_startReading (FILE *f, bool byteSwapped) {
+	NUMmapping_initMutex ();
+	char *mappingBase = nullptr;
+	#if ! defined (_WIN32)
+		struct stat status;
+		if (! byteSwapped && fstat (fileno (f), & status) == 0 && status.st_size > 0) {
+			void *base = mmap (nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (f), 0);
+			if (base != MAP_FAILED) {
+				MelderThread_LOCK (theMappingMutex);
+				if (theNumberOfMappings < NUM_MAXIMUM_NUMBER_OF_MAPPINGS) {
+					NUMmapping *mapping = & theMappings [theNumberOfMappings + 1];
+					mapping -> base = (char *) base;
+					mapping -> size = status.st_size;
+					mapping -> device = (int64) status.st_dev;
+					mapping -> inode = (int64) status.st_ino;
+					mapping -> numberOfArrays = 1;   // the reader's own reference
+					theNumberOfMappings += 1;
+					mappingBase = (char *) base;
+				}
+				MelderThread_UNLOCK (theMappingMutex);
+				if (! mappingBase) munmap (base, status.st_size);   // too many mappings: read with fread instead
+			}
+		}
+	#endif
+	NUMnativeBinary_start (f, byteSwapped, mappingBase);
+}
+
+void NUMnativeBinary_stop (FILE *f) {
+	if (theNumberOfNativeFiles == 0) return;
+	char *mappingBase = nullptr;
+	MelderThread_LOCK (theNativeFileMutex);
+	for (long i = 1; i <= theNumberOfNativeFiles; i ++) {
+		if (theNativeFiles [i]. file == f) {
+			mappingBase = theNativeFiles [i]. mappingBase;
+			theNativeFiles [i] = theNativeFiles [theNumberOfNativeFiles];
+			theNumberOfNativeFiles -= 1;
+			break;
+		}
+	}
+	MelderThread_UNLOCK (theNativeFileMutex);
+	if (mappingBase) NUMmapping_releaseArray (mappingBase);   // the reader's own reference
+}
+
+/*
+	Whether f is a native binary file; if so, copy what we know about it into native.
+*/
+static bool NUMnativeBinary_find (FILE *f, NUMnativeFile *native) {
+	if (theNumberOfNativeFiles == 0) return false;   // the usual case
+	bool found = false;
+	MelderThread_LOCK (theNativeFileMutex);
+	for (long i = 1; i <= theNumberOfNativeFiles; i ++) {
+		if (theNativeFiles [i]. file == f) {
+			if (native) *native = theNativeFiles [i];
+			found = true;
+			break;
+		}
+	}
+	MelderThread_UNLOCK (theNativeFileMutex);
+	return found;
+}
+
+static void NUMnativeBinary_swap (void *x, int64 numberOfBytes, int unit) {
+	unsigned char *bytes = (unsigned char *) x;
+	for (int64 i = 0; i < numberOfBytes; i += unit) {
+		for (int j = 0; j < unit / 2; j ++) {
+			unsigned char save = bytes [i + j];
+			bytes [i + j] = bytes [i + unit - 1 - j];
+			bytes [i + unit - 1 - j] = save;
+		}
+	}
+}
+
+/*
+	Write or read n elements of type T, stored as S, after the padding.
+	The byte order of an element of S is swapped in units of swapUnit bytes (the size of a real or imaginary part).
+*/
+template <class T, class S>
+static void NUMrow_writeNative (const T *x, int64 n, FILE *f) {
+	static const char zeroes [8] = { 0 };
+	long padding = (8 - ftell (f) % 8) % 8;
+	if (padding > 0) fwrite (zeroes, 1, padding, f);
+	if (sizeof (T) == sizeof (S)) {
+		fwrite (x, sizeof (S), n, f);
+		return;
+	}
+	S buffer [1024];
+	for (int64 done = 0; done < n; done += 1024) {
+		int64 chunk = std::min (n - done, (int64) 1024);
+		for (int64 i = 0; i < chunk; i ++) buffer [i] = (S) x [done + i];
+		fwrite (buffer, sizeof (S), chunk, f);
+	}
+}
+
+template <class T, class S>
+static void NUMrow_readNative (T *x, int64 n, FILE *f, bool byteSwapped, int swapUnit) {
+	if (sizeof (T) == sizeof (S)) {
+		if ((int64) fread (x, sizeof (S), n, f) != n)
+			Melder_throw (U"Early end of file.");
+		if (byteSwapped) NUMnativeBinary_swap (x, n * (int64) sizeof (S), swapUnit);
+		return;
+	}
+	S buffer [1024];
+	for (int64 done = 0; done < n; done += 1024) {
+		int64 chunk = std::min (n - done, (int64) 1024);
+		if ((int64) fread (buffer, sizeof (S), chunk, f) != chunk)
+			Melder_throw (U"Early end of file.");
+		if (byteSwapped) NUMnativeBinary_swap (buffer, chunk * (int64) sizeof (S), swapUnit);
+		for (int64 i = 0; i < chunk; i ++) x [done + i] = (T) buffer [i];
+	}
+}
+
+/*
+	Skip the padding before a payload of n elements of S.
+	If the payload can be used where it lies in the mapping, skip the payload as well and return its address;
+	otherwise, return nullptr and leave the file positioned at the start of the payload.
+*/
+template <class T, class S>
+static T * NUMnativeBinary_map (int64 n, FILE *f, const NUMnativeFile *native) {
+	int64 position = ftell (f);
+	position += (8 - position % 8) % 8;
+	if (! native -> mappingBase || sizeof (T) != sizeof (S)) {
+		fseek (f, position, SEEK_SET);
+		return nullptr;
+	}
+	MelderThread_LOCK (theMappingMutex);
+	NUMmapping *mapping = NUMmapping_find (native -> mappingBase);
+	bool fits = ( position + n * (int64) sizeof (S) <= mapping -> size );
+	if (fits) mapping -> numberOfArrays += 1;
+	MelderThread_UNLOCK (theMappingMutex);
+	if (! fits)
+		Melder_throw (U"Early end of file.");
+	fseek (f, position + n * (int64) sizeof (S), SEEK_SET);
+	return (T *) (native -> mappingBase + position);
+}
+
+template <class T, class S>
+static T * NUMvector_readNative (long lo, long hi, FILE *f, const NUMnativeFile *native, int swapUnit) {
+	int64 n = hi - lo + 1;
+	T *mapped = NUMnativeBinary_map <T, S> (n, f, native);
+	if (mapped) {
+		theTotalNumberOfArrays += 1;
+		return mapped - lo;
+	}
+	T *result = NUMvector <T> (lo, hi);
+	try {
+		NUMrow_readNative <T, S> (result + lo, n, f, native -> byteSwapped, swapUnit);
+	} catch (MelderError) {
+		NUMvector_free (result, lo);
+		throw;
+	}
+	return result;
+}
+
+template <class T, class S>
+static T ** NUMmatrix_readNative (long row1, long row2, long col1, long col2, FILE *f, const NUMnativeFile *native, int swapUnit) {
+	int64 numberOfColumns = col2 - col1 + 1, n = (row2 - row1 + 1) * numberOfColumns;
+	T *mapped = NUMnativeBinary_map <T, S> (n, f, native);
+	T **result;
+	if (! mapped) {
+		result = NUMmatrix <T> (row1, row2, col1, col2);
+		try {
+			NUMrow_readNative <T, S> (result [row1] + col1, n, f, native -> byteSwapped, swapUnit);
+		} catch (MelderError) {
+			NUMmatrix_free (result, row1, col1);
+			throw;
+		}
+		return result;
+	}
+	try {
+		result = Melder_malloc (T *, row2 - row1 + 1);
+	} catch (MelderError) {
+		NUMmapping_releaseArray ((char *) mapped);
+		throw;
+	}
+	result -= row1;
+	result [row1] = mapped - col1;
+	for (long irow = row1 + 1; irow <= row2; irow ++) result [irow] = result [irow - 1] + numberOfColumns;
+	theTotalNumberOfArrays += 1;
+	return result;
+}
+
+/*
+	Binary reading and writing of n consecutive elements. This goes element by element,
+	except for real numbers, which abcio can convert a block at a time.
+*/
 #define FUNCTION(type,storage)  \
+	static void NUMrow_readBinary_##storage (type *x, long n, FILE *f) { \
+		for (long i = 0; i < n; i ++) \
+			x [i] = binget##storage (f); \
+	} \
+	static void NUMrow_writeBinary_##storage (const type *x, long n, FILE *f) { \
+		for (long i = 0; i < n; i ++) \
+			binput##storage (x [i], f); \
+	}
+
+FUNCTION (signed char, i1)
+FUNCTION (int, i2)
+FUNCTION (long, i4)
+FUNCTION (unsigned char, u1)
+FUNCTION (unsigned int, u2)
+FUNCTION (unsigned long, u4)
+FUNCTION (fcomplex, c8)
+FUNCTION (dcomplex, c16)
+#undef FUNCTION
+
+static void NUMrow_readBinary_r4 (double *x, long n, FILE *f) { bingetr4array (x, n, f); }
+static void NUMrow_writeBinary_r4 (const double *x, long n, FILE *f) { binputr4array (x, n, f); }
+static void NUMrow_readBinary_r8 (double *x, long n, FILE *f) { bingetr8array (x, n, f); }
+static void NUMrow_writeBinary_r8 (const double *x, long n, FILE *f) { binputr8array (x, n, f); }
+
+#define FUNCTION(type,storage,nativeType,swapUnit)  \
 	void NUMvector_writeText_##storage (const type *v, long lo, long hi, MelderFile file, const char32 *name) { \
 		texputintro (file, name, U" []: ", hi >= lo ? nullptr : U"(empty)", 0,0,0); \
 		for (long i = lo; i <= hi; i ++) \
@@ -207,8 +551,12 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		if (feof (file -> filePointer) || ferror (file -> filePointer)) Melder_throw (U"Write error."); \
 	} \
 	void NUMvector_writeBinary_##storage (const type *v, long lo, long hi, FILE *f) { \
-		for (long i = lo; i <= hi; i ++) \
-			binput##storage (v [i], f); \
+		if (hi >= lo) { \
+			if (NUMnativeBinary_find (f, nullptr)) \
+				NUMrow_writeNative <type, nativeType> (v + lo, hi - lo + 1, f); \
+			else \
+				NUMrow_writeBinary_##storage (v + lo, hi - lo + 1, f); \
+		} \
 		if (feof (f) || ferror (f)) Melder_throw (U"Write error."); \
 	} \
 	type * NUMvector_readText_##storage (long lo, long hi, MelderReadText text, const char *name) { \
@@ -231,10 +579,11 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 	type * NUMvector_readBinary_##storage (long lo, long hi, FILE *f) { \
 		type *result = nullptr; \
 		try { \
+			NUMnativeFile native; \
+			if (hi >= lo && NUMnativeBinary_find (f, & native)) \
+				return NUMvector_readNative <type, nativeType> (lo, hi, f, & native, swapUnit); \
 			result = NUMvector <type> (lo, hi); \
-			for (long i = lo; i <= hi; i ++) { \
-				result [i] = binget##storage (f); \
-			} \
+			NUMrow_readBinary_##storage (result + lo, hi - lo + 1, f); \
 			return result; \
 		} catch (MelderError) { \
 			NUMvector_free (result, lo); \
@@ -256,11 +605,11 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		if (feof (file -> filePointer) || ferror (file -> filePointer)) Melder_throw (U"Write error."); \
 	} \
 	void NUMmatrix_writeBinary_##storage (type **m, long row1, long row2, long col1, long col2, FILE *f) { \
-		if (row2 >= row1) { \
-			for (long irow = row1; irow <= row2; irow ++) { \
-				for (long icol = col1; icol <= col2; icol ++) \
-					binput##storage (m [irow] [icol], f); \
-			} \
+		if (row2 >= row1 && col2 >= col1 && NUMnativeBinary_find (f, nullptr)) { \
+			NUMrow_writeNative <type, nativeType> (m [row1] + col1, (int64) (row2 - row1 + 1) * (col2 - col1 + 1), f);   /* all cells at once */ \
+		} else if (row2 >= row1) { \
+			for (long irow = row1; irow <= row2; irow ++) \
+				NUMrow_writeBinary_##storage (m [irow] + col1, col2 - col1 + 1, f); \
 		} \
 		if (feof (f) || ferror (f)) Melder_throw (U"Write error."); \
 	} \
@@ -284,9 +633,12 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 	type ** NUMmatrix_readBinary_##storage (long row1, long row2, long col1, long col2, FILE *f) { \
 		type **result = nullptr; \
 		try { \
+			NUMnativeFile native; \
+			if (row2 >= row1 && col2 >= col1 && NUMnativeBinary_find (f, & native)) \
+				return NUMmatrix_readNative <type, nativeType> (row1, row2, col1, col2, f, & native, swapUnit); \
 			result = NUMmatrix <type> (row1, row2, col1, col2); \
-			for (long irow = row1; irow <= row2; irow ++) for (long icol = col1; icol <= col2; icol ++) \
-				result [irow] [icol] = binget##storage (f); \
+			for (long irow = row1; irow <= row2; irow ++) \
+				NUMrow_readBinary_##storage (result [irow] + col1, col2 - col1 + 1, f); \
 			return result; \
 		} catch (MelderError) { \
 			NUMmatrix_free (result, row1, col1); \
@@ -294,16 +646,16 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		} \
 	}
 
-FUNCTION (signed char, i1)
-FUNCTION (int, i2)
-FUNCTION (long, i4)
-FUNCTION (unsigned char, u1)
-FUNCTION (unsigned int, u2)
-FUNCTION (unsigned long, u4)
-FUNCTION (double, r4)
-FUNCTION (double, r8)
-FUNCTION (fcomplex, c8)
-FUNCTION (dcomplex, c16)
+FUNCTION (signed char, i1, int8_t, 1)
+FUNCTION (int, i2, int16_t, 2)
+FUNCTION (long, i4, int32_t, 4)
+FUNCTION (unsigned char, u1, uint8_t, 1)
+FUNCTION (unsigned int, u2, uint16_t, 2)
+FUNCTION (unsigned long, u4, uint32_t, 4)
+FUNCTION (double, r4, float, 4)
+FUNCTION (double, r8, double, 8)
+FUNCTION (fcomplex, c8, fcomplex, 4)
+FUNCTION (dcomplex, c16, dcomplex, 8)
 #undef FUNCTION
 
 /* End of file NUMarrays.cpp */
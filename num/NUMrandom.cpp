@@ -149,7 +149,7 @@ void NUMrandom_State :: init_by_array64 (uint64_t init_key [], unsigned int key_
 }
 
 static bool theInited = false;
-void NUMrandom_init () {
+void NUMrandom_initializeSafelyAndUnpredictably () {
 	for (int threadNumber = 0; threadNumber <= 16; threadNumber ++) {
 		const int numberOfKeys = 6;
 		uint64_t keys [numberOfKeys];
@@ -180,6 +180,23 @@ void NUMrandom_init () {
 		keys [5] = (uint64_t) (int64) gethostid ();   // unique between computers
 		#endif
 		states [threadNumber]. init_by_array64 (keys, numberOfKeys);
+		states [threadNumber]. secondAvailable = false;
+	}
+	theInited = true;
+}
+
+void NUMrandom_init () {
+	NUMrandom_initializeSafelyAndUnpredictably ();
+}
+
+void NUMrandom_initializeWithSeedUnsafelyButPredictably (uint64_t seed) {
+	for (int threadNumber = 0; threadNumber <= 16; threadNumber ++) {
+		const int numberOfKeys = 2;
+		uint64_t keys [numberOfKeys];
+		keys [0] = seed;
+		keys [1] = UINT64_C (7320321686725470078) + (uint64_t) threadNumber;   // unique between threads in the same process
+		states [threadNumber]. init_by_array64 (keys, numberOfKeys);
+		states [threadNumber]. secondAvailable = false;   // otherwise a Gaussian left over from before the seeding would come out first
 	}
 	theInited = true;
 }
@@ -167,6 +167,33 @@ void Data_writeToBinaryFile (Daata me, MelderFile file) {
 	}
 }
 
+void Data_writeToNativeBinaryFile (Daata me, MelderFile file) {
+	try {
+		if (! Data_canWriteBinary (me))
+			Melder_throw (U"Objects of class ", my classInfo -> className, U" cannot be written to a generic binary file.");
+		autoMelderFile mfile = MelderFile_create (file);
+		const uint32 byteOrderMark = 1;
+		if (fprintf (file -> filePointer, "ooNativeBinaryFile") < 0 || fwrite (& byteOrderMark, 4, 1, file -> filePointer) != 1)
+			Melder_throw (U"Cannot write first bytes of file.");
+		binputw1 (
+			my classInfo -> version > 0 ?
+				Melder_cat (my classInfo -> className, U" ", my classInfo -> version) :
+				my classInfo -> className,
+			file -> filePointer);
+		NUMnativeBinary_startWriting (file -> filePointer);
+		try {
+			Data_writeBinary (me, file -> filePointer);
+		} catch (MelderError) {
+			NUMnativeBinary_stop (file -> filePointer);
+			throw;
+		}
+		NUMnativeBinary_stop (file -> filePointer);
+		mfile.close ();
+	} catch (MelderError) {
+		Melder_throw (me, U": not written to native binary file ", file, U".");
+	}
+}
+
 bool Data_canReadText (Daata me) {
 	return my v_writable ();
 }
@@ -234,7 +261,18 @@ autoDaata Data_readFromBinaryFile (MelderFile file) {
 		char *end = strstr (line, "ooBinaryFile");
 		autoDaata me;
 		int formatVersion;
-		if (end) {
+		bool native = false, byteSwapped = false;
+		if (n >= 22 && strncmp (line, "ooNativeBinaryFile", 18) == 0) {
+			uint32 byteOrderMark;
+			memcpy (& byteOrderMark, line + 18, 4);
+			if (byteOrderMark != 1 && byteOrderMark != 0x01000000)
+				Melder_throw (U"Unknown byte order.");
+			native = true;
+			byteSwapped = ( byteOrderMark != 1 );
+			fseek (f, 22, 0);
+			autostring8 klas = bingets1 (f);
+			me = Thing_newFromClassName (Melder_peek8to32 (klas.peek()), & formatVersion).static_cast_move <structDaata> ();
+		} else if (end) {
 			fseek (f, strlen ("ooBinaryFile"), 0);
 			autostring8 klas = bingets1 (f);
 			me = Thing_newFromClassName (Melder_peek8to32 (klas.peek()), & formatVersion).static_cast_move <structDaata> ();
@@ -250,7 +288,18 @@ autoDaata Data_readFromBinaryFile (MelderFile file) {
 			fread (line, 1, end - line + strlen ("BinaryFile"), f);
 		}
 		MelderFile_getParentDir (file, & Data_directoryBeingRead);
-		Data_readBinary (me.get(), f, formatVersion);
+		if (native) {
+			NUMnativeBinary_startReading (f, byteSwapped);
+			try {
+				Data_readBinary (me.get(), f, formatVersion);
+			} catch (MelderError) {
+				NUMnativeBinary_stop (f);
+				throw;
+			}
+			NUMnativeBinary_stop (f);
+		} else {
+			Data_readBinary (me.get(), f, formatVersion);
+		}
 		file -> format = structMelderFile :: Format :: binary;
 		f.close (file);
 		return me;
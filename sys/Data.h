@@ -185,6 +185,18 @@ void Data_writeToBinaryFile (Daata me, MelderFile file);
 		The format of the file after this is the same as in Data_writeBinary.
 */
 
+void Data_writeToNativeBinaryFile (Daata me, MelderFile file);
+/*
+	Message:
+		"try to write yourself as binary data to a file, with arrays in the byte order of this machine".
+	Description:
+		The file starts with "ooNativeBinaryFile" and a four-byte byte-order mark,
+		followed by your class name and the same data as in Data_writeToBinaryFile,
+		except that vectors and matrices are written in the machine representation of their storage type,
+		aligned at multiples of 8 bytes, so that Data_readFromBinaryFile can read them a block at a time,
+		or map them into memory without reading them at all.
+*/
+
 bool Data_canReadText (Daata me);
 /*
 	Message:
@@ -18,6 +18,8 @@
 
 #include <ctype.h>
 #include <time.h>
+#include <memory>
+#include <vector>
 #if defined (UNIX)
 	#include <sys/stat.h>
 #endif
@@ -61,6 +63,7 @@ typedef struct structFormulaInstruction {
 
 static FormulaInstruction lexan, parse;
 static int ilabel, ilexan, iparse, numberOfInstructions, numberOfStringConstants;
+static bool theProgramRefersToObjects;
 
 enum { GEENSYMBOOL_,
 
@@ -89,7 +92,7 @@ enum { GEENSYMBOOL_,
 	#define HIGH_VALUE  HIGH_ATTRIBUTE
 
 	SELF_, SELFSTR_, OBJECT_, OBJECTSTR_, MATRIKS_, MATRIKSSTR_,
-	STOPWATCH_,
+	STOPWATCH_, RANDOM_INITIALIZE_SAFELY_AND_UNPREDICTABLY_,
 
 /* The following symbols can be followed by "-" only if they are a variable. */
 
@@ -103,7 +106,7 @@ enum { GEENSYMBOOL_,
 		SIGMOID_, SIGMOID_NUMVEC_, SOFTMAX_NUMVEC_,
 		INV_SIGMOID_, ERF_, ERFC_, GAUSS_P_, GAUSS_Q_, INV_GAUSS_Q_,
 		RANDOM_BERNOULLI_, RANDOM_BERNOULLI_NUMVEC_,
-		RANDOM_POISSON_,
+		RANDOM_POISSON_, RANDOM_INITIALIZE_WITH_SEED_UNSAFELY_BUT_PREDICTABLY_,
 		LOG2_, LN_, LOG10_, LN_GAMMA_,
 		HERTZ_TO_BARK_, BARK_TO_HERTZ_, PHON_TO_DIFFERENCE_LIMENS_, DIFFERENCE_LIMENS_TO_PHON_,
 		HERTZ_TO_MEL_, MEL_TO_HERTZ_, HERTZ_TO_SEMITONES_, SEMITONES_TO_HERTZ_,
@@ -216,7 +219,7 @@ static const char32 *Formula_instructionNames [1 + hoogsteSymbool] = { U"",
 	U"xmin", U"xmax", U"ymin", U"ymax", U"nx", U"ny", U"dx", U"dy",
 	U"row", U"col", U"nrow", U"ncol", U"row$", U"col$", U"y", U"x",
 	U"self", U"self$", U"object", U"object$", U"_matriks", U"_matriks$",
-	U"stopwatch",
+	U"stopwatch", U"random_initializeSafelyAndUnpredictably",
 	U"abs", U"round", U"floor", U"ceiling",
 	U"rectify", U"rectify#",
 	U"sqrt", U"sin", U"cos", U"tan", U"arcsin", U"arccos", U"arctan", U"sinc", U"sincpi",
@@ -225,7 +228,7 @@ static const char32 *Formula_instructionNames [1 + hoogsteSymbool] = { U"",
 	U"sigmoid", U"sigmoid#", U"softmax#",
 	U"invSigmoid", U"erf", U"erfc", U"gaussP", U"gaussQ", U"invGaussQ",
 	U"randomBernoulli", U"randomBernoulli#",
-	U"randomPoisson",
+	U"randomPoisson", U"random_initializeWithSeedUnsafelyButPredictably",
 	U"log2", U"ln", U"log10", U"lnGamma",
 	U"hertzToBark", U"barkToHertz", U"phonToDifferenceLimens", U"differenceLimensToPhon",
 	U"hertzToMel", U"melToHertz", U"hertzToSemitones", U"semitonesToHertz",
@@ -356,7 +359,7 @@ static void Formula_lexan () {
 	int itok = 0;   /* Position of most recent symbol in "lexan". */
 #define nieuwtok(s)  { lexan [++ itok]. symbol = s; lexan [itok]. position = ikar; }
 #define tokgetal(g)  lexan [itok]. content.number = (g)
-#define tokmatriks(m)  lexan [itok]. content.object = (m)
+#define tokmatriks(m)  { lexan [itok]. content.object = (m); theProgramRefersToObjects = true; }
 
 	static MelderString token { 0 };   /* String to collect a symbol name in. */
 #define stokaan MelderString_empty (& token);
@@ -1447,7 +1450,7 @@ static void parsePowerFactor () {
 		}
 	}
 
-	if (symbol == STOPWATCH_) {
+	if (symbol == STOPWATCH_ || symbol == RANDOM_INITIALIZE_SAFELY_AND_UNPREDICTABLY_) {
 		nieuwontleed (symbol);
 		return;
 	}
@@ -1909,7 +1912,83 @@ static void Formula_print (FormulaInstruction f) {
 	} while (symbol != END_);
 }
 
+/*
+	Compiled expressions of scripts.
+
+	A script typically compiles the same expression over and over again, e.g. in the body of a loop.
+	The compiled program of such an expression depends only on its text, on the procedure it is in
+	(for local variables), and on the variables that exist, which are resolved to pointers;
+	since variables are never deleted while an interpreter runs, these pointers stay valid
+	until the next Formula_forgetCompiledExpressions ().
+	Programs that refer to objects (e.g. Sound_hello [3]) or to a current object (e.g. "self") are not kept,
+	because they are bound to objects that can disappear between two runs of the same expression.
+*/
+struct structFormulaCompiledExpression {
+	std::vector <struct structFormulaInstruction> instructions;
+	std::vector <char32 *> strings;   // owned copies of the strings in the instructions
+
+	structFormulaCompiledExpression () = default;
+	structFormulaCompiledExpression (const structFormulaCompiledExpression&) = delete;
+	structFormulaCompiledExpression& operator= (const structFormulaCompiledExpression&) = delete;
+	~structFormulaCompiledExpression () {
+		for (size_t i = 0; i < strings. size (); i ++)
+			Melder_free (strings [i]);
+	}
+};
+#define Formula_MAXIMUM_NUMBER_OF_COMPILED_EXPRESSIONS  10000
+static std::unordered_map <Interpreter, std::unordered_map <std::u32string, std::unique_ptr <structFormulaCompiledExpression>>> theCompiledExpressions;
+
+void Formula_forgetCompiledExpressions (Interpreter interpreter) {
+	theCompiledExpressions. erase (interpreter);
+}
+
+static std::u32string Formula_compiledExpressionKey (int expressionType, const char32 *expression) {
+	std::u32string key (1, (char32) (U'0' + expressionType));
+	key += theInterpreter -> procedureNames [theInterpreter -> callDepth];
+	key += U'\n';   // cannot occur in a procedure name
+	key += expression;
+	return key;
+}
+
+static bool Formula_isCacheable (Interpreter interpreter, Daata data, bool optimize) {
+	return interpreter && ! data && ! optimize;
+}
+
+static void Formula_rememberCompiledExpression (int expressionType) {
+	if (theProgramRefersToObjects) return;
+	for (int i = 1; i <= numberOfInstructions; i ++)
+		if (parse [i]. symbol == CALL_) return;
+	auto& compiledExpressions = theCompiledExpressions [theInterpreter];
+	if (compiledExpressions. size () >= Formula_MAXIMUM_NUMBER_OF_COMPILED_EXPRESSIONS)
+		compiledExpressions. clear ();   // e.g. a loop with a substituted variable in its text
+	std::unique_ptr <structFormulaCompiledExpression> compiled (new structFormulaCompiledExpression);
+	compiled -> instructions. assign (& parse [1], & parse [numberOfInstructions + 1]);
+	for (size_t i = 0; i < compiled -> instructions. size (); i ++) {
+		struct structFormulaInstruction *instruction = & compiled -> instructions [i];
+		int symbol = instruction -> symbol;
+		if (symbol == STRING_ || symbol == VARIABLE_NAME_ || symbol == INDEXED_NUMERIC_VARIABLE_ || symbol == INDEXED_STRING_VARIABLE_) {
+			instruction -> content.string = Melder_dup (instruction -> content.string);   // the lexan copy is freed at the next compilation
+			compiled -> strings. push_back (instruction -> content.string);
+		}
+	}
+	compiledExpressions [Formula_compiledExpressionKey (expressionType, theExpression)] = std::move (compiled);
+}
+
+static bool Formula_recallCompiledExpression (int expressionType) {
+	auto compiledExpressions = theCompiledExpressions. find (theInterpreter);
+	if (compiledExpressions == theCompiledExpressions. end ()) return false;
+	auto it = compiledExpressions -> second. find (Formula_compiledExpressionKey (expressionType, theExpression));
+	if (it == compiledExpressions -> second. end ()) return false;
+	const std::vector <struct structFormulaInstruction>& instructions = it -> second -> instructions;
+	numberOfInstructions = (int) instructions. size ();
+	for (int i = 1; i <= numberOfInstructions; i ++)
+		parse [i] = instructions [i - 1];
+	parse [numberOfInstructions + 1]. symbol = END_;
+	return true;
+}
+
 void Formula_compile (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize) {
+	bool cacheable = Formula_isCacheable (interpreter, data, optimize);
 	theInterpreter = interpreter;
 	if (! theInterpreter) {
 		if (! theLocalInterpreter) {
@@ -1932,6 +2011,8 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 	}
 	if (! parse) parse = Melder_calloc_f (struct structFormulaInstruction, 3000);
 
+	if (cacheable && Formula_recallCompiledExpression (expressionType)) return;
+
 	/*
 		Clean up strings from the previous call.
 		These strings are in a union, that's why this cannot be done later, when a new string is created.
@@ -1947,6 +2028,7 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 		numberOfStringConstants = 0;
 	}
 
+	theProgramRefersToObjects = false;
 	Formula_lexan ();
 	if (Melder_debug == 17) Formula_print (lexan);
 	Formula_parseExpression ();
@@ -1959,6 +2041,7 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 	}
 	Formula_removeLabels ();
 	if (Melder_debug == 17) Formula_print (parse);
+	if (cacheable) Formula_rememberCompiledExpression (expressionType);
 }
 
 /*
@@ -2686,6 +2769,18 @@ static void do_tanh () {
 		Melder_throw (U"Cannot take the hyperbolic tangent (tanh) of ", Stackel_whichText (x), U".");
 	}
 }
+static void do_random_initializeWithSeedUnsafelyButPredictably () {
+	Stackel x = pop;
+	if (x->which == Stackel_NUMBER) {
+		if (x->number == NUMundefined)
+			Melder_throw (U"The seed of random_initializeWithSeedUnsafelyButPredictably should not be undefined.");
+		NUMrandom_initializeWithSeedUnsafelyButPredictably ((uint64_t) (int64) llround (x->number));
+		pushNumber (NUMundefined);
+	} else {
+		Melder_throw (U"The function random_initializeWithSeedUnsafelyButPredictably requires a numeric argument, not ",
+			Stackel_whichText (x), U".");
+	}
+}
 static void do_log2 () {
 	Stackel x = pop;
 	if (x->which == Stackel_NUMBER) {
@@ -5410,6 +5505,7 @@ void Formula_run (long row, long col, struct Formula_Result *result) {
 
 case NUMBER_: { pushNumber (f [programPointer]. content.number);
 } break; case STOPWATCH_: { pushNumber (Melder_stopwatch ());
+} break; case RANDOM_INITIALIZE_SAFELY_AND_UNPREDICTABLY_: { NUMrandom_initializeSafelyAndUnpredictably (); pushNumber (NUMundefined);
 } break; case ROW_: { pushNumber (row);
 } break; case COL_: { pushNumber (col);
 } break; case X_: {
@@ -5472,6 +5568,7 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 } break; case RANDOM_BERNOULLI_: { do_function_n_n (NUMrandomBernoulli_real);
 } break; case RANDOM_BERNOULLI_NUMVEC_: { do_functionvec_n_n (NUMrandomBernoulli_real);
 } break; case RANDOM_POISSON_: { do_function_n_n (NUMrandomPoisson);
+} break; case RANDOM_INITIALIZE_WITH_SEED_UNSAFELY_BUT_PREDICTABLY_: { do_random_initializeWithSeedUnsafelyButPredictably ();
 } break; case LOG2_: { do_log2 ();
 } break; case LN_: { do_ln ();
 } break; case LOG10_: { do_log10 ();
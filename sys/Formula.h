@@ -74,6 +74,11 @@ struct Formula_Result {
 Thing_declare (Interpreter);
 
 void Formula_compile (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize);
+void Formula_forgetCompiledExpressions (Interpreter interpreter);
+/*
+	Formula_compile remembers the compiled expressions of each interpreter (see Formula.cpp);
+	call this whenever the variables of the interpreter are deleted.
+*/
 
 void Formula_run (long row, long col, struct Formula_Result *result);
 
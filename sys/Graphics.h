@@ -105,6 +105,8 @@ Thing_define (Graphics, Thing) {
 	int percentSignIsItalic, numberSignIsBold, circumflexIsSuperscript, underscoreIsSubscript;
 	int dollarSignIsCode, atSignIsLink;
 	bool recording, duringXor;
+	bool recordsFunctionsInFullPrecision;
+		/* If false, functions with more samples than can be shown are recorded as min/max envelopes. */
 	long irecord, nrecord;
 	double *record;
 	Graphics_Viewport outerViewport;   // for Graphics_(un)setInner ()
@@ -357,6 +359,7 @@ void *Graphics_x_getGC (Graphics me);
 
 bool Graphics_startRecording (Graphics me);
 bool Graphics_stopRecording (Graphics me);
+void Graphics_setFunctionRecordingPrecision (Graphics me, bool fullPrecision);
 void Graphics_clearRecording (Graphics me);
 void Graphics_play (Graphics from, Graphics to);
 void Graphics_writeRecordings (Graphics me, FILE *f);
@@ -934,11 +934,46 @@ void Graphics_fillArea (Graphics me, long numberOfPoints, double *xWC, double *y
 		Melder_free (xyDC); \
 	}
 
+/*
+	A function with many more samples than any output device can show is recorded
+	as the alternating minima and maxima of stretches of 1/1200 inch, so that
+	the size of the recording does not grow with the number of samples;
+	on replay, this envelope is drawn by Graphics_function like the original samples.
+	Only if the Graphics has been told to record functions in full precision are all the samples recorded.
+*/
+#define FUNCTION_RECORDING_RESOLUTION  1200   /* dots per inch */
+
+template <typename TYPE>
+static void recordFunction (Graphics me, TYPE yWC [], long stride, long ix1, long ix2, double x1WC, double x2WC) {
+	long n = ix2 - ix1 + 1;
+	Melder_assert (n >= 2);   // Graphics_function has drawn nothing and returned before recording shorter functions
+	double widthInInches = fabs (wdx (x2WC) - wdx (x1WC)) / my resolution;
+	long numberOfBins = (long) ceil (widthInInches * FUNCTION_RECORDING_RESOLUTION) + 1;
+	if (my recordsFunctionsInFullPrecision || n <= 2 * numberOfBins) {
+		op (FUNCTION, 3 + n); put (n); put (x1WC); put (x2WC);
+		for (long i = ix1; i <= ix2; i ++) put (yWC [stride * i]);
+		return;
+	}
+	op (FUNCTION, 3 + 2 * numberOfBins); put (2 * numberOfBins); put (x1WC); put (x2WC);
+	for (long ibin = 0; ibin < numberOfBins; ibin ++) {
+		long jmin = ix1 + (long) ((double) ibin * n / numberOfBins), jmax = ix1 + (long) ((double) (ibin + 1) * n / numberOfBins);
+		if (jmin > ix2) jmin = ix2;
+		if (jmax > ix2) jmax = ix2;   // one point overlap, as on the screen
+		TYPE first = yWC [stride * jmin], last = yWC [stride * jmax], mini = first, maxi = first;
+		for (long j = jmin + 1; j <= jmax; j ++) {
+			TYPE value = yWC [stride * j];
+			if (value > maxi) maxi = value;
+			else if (value < mini) mini = value;
+		}
+		if (first < last) { put (mini); put (maxi); } else { put (maxi); put (mini); }
+	}
+}
+
 void Graphics_function (Graphics me, double yWC [], long ix1, long ix2, double x1WC, double x2WC) {
 	#define STAGGER(i)  (i)
 	MACRO_Graphics_function (double)
 	#undef STAGGER
-	if (my recording) { op (FUNCTION, 3 + n); put (n); put (x1WC); put (x2WC); mput (n, & yWC [ix1]) }
+	if (my recording) recordFunction (me, yWC, 1, ix1, ix2, x1WC, x2WC);
 }
 
 void Graphics_function16 (Graphics me, int16_t yWC [], int stagger, long ix1, long ix2, double x1WC, double x2WC) {
@@ -955,6 +990,7 @@ void Graphics_function16 (Graphics me, int16_t yWC [], int stagger, long ix1, lo
 		MACRO_Graphics_function (int16_t)
 		#undef STAGGER
 	}
+	if (my recording) recordFunction (me, yWC, stagger > 0 ? stagger + 1 : 1, ix1, ix2, x1WC, x2WC);
 }
 
 void Graphics_rectangle (Graphics me, double x1WC, double x2WC, double y1WC, double y2WC) {
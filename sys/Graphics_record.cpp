@@ -76,6 +76,10 @@ bool Graphics_stopRecording (Graphics me) {
 	return wasRecording;
 }
 
+void Graphics_setFunctionRecordingPrecision (Graphics me, bool fullPrecision) {
+	my recordsFunctionsInFullPrecision = fullPrecision;
+}
+
 void Graphics_clearRecording (Graphics me) {
 	if (my record) {
 		Melder_free (my record);
@@ -24,6 +24,11 @@ extern structMelderDir praatDir;
 #include "Formula.h"
 #include "praat_version.h"
 #include "UnicodeData.h"
+#include "MelderThread.h"
+#if defined (UNIX) || defined (macintosh)
+	#include <unistd.h>
+	#include <sys/wait.h>
+#endif
 
 #define Interpreter_WORD 1
 #define Interpreter_REAL 2
@@ -79,6 +84,7 @@ void structInterpreter :: v_destroy () noexcept {
 		}
 	//	delete (our variablesMap);
 	//}
+	Formula_forgetCompiledExpressions (this);
 	Interpreter_Parent :: v_destroy ();
 }
 
@@ -690,9 +696,138 @@ static void parameterToVariable (Interpreter me, int type, const char32 *in_para
 	}
 }
 
+static long findEndfor (char32 **lines, long numberOfLines, long forLineNumber) {
+	int depth = 0;
+	long iline;
+	for (iline = forLineNumber + 1; iline <= numberOfLines; iline ++) {
+		if (str32nequ (lines [iline], U"endfor", 6)) {
+			if (depth == 0) break;
+			else depth --;
+		} else if (str32nequ (lines [iline], U"for ", 4)) {
+			depth ++;
+		}
+	}
+	if (iline > numberOfLines) Melder_throw (U"Unmatched 'for'.");
+	return iline;
+}
+
+/*
+	A loop written as "for i from a to b in parallel" is distributed over worker processes.
+	Each worker is a fork of the running Praat, so it starts with a private copy of the object list
+	and of all the variables; worker k (base 1) performs iterations k, k + numberOfWorkers, ...,
+	and after each iteration saves the objects that the iteration has left in the list.
+	When all workers have finished, the parent reads these objects into its own list,
+	in the order of the iterations. Changes that the loop body makes to variables are not seen after the loop.
+	This is done only in batch mode and where fork() exists; elsewhere the loop is performed serially.
+*/
+static bool theIsParallelWorker = false;
+
+static bool parallelFor_isAvailable () {
+	#if defined (UNIX) || defined (macintosh)
+		return theCurrentPraatApplication -> batch && ! theIsParallelWorker;
+	#else
+		return false;
+	#endif
+}
+
+static void parallelFor_getIterationFile (MelderDir dir, long iteration, MelderFile file) {
+	MelderDir_getFile (dir, Melder_cat (iteration, U".Collection"), file);
+}
+
+/*
+	Saves the objects that the iteration has created, and removes them from the worker's list,
+	so that a worker does not accumulate the objects of all its iterations.
+*/
+static void parallelFor_saveIteration (MelderDir dir, long iteration, long lastIdBeforeIteration) {
+	{// scope
+		autoCollection collection = Collection_create ();
+		for (int iobject = 1; iobject <= theCurrentPraatObjects -> n; iobject ++)
+			if (theCurrentPraatObjects -> list [iobject]. id > lastIdBeforeIteration)
+				collection -> addItem_ref (theCurrentPraatObjects -> list [iobject]. object);
+		if (collection -> size == 0) return;
+		structMelderFile file { 0 };
+		parallelFor_getIterationFile (dir, iteration, & file);
+		Data_writeToBinaryFile (collection.get(), & file);
+	}
+	for (int iobject = theCurrentPraatObjects -> n; iobject >= 1; iobject --)
+		if (theCurrentPraatObjects -> list [iobject]. id > lastIdBeforeIteration)
+			praat_removeObject (iobject);
+}
+
+/*
+	The workers are processes, so their number is the number of processors that are online,
+	not the fixed thread count of MelderThread_getNumberOfProcessors ().
+*/
+static int parallelFor_getNumberOfProcessors () {
+	#if defined (UNIX) || defined (macintosh)
+		long numberOfProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+		if (numberOfProcessors >= 1) return (int) std::min (numberOfProcessors, 64L);
+	#endif
+	return MelderThread_getNumberOfProcessors ();
+}
+
+/*
+	Returns the worker number (1 or more) in a forked worker, and 0 in the parent after all workers have finished
+	and their objects have been read.
+*/
+static int parallelFor_run (long numberOfIterations, int numberOfWorkers, MelderDir dir) {
+	#if defined (UNIX) || defined (macintosh)
+		const char *tmp = getenv ("TMPDIR");
+		char dirPath8 [kMelder_MAXPATH+1];
+		snprintf (dirPath8, kMelder_MAXPATH+1, "%s/praat_parallel_XXXXXX", tmp && tmp [0] ? tmp : "/tmp");
+		if (! mkdtemp (dirPath8))
+			Melder_throw (U"Cannot create a temporary directory for a parallel loop.");
+		Melder_pathToDir (Melder_peek8to32 (dirPath8), dir);
+		fflush (stdout);
+		fflush (stderr);   // otherwise pending output would be written by every worker
+		pid_t workers [1 + 64];
+		int numberOfStartedWorkers = 0;
+		for (int iworker = 1; iworker <= numberOfWorkers; iworker ++) {
+			pid_t pid = fork ();
+			if (pid == 0) {
+				theIsParallelWorker = true;
+				return iworker;
+			}
+			if (pid < 0) break;
+			workers [++ numberOfStartedWorkers] = pid;
+		}
+		bool allWorkersSucceeded = ( numberOfStartedWorkers == numberOfWorkers );
+		for (int iworker = 1; iworker <= numberOfStartedWorkers; iworker ++) {
+			int status;
+			if (waitpid (workers [iworker], & status, 0) < 0 || ! WIFEXITED (status) || WEXITSTATUS (status) != 0)
+				allWorkersSucceeded = false;
+		}
+		try {
+			for (long iteration = 1; iteration <= numberOfIterations; iteration ++) {
+				structMelderFile file { 0 };
+				parallelFor_getIterationFile (dir, iteration, & file);
+				if (! MelderFile_exists (& file)) continue;
+				if (allWorkersSucceeded) {
+					autoDaata collection = Data_readFromFile (& file);
+					praat_new (collection.move(), U"");
+				}
+				MelderFile_delete (& file);
+			}
+			rmdir (dirPath8);
+		} catch (MelderError) {
+			rmdir (dirPath8);
+			throw;
+		}
+		if (! allWorkersSucceeded)
+			Melder_throw (numberOfStartedWorkers < numberOfWorkers ? U"Cannot start the workers of a parallel loop." :
+				U"A worker of a parallel loop did not complete.");
+		praat_updateSelection ();
+	#else
+		(void) numberOfIterations;
+		(void) numberOfWorkers;
+		(void) dir;
+	#endif
+	return 0;
+}
+
 void Interpreter_run (Interpreter me, char32 *text) {
 	autoNUMvector <char32 *> lines;   // not autostringvector, because the elements are reference copies
-	long lineNumber = 0;
+	long lineNumber = 0, parallelForLine = 0;
 	bool assertionFailed = false;
 	try {
 		static MelderString valueString { 0 };   // to divert the info
@@ -702,6 +837,9 @@ void Interpreter_run (Interpreter me, char32 *text) {
 		autoMelderString buffer;
 		long numberOfLines = 0, assertErrorLineNumber = 0, callStack [1 + Interpreter_MAX_CALL_DEPTH];
 		bool atLastLine = false, fromif = false, fromendfor = false;
+		long parallelIteration = 0, parallelLastIdBeforeIteration = 0;
+		int parallelNumberOfWorkers = 0;
+		structMelderDir parallelDir { { 0 } };
 		int callDepth = 0, chopped = 0, ipar;
 		my callDepth = 0;
 		/*
@@ -767,9 +905,20 @@ void Interpreter_run (Interpreter me, char32 *text) {
 				lines [lineNumber] = emptyLine;
 			}
 		}
+		/*
+		 * The targets of the jumps made by control-flow lines ("endfor", "else", "while", "@proc"...)
+		 * depend only on the text of the script, so each of them is searched for only once.
+		 * This cannot be done for lines whose text changes by variable substitution.
+		 */
+		autoNUMvector <bool> lineIsStatic (1, numberOfLines);
+		for (lineNumber = 1; lineNumber <= numberOfLines; lineNumber ++)
+			lineIsStatic [lineNumber] = ! str32chr (lines [lineNumber], U'\'');
+		autoNUMvector <long> jumpTargets (1, numberOfLines), alternativeJumpTargets (1, numberOfLines);   // 0 = not yet known
+		std::unordered_map <std::u32string, long> procedureLines;
 		/*
 		 * Copy the parameter names and argument values into the array of variables.
 		 */
+		Formula_forgetCompiledExpressions (me);
 		for (auto it = my variablesMap. begin(); it != my variablesMap. end(); it ++) {
 			InterpreterVariable var = it -> second;
 			forget (var);
@@ -851,7 +1000,7 @@ void Interpreter_run (Interpreter me, char32 *text) {
 				 * Substitute variables.
 				 */
 				trace (U"substituting variables");
-				for (char32 *p = & command2. string [0]; *p != U'\0'; p ++) if (*p == U'\'') {
+				if (! lineIsStatic [lineNumber]) for (char32 *p = & command2. string [0]; *p != U'\0'; p ++) if (*p == U'\'') {
 					/*
 					 * Found a left quote. Search for a matching right quote.
 					 */
@@ -929,7 +1078,8 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							p ++;   // step over parenthesis or colon
 						}
 						int64 callLength = str32len (callName);
-						long iline = 1;
+						auto knownProcedure = procedureLines. find (callName);
+						long iline = ( knownProcedure != procedureLines. end () ? knownProcedure -> second : 1 );
 						for (; iline <= numberOfLines; iline ++) {
 							char32 *linei = lines [iline], *q;
 							if (linei [0] != U'p' || linei [1] != U'r' || linei [2] != U'o' || linei [3] != U'c' ||
@@ -944,6 +1094,7 @@ void Interpreter_run (Interpreter me, char32 *text) {
 								/*
 								 * We found the procedure definition.
 								 */
+								procedureLines [callName] = iline;
 								if (++ my callDepth > Interpreter_MAX_CALL_DEPTH)
 									Melder_throw (U"Call depth greater than ", Interpreter_MAX_CALL_DEPTH, U".");
 								str32cpy (my procedureNames [my callDepth], callName);
@@ -1059,7 +1210,9 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							hasArguments = *p != U'\0';
 							*p = U'\0';   // close procedure name
 							callLength = str32len (callName);
-							for (iline = 1; iline <= numberOfLines; iline ++) {
+							auto knownProcedure = procedureLines. find (callName);
+							iline = ( knownProcedure != procedureLines. end () ? knownProcedure -> second : 1 );
+							for (; iline <= numberOfLines; iline ++) {
 								char32 *linei = lines [iline], *q;
 								int hasParameters;
 								if (linei [0] != U'p' || linei [1] != U'r' || linei [2] != U'o' || linei [3] != U'c' ||
@@ -1072,6 +1225,7 @@ void Interpreter_run (Interpreter me, char32 *text) {
 								if (q == procName) Melder_throw (U"Missing procedure name after 'procedure'.");
 								hasParameters = *q != U'\0';
 								if (q - procName == callLength && str32nequ (procName, callName, callLength)) {
+									procedureLines [callName] = iline;
 									if (hasArguments && ! hasParameters)
 										Melder_throw (U"Call to procedure \"", callName, U"\" has too many arguments.");
 									if (hasParameters && ! hasArguments)
@@ -1156,82 +1310,111 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							if (str32nequ (command2.string, U"endif", 5) && wordEnd (command2.string [5])) {
 								/* Ignore. */
 							} else if (str32nequ (command2.string, U"endfor", 6) && wordEnd (command2.string [6])) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									char32 *line = lines [iline];
-									if (line [0] == U'f' && line [1] == U'o' && line [2] == U'r' && line [3] == U' ') {
-										if (depth == 0) { lineNumber = iline - 1; fromendfor = true; break; }   // go before 'for'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"endfor", 6) && wordEnd (lines [iline] [6])) {
-										depth ++;
+								long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										char32 *line = lines [iline];
+										if (line [0] == U'f' && line [1] == U'o' && line [2] == U'r' && line [3] == U' ') {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"endfor", 6) && wordEnd (lines [iline] [6])) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'endfor'.");
+									jumpTargets [lineNumber] = iline;
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'endfor'.");
+								if (iline == parallelForLine)
+									parallelFor_saveIteration (& parallelDir, parallelIteration, parallelLastIdBeforeIteration);
+								lineNumber = iline - 1;   // go before 'for'
+								fromendfor = true;
 							} else if (str32nequ (command2.string, U"endwhile", 8) && wordEnd (command2.string [8])) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									if (str32nequ (lines [iline], U"while ", 6)) {
-										if (depth == 0) { lineNumber = iline - 1; break; }   // go before 'while'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
-										depth ++;
+								long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										if (str32nequ (lines [iline], U"while ", 6)) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'endwhile'.");
+									jumpTargets [lineNumber] = iline;
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'endwhile'.");
+								lineNumber = iline - 1;   // go before 'while'
 							} else if (str32nequ (command2.string, U"endproc", 7) && wordEnd (command2.string [7])) {
 								if (callDepth == 0) Melder_throw (U"Unmatched 'endproc'.");
 								lineNumber = callStack [callDepth --];
 								-- my callDepth;
 							} else fail = true;
 						} else if (str32nequ (command2.string, U"else", 4) && wordEnd (command2.string [4])) {
-							int depth = 0;
-							long iline;
-							for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-								if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-									if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
-									else depth --;
-								} else if (str32nequ (lines [iline], U"if ", 3)) {
-									depth ++;
+							long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+							if (iline == 0) {
+								int depth = 0;
+								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+									if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
+										if (depth == 0) break;
+										else depth --;
+									} else if (str32nequ (lines [iline], U"if ", 3)) {
+										depth ++;
+									}
 								}
+								if (iline > numberOfLines) Melder_throw (U"Unmatched 'else'.");
+								jumpTargets [lineNumber] = iline;
 							}
-							if (iline > numberOfLines) Melder_throw (U"Unmatched 'else'.");
+							lineNumber = iline;   // go after 'endif'
 						} else if (str32nequ (command2.string, U"elsif ", 6) || str32nequ (command2.string, U"elif ", 5)) {
 							if (fromif) {
 								double value;
 								fromif = false;
 								Interpreter_numericExpression (me, command2.string + 5, & value);
 								if (value == 0.0) {
+									long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+									if (iline == 0) {
+										int depth = 0;
+										for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+											if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
+												if (depth == 0) break;
+												else depth --;
+											} else if (str32nequ (lines [iline], U"else", 4) && wordEnd (lines [iline] [4])) {
+												if (depth == 0) break;
+											} else if ((str32nequ (lines [iline], U"elsif", 5) && wordEnd (lines [iline] [5]))
+												|| (str32nequ (lines [iline], U"elif", 4) && wordEnd (lines [iline] [4]))) {
+												if (depth == 0) break;
+											} else if (str32nequ (lines [iline], U"if ", 3)) {
+												depth ++;
+											}
+										}
+										if (iline > numberOfLines) Melder_throw (U"Unmatched 'elsif'.");
+										jumpTargets [lineNumber] = iline;
+									}
+									if ((str32nequ (lines [iline], U"elsif", 5) && wordEnd (lines [iline] [5]))
+										|| (str32nequ (lines [iline], U"elif", 4) && wordEnd (lines [iline] [4]))) {
+										lineNumber = iline - 1;   // go at next 'elsif' or 'elif'
+										fromif = true;
+									} else {
+										lineNumber = iline;   // go after 'endif' or 'else'
+									}
+								}
+							} else {
+								long iline = ( lineIsStatic [lineNumber] ? alternativeJumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
 									int depth = 0;
-									long iline;
 									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
 										if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-											if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
+											if (depth == 0) break;
 											else depth --;
-										} else if (str32nequ (lines [iline], U"else", 4) && wordEnd (lines [iline] [4])) {
-											if (depth == 0) { lineNumber = iline; break; }   // go after 'else'
-										} else if ((str32nequ (lines [iline], U"elsif", 5) && wordEnd (lines [iline] [5]))
-											|| (str32nequ (lines [iline], U"elif", 4) && wordEnd (lines [iline] [4]))) {
-											if (depth == 0) { lineNumber = iline - 1; fromif = true; break; }   // go at next 'elsif' or 'elif'
 										} else if (str32nequ (lines [iline], U"if ", 3)) {
 											depth ++;
 										}
 									}
-									if (iline > numberOfLines) Melder_throw (U"Unmatched 'elsif'.");
+									if (iline > numberOfLines) Melder_throw (U"'elsif' not matched with 'endif'.");
+									alternativeJumpTargets [lineNumber] = iline;
 								}
-							} else {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-										if (depth == 0) { lineNumber = iline; break; }   /* Go after 'endif'. */
-										else depth --;
-									} else if (str32nequ (lines [iline], U"if ", 3)) {
-										depth ++;
-									}
-								}
-								if (iline > numberOfLines) Melder_throw (U"'elsif' not matched with 'endif'.");
+								lineNumber = iline;   /* Go after 'endif'. */
 							}
 						} else if (str32nequ (command2.string, U"exit", 4)) {
 							if (command2.string [4] == U'\0') {
@@ -1256,11 +1439,26 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							while (*endvar == U' ') { *endvar = '\0'; endvar --; }
 							while (*varpos == U' ') varpos ++;
 							if (endvar - varpos < 0) Melder_throw (U"Missing loop variable after \'for\'.");
+							bool inParallel = false;
+							char32 *parallelpos = str32str (topos + 4, U" in parallel");
+							if (parallelpos) {
+								char32 *rest = parallelpos + 12;
+								while (Melder_isblank (*rest)) rest ++;
+								if (*rest == U'\0') {
+									*parallelpos = U'\0';
+									inParallel = true;
+								}
+							}
 							InterpreterVariable var = Interpreter_lookUpVariable (me, varpos);
 							Interpreter_numericExpression (me, topos + 4, & toValue);
 							if (fromendfor) {
 								fromendfor = false;
-								loopVariable = var -> numericValue + 1.0;
+								if (lineNumber == parallelForLine) {
+									loopVariable = var -> numericValue + parallelNumberOfWorkers;
+									parallelIteration += parallelNumberOfWorkers;
+								} else {
+									loopVariable = var -> numericValue + 1.0;
+								}
 							} else if (frompos) {
 								*topos = '\0';
 								Interpreter_numericExpression (me, frompos + 6, & loopVariable);
@@ -1269,18 +1467,35 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							}
 							var -> numericValue = loopVariable;
 							if (loopVariable > toValue) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endfor", 6)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endfor'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"for ", 4)) {
-										depth ++;
-									}
+								if (lineNumber == parallelForLine) {
+									fflush (stdout);
+									fflush (stderr);
+									_exit (0);   // this worker has done all its iterations
+								}
+								long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
+									iline = findEndfor (lines.peek(), numberOfLines, lineNumber);
+									jumpTargets [lineNumber] = iline;
+								}
+								lineNumber = iline;   // go after 'endfor'
+							} else if (inParallel && lineNumber != parallelForLine && toValue - loopVariable >= 1.0 && parallelFor_isAvailable ()) {
+								long numberOfIterations = (long) floor (toValue - loopVariable) + 1;
+								int numberOfWorkers = (int) std::min ((long) parallelFor_getNumberOfProcessors (), numberOfIterations);
+								if (numberOfWorkers > 64) numberOfWorkers = 64;
+								long endforLine = findEndfor (lines.peek(), numberOfLines, lineNumber);
+								int worker = parallelFor_run (numberOfIterations, numberOfWorkers, & parallelDir);
+								if (worker > 0) {
+									parallelForLine = lineNumber;
+									parallelNumberOfWorkers = numberOfWorkers;
+									parallelIteration = worker;
+									var -> numericValue = loopVariable + (worker - 1);
+								} else {
+									var -> numericValue = loopVariable + numberOfIterations;
+									lineNumber = endforLine;   // go after 'endfor'
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'for'.");
 							}
+							if (lineNumber == parallelForLine)
+								parallelLastIdBeforeIteration = theCurrentPraatObjects -> uniqueId;
 						} else if (str32nequ (command2.string, U"form ", 5)) {
 							long iline;
 							for (iline = lineNumber + 1; iline <= numberOfLines; iline ++)
@@ -1317,21 +1532,30 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 3, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endif", 5)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"else", 4)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'else'
-									} else if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
-										if (depth == 0) { lineNumber = iline - 1; fromif = true; break; }   // go at 'elsif'
-									} else if (str32nequ (lines [iline], U"if ", 3)) {
-										depth ++;
+								long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+										if (str32nequ (lines [iline], U"endif", 5)) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"else", 4)) {
+											if (depth == 0) break;
+										} else if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
+											if (depth == 0) break;
+										} else if (str32nequ (lines [iline], U"if ", 3)) {
+											depth ++;
+										}
 									}
+									if (iline > numberOfLines) Melder_throw (U"Unmatched 'if'.");
+									jumpTargets [lineNumber] = iline;
+								}
+								if (! str32nequ (lines [iline], U"endif", 5) && ! str32nequ (lines [iline], U"else", 4)) {
+									lineNumber = iline - 1;   // go at 'elsif'
+									fromif = true;
+								} else {
+									lineNumber = iline;   // go after 'endif' or 'else'
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'if'.");
 							} else if (value == NUMundefined) {
 								Melder_throw (U"The value of the 'if' condition is undefined.");
 							}
@@ -1362,14 +1586,15 @@ void Interpreter_run (Interpreter me, char32 *text) {
 						break;
 					case U'p':
 						if (str32nequ (command2.string, U"procedure ", 10)) {
-							long iline = lineNumber + 1;
-							for (; iline <= numberOfLines; iline ++) {
-								if (str32nequ (lines [iline], U"endproc", 7) && wordEnd (lines [iline] [7])) {
-									lineNumber = iline;
-									break;
-								}   // go after 'endproc'
+							long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+							if (iline == 0) {
+								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++)
+									if (str32nequ (lines [iline], U"endproc", 7) && wordEnd (lines [iline] [7]))
+										break;
+								if (iline > numberOfLines) Melder_throw (U"Unmatched 'proc'.");
+								jumpTargets [lineNumber] = iline;
 							}
-							if (iline > numberOfLines) Melder_throw (U"Unmatched 'proc'.");
+							lineNumber = iline;   // go after 'endproc'
 						} else if (str32nequ (command2.string, U"print", 5)) {
 							/*
 							 * Make sure that lines like "print = 3" will not be regarded as assignments.
@@ -1400,17 +1625,21 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 6, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									if (str32nequ (lines [iline], U"repeat", 6) && wordEnd (lines [iline] [6])) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'repeat'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"until ", 6)) {
-										depth ++;
+								long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										if (str32nequ (lines [iline], U"repeat", 6) && wordEnd (lines [iline] [6])) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"until ", 6)) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'until'.");
+									jumpTargets [lineNumber] = iline;
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'until'.");
+								lineNumber = iline;   // go after 'repeat'
 							}
 						} else fail = true;
 						break;
@@ -1422,17 +1651,21 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 6, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endwhile'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"while ", 6)) {
-										depth ++;
+								long iline = ( lineIsStatic [lineNumber] ? jumpTargets [lineNumber] : 0 );
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+										if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"while ", 6)) {
+											depth ++;
+										}
 									}
+									if (iline > numberOfLines) Melder_throw (U"Unmatched 'while'.");
+									jumpTargets [lineNumber] = iline;
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'while'.");
+								lineNumber = iline;   // go after 'endwhile'
 							}
 						} else fail = true;
 						break;
@@ -1940,6 +2173,10 @@ void Interpreter_run (Interpreter me, char32 *text) {
 				}
 			}
 		} // endfor lineNumber
+		if (parallelForLine != 0) {
+			fflush (stdout);
+			_exit (0);   // a worker of a parallel loop must not return into the rest of Praat
+		}
 		my numberOfLabels = 0;
 		my running = false;
 		my stopped = false;
@@ -1954,6 +2191,12 @@ void Interpreter_run (Interpreter me, char32 *text) {
 				Melder_appendError (U"Script line ", lineNumber, U" not performed or completed:\n« ", lines [lineNumber], U" »");
 			}
 		}
+		if (parallelForLine != 0) {   // a worker of a parallel loop must not return into the rest of Praat
+			bool exited = str32equ (Melder_getError (), U"\nScript exited.\n");
+			if (exited) Melder_clearError (); else Melder_flushError ();
+			fflush (stdout);
+			_exit (exited ? 0 : 1);
+		}
 		my numberOfLabels = 0;
 		my running = false;
 		my stopped = false;
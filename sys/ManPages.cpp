@@ -17,6 +17,8 @@
  */
 
 #include <ctype.h>
+#include <wctype.h>
+#include <algorithm>
 #include "ManPages.h"
 #include "longchar.h"
 #include "Interpreter.h"
@@ -122,6 +124,7 @@ static void readOnePage (ManPages me, MelderReadText text) {
 	 * Add the page early, so that lookUp can find it.
 	 */
 	my pages. addItem_move (autopage.move());
+	my pageNumberByTitle.emplace (title, my pages.size);
 
 	try {
 		page -> author = texgetw2 (text);
@@ -253,6 +256,8 @@ void ManPages_addPage (ManPages me, const char32 *title, const char32 *author, l
 	page -> author = author;
 	page -> date = date;
 	my pages. addItem_move (page.move());
+	my pageNumberByTitle.emplace (title, my pages.size);
+	my searchIndex.clear ();
 }
 
 static int pageCompare (const void *first, const void *second) {
@@ -268,48 +273,36 @@ static int pageCompare (const void *first, const void *second) {
 	return 0;   /* Should not occur. */
 }
 
-static long lookUp_unsorted (ManPages me, const char32 *title) {
-	long i;
+static long lookUp_exact (ManPages me, const char32 *title) {
+	auto it = my pageNumberByTitle.find (title);
+	return it == my pageNumberByTitle.end () ? 0 : it -> second;
+}
 
+static long lookUp_unsorted (ManPages me, const char32 *title) {
 	/*
 	 * First try to match an unaltered 'title' with the titles of the man pages.
 	 */
-	for (i = 1; i <= my pages.size; i ++) {
-		ManPage page = my pages.at [i];
-		if (str32equ (page -> title, title)) return i;
-	}
+	long i = lookUp_exact (me, title);
+	if (i) return i;
 
 	/*
 	 * If that fails, try to find the upper-case variant.
 	 */
 	if (islower (title [0])) {
-		char32 upperTitle [300];
-		Melder_sprint (upperTitle,300, title);
+		std::u32string upperTitle (title);
 		upperTitle [0] = toupper (upperTitle [0]);
-		for (i = 1; i <= my pages.size; i ++) {
-			ManPage page = my pages.at [i];
-			if (str32equ (page -> title, upperTitle)) return i;
-		}
+		return lookUp_exact (me, upperTitle.c_str());
 	}
 	return 0;
 }
 
 static long lookUp_sorted (ManPages me, const char32 *title) {
-	static autoManPage dummy;
-	ManPage *page;
-	if (! dummy) dummy = Thing_new (ManPage);
-	dummy -> title = title;
-	page = (ManPage *) bsearch (& dummy, & my pages.at [1], my pages.size, sizeof (ManPage), pageCompare);   // noexcept
-	dummy -> title = nullptr;   // undangle
-	if (page) return (page - & my pages.at [1]) + 1;
+	long i = lookUp_exact (me, title);
+	if (i) return i;
 	if (islower (title [0]) || isupper (title [0])) {
-		char32 caseSwitchedTitle [300];
-		Melder_sprint (caseSwitchedTitle,300, title);
+		std::u32string caseSwitchedTitle (title);
 		caseSwitchedTitle [0] = islower (title [0]) ? toupper (caseSwitchedTitle [0]) : tolower (caseSwitchedTitle [0]);
-		dummy -> title = caseSwitchedTitle;
-		page = (ManPage *) bsearch (& dummy, & my pages.at [1], my pages.size, sizeof (ManPage), pageCompare);   // noexcept
-		dummy -> title = nullptr;   // undangle
-		if (page) return (page - & my pages.at [1]) + 1;
+		return lookUp_exact (me, caseSwitchedTitle.c_str());
 	}
 	return 0;
 }
@@ -319,6 +312,9 @@ static void grind (ManPages me) {
 	long *grandLinksHither, *grandLinksThither;
 
 	qsort (& my pages.at [1], my pages.size, sizeof (ManPage), pageCompare);
+	my pageNumberByTitle.clear ();
+	for (ipage = 1; ipage <= my pages.size; ipage ++)
+		my pageNumberByTitle.emplace (my pages.at [ipage] -> title, ipage);   // the first one wins
 
 	/*
 	 * First pass: count and check links: fill in nlinksHither and nlinksThither.
@@ -422,11 +418,7 @@ long ManPages_lookUp (ManPages me, const char32 *title) {
 
 static long ManPages_lookUp_caseSensitive (ManPages me, const char32 *title) {
 	if (! my ground) grind (me);
-	for (long i = 1; i <= my pages.size; i ++) {
-		ManPage page = my pages.at [i];
-		if (str32equ (page -> title, title)) return i;
-	}
-	return 0;
+	return lookUp_exact (me, title);
 }
 
 const char32 **ManPages_getTitles (ManPages me, long *numberOfTitles) {
@@ -442,6 +434,201 @@ const char32 **ManPages_getTitles (ManPages me, long *numberOfTitles) {
 	return my titles;
 }
 
+/********** SEARCHING **********/
+
+static inline char32 searchCharacter (char32 c) {
+	return (char32) towlower ((int) c);
+}
+static inline bool isSearchWordCharacter (char32 lowerCaseCharacter) {
+	return iswalnum ((int) lowerCaseCharacter);
+}
+
+static void addToSearchIndex (ManPages me, long ipage, int paragraph, const char32 *text) {
+	std::u32string word;
+	for (const char32 *p = text; ; p ++) {
+		char32 c = searchCharacter (*p);
+		if (*p != U'\0' && isSearchWordCharacter (c)) {
+			word += c;
+			continue;
+		}
+		if (! word.empty ()) {
+			std::vector <ManPages_Posting> & postings = my searchIndex [word];
+			if (! postings.empty () && postings.back (). page == ipage && postings.back (). paragraph == paragraph)
+				postings.back (). count ++;
+			else
+				postings.push_back ({ ipage, paragraph, 1 });
+			word.clear ();
+		}
+		if (*p == U'\0') break;
+	}
+}
+
+static void buildSearchIndex (ManPages me) {
+	my searchIndex.clear ();
+	for (long ipage = 1; ipage <= my pages.size; ipage ++) {
+		ManPage page = my pages.at [ipage];
+		addToSearchIndex (me, ipage, 0, page -> title);
+		for (int ipar = 0; page -> paragraphs [ipar]. type; ipar ++)
+			if (page -> paragraphs [ipar]. text)
+				addToSearchIndex (me, ipage, ipar + 1, page -> paragraphs [ipar]. text);
+	}
+}
+
+static double searchToken (ManPages me, long ipage, const char32 *token) {
+	double goodness = 0.0;
+	ManPage page = my pages.at [ipage];
+	struct structManPage_Paragraph *par = & page -> paragraphs [0];
+	if (! token [0]) return 1.0;
+	/*
+	 * Try to find a match in the title, case insensitively.
+	 */
+	static MelderString buffer { 0 };
+	MelderString_copy (& buffer, page -> title);
+	for (char32 *p = & buffer.string [0]; *p != U'\0'; p ++) *p = searchCharacter (*p);
+	if (str32str (buffer.string, token)) {
+		goodness += 300.0;   // lots of points for a match in the title!
+		if (str32equ (buffer.string, token))
+			goodness += 10000.0;   // even more points for an exact match!
+	}
+	/*
+	 * Try to find a match in the paragraphs, case-insensitively.
+	 */
+	while (par -> type) {
+		if (par -> text) {
+			const char32 *ptoken;
+			MelderString_copy (& buffer, par -> text);
+			for (char32 *p = & buffer.string [0]; *p != '\0'; p ++) *p = searchCharacter (*p);
+			ptoken = str32str (buffer.string, token);
+			if (ptoken) {
+				goodness += 10.0;   // ten points for every paragraph with a match!
+				if (str32str (ptoken + str32len (token), token)) {
+					goodness += 1.0;   // one point for every second occurrence in a paragraph!
+				}
+			}
+		}
+		par ++;
+	}
+	return goodness;
+}
+
+static std::vector <std::pair <long, double>> searchIndexedToken (ManPages me, const std::u32string & token) {
+	/*
+	 * A token that consists of word characters only can occur only inside words,
+	 * so its occurrences in a title or paragraph are its occurrences in the words of that title or paragraph.
+	 */
+	std::vector <ManPages_Posting> hits;
+	for (const auto & entry : my searchIndex) {
+		const std::u32string & word = entry.first;
+		int numberOfOccurrences = 0;
+		for (size_t pos = word.find (token); pos != std::u32string::npos; pos = word.find (token, pos + token.length ()))
+			numberOfOccurrences ++;
+		if (numberOfOccurrences == 0) continue;
+		for (const ManPages_Posting & posting : entry.second)
+			hits.push_back ({ posting.page, posting.paragraph, posting.count * numberOfOccurrences });
+	}
+	std::sort (hits.begin (), hits.end (), [] (const ManPages_Posting & a, const ManPages_Posting & b) {
+		return a.page < b.page || (a.page == b.page && a.paragraph < b.paragraph);
+	});
+	/*
+	 * Score the pages as searchToken () would.
+	 */
+	std::vector <std::pair <long, double>> goodnesses;   // in order of page number
+	for (size_t ihit = 0; ihit < hits.size (); ) {
+		long ipage = hits [ihit]. page;
+		double goodness = 0.0;
+		while (ihit < hits.size () && hits [ihit]. page == ipage) {
+			int paragraph = hits [ihit]. paragraph;
+			long count = 0;
+			while (ihit < hits.size () && hits [ihit]. page == ipage && hits [ihit]. paragraph == paragraph)
+				count += hits [ihit ++]. count;
+			if (paragraph == 0) {
+				goodness += 300.0;
+				const char32 *title = my pages.at [ipage] -> title;
+				if (str32len (title) == token.length ()) {
+					bool exact = true;
+					for (size_t i = 0; i < token.length (); i ++)
+						if (searchCharacter (title [i]) != token [i]) { exact = false; break; }
+					if (exact) goodness += 10000.0;
+				}
+			} else {
+				goodness += 10.0;
+				if (count > 1) goodness += 1.0;
+			}
+		}
+		goodnesses.push_back ({ ipage, goodness });
+	}
+	return goodnesses;
+}
+
+long ManPages_search (ManPages me, const char32 *query, long maximumNumberOfMatches, long *matches) {
+	if (! my ground) grind (me);
+	if (my searchIndex.empty ()) buildSearchIndex (me);
+	/*
+	 * Split the query at spaces into lower-case tokens.
+	 * Only tokens that consist of word characters can be looked up in the index.
+	 */
+	std::vector <std::u32string> indexedTokens, otherTokens;
+	std::u32string token;
+	for (const char32 *p = query; ; p ++) {
+		if (*p == U'\0' || *p == U' ' || *p == U'\n') {
+			if (! token.empty ()) {
+				bool indexed = true;
+				for (char32 c : token)
+					if (! isSearchWordCharacter (c)) { indexed = false; break; }
+				( indexed ? indexedTokens : otherTokens ). push_back (token);
+				token.clear ();
+			}
+			if (*p == U'\0') break;
+		} else {
+			token += searchCharacter (*p);
+		}
+	}
+	/*
+	 * The goodness of a page is the product of the goodnesses of all tokens,
+	 * so only the pages that contain the first indexed token are candidates.
+	 */
+	std::vector <std::pair <long, double>> candidates;   // in order of page number
+	if (indexedTokens.empty ()) {
+		for (long ipage = 1; ipage <= my pages.size; ipage ++)
+			candidates.push_back ({ ipage, 1.0 });
+	} else {
+		candidates = searchIndexedToken (me, indexedTokens [0]);
+		for (size_t itoken = 1; itoken < indexedTokens.size () && ! candidates.empty (); itoken ++) {
+			std::vector <std::pair <long, double>> goodnesses = searchIndexedToken (me, indexedTokens [itoken]);
+			size_t numberOfCandidates = 0, igoodness = 0;
+			for (size_t icandidate = 0; icandidate < candidates.size (); icandidate ++) {
+				long ipage = candidates [icandidate]. first;
+				while (igoodness < goodnesses.size () && goodnesses [igoodness]. first < ipage) igoodness ++;
+				if (igoodness < goodnesses.size () && goodnesses [igoodness]. first == ipage)
+					candidates [numberOfCandidates ++] = { ipage, candidates [icandidate]. second * goodnesses [igoodness]. second };
+			}
+			candidates.resize (numberOfCandidates);
+		}
+	}
+	for (const std::u32string & otherToken : otherTokens)
+		for (auto & candidate : candidates)
+			if (candidate.second > 0.0)
+				candidate.second *= searchToken (me, candidate.first, otherToken.c_str());
+	/*
+	 * Find the best matches; of equally good pages, the first one wins.
+	 */
+	long numberOfMatches = 0;
+	while (numberOfMatches < maximumNumberOfMatches) {
+		double max = 0.0;
+		auto best = candidates.end ();
+		for (auto candidate = candidates.begin (); candidate != candidates.end (); candidate ++) {
+			if (candidate -> second > max) {
+				max = candidate -> second;
+				best = candidate;
+			}
+		}
+		if (best == candidates.end ()) break;
+		matches [++ numberOfMatches] = best -> first;
+		best -> second = 0.0;   // skip next time
+	}
+	return numberOfMatches;
+}
+
 static struct stylesInfo {
 	const char32 *htmlIn, *htmlOut;
 } stylesInfo [] = {
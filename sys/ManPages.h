@@ -21,11 +21,23 @@
 #include "ManPage.h"
 #include "Collection.h"
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ManPages_Posting {
+	long page;
+	int paragraph;   // 0 for the title, 1 + the paragraph index otherwise
+	int count;   // number of times the word occurs in that title or paragraph
+};
+
 Thing_define (ManPages, Daata) {
 	OrderedOf<structManPage> pages;
 	const char32 **titles;
 	bool ground, dynamic, executable;
 	structMelderDir rootDirectory;
+	std::unordered_map <std::u32string, long> pageNumberByTitle;   // the first page with each title
+	std::unordered_map <std::u32string, std::vector <ManPages_Posting>> searchIndex;   // lower-case word -> postings in page order
 
 	void v_destroy () noexcept
 		override;
@@ -44,6 +56,15 @@ void ManPages_addPage (ManPages me, const char32 *title, const char32 *author, l
 
 long ManPages_lookUp (ManPages me, const char32 *title);
 
+long ManPages_search (ManPages me, const char32 *query, long maximumNumberOfMatches, long *matches);
+/*
+	Put the numbers of the best-matching pages into matches [1..maximumNumberOfMatches], best first,
+	and return how many pages match.
+	Every space-separated token of the query has to occur in the page, case-insensitively;
+	occurrences in the title count much more than occurrences in the paragraphs.
+	The word index that this uses is built on the first search.
+*/
+
 void ManPages_writeOneToHtmlFile (ManPages me, long ipage, MelderFile file);
 void ManPages_writeAllToHtmlDir (ManPages me, const char32 *dirPath);
 
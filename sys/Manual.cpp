@@ -256,85 +256,9 @@ static void menu_cb_printRange (Manual me, EDITOR_ARGS_FORM) {
 
 /********** SEARCHING **********/
 
-static double *goodnessOfMatch;
-
-static double searchToken (ManPages me, long ipage, char32 *token) {
-	double goodness = 0.0;
-	ManPage page = my pages.at [ipage];
-	struct structManPage_Paragraph *par = & page -> paragraphs [0];
-	if (! token [0]) return 1.0;
-	/*
-	 * Try to find a match in the title, case insensitively.
-	 */
-	static MelderString buffer { 0 };
-	MelderString_copy (& buffer, page -> title);
-	for (char32 *p = & buffer.string [0]; *p != U'\0'; p ++) *p = towlower ((int) *p);
-	if (str32str (buffer.string, token)) {
-		goodness += 300.0;   // lots of points for a match in the title!
-		if (str32equ (buffer.string, token))
-			goodness += 10000.0;   // even more points for an exact match!
-	}
-	/*
-	 * Try to find a match in the paragraphs, case-insensitively.
-	 */
-	while (par -> type) {
-		if (par -> text) {
-			char32 *ptoken;
-			MelderString_copy (& buffer, par -> text);
-			for (char32 *p = & buffer.string [0]; *p != '\0'; p ++) *p = towlower ((int) *p);
-			ptoken = str32str (buffer.string, token);
-			if (ptoken) {
-				goodness += 10.0;   // ten points for every paragraph with a match!
-				if (str32str (ptoken + str32len (token), token)) {
-					goodness += 1.0;   // one point for every second occurrence in a paragraph!
-				}
-			}
-		}
-		par ++;
-	}
-	return goodness;
-}
-
 static void search (Manual me, const char32 *query) {
 	ManPages manPages = (ManPages) my data;
-	long numberOfPages = manPages -> pages.size;
-	static MelderString searchText { 0 };
-	MelderString_copy (& searchText, query);
-	for (char32 *p = & searchText.string [0]; *p != U'\0'; p ++) {
-		if (*p == U'\n') *p = U' ';
-		*p = towlower ((int) *p);
-	}
-	if (! goodnessOfMatch)
-		goodnessOfMatch = NUMvector <double> (1, numberOfPages);
-	for (long ipage = 1; ipage <= numberOfPages; ipage ++) {
-		char32 *token = searchText.string;
-		goodnessOfMatch [ipage] = 1.0;
-		for (;;) {
-			char32 *space = str32chr (token, U' ');
-			if (space) *space = U'\0';
-			goodnessOfMatch [ipage] *= searchToken (manPages, ipage, token);
-			if (! space) break;
-			*space = U' ';   // restore
-			token = space + 1;
-		}
-	}
-	/*
-	 * Find the 20 best matches.
-	 */
-	my numberOfMatches = 0;
-	for (long imatch = 1; imatch <= 20; imatch ++) {
-		long imax = 0;
-		double max = 0.0;
-		for (long ipage = 1; ipage <= numberOfPages; ipage ++) {
-			if (goodnessOfMatch [ipage] > max) {
-				max = goodnessOfMatch [ipage];
-				imax = ipage;
-			}
-		}
-		if (! imax) break;
-		my matches [++ my numberOfMatches] = imax;
-		goodnessOfMatch [imax] = 0.0;   // skip next time
-	}
+	my numberOfMatches = ManPages_search (manPages, query, 20, my matches);
 	HyperPage_goToPage_i (me, SEARCH_PAGE);
 }
 
@@ -80,6 +80,8 @@
 #endif
 
 static int MelderThread_getNumberOfProcessors () {
+	if (Melder_debug == 48)
+		return 1;   // so that a test can compare a threaded computation with the serial one
 	#if USE_WINTHREADS
 		return 8;
 	#elif USE_PTHREADS
@@ -1024,6 +1024,113 @@ double bingetr8 (FILE *f) {
 	}
 }
 
+/*
+	The bulk versions of bingetr4, bingetr8 and binputr8 for little-endian IEEE machines:
+	swap the bytes of a whole block in memory, then treat the special values
+	in the same way as the byte-by-byte versions do.
+*/
+
+#define binario_BLOCK_SIZE  4096
+
+static bool binario_isLittleEndianIEEE () {
+	static const double one = 1.0;   // 0x3FF0000000000000
+	static const float onef = 1.0f;   // 0x3F800000
+	return sizeof (double) == 8 && sizeof (float) == 4 &&
+		((const uint8 *) & one) [7] == 0x3F && ((const uint8 *) & one) [6] == 0xF0 &&
+		((const uint8 *) & onef) [3] == 0x3F && ((const uint8 *) & onef) [2] == 0x80;
+}
+
+static inline uint64_t binario_swap8 (uint64_t u) {
+	return (u >> 56) | ((u >> 40) & 0x000000000000FF00ULL) | ((u >> 24) & 0x0000000000FF0000ULL) |
+		((u >> 8) & 0x00000000FF000000ULL) | ((u << 8) & 0x000000FF00000000ULL) |
+		((u << 24) & 0x0000FF0000000000ULL) | ((u << 40) & 0x00FF000000000000ULL) | (u << 56);
+}
+
+static inline uint32 binario_swap4 (uint32 u) {
+	return (u >> 24) | ((u >> 8) & 0x0000FF00) | ((u << 8) & 0x00FF0000) | (u << 24);
+}
+
+void bingetr8array (double *x, long n, FILE *f) {
+	if (binario_doubleIEEE8msb && Melder_debug != 18) {
+		if (n > 0 && fread (x, sizeof (double), (size_t) n, f) != (size_t) n)
+			readError (f, U"64-bit floating-point numbers.");
+	} else if (binario_isLittleEndianIEEE () && Melder_debug != 18) {
+		uint64_t block [binario_BLOCK_SIZE];
+		for (long offset = 0; offset < n; offset += binario_BLOCK_SIZE) {
+			long blockSize = n - offset < binario_BLOCK_SIZE ? n - offset : binario_BLOCK_SIZE;
+			if (fread (block, 8, (size_t) blockSize, f) != (size_t) blockSize)
+				readError (f, U"64-bit floating-point numbers.");
+			for (long i = 0; i < blockSize; i ++) {
+				uint64_t u = binario_swap8 (block [i]);
+				if ((u & 0x7FF0000000000000ULL) == 0x7FF0000000000000ULL)   // Infinity or Not-a-Number
+					x [offset + i] = u >> 63 ? - HUGE_VAL : HUGE_VAL;
+				else
+					memcpy (& x [offset + i], & u, 8);
+			}
+		}
+	} else {
+		for (long i = 0; i < n; i ++)
+			x [i] = bingetr8 (f);
+	}
+}
+
+void binputr8array (const double *x, long n, FILE *f) {
+	if (binario_doubleIEEE8msb && Melder_debug != 18) {
+		if (n > 0 && fwrite (x, sizeof (double), (size_t) n, f) != (size_t) n)
+			writeError (U"64-bit floating-point numbers.");
+	} else if (binario_isLittleEndianIEEE () && Melder_debug != 18) {
+		uint64_t block [binario_BLOCK_SIZE];
+		for (long offset = 0; offset < n; offset += binario_BLOCK_SIZE) {
+			long blockSize = n - offset < binario_BLOCK_SIZE ? n - offset : binario_BLOCK_SIZE;
+			for (long i = 0; i < blockSize; i ++) {
+				double value = x [offset + i];
+				if (value == 0.0) value = 0.0;   // no negative zero
+				else if (value != value) value = HUGE_VAL;   // Not-a-Number becomes Infinity
+				uint64_t u;
+				memcpy (& u, & value, 8);
+				block [i] = binario_swap8 (u);
+			}
+			if (fwrite (block, 8, (size_t) blockSize, f) != (size_t) blockSize)
+				writeError (U"64-bit floating-point numbers.");
+		}
+	} else {
+		for (long i = 0; i < n; i ++)
+			binputr8 (x [i], f);
+	}
+}
+
+void bingetr4array (double *x, long n, FILE *f) {
+	if (binario_isLittleEndianIEEE () && ! binario_floatIEEE4msb && Melder_debug != 18) {
+		uint32 block [binario_BLOCK_SIZE];
+		for (long offset = 0; offset < n; offset += binario_BLOCK_SIZE) {
+			long blockSize = n - offset < binario_BLOCK_SIZE ? n - offset : binario_BLOCK_SIZE;
+			if (fread (block, 4, (size_t) blockSize, f) != (size_t) blockSize)
+				readError (f, U"32-bit floating-point numbers.");
+			for (long i = 0; i < blockSize; i ++) {
+				uint32 u = binario_swap4 (block [i]);
+				if ((u & 0x7F800000) == 0x7F800000) {   // Infinity or Not-a-Number
+					x [offset + i] = u >> 31 ? - HUGE_VAL : HUGE_VAL;
+				} else {
+					float value;
+					memcpy (& value, & u, 4);
+					x [offset + i] = value;
+				}
+			}
+		}
+	} else {
+		for (long i = 0; i < n; i ++)
+			x [i] = bingetr4 (f);
+	}
+}
+
+void binputr4array (const double *x, long n, FILE *f) {
+	/*
+		No block version: binputr4 truncates the mantissa, which a conversion to `float` would not do.
+	*/
+	for (long i = 0; i < n; i ++)
+		binputr4 (x [i], f);
+}
+
 double bingetr10 (FILE *f) {
 	try {
 		uint8 bytes [10];
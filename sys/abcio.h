@@ -166,6 +166,14 @@ double bingetr8 (FILE *f);   void binputr8 (double x, FILE *f);
 	This is the native format of a `double` on Silicon Graphics Iris and PowerMac.
 */
 
+void bingetr4array (double *x, long n, FILE *f);   void binputr4array (const double *x, long n, FILE *f);
+void bingetr8array (double *x, long n, FILE *f);   void binputr8array (const double *x, long n, FILE *f);
+/*
+	Read or write the n numbers x [0..n-1] in the same format as bingetr4/binputr4 or bingetr8/binputr8,
+	with exactly the same results, but in blocks: on little-endian IEEE machines,
+	many numbers are read or written with one `fread` or `fwrite` and byte-swapped in memory.
+*/
+
 double bingetr10 (FILE *f);   void binputr10 (double x, FILE *f);
 /*
 	Read or write a real number from or to 10 bytes in the stream `f`,
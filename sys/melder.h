@@ -387,7 +387,7 @@ void Melder_fwrite32to8 (const char32 *ptr, FILE *f);
 #endif
 
 struct FLAC__StreamDecoder;
-struct FLAC__StreamEncoder;
+struct structMelderFlacEncoder;
 
 #define kMelder_MAXPATH 1023   /* excluding the null byte */
 
@@ -398,7 +398,7 @@ struct structMelderFile {
 	bool openForReading, openForWriting, verbose, requiresCRLF;
 	unsigned long outputEncoding;
 	int indent;
-	struct FLAC__StreamEncoder *flacEncoder;
+	struct structMelderFlacEncoder *flacEncoder;
 };
 typedef struct structMelderFile *MelderFile;
 
@@ -438,6 +438,7 @@ void Melder_getTempDir (MelderDir tempDir);
 bool MelderFile_exists (MelderFile file);
 bool MelderFile_readable (MelderFile file);
 long MelderFile_length (MelderFile file);
+double MelderFile_modificationTime (MelderFile file);   // seconds since 1970, or 0.0 if unknown
 void MelderFile_delete (MelderFile file);
 
 /* The following two should be combined with each other and with Windows extension setting: */
@@ -751,6 +752,16 @@ struct structMelderReadText {
 	char32 *string32, *readPointer32;
 	char *string8, *readPointer8;
 	unsigned long input8Encoding;
+	/*
+		An 8-bit text file is not read into memory as a whole:
+		string8 is a window on the file, which is moved forward when the read pointer reaches its end,
+		so that the memory needed is independent of the size of the file.
+	*/
+	FILE *file8;   // null after the last window has been read
+	char *end8;   // the null byte that terminates the window
+	int64 size8;   // the number of bytes allocated for the window
+	int64 numberOfLinesBeforeWindow, numberOfLines;
+	bool pendingCarriageReturn;
 };
 typedef struct structMelderReadText *MelderReadText;
 
@@ -1303,6 +1314,9 @@ void Melder_readAudioToShort (FILE *f, int numberOfChannels, int encoding, short
  */
 void MelderFile_writeFloatToAudio (MelderFile file, int numberOfChannels, int encoding, double **buffer, long numberOfSamples, int warnIfClipped);
 void MelderFile_writeShortToAudio (MelderFile file, int numberOfChannels, int encoding, const short *buffer, long numberOfSamples);
+void MelderFile_finishFlac (MelderFile file, bool mayThrow);
+/* Encodes the remaining samples, completes the STREAMINFO block, and closes the file; called by MelderFile_close.
+ */
 
 /********** QUANTITY **********/
 
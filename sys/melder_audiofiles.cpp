@@ -22,7 +22,12 @@
 #include "flac_FLAC_metadata.h"
 #include "flac_FLAC_stream_decoder.h"
 #include "flac_FLAC_stream_encoder.h"
+extern "C" {
+	#include "flac_private_crc.h"
+	#include "flac_private_md5.h"
+}
 #include "mp3.h"
+#include "MelderThread.h"
 
 /***** WRITING *****/
 
@@ -35,6 +40,271 @@
 #define WAVE_FORMAT_DVI_ADPCM  0x0011
 #define WAVE_FORMAT_EXTENSIBLE 0xFFFE
 
+/*
+	A FLAC stream is written in segments of whole blocks, each segment by its own libFLAC encoder,
+	so that the segments of a batch can be encoded in parallel.
+	Every frame that such an encoder writes is renumbered to its place in the whole stream
+	(which changes its header CRC-8 and its frame CRC-16); the calling thread then writes the frames in order,
+	so that the stream is the same as if a single encoder had written it.
+	The STREAMINFO block, with the MD5 signature of the samples, is completed when the file is closed.
+*/
+
+#define MelderFlacEncoder_NUMBER_OF_BLOCKS_PER_SEGMENT  256
+#define MelderFlacEncoder_MAXIMUM_NUMBER_OF_THREADS  16
+
+Thing_define (MelderFlacEncoder_Segment, Thing) {
+	struct structMelderFlacEncoder *encoder;
+	const FLAC__int32 *channels [FLAC__MAX_CHANNELS];
+	long numberOfSamples;
+	bool computeMD5;   // instead of encoding
+	int64 firstFrameNumber;
+	std::vector <FLAC__byte> frames;
+	unsigned minimumFrameSize, maximumFrameSize;
+	bool failed;
+};
+Thing_implement (MelderFlacEncoder_Segment, Thing, 0);
+
+struct structMelderFlacEncoder {
+	int numberOfChannels, numberOfBitsPerSamplePoint;
+	long sampleRate;
+	long blocksize, segmentLength, batchLength;
+	int numberOfThreads;
+	std::vector <FLAC__int32> samples [FLAC__MAX_CHANNELS];   // [0..batchLength-1]
+	long numberOfWaitingSamples;
+	int64 numberOfSamplesEncoded, numberOfFramesEncoded;
+	unsigned minimumFrameSize, maximumFrameSize;
+	FLAC__MD5Context md5;
+	autoMelderFlacEncoder_Segment segments [1 + MelderFlacEncoder_MAXIMUM_NUMBER_OF_THREADS];
+};
+
+static FLAC__StreamEncoderWriteStatus MelderFlacEncoder_Segment_write (const FLAC__StreamEncoder *flac,
+	const FLAC__byte buffer [], size_t numberOfBytes, unsigned numberOfSamples, unsigned currentFrame, void *clientData)
+{
+	(void) flac;
+	MelderFlacEncoder_Segment me = (MelderFlacEncoder_Segment) clientData;
+	if (numberOfSamples == 0)
+		return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;   // the segment's own metadata; the stream has its own
+	try {
+		const size_t start = my frames.size ();
+		const int64 frameNumber = my firstFrameNumber + currentFrame;
+		if (frameNumber == currentFrame) {
+			my frames.insert (my frames.end (), buffer, buffer + numberOfBytes);
+		} else {
+			/*
+				The header: 4 fixed bytes, the frame number in UTF-8 coding,
+				an optional block size and sample rate, and the CRC-8.
+			*/
+			int oldNumberLength = 1;
+			if (buffer [4] & 0x80)
+				while (buffer [4] & (0x80 >> oldNumberLength))
+					oldNumberLength ++;
+			const int blocksizeCode = buffer [2] >> 4, sampleRateCode = buffer [2] & 15;
+			const size_t headerLength = 4 + oldNumberLength +
+				(blocksizeCode == 6 ? 1 : blocksizeCode == 7 ? 2 : 0) + (sampleRateCode == 12 ? 1 : sampleRateCode >= 13 && sampleRateCode <= 14 ? 2 : 0);
+			FLAC__byte number [7];
+			int numberLength = 1;
+			if (frameNumber < 0x80) {
+				number [0] = (FLAC__byte) frameNumber;
+			} else {
+				int numberOfContinuationBytes = 1;
+				while (frameNumber >= (int64) 1 << (5 * numberOfContinuationBytes + 6))
+					numberOfContinuationBytes ++;
+				number [0] = (FLAC__byte) ((0xFF00 >> (numberOfContinuationBytes + 1)) | (frameNumber >> (6 * numberOfContinuationBytes)));
+				for (int i = 1; i <= numberOfContinuationBytes; i ++)
+					number [i] = (FLAC__byte) (0x80 | ((frameNumber >> (6 * (numberOfContinuationBytes - i))) & 0x3F));
+				numberLength = 1 + numberOfContinuationBytes;
+			}
+			my frames.insert (my frames.end (), buffer, buffer + 4);
+			my frames.insert (my frames.end (), number, number + numberLength);
+			my frames.insert (my frames.end (), buffer + 4 + oldNumberLength, buffer + headerLength);
+			const size_t newHeaderLength = my frames.size () - start;
+			my frames.push_back (FLAC__crc8 (& my frames [start], newHeaderLength));
+			my frames.insert (my frames.end (), buffer + headerLength + 1, buffer + numberOfBytes - 2);
+			const unsigned crc16 = FLAC__crc16 (& my frames [start], my frames.size () - start);
+			my frames.push_back ((FLAC__byte) (crc16 >> 8));
+			my frames.push_back ((FLAC__byte) (crc16 & 0xFF));
+		}
+		const unsigned frameSize = my frames.size () - start;
+		if (frameSize < my minimumFrameSize) my minimumFrameSize = frameSize;
+		if (frameSize > my maximumFrameSize) my maximumFrameSize = frameSize;
+		return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+	} catch (...) {
+		return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;   // out of memory
+	}
+}
+
+static MelderThread_RETURN_TYPE MelderFlacEncoder_Segment_encode (MelderFlacEncoder_Segment me) {
+	struct structMelderFlacEncoder *encoder = my encoder;
+	if (my computeMD5) {
+		my failed = ! FLAC__MD5Accumulate (& encoder -> md5, my channels, encoder -> numberOfChannels,
+			my numberOfSamples, (encoder -> numberOfBitsPerSamplePoint + 7) / 8);
+		MelderThread_RETURN;
+	}
+	my frames.clear ();
+	my minimumFrameSize = (1u << FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN) - 1;
+	my maximumFrameSize = 0;
+	FLAC__StreamEncoder *flac = FLAC__stream_encoder_new ();
+	my failed = ! flac ||
+		! FLAC__stream_encoder_set_bits_per_sample (flac, encoder -> numberOfBitsPerSamplePoint) ||
+		! FLAC__stream_encoder_set_channels (flac, encoder -> numberOfChannels) ||
+		! FLAC__stream_encoder_set_sample_rate (flac, encoder -> sampleRate) ||
+		! FLAC__stream_encoder_set_blocksize (flac, encoder -> blocksize) ||
+		! FLAC__stream_encoder_set_do_md5 (flac, false) ||   // the signature is computed for the whole stream
+		FLAC__stream_encoder_init_stream (flac, MelderFlacEncoder_Segment_write, nullptr, nullptr, nullptr, me) != FLAC__STREAM_ENCODER_INIT_STATUS_OK ||
+		! FLAC__stream_encoder_process (flac, my channels, my numberOfSamples);
+	if (flac) {
+		if (! FLAC__stream_encoder_finish (flac))
+			my failed = true;
+		FLAC__stream_encoder_delete (flac);
+	}
+	MelderThread_RETURN;
+}
+
+static void MelderFlacEncoder_writeStreamInfo (struct structMelderFlacEncoder *me, FILE *f, int64 numberOfSamples, const FLAC__byte md5 [16]) {
+	FLAC__byte info [FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
+	info [0] = (FLAC__byte) (my blocksize >> 8);   // minimum block size
+	info [1] = (FLAC__byte) (my blocksize & 0xFF);
+	info [2] = info [0];   // maximum block size
+	info [3] = info [1];
+	const unsigned minimumFrameSize = my numberOfFramesEncoded > 0 ? my minimumFrameSize : 0;
+	info [4] = (FLAC__byte) (minimumFrameSize >> 16);
+	info [5] = (FLAC__byte) ((minimumFrameSize >> 8) & 0xFF);
+	info [6] = (FLAC__byte) (minimumFrameSize & 0xFF);
+	info [7] = (FLAC__byte) (my maximumFrameSize >> 16);
+	info [8] = (FLAC__byte) ((my maximumFrameSize >> 8) & 0xFF);
+	info [9] = (FLAC__byte) (my maximumFrameSize & 0xFF);
+	info [10] = (FLAC__byte) (my sampleRate >> 12);
+	info [11] = (FLAC__byte) ((my sampleRate >> 4) & 0xFF);
+	info [12] = (FLAC__byte) (((my sampleRate & 15) << 4) | ((my numberOfChannels - 1) << 1) | ((my numberOfBitsPerSamplePoint - 1) >> 4));
+	info [13] = (FLAC__byte) ((((my numberOfBitsPerSamplePoint - 1) & 15) << 4) | ((numberOfSamples >> 32) & 15));
+	info [14] = (FLAC__byte) ((numberOfSamples >> 24) & 0xFF);
+	info [15] = (FLAC__byte) ((numberOfSamples >> 16) & 0xFF);
+	info [16] = (FLAC__byte) ((numberOfSamples >> 8) & 0xFF);
+	info [17] = (FLAC__byte) (numberOfSamples & 0xFF);
+	memcpy (info + 18, md5, 16);
+	if (fwrite (info, 1, sizeof info, f) != sizeof info)
+		Melder_throw (U"Error in file while trying to write the FLAC STREAMINFO block.");
+}
+
+static void MelderFlacEncoder_writeHeader (struct structMelderFlacEncoder *me, FILE *f, long numberOfSamples) {
+	/*
+		The same metadata as libFLAC writes: STREAMINFO, and an empty VORBIS_COMMENT with libFLAC's vendor string.
+	*/
+	if (fwrite (FLAC__STREAM_SYNC_STRING, 1, FLAC__STREAM_SYNC_LENGTH, f) != FLAC__STREAM_SYNC_LENGTH)
+		Melder_throw (U"Error in file while trying to write the FLAC signature.");
+	binputu4 (((uint32) FLAC__METADATA_TYPE_STREAMINFO << 24) | FLAC__STREAM_METADATA_STREAMINFO_LENGTH, f);
+	const FLAC__byte noSignature [16] = { 0 };
+	MelderFlacEncoder_writeStreamInfo (me, f, numberOfSamples, noSignature);
+	const uint32 vendorStringLength = strlen (FLAC__VENDOR_STRING);
+	binputu4 ((1u << 31) | ((uint32) FLAC__METADATA_TYPE_VORBIS_COMMENT << 24) | (4 + vendorStringLength + 4), f);
+	binputu4LE (vendorStringLength, f);
+	if (fwrite (FLAC__VENDOR_STRING, 1, vendorStringLength, f) != vendorStringLength)
+		Melder_throw (U"Error in file while trying to write the FLAC vendor string.");
+	binputu4LE (0, f);   // no comments
+}
+
+static void MelderFlacEncoder_encodeWaitingSamples (struct structMelderFlacEncoder *me, FILE *f) {
+	const long numberOfSamples = my numberOfWaitingSamples;
+	if (numberOfSamples == 0)
+		return;
+	const int numberOfSegments = (int) ((numberOfSamples - 1) / my segmentLength + 1);
+	for (int isegment = 0; isegment <= numberOfSegments; isegment ++) {
+		MelderFlacEncoder_Segment segment = my segments [isegment].get();
+		segment -> encoder = me;
+		segment -> computeMD5 = isegment == numberOfSegments;
+		const long firstSample = segment -> computeMD5 ? 0 : isegment * my segmentLength;
+		segment -> numberOfSamples = segment -> computeMD5 ? numberOfSamples :
+			isegment == numberOfSegments - 1 ? numberOfSamples - firstSample : my segmentLength;
+		for (int ichan = 0; ichan < my numberOfChannels; ichan ++)
+			segment -> channels [ichan] = & my samples [ichan] [firstSample];
+		segment -> firstFrameNumber = my numberOfFramesEncoded + isegment * MelderFlacEncoder_NUMBER_OF_BLOCKS_PER_SEGMENT;
+		segment -> failed = false;
+	}
+	MelderThread_run (MelderFlacEncoder_Segment_encode, my segments, numberOfSegments + 1);
+	for (int isegment = 0; isegment <= numberOfSegments; isegment ++) {
+		MelderFlacEncoder_Segment segment = my segments [isegment].get();
+		if (segment -> failed)
+			Melder_throw (U"Error encoding FLAC stream.");
+		if (segment -> computeMD5)
+			continue;
+		if (fwrite (segment -> frames.data (), 1, segment -> frames.size (), f) != segment -> frames.size ())
+			Melder_throw (U"Error in file while trying to write FLAC frames.");
+		if (segment -> minimumFrameSize < my minimumFrameSize) my minimumFrameSize = segment -> minimumFrameSize;
+		if (segment -> maximumFrameSize > my maximumFrameSize) my maximumFrameSize = segment -> maximumFrameSize;
+		my numberOfFramesEncoded += (segment -> numberOfSamples - 1) / my blocksize + 1;
+	}
+	my numberOfSamplesEncoded += numberOfSamples;
+	my numberOfWaitingSamples = 0;
+}
+
+static struct structMelderFlacEncoder * MelderFlacEncoder_create (int numberOfChannels, int numberOfBitsPerSamplePoint, long sampleRate, long numberOfSamples) {
+	struct structMelderFlacEncoder *me = new structMelderFlacEncoder ();   // with zeroed members
+	my numberOfChannels = numberOfChannels;
+	my numberOfBitsPerSamplePoint = numberOfBitsPerSamplePoint;
+	my sampleRate = sampleRate;
+	my blocksize = 1152;   // libFLAC's default for its default (fixed-predictor) settings
+	my segmentLength = my blocksize * MelderFlacEncoder_NUMBER_OF_BLOCKS_PER_SEGMENT;
+	my numberOfThreads = MelderThread_getNumberOfProcessors ();
+	if (my numberOfThreads > MelderFlacEncoder_MAXIMUM_NUMBER_OF_THREADS) my numberOfThreads = MelderFlacEncoder_MAXIMUM_NUMBER_OF_THREADS;
+	if (my numberOfThreads < 1) my numberOfThreads = 1;
+	/*
+		A batch should not be much larger than the whole sound,
+		but it has to consist of whole blocks, and of whole segments if it contains more than one.
+	*/
+	my batchLength = my numberOfThreads * my segmentLength;
+	if (numberOfSamples > 0 && numberOfSamples < my batchLength)
+		my batchLength = numberOfSamples <= my segmentLength ? (numberOfSamples - 1) / my blocksize * my blocksize + my blocksize :
+			(numberOfSamples - 1) / my segmentLength * my segmentLength + my segmentLength;
+	try {
+		for (int ichan = 0; ichan < numberOfChannels; ichan ++)
+			my samples [ichan]. resize (my batchLength);
+		for (int isegment = 0; isegment <= my numberOfThreads; isegment ++)
+			my segments [isegment] = Thing_new (MelderFlacEncoder_Segment);
+	} catch (...) {
+		delete me;
+		Melder_throw (U"Out of memory for the FLAC encoder.");
+	}
+	my minimumFrameSize = (1u << FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN) - 1;
+	FLAC__MD5Init (& my md5);
+	return me;
+}
+
+static void MelderFlacEncoder_delete (struct structMelderFlacEncoder *me) {
+	FLAC__byte digest [16];
+	FLAC__MD5Final (digest, & my md5);   // frees the MD5 buffer
+	delete me;
+}
+
+void MelderFile_finishFlac (MelderFile file, bool mayThrow) {
+	struct structMelderFlacEncoder *me = file -> flacEncoder;
+	FILE *f = file -> filePointer;
+	file -> flacEncoder = nullptr;
+	file -> filePointer = nullptr;
+	try {
+		MelderFlacEncoder_encodeWaitingSamples (me, f);
+		FLAC__byte digest [16];
+		FLAC__MD5Final (digest, & my md5);
+		FLAC__MD5Init (& my md5);
+		if (fseek (f, FLAC__STREAM_SYNC_LENGTH + FLAC__STREAM_METADATA_HEADER_LENGTH, SEEK_SET))
+			Melder_throw (U"Cannot seek back to the FLAC STREAMINFO block.");
+		MelderFlacEncoder_writeStreamInfo (me, f, my numberOfSamplesEncoded, digest);
+	} catch (MelderError) {
+		MelderFlacEncoder_delete (me);
+		if (mayThrow) {
+			fclose (f);
+			throw;
+		}
+		Melder_clearError ();
+		fclose (f);
+		return;
+	}
+	MelderFlacEncoder_delete (me);
+	if (mayThrow)
+		Melder_fclose (file, f);
+	else
+		fclose (f);
+}
+
 void MelderFile_writeAudioFileHeader (MelderFile file, int audioFileType, long sampleRate, long numberOfSamples, int numberOfChannels, int numberOfBitsPerSamplePoint) {
 	try {
 		FILE *f = file -> filePointer;
@@ -186,18 +456,14 @@ void MelderFile_writeAudioFileHeader (MelderFile file, int audioFileType, long s
 			} break;
 			case Melder_FLAC: {
 				try {
-					FLAC__StreamEncoder *encoder = nullptr;
 					if (numberOfChannels > (int) FLAC__MAX_CHANNELS)
 						Melder_throw (U"FLAC files cannot have more than 8 channels.");
-					if ((encoder = FLAC__stream_encoder_new ()) == nullptr)
-						Melder_throw (U"Error creating FLAC stream encoder.");
-					FLAC__stream_encoder_set_bits_per_sample (encoder, numberOfBitsPerSamplePoint);
-					FLAC__stream_encoder_set_channels (encoder, numberOfChannels);
-					FLAC__stream_encoder_set_sample_rate (encoder, sampleRate);
-					FLAC__stream_encoder_set_total_samples_estimate (encoder, numberOfSamples);
-					if (FLAC__stream_encoder_init_FILE (encoder, file -> filePointer, nullptr, nullptr) != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
-						FLAC__stream_encoder_delete (encoder);
-						Melder_throw (U"Error creating FLAC stream encoder");
+					struct structMelderFlacEncoder *encoder = MelderFlacEncoder_create (numberOfChannels, numberOfBitsPerSamplePoint, sampleRate, numberOfSamples);
+					try {
+						MelderFlacEncoder_writeHeader (encoder, f, numberOfSamples);
+					} catch (MelderError) {
+						MelderFlacEncoder_delete (encoder);
+						throw;
 					}
 					file -> flacEncoder = encoder;   // only after we know it's correct (for MelderFile_close)
 					file -> outputEncoding = kMelder_textOutputEncoding_FLAC;   // only after we know it's correct (for MelderFile_close)
@@ -1352,12 +1618,14 @@ void MelderFile_writeShortToAudio (MelderFile file, int numberOfChannels, int en
 			case Melder_FLAC_COMPRESSION_32:
 				if (! file -> flacEncoder)
 					Melder_throw (U"FLAC encoder not initialized.");
-				for (i = start; i < n; i += step * numberOfChannels) {
-					FLAC__int32 samples [FLAC__MAX_CHANNELS];
-					for (int ichan = 1; ichan <= numberOfChannels; ichan ++)
-						samples [ichan - 1] = buffer [i + ichan - 1];
-					if (! FLAC__stream_encoder_process_interleaved (file -> flacEncoder, samples, 1))
-						Melder_throw (U"Error encoding FLAC stream.");
+				{// scope
+					struct structMelderFlacEncoder *encoder = file -> flacEncoder;
+					for (i = start; i < n; i += step * numberOfChannels) {
+						for (int ichan = 1; ichan <= numberOfChannels; ichan ++)
+							encoder -> samples [ichan - 1] [encoder -> numberOfWaitingSamples] = buffer [i + ichan - 1];
+						if (++ encoder -> numberOfWaitingSamples == encoder -> batchLength)
+							MelderFlacEncoder_encodeWaitingSamples (encoder, f);
+					}
 				}
 			break; case Melder_MULAW: case Melder_ALAW: default:
 				Melder_throw (U"Unknown encoding ", encoding, U".");
@@ -1474,16 +1742,18 @@ void MelderFile_writeFloatToAudio (MelderFile file, int numberOfChannels, int en
 			case Melder_FLAC_COMPRESSION_32:
 				if (! file -> flacEncoder)
 					Melder_throw (U"FLAC encoder not initialized.");
-				for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-					FLAC__int32 samples [FLAC__MAX_CHANNELS];
-					for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-						double value = round (buffer [ichan] [isamp] * 32768.0);
-						if (value < -32768.0) { value = -32768.0; nclipped ++; }
-						if (value > 32767.0) { value = 32767.0; nclipped ++; }
-						samples [ichan - 1] = (FLAC__int32) value;
+				{// scope
+					struct structMelderFlacEncoder *encoder = file -> flacEncoder;
+					for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
+						for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
+							double value = round (buffer [ichan] [isamp] * 32768.0);
+							if (value < -32768.0) { value = -32768.0; nclipped ++; }
+							if (value > 32767.0) { value = 32767.0; nclipped ++; }
+							encoder -> samples [ichan - 1] [encoder -> numberOfWaitingSamples] = (FLAC__int32) value;
+						}
+						if (++ encoder -> numberOfWaitingSamples == encoder -> batchLength)
+							MelderFlacEncoder_encodeWaitingSamples (encoder, f);
 					}
-					if (! FLAC__stream_encoder_process_interleaved (file -> flacEncoder, samples, 1))
-						Melder_throw (U"Error encoding FLAC stream.");
 				}
 				break;
 			case Melder_MULAW:
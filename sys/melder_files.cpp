@@ -63,10 +63,7 @@ using namespace std;
 #include <errno.h>
 #include "abcio.h"
 #include "melder.h"
-
-//#include "flac_FLAC_stream_encoder.h"
-extern "C" int  FLAC__stream_encoder_finish (FLAC__StreamEncoder *);
-extern "C" void FLAC__stream_encoder_delete (FLAC__StreamEncoder *);
+#include "NUM.h"
 
 #if defined (macintosh)
 	#include <sys/stat.h>
@@ -592,6 +589,8 @@ FILE * Melder_fopen (MelderFile file, const char *type) {
 		#if defined (_WIN32) && ! defined (__CYGWIN__)
 			f = _wfopen (Melder_peek32toW (file -> path), Melder_peek32toW (Melder_peek8to32 (type)));
 		#else
+			if (type [0] == 'w' && NUMnativeBinary_fileIsMapped (utf8path))
+				unlink (utf8path);   // do not truncate a file that arrays are mapped to; the mapping keeps the old file alive
 			f = fopen ((char *) utf8path, type);
 		#endif
 	}
@@ -727,6 +726,24 @@ long MelderFile_length (MelderFile file) {
 	#endif
 }
 
+double MelderFile_modificationTime (MelderFile file) {
+	#if defined (UNIX) || defined (macintosh)
+		char utf8path [kMelder_MAXPATH+1];
+		Melder_str32To8bitFileRepresentation_inline (file -> path, utf8path);
+		struct stat statistics;
+		if (stat ((char *) utf8path, & statistics) != 0) return 0.0;
+		return (double) statistics. st_mtime;
+	#elif defined (_WIN32)
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (! GetFileAttributesExW (Melder_peek32toW (file -> path), GetFileExInfoStandard, & attributes)) return 0.0;
+		uint64_t ticks = (uint64_t) attributes. ftLastWriteTime. dwHighDateTime << 32 | attributes. ftLastWriteTime. dwLowDateTime;
+		return ticks * 1e-7 - 11644473600.0;   // from 100-nanosecond ticks since 1601
+	#else
+		(void) file;
+		return 0.0;
+	#endif
+}
+
 void MelderFile_delete (MelderFile file) {
 	if (! file) return;
 	#if defined (UNIX)
@@ -900,10 +917,8 @@ void MelderFile_rewind (MelderFile me) {
 
 static void _MelderFile_close (MelderFile me, bool mayThrow) {
 	if (my outputEncoding == kMelder_textOutputEncoding_FLAC) {
-		if (my flacEncoder) {
-			FLAC__stream_encoder_finish (my flacEncoder);   // This already calls fclose! BUG: we cannot get any error messages out.
-			FLAC__stream_encoder_delete (my flacEncoder);
-		}
+		if (my flacEncoder)
+			MelderFile_finishFlac (me, mayThrow);   // this also closes the file
 	} else if (my filePointer) {
 		if (mayThrow) {
 			Melder_fclose (me, my filePointer);
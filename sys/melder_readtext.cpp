@@ -21,11 +21,83 @@
 #include "abcio.h"
 #define my  me ->
 
+/*
+	An 8-bit text file is read in windows of a megabyte or so.
+	Every byte that comes from the file goes through MelderReadText_cleanChunk,
+	which removes null bytes and turns CR-LF and bare CR into LF,
+	so that the window contains the same text that Melder_killReturns_inline would have made of the whole file.
+*/
+#define MelderReadText_CHUNK_SIZE  1000000
+
+static int64 MelderReadText_cleanChunk (char *chunk, int64 numberOfBytes, bool *pendingCarriageReturn, int64 *numberOfNullBytes) {
+	char *to = chunk;
+	for (const char *from = chunk; from < chunk + numberOfBytes; from ++) {
+		char kar = *from;
+		if (kar == '\0') {
+			*numberOfNullBytes += 1;
+			continue;
+		}
+		if (*pendingCarriageReturn) {
+			*pendingCarriageReturn = false;
+			if (kar == '\n') continue;   // the linefeed of a Windows line end, which has already been written
+		}
+		if (kar == 13) {   // carriage return?
+			*to ++ = '\n';
+			*pendingCarriageReturn = true;
+		} else {
+			*to ++ = kar;
+		}
+	}
+	return to - chunk;
+}
+
+static int64 MelderReadText_readChunk (MelderReadText me, char *chunk, int64 maximumNumberOfBytes, int64 *numberOfNullBytes) {
+	/*
+		Read and clean bytes until at least one byte is left or the file is exhausted.
+	*/
+	int64 numberOfBytes = 0;
+	while (numberOfBytes == 0) {
+		size_t numberOfBytesRead = fread (chunk, sizeof (char), (size_t) maximumNumberOfBytes, my file8);
+		if (ferror (my file8))
+			Melder_throw (U"Error reading text file.");
+		if (numberOfBytesRead == 0) break;
+		numberOfBytes = MelderReadText_cleanChunk (chunk, (int64) numberOfBytesRead, & my pendingCarriageReturn, numberOfNullBytes);
+	}
+	return numberOfBytes;
+}
+
+static void MelderReadText_refill (MelderReadText me) {
+	/*
+		Move the unread part of the window to the front and append the next chunk of the file.
+	*/
+	for (const char *p = my string8; p < my readPointer8; p ++)
+		if (*p == '\0' || *p == '\n') my numberOfLinesBeforeWindow ++;
+	int64 numberOfUnreadBytes = my end8 - my readPointer8;
+	memmove (my string8, my readPointer8, (size_t) numberOfUnreadBytes);
+	if (my size8 - 1 - numberOfUnreadBytes < MelderReadText_CHUNK_SIZE) {   // a very long line
+		int64 newSize = 2 * my size8;
+		char *newString8 = (char *) Melder_realloc (my string8, newSize);
+		my string8 = newString8;
+		my size8 = newSize;
+	}
+	int64 numberOfNullBytes = 0;   // already reported by the first pass
+	int64 numberOfBytes = MelderReadText_readChunk (me, my string8 + numberOfUnreadBytes, MelderReadText_CHUNK_SIZE, & numberOfNullBytes);
+	my readPointer8 = my string8;
+	my end8 = my string8 + numberOfUnreadBytes + numberOfBytes;
+	*my end8 = '\0';
+	if (numberOfBytes == 0) {
+		fclose (my file8);
+		my file8 = nullptr;
+	}
+}
+
 char32 MelderReadText_getChar (MelderReadText me) {
 	if (my string32) {
 		if (* my readPointer32 == U'\0') return U'\0';
 		return * my readPointer32 ++;
 	} else {
+		if (my end8 - my readPointer8 < 4 && my file8)
+			MelderReadText_refill (me);   // a complete UTF-8 sequence is now in the window
 		if (* my readPointer8 == '\0') return U'\0';
 		if (my input8Encoding == kMelder_textInputEncoding_UTF8) {
 			char32 kar1 = (char32) (char8) * my readPointer8 ++;
@@ -77,16 +149,23 @@ char32 * MelderReadText_readLine (MelderReadText me) {
 		Melder_assert (my string8);
 		Melder_assert (! my readPointer32);
 		Melder_assert (my readPointer8);
+		if (my readPointer8 == my end8 && my file8)
+			MelderReadText_refill (me);
 		if (*my readPointer8 == '\0') {   // tried to read past end of file
 			return nullptr;
 		}
+		char *newline = (char *) memchr (my readPointer8, '\n', (size_t) (my end8 - my readPointer8));
+		while (! newline && my file8) {
+			int64 offset = my end8 - my readPointer8;   // no newline before this
+			MelderReadText_refill (me);
+			newline = (char *) memchr (my readPointer8 + offset, '\n', (size_t) (my end8 - my readPointer8 - offset));
+		}
 		char *result8 = my readPointer8;
-		char *newline = strchr (result8, '\n');
 		if (newline) {
 			*newline = '\0';
 			my readPointer8 = newline + 1;
 		} else {
-			my readPointer8 += strlen (result8);
+			my readPointer8 = my end8;
 		}
 		static char32 *text32 = nullptr;
 		static int64 size = 0;
@@ -108,9 +187,7 @@ int64 MelderReadText_getNumberOfLines (MelderReadText me) {
 		for (; *p != U'\0'; p ++) if (*p == U'\n') n ++;
 		if (p - my string32 > 1 && p [-1] != U'\n') n ++;
 	} else {
-		char *p = & my string8 [0];
-		for (; *p != '\0'; p ++) if (*p == '\n') n ++;
-		if (p - my string8 > 1 && p [-1] != '\n') n ++;
+		n = my numberOfLines;   // counted in the first pass through the file
 	}
 	return n;
 }
@@ -124,12 +201,12 @@ const char32 * MelderReadText_getLineNumber (MelderReadText me) {
 			p ++;
 		}
 	} else {
+		result += my numberOfLinesBeforeWindow;
 		char *p = my string8;
 		while (my readPointer8 - p > 0) {
 			if (*p == '\0' || *p == '\n') result ++;
 			p ++;
 		}
-		return Melder_integer (result);
 	}
 	return Melder_integer (result);
 }
@@ -152,7 +229,7 @@ static size_t fread_multi (char *buffer, size_t numberOfBytes, FILE *f) {
 	return numberOfBytesRead;
 }
 
-static char32 * _MelderFile_readText (MelderFile file, char **string8) {
+char32 * MelderFile_readText (MelderFile file) {
 	try {
 		int type = 0;   // 8-bit
 		autostring32 text;
@@ -210,13 +287,7 @@ static char32 * _MelderFile_readText (MelderFile file, char **string8) {
 					Melder_warning (U"Ignored ", numberOfNullBytes, U" null bytes in text file ", file, U".");
 				}
 			}
-			if (string8) {
-				*string8 = text8bit.transfer();
-				(void) Melder_killReturns_inline (*string8);
-				return nullptr;   // OK
-			} else {
-				text.reset (Melder_8to32 (text8bit.peek(), 0));
-			}
+			text.reset (Melder_8to32 (text8bit.peek(), 0));
 		} else {
 			length = length / 2 - 1;   // Byte Order Mark subtracted. Length = number of UTF-16 codes
 			text.reset (Melder_malloc (char32, length + 1));
@@ -275,25 +346,91 @@ static char32 * _MelderFile_readText (MelderFile file, char **string8) {
 	}
 }
 
-char32 * MelderFile_readText (MelderFile file) {
-	return _MelderFile_readText (file, nullptr);
-}
-
 MelderReadText MelderReadText_createFromFile (MelderFile file) {
-	autoMelderReadText me = Melder_calloc (struct structMelderReadText, 1);
-	my string32 = _MelderFile_readText (file, & my string8);
-	if (my string32) {
-		my readPointer32 = & my string32 [0];
-	} else {
-		Melder_assert (my string8);
-		my readPointer8 = & my string8 [0];
+	try {
+		autoMelderReadText me = Melder_calloc (struct structMelderReadText, 1);
+		/*
+			Look for a byte-order mark.
+		*/
+		int type = 0;   // 8-bit
+		{
+			autofile f = Melder_fopen (file, "rb");
+			int firstByte = fgetc (f), secondByte = fgetc (f), thirdByte = fgetc (f);
+			if (firstByte == 0xFE && secondByte == 0xFF) {
+				type = 1;   // big-endian 16-bit
+			} else if (firstByte == 0xFF && secondByte == 0xFE) {
+				type = 2;   // little-endian 16-bit
+			} else if (firstByte == 0xEF && secondByte == 0xBB && thirdByte == 0xBF) {
+				type = -1;   // UTF-8 with BOM
+			}
+			f.close (file);
+		}
+		if (type > 0) {
+			my string32 = MelderFile_readText (file);
+			my readPointer32 = & my string32 [0];
+			return me.transfer();
+		}
+		/*
+			An 8-bit file is streamed, so that only a window of it is in memory at any time.
+			A first pass through the file counts the lines and null bytes
+			and finds out whether the text is valid UTF-8.
+		*/
+		my file8 = Melder_fopen (file, "rb");
+		off_t startOfText = ( type == -1 ? 3 : 0 );
+		fseeko (my file8, startOfText, SEEK_SET);
+		my size8 = MelderReadText_CHUNK_SIZE + 1;
+		my string8 = Melder_malloc (char, my size8);
+		int64 numberOfNullBytes = 0, length = 0, numberOfNewlines = 0;
+		char lastByte = '\0';
+		int numberOfContinuationBytesExpected = 0;
+		bool isValidUtf8 = true;
+		for (;;) {
+			int64 numberOfBytes = MelderReadText_readChunk (me.peek(), my string8, MelderReadText_CHUNK_SIZE, & numberOfNullBytes);
+			if (numberOfBytes == 0) break;
+			for (const char8 *p = (const char8 *) my string8; p < (const char8 *) my string8 + numberOfBytes; p ++) {
+				char8 kar = *p;
+				if (kar == '\n') numberOfNewlines ++;
+				if (! isValidUtf8) continue;
+				if (numberOfContinuationBytesExpected > 0) {
+					if ((kar & 0xC0) != 0x80) isValidUtf8 = false;
+					numberOfContinuationBytesExpected --;
+				} else if (kar <= 0x7F) {
+					;
+				} else if (kar <= 0xC1) {
+					isValidUtf8 = false;
+				} else if (kar <= 0xDF) {
+					numberOfContinuationBytesExpected = 1;
+				} else if (kar <= 0xEF) {
+					numberOfContinuationBytesExpected = 2;
+				} else if (kar <= 0xF4) {
+					numberOfContinuationBytesExpected = 3;
+				} else {
+					isValidUtf8 = false;
+				}
+			}
+			length += numberOfBytes;
+			lastByte = my string8 [numberOfBytes - 1];
+		}
+		if (numberOfContinuationBytesExpected > 0) isValidUtf8 = false;
+		my numberOfLines = numberOfNewlines + ( length > 1 && lastByte != '\n' );
+		if (numberOfNullBytes > 0)
+			Melder_warning (U"Ignored ", numberOfNullBytes, U" null bytes in text file ", file, U".");
+		/*
+			Start streaming.
+		*/
+		fseeko (my file8, startOfText, SEEK_SET);
+		clearerr (my file8);
+		my pendingCarriageReturn = false;
+		my readPointer8 = my end8 = & my string8 [0];
+		*my end8 = '\0';
+		MelderReadText_refill (me.peek());
 		my input8Encoding = Melder_getInputEncoding ();
 		if (my input8Encoding == kMelder_textInputEncoding_UTF8 ||
 			my input8Encoding == kMelder_textInputEncoding_UTF8_THEN_ISO_LATIN1 ||
 			my input8Encoding == kMelder_textInputEncoding_UTF8_THEN_WINDOWS_LATIN1 ||
 			my input8Encoding == kMelder_textInputEncoding_UTF8_THEN_MACROMAN)
 		{
-			if (Melder_str8IsValidUtf8 (my string8)) {
+			if (isValidUtf8) {
 				my input8Encoding = kMelder_textInputEncoding_UTF8;
 			} else if (my input8Encoding == kMelder_textInputEncoding_UTF8) {
 				Melder_throw (U"Text is not valid UTF-8; please try a different text input encoding.");
@@ -305,8 +442,10 @@ MelderReadText MelderReadText_createFromFile (MelderFile file) {
 				my input8Encoding = kMelder_textInputEncoding_MACROMAN;
 			}
 		}
+		return me.transfer();
+	} catch (MelderError) {
+		Melder_throw (U"Error reading file ", file, U".");
 	}
-	return me.transfer();
 }
 
 MelderReadText MelderReadText_createFromString (const char32 *string);
@@ -315,6 +454,7 @@ void MelderReadText_delete (MelderReadText me) {
 	if (! me) return;
 	Melder_free (my string32);
 	Melder_free (my string8);
+	if (my file8) fclose (my file8);
 	Melder_free (me);
 }
 
@@ -106,6 +106,8 @@ static structMelderFile tracingFile { 0 };
 
 static GuiList praatList_objects;
 
+static double theStartOfCommandRegistration;   // for reporting the start-up time with tracing on
+
 /***** selection *****/
 
 long praat_idOfSelected (ClassInfo klas, int inplace) {
@@ -1318,6 +1320,7 @@ void praat_init (const char32 *title, int argc, char **argv)
 	/*
 	 * Make room for commands.
 	 */
+	theStartOfCommandRegistration = Melder_clock ();
 	trace (U"initing actions");
 	praat_actions_init ();
 	trace (U"initing menu commands");
@@ -1508,6 +1511,8 @@ void praat_run () {
 	trace (U"adding the Quit command");
 	praat_addMenuCommand (U"Objects", U"Praat", U"-- quit --", nullptr, 0, nullptr);
 	praat_addMenuCommand (U"Objects", U"Praat", U"Quit", nullptr, praat_UNHIDABLE | 'Q' | praat_NO_API, DO_Quit);
+	trace (U"registered ", praat_getNumberOfActions (), U" actions and ", praat_getNumberOfMenuCommands (),
+		U" menu commands in ", Melder_clock () - theStartOfCommandRegistration, U" seconds");
 
 	trace (U"read the preferences file, and notify those who want to be notified of this");
 	/* ...namely, those who already have a window (namely, the Picture window),
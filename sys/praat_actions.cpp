@@ -22,10 +22,85 @@
 #include "machine.h"
 #include "GuiP.h"
 
+#include <string>
+#include <unordered_map>
+
 #define BUTTON_LEFT  -240
 #define BUTTON_RIGHT -5
 
 static OrderedOf <structPraat_Command> theActions;
+
+/*
+ * Hash indices into theActions, so that neither registration nor the execution of a command from a script
+ * has to do a linear string search through the thousands of actions.
+ * The indices point to the actions themselves rather than to their positions,
+ * because positions shift whenever an action is inserted "after" another one or when the actions are sorted.
+ * Every insertion into or removal from theActions has to go through indexAction () and unindexAction ().
+ */
+struct ActionKey {
+	ClassInfo class1, class2, class3, class4;
+	std::u32string title;
+	bool operator== (const ActionKey& other) const {
+		return class1 == other.class1 && class2 == other.class2 && class3 == other.class3 && class4 == other.class4 &&
+			title == other.title;
+	}
+};
+struct ActionKeyHash {
+	size_t operator() (const ActionKey& key) const {
+		size_t hash = std::hash <std::u32string> () (key.title);
+		hash ^= std::hash <const void *> () (key.class1) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash <const void *> () (key.class2) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash <const void *> () (key.class3) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash <const void *> () (key.class4) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+};
+static std::unordered_multimap <ActionKey, Praat_Command, ActionKeyHash> theActionsByClassesAndTitle;
+static std::unordered_multimap <std::u32string, Praat_Command> theActionsByTitle;
+
+static void indexAction (Praat_Command action) {
+	if (! action -> title) return;   // untitled separators cannot be looked up
+	theActionsByClassesAndTitle. insert ({ { action -> class1, action -> class2, action -> class3, action -> class4, action -> title }, action });
+	theActionsByTitle. insert ({ action -> title, action });
+}
+
+template <class Index, class Key>
+static void unindex (Index& index, const Key& key, Praat_Command action) {
+	auto range = index. equal_range (key);
+	for (auto it = range. first; it != range. second; ++ it) {
+		if (it -> second == action) {
+			index. erase (it);
+			return;
+		}
+	}
+}
+
+static void unindexAction (Praat_Command action) {
+	if (! action -> title) return;
+	unindex (theActionsByClassesAndTitle, ActionKey { action -> class1, action -> class2, action -> class3, action -> class4, action -> title }, action);
+	unindex (theActionsByTitle, std::u32string (action -> title), action);
+}
+
+static long positionOfAction (Praat_Command action) {
+	/*
+	 * Search backwards, because most look-ups are for commands that have just been added.
+	 * This compares pointers only.
+	 */
+	for (long i = theActions.size; i > 0; i --)
+		if (theActions.at [i] == action) return i;
+	Melder_fatal (U"Action \"", action -> title, U"\" not in the list.");
+	return 0;
+}
+
+static void insertAction (autoPraat_Command action, long position) {
+	indexAction (action.get());
+	theActions. addItemAtPosition_move (action.move(), position);
+}
+
+static void removeAction (long position) {
+	unindexAction (theActions.at [position]);
+	theActions. removeItem (position);
+}
 static GuiMenu praat_writeMenu;
 static GuiMenuItem praat_writeMenuSeparator;
 static GuiForm praat_form;
@@ -72,13 +147,14 @@ static long lookUpMatchingAction (ClassInfo class1, ClassInfo class2, ClassInfo
  * Precondition:
  *	class1, class2, and class3 must be in sorted order.
  */
-	for (long i = 1; i <= theActions.size; i ++) {
-		Praat_Command action = theActions.at [i];
-		if (class1 == action -> class1 && class2 == action -> class2 &&
-		    class3 == action -> class3 && class4 == action -> class4 &&
-		    title && action -> title && str32equ (action -> title, title)) return i;
+	if (! title) return 0;
+	auto range = theActionsByClassesAndTitle. equal_range (ActionKey { class1, class2, class3, class4, title });
+	long found = 0;
+	for (auto it = range. first; it != range. second; ++ it) {
+		long position = positionOfAction (it -> second);
+		if (found == 0 || position < found) found = position;   // the first one in the list wins, as before
 	}
-	return 0;   // not found
+	return found;
 }
 
 void praat_addAction1_ (ClassInfo class1, int n1,
@@ -159,7 +235,7 @@ void praat_addAction4_ (ClassInfo class1, int n1, ClassInfo class2, int n2, Clas
 		/*
 		 * Insert new command.
 		 */
-		theActions. addItemAtPosition_move (action.move(), position);
+		insertAction (action.move(), position);
 	} catch (MelderError) {
 		Melder_flushError ();
 	}
@@ -246,7 +322,7 @@ void praat_addActionScript (const char32 *className1, int n1, const char32 *clas
 		 */
 		long found = lookUpMatchingAction (class1, class2, class3, nullptr, title);
 		if (found) {
-			theActions. removeItem (found);
+			removeAction (found);
 		}
 
 		/*
@@ -295,7 +371,7 @@ void praat_addActionScript (const char32 *className1, int n1, const char32 *clas
 		/*
 		 * Insert new command.
 		 */
-		theActions. addItemAtPosition_move (action.move(), position);
+		insertAction (action.move(), position);
 		updateDynamicMenu ();
 	} catch (MelderError) {
 		Melder_throw (U"Praat: script action not added.");
@@ -313,7 +389,7 @@ void praat_removeAction (ClassInfo class1, ClassInfo class2, ClassInfo class3, c
 				class3 ? U" & ": U"", class3 -> className,
 				U": ", title, U"\" not found.");
 		}
-		theActions. removeItem (found);
+		removeAction (found);
 	} catch (MelderError) {
 		Melder_throw (U"Praat: action not removed.");
 	}
@@ -605,7 +681,7 @@ void praat_actions_show () {
 					if (! praat_writeMenuSeparator) {
 						if (writeMenuGoingToSeparate)
 							praat_writeMenuSeparator = GuiMenu_addSeparator (parentMenu);
-						else if (str32equ (my title, U"Save as binary file..."))
+						else if (str32equ (my title, U"Save as native binary file..."))
 							writeMenuGoingToSeparate = true;
 					}
 				}
@@ -707,19 +783,42 @@ void praat_saveAddedActions (MelderString *buffer) {
 	}
 }
 
+static Praat_Command lookUpExecutableAction (const char32 *command) {
+	auto range = theActionsByTitle. equal_range (command);
+	Praat_Command found = nullptr;
+	long positionOfFound = 0;
+	for (auto it = range. first; it != range. second; ++ it) {
+		Praat_Command action = it -> second;
+		if (! action -> executable) continue;
+		if (! found) {
+			found = action;
+		} else {
+			/*
+			 * Rare: more than one executable action with this title.
+			 * The first one in the list wins, as it did with the linear search.
+			 */
+			if (positionOfFound == 0) positionOfFound = positionOfAction (found);
+			long position = positionOfAction (action);
+			if (position < positionOfFound) {
+				found = action;
+				positionOfFound = position;
+			}
+		}
+	}
+	return found;
+}
+
 int praat_doAction (const char32 *command, const char32 *arguments, Interpreter interpreter) {
-	long i = 1;
-	while (i <= theActions.size && (! theActions.at [i] -> executable || str32cmp (theActions.at [i] -> title, command))) i ++;
-	if (i > theActions.size) return 0;   // not found
-	theActions.at [i] -> callback (nullptr, 0, nullptr, arguments, interpreter, command, false, nullptr);
+	Praat_Command action = lookUpExecutableAction (command);
+	if (! action) return 0;   // not found
+	action -> callback (nullptr, 0, nullptr, arguments, interpreter, command, false, nullptr);
 	return 1;
 }
 
 int praat_doAction (const char32 *command, int narg, Stackel args, Interpreter interpreter) {
-	long i = 1;
-	while (i <= theActions.size && (! theActions.at [i] -> executable || str32cmp (theActions.at [i] -> title, command))) i ++;
-	if (i > theActions.size) return 0;   // not found
-	theActions.at [i] -> callback (nullptr, narg, args, nullptr, interpreter, command, false, nullptr);
+	Praat_Command action = lookUpExecutableAction (command);
+	if (! action) return 0;   // not found
+	action -> callback (nullptr, narg, args, nullptr, interpreter, command, false, nullptr);
 	return 1;
 }
 
@@ -21,8 +21,75 @@
 #include "praat_version.h"
 #include "GuiP.h"
 
+#include <string>
+#include <unordered_map>
+
 static OrderedOf <structPraat_Command> theCommands;
 
+/*
+ * Hash indices into theCommands, analogous to those into the actions in praat_actions.cpp.
+ * Menu commands are never removed, so the indices only have to follow insertions.
+ */
+struct MenuCommandKey {
+	std::u32string window, menu, title;
+	bool hasWindow, hasMenu, hasTitle;
+	MenuCommandKey (const char32 *window_, const char32 *menu_, const char32 *title_) :
+		window (window_ ? window_ : U""), menu (menu_ ? menu_ : U""), title (title_ ? title_ : U""),
+		hasWindow (!! window_), hasMenu (!! menu_), hasTitle (!! title_) { }
+	bool operator== (const MenuCommandKey& other) const {
+		return hasWindow == other.hasWindow && hasMenu == other.hasMenu && hasTitle == other.hasTitle &&
+			window == other.window && menu == other.menu && title == other.title;
+	}
+};
+struct MenuCommandKeyHash {
+	size_t operator() (const MenuCommandKey& key) const {
+		size_t hash = std::hash <std::u32string> () (key.title);
+		hash ^= std::hash <std::u32string> () (key.menu) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash <std::u32string> () (key.window) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+};
+static std::unordered_multimap <MenuCommandKey, Praat_Command, MenuCommandKeyHash> theCommandsByWindowMenuAndTitle;
+static std::unordered_multimap <std::u32string, Praat_Command> theCommandsByTitle;
+
+static long positionOfMenuCommand (Praat_Command command) {
+	for (long i = theCommands.size; i > 0; i --)
+		if (theCommands.at [i] == command) return i;
+	Melder_fatal (U"Menu command \"", command -> title, U"\" not in the list.");
+	return 0;
+}
+
+static void insertMenuCommand (autoPraat_Command command, long position) {
+	Praat_Command me = command.get();
+	theCommandsByWindowMenuAndTitle. insert ({ MenuCommandKey (my window, my menu, my title), me });
+	if (my title) theCommandsByTitle. insert ({ my title, me });
+	theCommands. addItemAtPosition_move (command.move(), position);
+}
+
+template <class Range>
+static Praat_Command firstInList (Range range, bool (*isMatch) (Praat_Command)) {
+	/*
+	 * Of all the matching commands, the one that comes first in the list wins, as it did with the linear search.
+	 */
+	Praat_Command found = nullptr;
+	long positionOfFound = 0;
+	for (auto it = range. first; it != range. second; ++ it) {
+		Praat_Command command = it -> second;
+		if (isMatch && ! isMatch (command)) continue;
+		if (! found) {
+			found = command;
+		} else {
+			if (positionOfFound == 0) positionOfFound = positionOfMenuCommand (found);
+			long position = positionOfMenuCommand (command);
+			if (position < positionOfFound) {
+				found = command;
+				positionOfFound = position;
+			}
+		}
+	}
+	return found;
+}
+
 void praat_menuCommands_init () {
 }
 
@@ -54,16 +121,8 @@ static long lookUpMatchingMenuCommand (const char32 *window, const char32 *menu,
 /*
  * A menu command is fully specified by its environment (window + menu) and its title.
  */
-	for (long i = 1; i <= theCommands.size; i ++) {
-		Praat_Command command = theCommands.at [i];
-		const char32 *tryWindow = command -> window;
-		const char32 *tryMenu = command -> menu;
-		const char32 *tryTitle = command -> title;
-		if ((window == tryWindow || (window && tryWindow && str32equ (window, tryWindow))) &&
-		    (menu == tryMenu || (menu && tryMenu && str32equ (menu, tryMenu))) &&
-		    (title == tryTitle || (title && tryTitle && str32equ (title, tryTitle)))) return i;
-	}
-	return 0;   // not found
+	Praat_Command found = firstInList (theCommandsByWindowMenuAndTitle. equal_range (MenuCommandKey (window, menu, title)), nullptr);
+	return found ? positionOfMenuCommand (found) : 0;   // 0 = not found
 }
 
 static void do_menu (Praat_Command me, unsigned long modified) {
@@ -224,7 +283,7 @@ GuiMenuItem praat_addMenuCommand_ (const char32 *window, const char32 *menu, con
 		if (hidden) GuiThing_hide (command -> button);
 	}
 	Thing_cast (GuiMenuItem, button_as_GuiMenuItem, command -> button);
-	theCommands. addItemAtPosition_move (command.move(), position);
+	insertMenuCommand (command.move(), position);
 	return button_as_GuiMenuItem;
 }
 
@@ -315,7 +374,7 @@ void praat_addMenuCommandScript (const char32 *window, const char32 *menu, const
 				}
 			}
 		}
-		theCommands. addItemAtPosition_move (command.move(), position);
+		insertMenuCommand (command.move(), position);
 
 		if (praatP.phase >= praat_HANDLING_EVENTS) praat_sortMenuCommands ();
 	} catch (MelderError) {
@@ -390,51 +449,35 @@ void praat_addFixedButtonCommand_ (GuiForm parent, const char32 *title, UiCallba
 		GuiThing_show (button);
 	}
 	my executable = false;
-	theCommands. addItemAtPosition_move (me.move(), 0);
+	insertMenuCommand (me.move(), 0);
 }
 
 void praat_sensitivizeFixedButtonCommand (const char32 *title, int sensitive) {
-	Praat_Command commandFound = nullptr;
-	for (long i = 1; i <= theCommands.size; i ++) {
-		Praat_Command command = theCommands.at [i];
-		if (str32equ (command -> title, title)) {
-			commandFound = command;
-			break;
-		}
-	}
+	Praat_Command commandFound = firstInList (theCommandsByTitle. equal_range (title), nullptr);
 	if (! commandFound) Melder_fatal (U"Unkown fixed button <<", title, U">>");
 	commandFound -> executable = sensitive;
 	if (! theCurrentPraatApplication -> batch && ! Melder_backgrounding)
 		GuiThing_setSensitive (commandFound -> button, sensitive);
 }
 
+static bool isExecutableFromScript (Praat_Command command) {
+	return command -> executable &&
+		(str32equ (command -> window, U"Objects") || str32equ (command -> window, U"Picture"));
+}
+
+static Praat_Command lookUpExecutableMenuCommand (const char32 *title) {
+	return firstInList (theCommandsByTitle. equal_range (title), isExecutableFromScript);
+}
+
 int praat_doMenuCommand (const char32 *title, const char32 *arguments, Interpreter interpreter) {
-	Praat_Command commandFound = nullptr;
-	for (long i = 1; i <= theCommands.size; i ++) {
-		Praat_Command command = theCommands.at [i];
-		if (command -> executable && str32equ (command -> title, title) &&
-			(str32equ (command -> window, U"Objects") || str32equ (command -> window, U"Picture")))
-		{
-			commandFound = command;
-			break;
-		}
-	}
+	Praat_Command commandFound = lookUpExecutableMenuCommand (title);
 	if (! commandFound) return 0;
 	commandFound -> callback (nullptr, 0, nullptr, arguments, interpreter, title, false, nullptr);
 	return 1;
 }
 
 int praat_doMenuCommand (const char32 *title, int narg, Stackel args, Interpreter interpreter) {
-	Praat_Command commandFound = nullptr;
-	for (long i = 1; i <= theCommands.size; i ++) {
-		Praat_Command command = theCommands.at [i];
-		if (command -> executable && str32equ (command -> title, title) &&
-			(str32equ (command -> window, U"Objects") || str32equ (command -> window, U"Picture")))
-		{
-			commandFound = command;
-			break;
-		}
-	}
+	Praat_Command commandFound = lookUpExecutableMenuCommand (title);
 	if (! commandFound) return 0;
 	commandFound -> callback (nullptr, narg, args, nullptr, interpreter, title, false, nullptr);
 	return 1;
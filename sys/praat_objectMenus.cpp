@@ -504,6 +504,18 @@ FORM_WRITE2 (Data_writeToBinaryFile, U"Save Object(s) as one binary file", nullp
 	}
 END2 }
 
+FORM_WRITE2 (Data_writeToNativeBinaryFile, U"Save Object(s) as one native binary file", nullptr, nullptr) {
+	if (theCurrentPraatObjects -> totalSelection == 1) {
+		LOOP {
+			iam (Daata);
+			Data_writeToNativeBinaryFile (me, file);
+		}
+	} else {
+		autoCollection set = praat_getSelectedObjects ();
+		Data_writeToNativeBinaryFile (set.get(), file);
+	}
+END2 }
+
 FORM (ManPages_saveToHtmlDirectory, U"Save all pages as HTML files", nullptr) {
 	LABEL (U"", U"Type a directory name:")
 	TEXTFIELD (U"directory", U"")
@@ -734,6 +746,7 @@ void praat_addMenus (GuiWindow window) {
 	praat_addAction1 (classDaata, 0,   U"Write to short text file...", nullptr, praat_DEPRECATED_2011, DO_Data_writeToShortTextFile);
 	praat_addAction1 (classDaata, 0, U"Save as binary file...", nullptr, 0, DO_Data_writeToBinaryFile);
 	praat_addAction1 (classDaata, 0,   U"Write to binary file...", nullptr, praat_DEPRECATED_2011, DO_Data_writeToBinaryFile);
+	praat_addAction1 (classDaata, 0, U"Save as native binary file...", nullptr, 0, DO_Data_writeToNativeBinaryFile);
 
 	praat_addAction1 (classManPages, 1, U"Save to HTML directory...", nullptr, 0, DO_ManPages_saveToHtmlDirectory);
 	praat_addAction1 (classManPages, 1, U"View", nullptr, praat_NO_API, DO_ManPages_view);
@@ -25,11 +25,13 @@
 #include "GuiP.h"
 
 static bool praat_mouseSelectsInnerViewport;
+static bool praat_recordsFunctionsInFullPrecision;
 
 void praat_picture_prefs () {
 	Preferences_addEnum (U"Picture.font", & theCurrentPraatPicture -> font, kGraphics_font, kGraphics_font_DEFAULT);
 	Preferences_addInt (U"Picture.fontSize", & theCurrentPraatPicture -> fontSize, 10);
 	Preferences_addBool (U"Picture.mouseSelectsInnerViewport", & praat_mouseSelectsInnerViewport, false);
+	Preferences_addBool (U"Picture.recordsFunctionsInFullPrecision", & praat_recordsFunctionsInFullPrecision, false);
 }
 
 /***** static variable *****/
@@ -1363,6 +1365,17 @@ DIRECT2 (PictureWindowHelp) { Melder_help (U"Picture window"); END2 }
 DIRECT2 (AboutSpecialSymbols) { Melder_help (U"Special symbols"); END2 }
 DIRECT2 (AboutTextStyles) { Melder_help (U"Text styles"); END2 }
 DIRECT2 (PhoneticSymbols) { Melder_help (U"Phonetic symbols"); END2 }
+FORM (FunctionPrecision, U"Praat picture: Function precision", U"Function precision...") {
+	LABEL (U"", U"Long sounds and other functions are remembered in the picture")
+	LABEL (U"", U"with a resolution of 1200 dots per inch, unless you keep all their samples.")
+	BOOLEAN (U"Keep all samples", false)
+OK2
+	SET_INTEGER (U"Keep all samples", praat_recordsFunctionsInFullPrecision);
+DO
+	praat_recordsFunctionsInFullPrecision = GET_INTEGER (U"Keep all samples");
+	Graphics_setFunctionRecordingPrecision (static_cast<Graphics> (Picture_peekGraphics (praat_picture.get())), praat_recordsFunctionsInFullPrecision);
+END2 }
+
 DIRECT2 (Picture_settings_report) {
 	MelderInfo_open ();
 	const char32 *units = theCurrentPraatPicture == & theForegroundPraatPicture ? U" inches" : U"";
@@ -1626,6 +1639,7 @@ void praat_picture_init () {
 		praat_addMenuCommand (U"Picture", U"File", U"Save as Windows metafile...", nullptr, 0, DO_Picture_writeToWindowsMetafile);
 		praat_addMenuCommand (U"Picture", U"File",   U"Write to Windows metafile...", U"*Save as Windows metafile...", praat_DEPRECATED_2011, DO_Picture_writeToWindowsMetafile);
 	#endif
+	praat_addMenuCommand (U"Picture", U"File", U"Function precision...", nullptr, 0, DO_FunctionPrecision);
 	praat_addMenuCommand (U"Picture", U"File", U"-- praat picture file --", nullptr, 0, nullptr);
 	praat_addMenuCommand (U"Picture", U"File", U"Read from praat picture file...", nullptr, 0, DO_Picture_readFromPraatPictureFile);
 	praat_addMenuCommand (U"Picture", U"File", U"Save as praat picture file...", nullptr, 0, DO_Picture_writeToPraatPictureFile);
@@ -1797,6 +1811,7 @@ void praat_picture_init () {
 	updateFontMenu ();
 	updateSizeMenu ();
 	updateViewportMenu ();
+	Graphics_setFunctionRecordingPrecision (theCurrentPraatPicture -> graphics, praat_recordsFunctionsInFullPrecision);
 }
 
 void praat_picture_prefsChanged () {
@@ -1805,6 +1820,7 @@ void praat_picture_prefsChanged () {
 	updateViewportMenu ();
 	Graphics_setFontSize (theCurrentPraatPicture -> graphics, theCurrentPraatPicture -> fontSize);   // so that the thickness of the selection rectangle is correct
 	Picture_setMouseSelectsInnerViewport (praat_picture.get(), praat_mouseSelectsInnerViewport);
+	Graphics_setFunctionRecordingPrecision (theCurrentPraatPicture -> graphics, praat_recordsFunctionsInFullPrecision);
 }
 
 void praat_picture_background () {